@@ -40,9 +40,6 @@ public:
         sp_destroy(&sp);
     }
 
-    // Is this needed? Ramping should be rethought
-    virtual void startRamp(AUParameterAddress address, AUValue value, AUAudioFrameCount duration) {}
-
     virtual void setParameter(AUParameterAddress address, AUValue value, bool immediate) override {}
     virtual AUValue getParameter(AUParameterAddress address) override { return 0.0f; }
 
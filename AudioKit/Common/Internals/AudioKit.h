@@ -31,6 +31,9 @@ FOUNDATION_EXPORT const unsigned char AudioKitVersionString[];
 // Analysis
 #import "AKAmplitudeTrackerAudioUnit.h"
 #import "AKFrequencyTrackerAudioUnit.h"
+#import "AKLoudnessMeter_Typedefs.h"
+#import "AKLoudnessMeter.hpp"
+#import "AKLoudnessMeterDSP.hpp"
 #if !TARGET_OS_TV
 #import "AKMicrophoneTrackerEngine.h"
 #endif
@@ -169,6 +172,7 @@ FOUNDATION_EXPORT const unsigned char AudioKitVersionString[];
 #import "AKRenderTap.h"
 #import "AKLazyTap.h"
 #import "AKTimelineTap.h"
+#import "AKWavpackRecorderTap.h"
 
 // Utilities
 #import "TPCircularBuffer.h"
@@ -20,6 +20,10 @@ public typealias AKCallback = () -> Void
 /// Function type for MIDI callbacks
 public typealias AKMIDICallback = (MIDIByte, MIDIByte, MIDIByte) -> Void
 
+/// Function type for MIDI callbacks that also receive the host time the event is meant to sound at
+/// and the latency in seconds between the event being rendered and the callback being called
+public typealias AKMIDITimedCallback = (MIDIByte, MIDIByte, MIDIByte, UInt64, Double) -> Void
+
 /// Top level AudioKit managing class
 open class AudioKit: NSObject {
     #if !os(macOS)
@@ -14,6 +14,7 @@
 #import "AKDSPBase.hpp"
 #import "BufferedAudioUnit.h"
 #import "AKInterop.h"
+#import "AKRenderStats.h"
 
 @interface AKAudioUnitBase : BufferedAudioUnit
 
@@ -60,6 +61,11 @@
 @property (readonly) BOOL isPlaying;
 @property (readonly) BOOL isSetUp;
 
+// Render instrumentation: opt-in, and polled without blocking the render thread
+@property BOOL instrumentationEnabled;
+@property (readonly) AKRenderStats renderStats;
+- (void)resetRenderStats;
+
 @end
 
 
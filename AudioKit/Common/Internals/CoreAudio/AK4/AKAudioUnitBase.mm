@@ -36,6 +36,15 @@
 - (void)initializeConstant:(AUValue)value { self.kernel->initializeConstant(value); }
 - (BOOL)isPlaying { return self.kernel->isPlaying(); }
 - (BOOL)isSetUp { return self.kernel->isSetup(); }
+
+- (BOOL)instrumentationEnabled { return self.kernel->isInstrumentationEnabled(); }
+- (void)setInstrumentationEnabled:(BOOL)enabled { self.kernel->setInstrumentationEnabled(enabled); }
+- (AKRenderStats)renderStats {
+    AKRenderStats stats = {};
+    self.kernel->getRenderStats(stats);
+    return stats;
+}
+- (void)resetRenderStats { self.kernel->resetRenderStats(); }
 - (void)setupWaveform:(int)size {
     self.kernel->setupWaveform((uint32_t)size);
 }
@@ -147,6 +156,12 @@
     };
 }
 
+// Input is pulled into the output buffers only for kernels that opt in. The canProcessInPlace
+// overrides of the Swift subclasses don't say whether their kernels are safe in place.
+-(BOOL)shouldProcessInPlace {
+    return self.kernel != NULL && self.kernel->canProcessInPlace();
+}
+
 // Deallocate resources allocated by allocateRenderResourcesAndReturnError:
 // Hosts should call this after finishing rendering.
 
@@ -163,7 +178,8 @@
 // See the discussion of renderBlock.
 // Partially bridged to the v2 property kAudioUnitProperty_InPlaceProcessing, the v3 property is not settable.
 - (BOOL)canProcessInPlace {
-    return NO;   // OK THIS IS DIFFERENT FROM APPLE EXAMPLE CODE
+    // OK THIS IS DIFFERENT FROM APPLE EXAMPLE CODE: only when the kernel says so
+    return self.kernel != NULL && self.kernel->canProcessInPlace();
 }
 
 // ----- END UNMODIFIED COPY FROM APPLE CODE -----
@@ -14,6 +14,11 @@
 #import <AudioToolbox/AudioToolbox.h>
 #import <algorithm>
 #import "AKInterop.h"
+#import "AKDSPCommandBus.hpp"
+#import "AKDSPInstrumentation.hpp"
+
+class AKParameterRampBase;
+
 /**
  Base class for DSPKernels. Many of the methods are virtual, because the base AudioUnit class
  does not know the type of the subclass at compile time.
@@ -33,10 +38,18 @@ protected:
     bool isStarted = true;
     int64_t now = 0;  // current time in samples
 
+    /// Control threads to render thread
+    AKDSPCommandBus commandBus;
+    /// Render thread back to the control thread: buffers replaced by AKDSPCommandBufferSwap, to be freed there
+    AKDSPCommandBus retiredBufferBus;
+
 public:
     
     /// Virtual destructor allows child classes to be deleted with only AKDSPBase *pointer
-    virtual ~AKDSPBase() {}
+    virtual ~AKDSPBase() {
+        delete[] scheduledCommands;
+        delete instrumentation;
+    }
     
     /// The Render function.
     virtual void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) = 0;
@@ -47,6 +60,15 @@ public:
     /// Uses the ParameterAddress as a key
     virtual float getParameter(AUParameterAddress address) { return 0.0; }
 
+    /// The ramp driving a parameter, if it has one, so scheduled ramp events can reach it
+    virtual AKParameterRampBase *getRamp(AUParameterAddress address) { return nullptr; }
+
+    /**
+     Applies an AURenderEventParameter or AURenderEventParameterRamp at its sample time. The default
+     hands it to the parameter's ramp from getRamp, or to setParameter if there is none.
+     */
+    virtual void startRamp(AUParameterAddress address, AUValue value, AUAudioFrameCount duration);
+
     /// Get the DSP into initialized state
     virtual void reset() {}
 
@@ -71,6 +93,8 @@ public:
 
     /// File-based effects convolution and phase locked vocoder
     virtual void setUpTable(float *table, UInt32 size) {}
+    /// Interleaved; the kernel keeps its own copy
+    virtual void setUpMultichannelTable(float *table, UInt32 frameCount, int channelCount) {}
     virtual void setPartitionLength(int partLength) {}
     virtual void initConvolutionEngine() {}
     virtual bool isLooping() { return false; }
@@ -90,6 +114,11 @@ public:
         outBufferListPtr = outBufs;
     }
 
+    /// True if process() still works when the input and output buffers are the same, i.e. it reads each
+    /// input sample before writing the output sample at that position. The audio unit then pulls its input
+    /// straight into the output buffers instead of into scratch memory.
+    virtual bool canProcessInPlace() { return false; }
+
     virtual void init(int channelCount, double sampleRate) {
         this->channelCount = channelCount;
         this->sampleRate = sampleRate;
@@ -106,6 +135,38 @@ public:
     virtual bool isSetup() { return isInitialized; }
 
     virtual void handleMIDIEvent(AUMIDIEvent const& midiEvent) {}
+
+    /// Post a command to be applied on the render thread, at sampleTime or at the start of the next
+    /// render slice. Safe from any thread; returns false if the queue is full.
+    bool postCommand(AKDSPCommand const &command) { return commandBus.post(command); }
+
+    bool postParameter(AUParameterAddress address, AUValue value, bool immediate = false,
+                       AUEventSampleTime sampleTime = AKDSPCommandImmediate);
+    bool postNoteOn(uint8_t noteNumber, uint8_t velocity, float frequency = 0.0f,
+                    AUEventSampleTime sampleTime = AKDSPCommandImmediate);
+    bool postNoteOff(uint8_t noteNumber, bool immediate = false,
+                     AUEventSampleTime sampleTime = AKDSPCommandImmediate);
+    bool postSustainPedal(bool down, AUEventSampleTime sampleTime = AKDSPCommandImmediate);
+    bool postAllNotesOff(AUEventSampleTime sampleTime = AKDSPCommandImmediate);
+
+    /// Hand a new buffer to the render thread; the one it replaces comes back through collectRetiredBuffer
+    bool postBufferSwap(uint32_t tag, void *buffer, AUEventSampleTime sampleTime = AKDSPCommandImmediate);
+
+    /// Control thread: fetch a buffer the render thread no longer uses, so it can be freed
+    bool collectRetiredBuffer(uint32_t &tag, void *&buffer);
+
+    /**
+     Applies one command on the render thread. The default turns notes into MIDI events for
+     handleMIDIEvent and parameters into setParameter calls; override for anything else.
+     */
+    virtual void handleCommand(AKDSPCommand const &command);
+
+    /**
+     Render thread: install a buffer posted with postBufferSwap and return the one it replaces
+     (or nullptr). The default refuses the swap by handing the new buffer straight back.
+     */
+    virtual void *swapBuffer(uint32_t tag, void *buffer) { return buffer; }
+
     /**
      Handles the event list processing and rendering loop. Should be called from AU renderBlock
      From Apple Example code
@@ -113,10 +174,35 @@ public:
     void processWithEvents(AudioTimeStamp const *timestamp, AUAudioFrameCount frameCount,
                            AURenderEvent const *events);
 
+    /// Opt-in render timing for this kernel. Allocates the first time, so call from a control thread.
+    void setInstrumentationEnabled(bool enabled);
+    bool isInstrumentationEnabled() { return instrumentationEnabled; }
+
+    /// Any thread, lock-free. Returns false if instrumentation was never enabled.
+    bool getRenderStats(AKRenderStats &stats);
+    void resetRenderStats();
+
+    /// Fraction of each buffer's duration this kernel may use before a render counts as a deadline miss
+    void setDeadlineBudget(double fraction);
+
 private:
 
+    void renderSegments(AUAudioFrameCount frameCount, AURenderEvent const *events);
+    void checkForDenormals(AUAudioFrameCount frameCount, bool instrumented);
+
     void handleOneEvent(AURenderEvent const *event);
     void performAllSimultaneousEvents(AUEventSampleTime now, AURenderEvent const *&event);
+
+    void fetchCommands();
+    void performDueCommands(AUEventSampleTime now);
+    AUEventSampleTime nextCommandTime();
+
+    /// Commands popped from commandBus but not yet due, sorted by sampleTime. Preallocated, render thread only.
+    AKDSPCommand *scheduledCommands = new AKDSPCommand[commandBus.capacity()];
+    uint32_t scheduledCommandCount = 0;
+
+    AKDSPInstrumentation *instrumentation = nullptr;
+    std::atomic<bool> instrumentationEnabled{false};
 };
 
 #endif
@@ -7,17 +7,65 @@
 //
 
 #import "AKDSPBase.hpp"
+#import "AKParameterRampBase.hpp"
+#import "AKScopedFlushToZero.hpp"
 
 void AKDSPBase::processWithEvents(AudioTimeStamp const *timestamp, AUAudioFrameCount frameCount,
                                   AURenderEvent const *events)
 {
     now = timestamp->mSampleTime;
+
+    bool const checkingDenormals = AKDenormalCheckingIsEnabled();
+    AKScopedFlushToZero flushToZero(!checkingDenormals);
+
+    bool const instrumented = instrumentationEnabled.load(std::memory_order_acquire);
+    bool const checking = AKRealtimeSafetyIsCheckingEnabled();
+    if (!instrumented && !checking && !checkingDenormals) {
+        renderSegments(frameCount, events);
+        return;
+    }
+
+    if (checking) AKRealtimeSafetyEnterRenderContext(instrumented ? instrumentation : nullptr);
+    uint64_t const start = instrumented ? instrumentation->now() : 0;
+
+    renderSegments(frameCount, events);
+
+    if (instrumented) instrumentation->recordRender(start, instrumentation->now(), frameCount, sampleRate);
+    if (checking) AKRealtimeSafetyLeaveRenderContext();
+    if (checkingDenormals) checkForDenormals(frameCount, instrumented);
+}
+
+/** Debug mode: look for subnormal samples in what this render wrote */
+void AKDSPBase::checkForDenormals(AUAudioFrameCount frameCount, bool instrumented) {
+    if (!outBufferListPtr) return;
+    uint64_t found = 0;
+    for (UInt32 i = 0; i < outBufferListPtr->mNumberBuffers; i++) {
+        AudioBuffer const &buffer = outBufferListPtr->mBuffers[i];
+        if (!buffer.mData) continue;
+        UInt32 count = std::min(frameCount * std::max(buffer.mNumberChannels, 1u),
+                                UInt32(buffer.mDataByteSize / sizeof(float)));
+        uint32_t const *bits = (uint32_t const *)buffer.mData;
+        for (UInt32 j = 0; j < count; j++) {
+            // zero exponent, nonzero mantissa
+            found += (bits[j] & 0x7F800000) == 0 && (bits[j] & 0x007FFFFF) != 0;
+        }
+    }
+    if (found > 0) AKDenormalCheckingReport(instrumented ? instrumentation : nullptr, found);
+}
+
+void AKDSPBase::renderSegments(AUAudioFrameCount frameCount, AURenderEvent const *events)
+{
     AUAudioFrameCount framesRemaining = frameCount;
     AURenderEvent const *event = events;
 
+    fetchCommands();
+
     while (framesRemaining > 0) {
+        performDueCommands(now);
+        AUEventSampleTime const commandTime = nextCommandTime();
+
         // If there are no more events, we can process the entire remaining segment and exit.
-        if (event == nullptr) {
+        if (event == nullptr && commandTime >= now + framesRemaining) {
             AUAudioFrameCount const bufferOffset = frameCount - framesRemaining;
             process(framesRemaining, bufferOffset);
             return;
@@ -25,8 +73,9 @@ void AKDSPBase::processWithEvents(AudioTimeStamp const *timestamp, AUAudioFrameC
 
         // **** start late events late.
         auto timeZero = AUEventSampleTime(0);
-        auto headEventTime = event->head.eventSampleTime;
-        AUAudioFrameCount const framesThisSegment = AUAudioFrameCount(std::max(timeZero, headEventTime - now));
+        auto headEventTime = event ? std::min(event->head.eventSampleTime, commandTime) : commandTime;
+        AUAudioFrameCount const framesThisSegment = AUAudioFrameCount(std::min(std::max(timeZero, headEventTime - now),
+                                                                               AUEventSampleTime(framesRemaining)));
 
         // Compute everything before the next event.
         if (framesThisSegment > 0) {
@@ -38,17 +87,167 @@ void AKDSPBase::processWithEvents(AudioTimeStamp const *timestamp, AUAudioFrameC
             // Advance time.
             now += framesThisSegment;
         }
-        performAllSimultaneousEvents(now, event);
+        if (event && event->head.eventSampleTime <= now) {
+            performAllSimultaneousEvents(now, event);
+        }
+    }
+}
+
+bool AKDSPBase::postParameter(AUParameterAddress address, AUValue value, bool immediate, AUEventSampleTime sampleTime) {
+    AKDSPCommand command;
+    command.type = AKDSPCommandParameter;
+    command.sampleTime = sampleTime;
+    command.parameter.address = address;
+    command.parameter.value = value;
+    command.parameter.immediate = immediate;
+    return commandBus.post(command);
+}
+
+bool AKDSPBase::postNoteOn(uint8_t noteNumber, uint8_t velocity, float frequency, AUEventSampleTime sampleTime) {
+    AKDSPCommand command;
+    command.type = AKDSPCommandNoteOn;
+    command.sampleTime = sampleTime;
+    command.note.noteNumber = noteNumber;
+    command.note.velocity = velocity;
+    command.note.immediate = false;
+    command.note.frequency = frequency;
+    return commandBus.post(command);
+}
+
+bool AKDSPBase::postNoteOff(uint8_t noteNumber, bool immediate, AUEventSampleTime sampleTime) {
+    AKDSPCommand command;
+    command.type = AKDSPCommandNoteOff;
+    command.sampleTime = sampleTime;
+    command.note.noteNumber = noteNumber;
+    command.note.velocity = 0;
+    command.note.immediate = immediate;
+    command.note.frequency = 0.0f;
+    return commandBus.post(command);
+}
+
+bool AKDSPBase::postSustainPedal(bool down, AUEventSampleTime sampleTime) {
+    AKDSPCommand command;
+    command.type = AKDSPCommandSustainPedal;
+    command.sampleTime = sampleTime;
+    command.pedal.down = down;
+    return commandBus.post(command);
+}
+
+bool AKDSPBase::postAllNotesOff(AUEventSampleTime sampleTime) {
+    AKDSPCommand command;
+    command.type = AKDSPCommandAllNotesOff;
+    command.sampleTime = sampleTime;
+    return commandBus.post(command);
+}
+
+bool AKDSPBase::postBufferSwap(uint32_t tag, void *buffer, AUEventSampleTime sampleTime) {
+    AKDSPCommand command;
+    command.type = AKDSPCommandBufferSwap;
+    command.sampleTime = sampleTime;
+    command.buffer.tag = tag;
+    command.buffer.buffer = buffer;
+    return commandBus.post(command);
+}
+
+bool AKDSPBase::collectRetiredBuffer(uint32_t &tag, void *&buffer) {
+    AKDSPCommand command;
+    if (!retiredBufferBus.pop(command)) {
+        return false;
+    }
+    tag = command.buffer.tag;
+    buffer = command.buffer.buffer;
+    return true;
+}
+
+void AKDSPBase::handleCommand(AKDSPCommand const &command) {
+    AUMIDIEvent midiEvent = {};
+    midiEvent.eventSampleTime = now;
+    midiEvent.eventType = AURenderEventMIDI;
+    midiEvent.length = 3;
+
+    switch (command.type) {
+        case AKDSPCommandParameter:
+            setParameter(command.parameter.address, command.parameter.value, command.parameter.immediate);
+            return;
+        case AKDSPCommandNoteOn:
+            midiEvent.data[0] = 0x90;
+            midiEvent.data[1] = command.note.noteNumber;
+            midiEvent.data[2] = command.note.velocity;
+            break;
+        case AKDSPCommandNoteOff:
+            midiEvent.data[0] = 0x80;
+            midiEvent.data[1] = command.note.noteNumber;
+            midiEvent.data[2] = 0;
+            break;
+        case AKDSPCommandSustainPedal:
+            midiEvent.data[0] = 0xB0;
+            midiEvent.data[1] = 64;
+            midiEvent.data[2] = command.pedal.down ? 127 : 0;
+            break;
+        case AKDSPCommandAllNotesOff:
+            midiEvent.data[0] = 0xB0;
+            midiEvent.data[1] = 123;
+            midiEvent.data[2] = 0;
+            break;
+        case AKDSPCommandBufferSwap: {
+            AKDSPCommand retired = command;
+            retired.buffer.buffer = swapBuffer(command.buffer.tag, command.buffer.buffer);
+            if (retired.buffer.buffer != nullptr) {
+                retiredBufferBus.post(retired);
+            }
+            return;
+        }
+    }
+    handleMIDIEvent(midiEvent);
+}
+
+/** Move newly posted commands into the time-ordered schedule */
+void AKDSPBase::fetchCommands() {
+    AKDSPCommand command;
+    while (scheduledCommandCount < commandBus.capacity() && commandBus.pop(command)) {
+        uint32_t i = scheduledCommandCount++;
+        // insertion sort, stable so commands with equal times keep their posting order
+        while (i > 0 && scheduledCommands[i - 1].sampleTime > command.sampleTime) {
+            scheduledCommands[i] = scheduledCommands[i - 1];
+            i--;
+        }
+        scheduledCommands[i] = command;
+    }
+}
+
+void AKDSPBase::performDueCommands(AUEventSampleTime now) {
+    uint32_t due = 0;
+    while (due < scheduledCommandCount && scheduledCommands[due].sampleTime <= now) {
+        handleCommand(scheduledCommands[due]);
+        due++;
+    }
+    if (due > 0) {
+        scheduledCommandCount -= due;
+        memmove(scheduledCommands, scheduledCommands + due, scheduledCommandCount * sizeof(AKDSPCommand));
     }
 }
 
+AUEventSampleTime AKDSPBase::nextCommandTime() {
+    return scheduledCommandCount > 0 ? scheduledCommands[0].sampleTime : INT64_MAX;
+}
+
 /** From Apple Example code */
+void AKDSPBase::startRamp(AUParameterAddress address, AUValue value, AUAudioFrameCount duration) {
+    AKParameterRampBase *ramp = getRamp(address);
+    if (ramp) {
+        // the event loop has already split the buffer here, so the ramp starts on the event's sample
+        ramp->startRamp(value, duration);
+    } else {
+        setParameter(address, value, duration == 0);
+    }
+}
+
 void AKDSPBase::handleOneEvent(AURenderEvent const *event) {
     switch (event->head.eventType) {
         case AURenderEventParameter:
         case AURenderEventParameterRamp: {
-            // AUParameterEvent const& paramEvent = event->parameter;
-            // startRamp(paramEvent.parameterAddress, paramEvent.value, paramEvent.rampDurationSampleFrames);
+            AUParameterEvent const& paramEvent = event->parameter;
+            startRamp(paramEvent.parameterAddress, paramEvent.value, paramEvent.rampDurationSampleFrames);
             break;
         }
         case AURenderEventMIDI:
@@ -67,3 +266,25 @@ void AKDSPBase::performAllSimultaneousEvents(AUEventSampleTime now, AURenderEven
         // While event is not null and is simultaneous (or late).
     } while (event && event->head.eventSampleTime <= now);
 }
+
+void AKDSPBase::setInstrumentationEnabled(bool enabled) {
+    if (enabled && !instrumentation) {
+        instrumentation = new AKDSPInstrumentation();
+    }
+    instrumentationEnabled.store(enabled, std::memory_order_release);
+}
+
+bool AKDSPBase::getRenderStats(AKRenderStats &stats) {
+    if (!instrumentation) return false;
+    instrumentation->getStats(stats);
+    return true;
+}
+
+void AKDSPBase::resetRenderStats() {
+    if (instrumentation) instrumentation->requestReset();
+}
+
+void AKDSPBase::setDeadlineBudget(double fraction) {
+    if (!instrumentation) instrumentation = new AKDSPInstrumentation();
+    instrumentation->setDeadlineBudget(fraction);
+}
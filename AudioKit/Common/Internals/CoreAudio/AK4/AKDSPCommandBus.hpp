@@ -0,0 +1,146 @@
+//
+//  AKDSPCommandBus.hpp
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+#ifdef __cplusplus
+
+#import <AudioToolbox/AudioToolbox.h>
+#import <atomic>
+
+/// Sample time meaning "as soon as possible", i.e. at the start of the next render slice
+#define AKDSPCommandImmediate ((AUEventSampleTime)-1)
+
+typedef enum {
+    AKDSPCommandParameter,
+    AKDSPCommandNoteOn,
+    AKDSPCommandNoteOff,
+    AKDSPCommandSustainPedal,
+    AKDSPCommandAllNotesOff,
+    AKDSPCommandBufferSwap,
+} AKDSPCommandType;
+
+/**
+ A message from a control thread to the render thread. Small and trivially copyable,
+ so posting one is a handful of stores into preallocated memory.
+ */
+struct AKDSPCommand {
+    AKDSPCommandType type;
+    AUEventSampleTime sampleTime;   // render timeline, or AKDSPCommandImmediate
+
+    union {
+        struct {
+            AUParameterAddress address;
+            AUValue value;
+            bool immediate;
+        } parameter;
+
+        struct {
+            uint8_t noteNumber;
+            uint8_t velocity;
+            bool immediate;         // note off without release
+            float frequency;        // 0 to use the kernel's tuning
+        } note;
+
+        struct {
+            bool down;
+        } pedal;
+
+        struct {
+            uint32_t tag;           // which of the kernel's buffers to replace
+            void *buffer;
+        } buffer;
+    };
+};
+
+/**
+ Bounded multi-producer / single-consumer queue of AKDSPCommands.
+
+ All storage is allocated by the constructor. Any number of threads may post; only the
+ render thread may pop. Popping never blocks or spins: a command whose producer has been
+ preempted half way through posting is simply picked up on the next render slice.
+ Posting never blocks either, it fails (and counts a drop) when the queue is full.
+ Based on Dmitry Vyukov's bounded queue, with per-slot sequence numbers.
+ */
+class AKDSPCommandBus {
+
+public:
+
+    /// capacity is rounded up to a power of two
+    AKDSPCommandBus(uint32_t capacity = 256) {
+        size = 1;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        slots = new Slot[size];
+        for (uint32_t i = 0; i < size; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~AKDSPCommandBus() {
+        delete[] slots;
+    }
+
+    AKDSPCommandBus(const AKDSPCommandBus &) = delete;
+    AKDSPCommandBus &operator=(const AKDSPCommandBus &) = delete;
+
+    /// Any thread. Returns false, and counts a drop, if the render thread has fallen a full queue behind.
+    bool post(AKDSPCommand const &command) {
+        uint32_t position = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[position & mask];
+            uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+            int32_t difference = (int32_t)(sequence - position);
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.command = command;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Render thread only. Returns false when there is nothing (yet) to read.
+    bool pop(AKDSPCommand &command) {
+        Slot &slot = slots[tail & mask];
+        uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != tail + 1) {
+            return false;
+        }
+        command = slot.command;
+        slot.sequence.store(tail + size, std::memory_order_release);
+        tail++;
+        return true;
+    }
+
+    uint32_t capacity() const { return size; }
+
+    /// Number of commands rejected because the queue was full
+    uint32_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        AKDSPCommand command;
+    };
+
+    Slot *slots = nullptr;
+    uint32_t size = 0;
+    uint32_t mask = 0;
+    alignas(64) std::atomic<uint32_t> head{0};
+    alignas(64) uint32_t tail = 0;
+    std::atomic<uint32_t> droppedCount{0};
+};
+
+#endif
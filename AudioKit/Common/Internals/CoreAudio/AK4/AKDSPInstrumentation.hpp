@@ -0,0 +1,127 @@
+//
+//  AKDSPInstrumentation.hpp
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+#ifdef __cplusplus
+
+#import <AudioToolbox/AudioToolbox.h>
+#import <atomic>
+#import <cstring>
+#import "AKRenderStats.h"
+
+#ifdef __APPLE__
+#import <mach/mach_time.h>
+#else
+#import <chrono>
+#endif
+
+/**
+ Render timing for one kernel. The render thread is the only writer and never waits; readers on
+ any thread take a consistent copy with a sequence lock, retrying if a render finished meanwhile.
+ */
+class AKDSPInstrumentation {
+public:
+
+    AKDSPInstrumentation() {
+#ifdef __APPLE__
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        nanosecondsPerTick = (double)timebase.numer / (double)timebase.denom;
+#endif
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    /// The finest clock available: mach_absolute_time on Apple platforms
+    uint64_t now() {
+#ifdef __APPLE__
+        return mach_absolute_time();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /// Fraction of each buffer's duration this kernel may take before a render counts as a deadline miss
+    void setDeadlineBudget(double fraction) { deadlineBudget = fraction; }
+
+    /// Any thread. Takes effect at the next render.
+    void requestReset() { resetRequested = true; }
+
+    /// Render thread
+    void recordRender(uint64_t startTicks, uint64_t endTicks, AUAudioFrameCount frameCount, double sampleRate) {
+        if (resetRequested.exchange(false)) {
+            beginWrite();
+            memset(&stats, 0, sizeof(stats));
+            endWrite();
+        }
+        if (frameCount == 0 || sampleRate <= 0) return;
+
+        uint64_t nanoseconds = (uint64_t)((endTicks - startTicks) * nanosecondsPerTick);
+        double deadline = 1.0e9 * frameCount / sampleRate;
+        double load = nanoseconds / deadline;
+        int bin = (int)(load * 8.0);
+        if (bin >= AKRenderStatsHistogramBinCount) bin = AKRenderStatsHistogramBinCount - 1;
+
+        beginWrite();
+        stats.renderCount++;
+        stats.lastNanoseconds = nanoseconds;
+        if (nanoseconds > stats.maximumNanoseconds) stats.maximumNanoseconds = nanoseconds;
+        stats.lastLoad = load;
+        if (load > stats.maximumLoad) stats.maximumLoad = load;
+        stats.averageLoad += (load - stats.averageLoad) / stats.renderCount;
+        stats.loadHistogram[bin]++;
+        if (load > deadlineBudget) stats.deadlineMisses++;
+        endWrite();
+    }
+
+    /// Render thread, from AKRealtimeSafetyReport
+    void recordViolation(AKRealtimeViolation kind, const char *where) {
+        beginWrite();
+        stats.violations[kind]++;
+        stats.lastViolation = where;
+        endWrite();
+    }
+
+    /// Render thread, from AKDenormalCheckingReport
+    void recordDenormals(uint64_t sampleCount) {
+        beginWrite();
+        stats.denormalRenders++;
+        stats.denormalSamples += sampleCount;
+        endWrite();
+    }
+
+    /// Any thread. Never blocks the render thread.
+    void getStats(AKRenderStats &copy) {
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            memcpy(&copy, &stats, sizeof(copy));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+    }
+
+private:
+
+    void beginWrite() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void endWrite() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    AKRenderStats stats;
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<bool> resetRequested{false};
+    double nanosecondsPerTick = 1.0;
+    std::atomic<double> deadlineBudget{1.0};
+};
+
+#endif
@@ -32,6 +32,7 @@
 
 // Convolution and Phase-Locked Vocoder
 - (void)setupAudioFileTable:(float *)data size:(UInt32)size;
+- (void)setupAudioFileTable:(float *)data size:(UInt32)size channelCount:(UInt32)channelCount;
 - (void)setPartitionLength:(int)partitionLength;
 - (void)initConvolutionEngine;
 
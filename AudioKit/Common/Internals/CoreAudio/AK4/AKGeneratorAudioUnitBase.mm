@@ -34,6 +34,9 @@
 - (void)setupAudioFileTable:(float *)data size:(UInt32)size {
     ((AKDSPBase *)self.dsp)->setUpTable(data, size);
 }
+- (void)setupAudioFileTable:(float *)data size:(UInt32)size channelCount:(UInt32)channelCount {
+    ((AKDSPBase *)self.dsp)->setUpMultichannelTable(data, size, channelCount);
+}
 - (void)setPartitionLength:(int)partitionLength {
     ((AKDSPBase *)self.dsp)->setPartitionLength(partitionLength);
 }
@@ -0,0 +1,594 @@
+//
+//  AKRenderGraph.cpp
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#include "AKRenderGraph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#else
+#include <semaphore.h>
+#endif
+
+void AKRenderGraphMixer::render(AudioBufferList *in, AudioBufferList *out,
+                                AudioTimeStamp const *timestamp, uint32_t frameCount) {
+    if (!in || in == out) return;
+    for (UInt32 channel = 0; channel < out->mNumberBuffers; ++channel) {
+        memcpy(out->mBuffers[channel].mData, in->mBuffers[channel].mData, frameCount * sizeof(float));
+    }
+}
+
+namespace {
+
+/// Wakes one waiting thread per signal. Signalling never blocks, so the render thread may do it.
+class WorkerSemaphore {
+public:
+#ifdef __APPLE__
+    WorkerSemaphore() { semaphore = dispatch_semaphore_create(0); }
+    void signal() { dispatch_semaphore_signal(semaphore); }
+    void wait() { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+private:
+    dispatch_semaphore_t semaphore;
+#else
+    WorkerSemaphore() { sem_init(&semaphore, 0, 0); }
+    ~WorkerSemaphore() { sem_destroy(&semaphore); }
+    void signal() { sem_post(&semaphore); }
+    void wait() { while (sem_wait(&semaphore) != 0) {} }
+private:
+    sem_t semaphore;
+#endif
+};
+
+/**
+ Chase-Lev work-stealing deque of step indices, with fixed capacity. The owning thread pushes
+ and pops at the bottom; any other thread steals from the top. Reset only while no thread uses it.
+ */
+class StealDeque {
+public:
+    StealDeque(int capacity) {
+        size = 1;
+        while (size < capacity) size <<= 1;
+        items.reset(new std::atomic<int>[size]);
+    }
+
+    void reset() {
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+    }
+
+    void push(int item) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        items[b & (size - 1)].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    bool pop(int &item) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = items[b & (size - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // last item: race the thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool steal(int &item) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        item = items[t & (size - 1)].load(std::memory_order_relaxed);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<std::atomic<int>[]> items;
+    int64_t size;
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+};
+
+/**
+ On Apple platforms, gives the calling thread the time constraint policy the render thread has,
+ over a period of periodFrames. The graph doesn't know its sample rate, so the period is taken at
+ 44.1 kHz. Elsewhere the thread gets SCHED_FIFO, which needs privileges on Linux. Either is
+ ignored if refused.
+ */
+void promoteToRealTime(uint32_t periodFrames) {
+#ifdef __APPLE__
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    uint32_t period = (uint32_t)(1e9 * periodFrames / 44100.0 * timebase.denom / timebase.numer);
+    thread_time_constraint_policy_data_t policy;
+    policy.period = period;
+    policy.computation = period / 2;
+    policy.constraint = period;
+    policy.preemptible = true;
+    thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY,
+                      (thread_policy_t)&policy, THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+#else
+    sched_param parameters;
+    parameters.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+#endif
+}
+
+typedef std::vector<uint64_t> NodeSet;
+
+void addToSet(NodeSet &set, int node) { set[node / 64] |= uint64_t(1) << (node % 64); }
+
+/// Whether every member of set, other than except, is in superset
+bool isSubset(NodeSet const &set, NodeSet const &superset, int except) {
+    for (size_t i = 0; i < set.size(); ++i) {
+        uint64_t word = set[i];
+        if (except >= 0 && (size_t)except / 64 == i) word &= ~(uint64_t(1) << (except % 64));
+        if (word & ~superset[i]) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+struct AKRenderGraph::InternalData {
+
+    struct Node {
+        std::unique_ptr<AKRenderGraphProcessor> processor;
+        bool inPlace = false;
+        std::vector<NodeID> inputs;
+
+        std::atomic<uint64_t> lastNanoseconds{0};
+        std::atomic<uint64_t> maximumNanoseconds{0};
+        std::atomic<uint64_t> totalNanoseconds{0};
+        std::atomic<uint64_t> renderCount{0};
+    };
+
+    struct Step {
+        Node *node;
+        std::vector<int> inputs;        // buffers of the nodes feeding this one
+        int target = -1;                // buffer the inputs are summed into, or -1 to read the only input directly
+        int output = -1;
+        std::vector<int> successors;    // steps to release when this one completes
+    };
+
+    /// Everything the render thread needs, built by compile and never changed afterwards
+    struct Plan {
+        std::vector<Step> steps;        // in topological order
+        std::vector<int> sources;       // steps without inputs
+        std::vector<AudioBufferList *> buffers;
+        std::vector<float> samples;
+        int outputBuffer = -1;
+
+        std::unique_ptr<std::atomic<int>[]> pendingInputs;
+        std::vector<std::unique_ptr<StealDeque>> deques;    // render thread first, then the workers
+        std::atomic<int> completedSteps{0};
+
+        ~Plan() {
+            for (auto buffer : buffers) free(buffer);
+        }
+    };
+
+    /// Single-producer / single-consumer ring of plans the render thread has replaced, for a control thread to free
+    class RetiredPlans {
+    public:
+        bool push(Plan *plan) {
+            uint32_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) == kCapacity) return false;
+            slots[h % kCapacity] = plan;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(Plan *&plan) {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) return false;
+            plan = slots[t % kCapacity];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        static const uint32_t kCapacity = 16;
+        Plan *slots[kCapacity];
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint32_t> tail{0};
+    };
+
+    int channelCount;
+    uint32_t maximumFrameCount;
+    std::vector<std::unique_ptr<Node>> nodes;
+    NodeID outputNode = -1;
+    std::atomic<int> bufferCount{0};
+
+    // The newest plan waits in pendingPlan, replacing any the render thread hasn't taken yet. The ones
+    // it replaces on the render thread come back through retiredPlans, to be freed by the next compile
+    // or the destructor; the render thread takes at most one plan per compile, so the ring never fills.
+    Plan *activePlan = nullptr;     // render thread only
+    std::atomic<Plan *> pendingPlan{nullptr};
+    RetiredPlans retiredPlans;
+
+    // Worker pool
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerSemaphore>> wakeups;
+    WorkerSemaphore passFinished;   // signalled by each worker as it leaves a pass
+    std::atomic<bool> running{true};
+    Plan *renderPlan = nullptr;
+    AudioTimeStamp const *renderTimestamp = nullptr;
+    uint32_t renderFrameCount = 0;
+
+    void runStep(Plan &plan, int stepIndex, AudioTimeStamp const *timestamp, uint32_t frameCount) {
+        Step &step = plan.steps[stepIndex];
+        AudioBufferList *out = plan.buffers[step.output];
+        AudioBufferList *in = nullptr;
+
+        if (step.inputs.empty()) {
+            for (int channel = 0; channel < channelCount; ++channel) {
+                memset(out->mBuffers[channel].mData, 0, frameCount * sizeof(float));
+            }
+        } else if (step.target < 0) {
+            in = plan.buffers[step.inputs[0]];
+        } else {
+            in = plan.buffers[step.target];
+            for (size_t i = 0; i < step.inputs.size(); ++i) {
+                if (step.inputs[i] == step.target) continue;
+                for (int channel = 0; channel < channelCount; ++channel) {
+                    float *sum = (float *)in->mBuffers[channel].mData;
+                    float const *source = (float const *)plan.buffers[step.inputs[i]]->mBuffers[channel].mData;
+                    bool first = i == 0;
+                    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+                        sum[frame] = first ? source[frame] : sum[frame] + source[frame];
+                    }
+                }
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        step.node->processor->render(in, out, timestamp, frameCount);
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        Node &node = *step.node;
+        node.lastNanoseconds.store(elapsed, std::memory_order_relaxed);
+        node.totalNanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        node.renderCount.fetch_add(1, std::memory_order_relaxed);
+        uint64_t maximum = node.maximumNanoseconds.load(std::memory_order_relaxed);
+        while (elapsed > maximum &&
+               !node.maximumNanoseconds.compare_exchange_weak(maximum, elapsed, std::memory_order_relaxed)) {}
+    }
+
+    /// Runs ready steps, stealing when out of local work, until the whole plan has completed
+    void work(Plan &plan, int threadIndex, AudioTimeStamp const *timestamp, uint32_t frameCount) {
+        int const stepCount = (int)plan.steps.size();
+        int const threadCount = (int)plan.deques.size();
+        StealDeque &own = *plan.deques[threadIndex];
+
+        while (plan.completedSteps.load(std::memory_order_acquire) < stepCount) {
+            int stepIndex;
+            bool found = own.pop(stepIndex);
+            for (int i = 1; !found && i < threadCount; ++i) {
+                found = plan.deques[(threadIndex + i) % threadCount]->steal(stepIndex);
+            }
+            if (!found) {
+                std::this_thread::yield();
+                continue;
+            }
+            runStep(plan, stepIndex, timestamp, frameCount);
+            for (int successor : plan.steps[stepIndex].successors) {
+                if (plan.pendingInputs[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    own.push(successor);
+                }
+            }
+            plan.completedSteps.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+
+    void workerLoop(int threadIndex) {
+        promoteToRealTime(maximumFrameCount);
+        while (true) {
+            wakeups[threadIndex - 1]->wait();
+            if (!running) return;
+            // Woken once per pass; a worker that wakes after the other threads finished returns at once
+            work(*renderPlan, threadIndex, renderTimestamp, renderFrameCount);
+            passFinished.signal();
+        }
+    }
+
+    /// Renders one pass of at most maximumFrameCount frames into output, starting at offset
+    void renderPass(Plan &plan, AudioTimeStamp const *timestamp, uint32_t frameCount,
+                    AudioBufferList *output, uint32_t offset) {
+        for (auto buffer : plan.buffers) {
+            for (int channel = 0; channel < channelCount; ++channel) {
+                buffer->mBuffers[channel].mDataByteSize = frameCount * sizeof(float);
+            }
+        }
+
+        if (workers.empty() || plan.steps.size() < 2) {
+            for (size_t i = 0; i < plan.steps.size(); ++i) {
+                runStep(plan, (int)i, timestamp, frameCount);
+            }
+        } else {
+            for (size_t i = 0; i < plan.steps.size(); ++i) {
+                plan.pendingInputs[i].store((int)plan.steps[i].inputs.size(), std::memory_order_relaxed);
+            }
+            for (auto &deque : plan.deques) deque->reset();
+            for (int source : plan.sources) plan.deques[0]->push(source);
+            plan.completedSteps.store(0);
+
+            renderPlan = &plan;
+            renderTimestamp = timestamp;
+            renderFrameCount = frameCount;
+            for (auto &wakeup : wakeups) wakeup->signal();
+
+            work(plan, 0, timestamp, frameCount);
+
+            // Nothing may touch the plan's render state once the next pass starts resetting it. Every
+            // step has completed, so each worker is at most finishing its bookkeeping for the last one.
+            for (size_t i = 0; i < workers.size(); ++i) {
+                passFinished.wait();
+            }
+        }
+
+        AudioBufferList *result = plan.buffers[plan.outputBuffer];
+        for (UInt32 channel = 0; channel < output->mNumberBuffers; ++channel) {
+            UInt32 source = std::min(channel, (UInt32)channelCount - 1);
+            memcpy((float *)output->mBuffers[channel].mData + offset, result->mBuffers[source].mData,
+                   frameCount * sizeof(float));
+        }
+    }
+
+    Plan *buildPlan();
+
+    /// Control thread
+    void collectRetiredPlans() {
+        Plan *plan;
+        while (retiredPlans.pop(plan)) delete plan;
+    }
+};
+
+AKRenderGraph::AKRenderGraph(int channelCount, uint32_t maximumFrameCount, int workerCount)
+: data(new InternalData) {
+    data->channelCount = channelCount;
+    data->maximumFrameCount = maximumFrameCount;
+    for (int i = 0; i < workerCount; ++i) {
+        data->wakeups.emplace_back(new WorkerSemaphore());
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        InternalData *internal = data.get();
+        data->workers.emplace_back([internal, i] { internal->workerLoop(i + 1); });
+    }
+}
+
+AKRenderGraph::~AKRenderGraph() {
+    data->running = false;
+    for (auto &wakeup : data->wakeups) wakeup->signal();
+    for (auto &worker : data->workers) worker.join();
+    delete data->activePlan;
+    delete data->pendingPlan.exchange(nullptr);
+    data->collectRetiredPlans();
+}
+
+AKRenderGraph::NodeID AKRenderGraph::addNode(AKRenderGraphProcessor *processor, bool inPlace) {
+    InternalData::Node *node = new InternalData::Node();
+    node->processor.reset(processor);
+    node->inPlace = inPlace;
+    data->nodes.emplace_back(node);
+    return (NodeID)data->nodes.size() - 1;
+}
+
+void AKRenderGraph::connect(NodeID source, NodeID destination) {
+    auto &inputs = data->nodes[destination]->inputs;
+    if (std::find(inputs.begin(), inputs.end(), source) == inputs.end()) {
+        inputs.push_back(source);
+    }
+}
+
+void AKRenderGraph::disconnect(NodeID source, NodeID destination) {
+    auto &inputs = data->nodes[destination]->inputs;
+    inputs.erase(std::remove(inputs.begin(), inputs.end(), source), inputs.end());
+}
+
+void AKRenderGraph::setOutputNode(NodeID node) {
+    data->outputNode = node;
+}
+
+AKRenderGraph::InternalData::Plan *AKRenderGraph::InternalData::buildPlan() {
+    int const nodeCount = (int)nodes.size();
+    int const words = (nodeCount + 63) / 64;
+
+    std::vector<std::vector<int>> consumers(nodeCount);
+    std::vector<int> unsortedInputs(nodeCount);
+    for (int node = 0; node < nodeCount; ++node) {
+        unsortedInputs[node] = (int)nodes[node]->inputs.size();
+        for (NodeID input : nodes[node]->inputs) consumers[input].push_back(node);
+    }
+
+    // Kahn's algorithm
+    std::vector<int> order;
+    for (int node = 0; node < nodeCount; ++node) {
+        if (unsortedInputs[node] == 0) order.push_back(node);
+    }
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (int consumer : consumers[order[i]]) {
+            if (--unsortedInputs[consumer] == 0) order.push_back(consumer);
+        }
+    }
+    if ((int)order.size() != nodeCount) return nullptr;
+
+    // A buffer may be reused by a node once every node that touches it is one of that node's
+    // ancestors: those are certain to have finished, whichever threads run them.
+    std::vector<NodeSet> ancestors(nodeCount, NodeSet(words, 0));
+    for (int node : order) {
+        for (NodeID input : nodes[node]->inputs) {
+            for (int w = 0; w < words; ++w) ancestors[node][w] |= ancestors[input][w];
+            addToSet(ancestors[node], input);
+        }
+    }
+
+    std::vector<NodeSet> bufferUsers;
+    std::vector<bool> bufferPinned;
+    std::vector<int> outputOf(nodeCount, -1);
+
+    auto freeBufferFor = [&](int node) {
+        for (size_t b = 0; b < bufferUsers.size(); ++b) {
+            if (!bufferPinned[b] && isSubset(bufferUsers[b], ancestors[node], -1)) return (int)b;
+        }
+        bufferUsers.push_back(NodeSet(words, 0));
+        bufferPinned.push_back(false);
+        return (int)bufferUsers.size() - 1;
+    };
+
+    Plan *plan = new Plan();
+    std::vector<int> stepOf(nodeCount);
+    for (int node : order) {
+        stepOf[node] = (int)plan->steps.size();
+        plan->steps.emplace_back();
+        Step &step = plan->steps.back();
+        step.node = nodes[node].get();
+
+        // An input whose only other users have already finished can be summed or rendered over
+        int reusableInput = -1;
+        for (NodeID input : nodes[node]->inputs) {
+            int buffer = outputOf[input];
+            step.inputs.push_back(buffer);
+            if (reusableInput < 0 && !bufferPinned[buffer] &&
+                isSubset(bufferUsers[buffer], ancestors[node], node)) {
+                reusableInput = buffer;
+            }
+        }
+        if (reusableInput >= 0) {
+            // sum into it starting from its own contents
+            auto position = std::find(step.inputs.begin(), step.inputs.end(), reusableInput);
+            std::iter_swap(step.inputs.begin(), position);
+        }
+
+        if (nodes[node]->inPlace) {
+            if (!step.inputs.empty()) {
+                step.target = reusableInput >= 0 ? reusableInput : freeBufferFor(node);
+                addToSet(bufferUsers[step.target], node);
+                step.output = step.target;
+            }
+        } else if (step.inputs.size() > 1) {
+            step.target = reusableInput >= 0 ? reusableInput : freeBufferFor(node);
+            addToSet(bufferUsers[step.target], node);
+        }
+        if (step.output < 0) {
+            step.output = freeBufferFor(node);
+        }
+        addToSet(bufferUsers[step.output], node);
+        for (int consumer : consumers[node]) addToSet(bufferUsers[step.output], consumer);
+        if (node == outputNode) bufferPinned[step.output] = true;
+        outputOf[node] = step.output;
+    }
+
+    for (int node : order) {
+        Step &step = plan->steps[stepOf[node]];
+        for (int consumer : consumers[node]) step.successors.push_back(stepOf[consumer]);
+        if (step.inputs.empty()) plan->sources.push_back(stepOf[node]);
+    }
+    plan->outputBuffer = outputNode >= 0 && outputNode < nodeCount ? outputOf[outputNode] : -1;
+
+    // All the memory the render thread will touch
+    size_t const bufferSamples = (size_t)channelCount * maximumFrameCount;
+    plan->samples.assign(bufferUsers.size() * bufferSamples, 0.0f);
+    for (size_t b = 0; b < bufferUsers.size(); ++b) {
+        AudioBufferList *list = (AudioBufferList *)malloc(sizeof(AudioBufferList) +
+                                                          (channelCount - 1) * sizeof(AudioBuffer));
+        list->mNumberBuffers = channelCount;
+        for (int channel = 0; channel < channelCount; ++channel) {
+            list->mBuffers[channel].mNumberChannels = 1;
+            list->mBuffers[channel].mDataByteSize = maximumFrameCount * sizeof(float);
+            list->mBuffers[channel].mData = &plan->samples[b * bufferSamples + channel * maximumFrameCount];
+        }
+        plan->buffers.push_back(list);
+    }
+    plan->pendingInputs.reset(new std::atomic<int>[plan->steps.size()]);
+    for (size_t i = 0; i <= workers.size(); ++i) {
+        plan->deques.emplace_back(new StealDeque((int)plan->steps.size()));
+    }
+    return plan;
+}
+
+bool AKRenderGraph::compile() {
+    InternalData::Plan *plan = data->buildPlan();
+    if (!plan) return false;
+    data->bufferCount = (int)plan->buffers.size();
+    data->collectRetiredPlans();
+    // a plan still pending was never seen by the render thread, so it can be freed here
+    delete data->pendingPlan.exchange(plan, std::memory_order_acq_rel);
+    return true;
+}
+
+void AKRenderGraph::render(AudioTimeStamp const *timestamp, uint32_t frameCount, AudioBufferList *output) {
+    InternalData &d = *data;
+
+    // Adopt the newest compiled plan
+    if (d.pendingPlan.load(std::memory_order_relaxed) != nullptr) {
+        InternalData::Plan *fresh = d.pendingPlan.exchange(nullptr, std::memory_order_acq_rel);
+        if (d.activePlan) d.retiredPlans.push(d.activePlan);
+        d.activePlan = fresh;
+    }
+
+    InternalData::Plan *plan = d.activePlan;
+    if (!plan || plan->outputBuffer < 0) {
+        for (UInt32 channel = 0; channel < output->mNumberBuffers; ++channel) {
+            memset(output->mBuffers[channel].mData, 0, frameCount * sizeof(float));
+        }
+        return;
+    }
+
+    // The plan's buffers hold maximumFrameCount frames, so longer renders take several passes
+    AudioTimeStamp passTimestamp = *timestamp;
+    for (uint32_t offset = 0; offset < frameCount;) {
+        uint32_t passFrameCount = std::min(frameCount - offset, d.maximumFrameCount);
+        d.renderPass(*plan, &passTimestamp, passFrameCount, output, offset);
+        offset += passFrameCount;
+        passTimestamp.mSampleTime += passFrameCount;
+    }
+}
+
+int AKRenderGraph::getBufferCount() {
+    return data->bufferCount;
+}
+
+AKRenderGraph::NodeTiming AKRenderGraph::getTiming(NodeID node) {
+    InternalData::Node &n = *data->nodes[node];
+    NodeTiming timing;
+    timing.lastNanoseconds = n.lastNanoseconds.load(std::memory_order_relaxed);
+    timing.maximumNanoseconds = n.maximumNanoseconds.load(std::memory_order_relaxed);
+    timing.totalNanoseconds = n.totalNanoseconds.load(std::memory_order_relaxed);
+    timing.renderCount = n.renderCount.load(std::memory_order_relaxed);
+    return timing;
+}
+
+void AKRenderGraph::resetTimings() {
+    for (auto &node : data->nodes) {
+        node->lastNanoseconds = 0;
+        node->maximumNanoseconds = 0;
+        node->totalNanoseconds = 0;
+        node->renderCount = 0;
+    }
+}
@@ -0,0 +1,124 @@
+//
+//  AKRenderGraph.hpp
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+#ifdef __cplusplus
+
+#include <cstdint>
+#include <memory>
+
+#ifdef __APPLE__
+#include <CoreAudio/CoreAudioTypes.h>
+#else
+// Where CoreAudio is missing, the parts of its plain types that the graph and its processors use
+typedef uint32_t UInt32;
+typedef uint64_t UInt64;
+
+struct AudioBuffer {
+    UInt32 mNumberChannels;
+    UInt32 mDataByteSize;
+    void *mData;
+};
+
+struct AudioBufferList {
+    UInt32 mNumberBuffers;
+    AudioBuffer mBuffers[1];
+};
+
+struct AudioTimeStamp {
+    double mSampleTime;
+    UInt64 mHostTime;
+    double mRateScalar;
+    UInt64 mWordClockTime;
+    UInt32 mFlags;
+};
+#endif
+
+/**
+ One node's worth of rendering. All buffers are non-interleaved float with the graph's channel count.
+ in is nullptr for nodes without inputs, whose out is cleared first. When the node was added in-place,
+ in and out are the same list.
+ */
+class AKRenderGraphProcessor {
+public:
+    virtual ~AKRenderGraphProcessor() {}
+    virtual void render(AudioBufferList *in, AudioBufferList *out,
+                        AudioTimeStamp const *timestamp, uint32_t frameCount) = 0;
+};
+
+/// Sums its inputs and passes them on; add it in-place so the sum costs no copy
+class AKRenderGraphMixer : public AKRenderGraphProcessor {
+public:
+    void render(AudioBufferList *in, AudioBufferList *out,
+                AudioTimeStamp const *timestamp, uint32_t frameCount) override;
+};
+
+/**
+ Renders a graph of kernels without AVAudioEngine.
+
+ Build the graph on a control thread with addNode and connect, then call compile. Compiling
+ sorts the nodes, assigns every node's output to a buffer from a pool that is reused once all
+ of its readers are guaranteed to have finished, and publishes the result to the render thread
+ without locking. Until the next compile, render allocates nothing and takes no locks.
+
+ A node's inputs are summed before it runs. Nodes added as in-place render over their input,
+ which they take over whenever they are its only reader.
+
+ Branches that do not depend on each other run in parallel: the render thread and workerCount
+ real-time worker threads each keep a deque of ready nodes, and idle threads steal from the others.
+ With workerCount 0 everything runs on the render thread, in topological order.
+
+ Nodes live as long as the graph. Only CoreAudio's plain types are used here, declared above where
+ CoreAudio is missing, so the graph builds on its own for other platforms; the adapters for AudioKit's
+ kernels are in AKRenderGraphAdapters.hpp.
+ */
+class AKRenderGraph {
+public:
+    typedef int NodeID;
+
+    struct NodeTiming {
+        uint64_t lastNanoseconds;
+        uint64_t maximumNanoseconds;
+        uint64_t totalNanoseconds;
+        uint64_t renderCount;
+    };
+
+    AKRenderGraph(int channelCount, uint32_t maximumFrameCount, int workerCount = 0);
+    ~AKRenderGraph();
+
+    AKRenderGraph(const AKRenderGraph &) = delete;
+    AKRenderGraph &operator=(const AKRenderGraph &) = delete;
+
+    /// Control thread. The graph owns the processor.
+    NodeID addNode(AKRenderGraphProcessor *processor, bool inPlace = false);
+
+    /// Control thread. Changes take effect at the next compile.
+    void connect(NodeID source, NodeID destination);
+    void disconnect(NodeID source, NodeID destination);
+    void setOutputNode(NodeID node);
+
+    /// Control thread. Returns false, leaving the current plan in place, if the graph has a cycle.
+    bool compile();
+
+    /// Render thread. Renders the output node into output, or silence if there is none. Frame counts
+    /// above maximumFrameCount are rendered in several passes.
+    void render(AudioTimeStamp const *timestamp, uint32_t frameCount, AudioBufferList *output);
+
+    /// Number of distinct buffers the current plan uses
+    int getBufferCount();
+
+    /// Any thread. Measured around each node's render call.
+    NodeTiming getTiming(NodeID node);
+    void resetTimings();
+
+private:
+    struct InternalData;
+    std::unique_ptr<InternalData> data;
+};
+
+#endif
@@ -0,0 +1,69 @@
+//
+//  AKRenderGraphAdapters.hpp
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+#ifdef __cplusplus
+
+#import <type_traits>
+
+#import "AKRenderGraph.hpp"
+#import "AKDSPBase.hpp"
+#import "AKDSPKernel.hpp"
+
+/// Hosts an AKDSPBase (or AKSoundpipeDSPBase) kernel. The graph does not own the kernel.
+class AKDSPBaseRenderGraphProcessor : public AKRenderGraphProcessor {
+public:
+    AKDSPBaseRenderGraphProcessor(AKDSPBase *dsp) : dsp(dsp) {}
+
+    void render(AudioBufferList *in, AudioBufferList *out,
+                AudioTimeStamp const *timestamp, AUAudioFrameCount frameCount) override {
+        // A node without inputs gets a silent output buffer, so effects can read it as their input
+        dsp->setBuffers(in ? in : out, out);
+        dsp->processWithEvents(timestamp, frameCount, nullptr);
+    }
+
+private:
+    AKDSPBase *dsp;
+};
+
+/// Hosts a DSPKernel subclass (AKDSPKernel, AKSoundpipeKernel, AKBankDSPKernel...) that is AKBuffered
+/// or AKOutputBuffered. The graph does not own the kernel.
+template <typename Kernel>
+class AKDSPKernelRenderGraphProcessor : public AKRenderGraphProcessor {
+public:
+    AKDSPKernelRenderGraphProcessor(Kernel *kernel) : kernel(kernel) {}
+
+    void render(AudioBufferList *in, AudioBufferList *out,
+                AudioTimeStamp const *timestamp, AUAudioFrameCount frameCount) override {
+        setBuffers(in, out, std::is_base_of<AKBuffered, Kernel>());
+        kernel->processWithEvents(timestamp, frameCount, nullptr);
+    }
+
+private:
+    void setBuffers(AudioBufferList *in, AudioBufferList *out, std::true_type) {
+        kernel->setBuffers(in ? in : out, out);
+    }
+    void setBuffers(AudioBufferList *in, AudioBufferList *out, std::false_type) {
+        kernel->setBuffer(out);
+    }
+
+    Kernel *kernel;
+};
+
+/// Control thread. Adds an AKDSPBase kernel to graph; see AKRenderGraph::addNode.
+inline AKRenderGraph::NodeID AKRenderGraphAddDSP(AKRenderGraph &graph, AKDSPBase *dsp, bool inPlace = false) {
+    return graph.addNode(new AKDSPBaseRenderGraphProcessor(dsp), inPlace);
+}
+
+/// Control thread. Adds a DSPKernel subclass to graph; see AKRenderGraph::addNode.
+template <typename Kernel>
+AKRenderGraph::NodeID AKRenderGraphAddKernel(AKRenderGraph &graph, Kernel *kernel, bool inPlace = false) {
+    return graph.addNode(new AKDSPKernelRenderGraphProcessor<Kernel>(kernel), inPlace);
+}
+
+#endif
@@ -0,0 +1,91 @@
+//
+//  AKRenderStats.h
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+
+#import <stdbool.h>
+#import <stdint.h>
+#import "AKInterop.h"
+
+/// Histogram bins, each an eighth of the buffer's duration; the last one also counts everything slower
+#define AKRenderStatsHistogramBinCount 16
+
+/// Things that must not happen on the render thread
+typedef AK_ENUM(AKRealtimeViolation) {
+    AKRealtimeViolationAllocation,
+    AKRealtimeViolationDeallocation,
+    AKRealtimeViolationLock,
+    AKRealtimeViolationFileIO,
+    AKRealtimeViolationCount
+} AKRealtimeViolation;
+
+/// Render timing of one kernel. Loads are fractions of the buffer's duration at the kernel's sample rate.
+typedef struct {
+    uint64_t renderCount;
+    uint64_t deadlineMisses;            // renders slower than the kernel's share of the buffer
+    uint64_t lastNanoseconds;
+    uint64_t maximumNanoseconds;
+    double lastLoad;
+    double maximumLoad;
+    double averageLoad;
+    uint64_t loadHistogram[AKRenderStatsHistogramBinCount];
+    uint64_t violations[AKRealtimeViolationCount];
+    const char *lastViolation;          // static description of the most recent violation, or NULL
+    uint64_t denormalRenders;           // renders whose output held subnormal samples, while checking them
+    uint64_t denormalSamples;
+} AKRenderStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ Debug mode. While enabled, allocations and deallocations in the default malloc zone are checked,
+ and any made on a thread that is inside a kernel's render call are counted as violations, against
+ the kernel and globally. Annotated locks and file I/O (AK_REALTIME_UNSAFE) are counted the same way.
+ Meant for development: it patches the malloc zone, and costs a thread-local read per allocation.
+ */
+void AKRealtimeSafetySetCheckingEnabled(bool enabled);
+bool AKRealtimeSafetyIsCheckingEnabled(void);
+
+/// Brackets a render call; the context is what violations are attributed to. Not nestable.
+void AKRealtimeSafetyEnterRenderContext(void *context);
+void AKRealtimeSafetyLeaveRenderContext(void);
+bool AKRealtimeSafetyIsInRenderContext(void);
+
+/// Counts a violation if the calling thread is rendering. where must be a static string.
+void AKRealtimeSafetyReport(AKRealtimeViolation kind, const char *where);
+
+/// Violations across all kernels since the process started
+uint64_t AKRealtimeSafetyGetViolationCount(AKRealtimeViolation kind);
+
+/**
+ Debug mode. Kernels normally render with subnormal numbers flushed to zero. While this is enabled they
+ don't, and each render's output is scanned for subnormal samples, which are counted against the kernel
+ (in its AKRenderStats, if instrumentation is enabled for it) and globally. Costs a pass over every output.
+ */
+void AKDenormalCheckingSetEnabled(bool enabled);
+bool AKDenormalCheckingIsEnabled(void);
+
+/// Renders, across all kernels, whose output held subnormal samples while checking was enabled
+uint64_t AKDenormalCheckingGetRenderCount(void);
+
+/// Render thread: counts a render whose output held subnormal samples, against the context (the kernel's
+/// instrumentation, or NULL) and globally
+void AKDenormalCheckingReport(void *context, uint64_t sampleCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+/// Marks code that must not run on the render thread. Compiled out of release builds.
+#ifdef DEBUG
+#define AK_REALTIME_UNSAFE(kind, where) AKRealtimeSafetyReport(kind, where)
+#else
+#define AK_REALTIME_UNSAFE(kind, where) do {} while (0)
+#endif
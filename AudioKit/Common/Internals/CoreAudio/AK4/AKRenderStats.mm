@@ -0,0 +1,159 @@
+//
+//  AKRenderStats.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import "AKRenderStats.h"
+#import "AKDSPInstrumentation.hpp"
+
+#import <atomic>
+#import <pthread.h>
+
+#ifdef __APPLE__
+#import <malloc/malloc.h>
+#import <mach/mach.h>
+#endif
+
+// Per-thread render state lives in pthread keys rather than thread_local variables: Darwin sets up
+// thread_local storage lazily, with malloc, so reading one from inside the malloc hooks could recurse.
+// The keys are created before the hooks are installed, and reading them never allocates.
+static pthread_key_t renderContextKey;     // the AKDSPInstrumentation, or nullptr
+static pthread_key_t inRenderContextKey;   // non-null while rendering
+static pthread_once_t renderContextKeysOnce = PTHREAD_ONCE_INIT;
+
+static void createRenderContextKeys() {
+    pthread_key_create(&renderContextKey, nullptr);
+    pthread_key_create(&inRenderContextKey, nullptr);
+}
+
+static void ensureRenderContextKeys() {
+    pthread_once(&renderContextKeysOnce, createRenderContextKeys);
+}
+
+static std::atomic<uint64_t> violationCounts[AKRealtimeViolationCount];
+static std::atomic<bool> checkingEnabled{false};
+static std::atomic<bool> denormalCheckingEnabled{false};
+static std::atomic<uint64_t> denormalRenderCount{0};
+
+void AKRealtimeSafetyEnterRenderContext(void *context) {
+    ensureRenderContextKeys();
+    pthread_setspecific(renderContextKey, context);
+    pthread_setspecific(inRenderContextKey, (void *)1);
+}
+
+void AKRealtimeSafetyLeaveRenderContext(void) {
+    ensureRenderContextKeys();
+    pthread_setspecific(inRenderContextKey, nullptr);
+    pthread_setspecific(renderContextKey, nullptr);
+}
+
+bool AKRealtimeSafetyIsInRenderContext(void) {
+    ensureRenderContextKeys();
+    return pthread_getspecific(inRenderContextKey) != nullptr;
+}
+
+void AKRealtimeSafetyReport(AKRealtimeViolation kind, const char *where) {
+    // Checking is only ever enabled after the keys exist
+    if (!checkingEnabled.load(std::memory_order_acquire)) return;
+    if (pthread_getspecific(inRenderContextKey) == nullptr) return;
+    // Nothing in here may allocate: we may be inside malloc
+    pthread_setspecific(inRenderContextKey, nullptr);
+    violationCounts[kind].fetch_add(1, std::memory_order_relaxed);
+    AKDSPInstrumentation *renderContext = (AKDSPInstrumentation *)pthread_getspecific(renderContextKey);
+    if (renderContext) renderContext->recordViolation(kind, where);
+    pthread_setspecific(inRenderContextKey, (void *)1);
+}
+
+uint64_t AKRealtimeSafetyGetViolationCount(AKRealtimeViolation kind) {
+    return violationCounts[kind].load(std::memory_order_relaxed);
+}
+
+bool AKRealtimeSafetyIsCheckingEnabled(void) {
+    return checkingEnabled;
+}
+
+#ifdef __APPLE__
+
+// The default zone's entry points, wrapped while checking is enabled
+static void *(*systemMalloc)(malloc_zone_t *, size_t);
+static void *(*systemCalloc)(malloc_zone_t *, size_t, size_t);
+static void *(*systemRealloc)(malloc_zone_t *, void *, size_t);
+static void (*systemFree)(malloc_zone_t *, void *);
+
+static void *checkedMalloc(malloc_zone_t *zone, size_t size) {
+    AKRealtimeSafetyReport(AKRealtimeViolationAllocation, "malloc");
+    return systemMalloc(zone, size);
+}
+
+static void *checkedCalloc(malloc_zone_t *zone, size_t count, size_t size) {
+    AKRealtimeSafetyReport(AKRealtimeViolationAllocation, "calloc");
+    return systemCalloc(zone, count, size);
+}
+
+static void *checkedRealloc(malloc_zone_t *zone, void *pointer, size_t size) {
+    AKRealtimeSafetyReport(AKRealtimeViolationAllocation, "realloc");
+    return systemRealloc(zone, pointer, size);
+}
+
+static void checkedFree(malloc_zone_t *zone, void *pointer) {
+    if (pointer) AKRealtimeSafetyReport(AKRealtimeViolationDeallocation, "free");
+    systemFree(zone, pointer);
+}
+
+static void setZoneHooks(bool install) {
+    malloc_zone_t *zone = malloc_default_zone();
+    vm_address_t page = trunc_page((vm_address_t)zone);
+    vm_size_t size = round_page((vm_address_t)zone + sizeof(malloc_zone_t)) - page;
+    // The zone structure is read-only once malloc has initialized
+    if (vm_protect(mach_task_self(), page, size, 0, VM_PROT_READ | VM_PROT_WRITE) != KERN_SUCCESS) return;
+    if (install) {
+        systemMalloc = zone->malloc;
+        systemCalloc = zone->calloc;
+        systemRealloc = zone->realloc;
+        systemFree = zone->free;
+        zone->malloc = checkedMalloc;
+        zone->calloc = checkedCalloc;
+        zone->realloc = checkedRealloc;
+        zone->free = checkedFree;
+    } else {
+        zone->malloc = systemMalloc;
+        zone->calloc = systemCalloc;
+        zone->realloc = systemRealloc;
+        zone->free = systemFree;
+    }
+    vm_protect(mach_task_self(), page, size, 0, VM_PROT_READ);
+}
+
+#else
+
+// Elsewhere only the AK_REALTIME_UNSAFE annotations are checked
+static void setZoneHooks(bool install) {}
+
+#endif
+
+void AKRealtimeSafetySetCheckingEnabled(bool enabled) {
+    ensureRenderContextKeys();
+    if (checkingEnabled.exchange(enabled, std::memory_order_acq_rel) != enabled) {
+        setZoneHooks(enabled);
+    }
+}
+
+void AKDenormalCheckingSetEnabled(bool enabled) {
+    denormalCheckingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool AKDenormalCheckingIsEnabled(void) {
+    return denormalCheckingEnabled.load(std::memory_order_relaxed);
+}
+
+uint64_t AKDenormalCheckingGetRenderCount(void) {
+    return denormalRenderCount.load(std::memory_order_relaxed);
+}
+
+void AKDenormalCheckingReport(void *context, uint64_t sampleCount) {
+    denormalRenderCount.fetch_add(1, std::memory_order_relaxed);
+    if (context) ((AKDSPInstrumentation *)context)->recordDenormals(sampleCount);
+}
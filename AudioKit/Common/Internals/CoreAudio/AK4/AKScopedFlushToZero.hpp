@@ -0,0 +1,76 @@
+//
+//  AKScopedFlushToZero.hpp
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+#ifdef __cplusplus
+
+#import <stdint.h>
+
+#if defined(__SSE__) || defined(__x86_64__)
+#import <xmmintrin.h>
+#endif
+
+/**
+ Makes the calling thread flush subnormal floats to zero, as inputs and results, for its lifetime, and
+ restores the previous mode when it goes out of scope. Filters, delays and reverbs decaying towards
+ silence otherwise spend long stretches on subnormal numbers, which most CPUs process many times slower.
+ On platforms it doesn't know it does nothing.
+ */
+class AKScopedFlushToZero {
+public:
+
+    explicit AKScopedFlushToZero(bool enabled = true) {
+        if (!enabled) return;
+        saved = getMode();
+        setMode(saved | flushMask);
+        active = true;
+    }
+
+    ~AKScopedFlushToZero() {
+        if (active) setMode(saved);
+    }
+
+    AKScopedFlushToZero(AKScopedFlushToZero const &) = delete;
+    AKScopedFlushToZero &operator=(AKScopedFlushToZero const &) = delete;
+
+private:
+
+#if defined(__SSE__) || defined(__x86_64__)
+    // MXCSR flush-to-zero and denormals-are-zero
+    static constexpr uint64_t flushMask = 0x8040;
+    static uint64_t getMode() { return _mm_getcsr(); }
+    static void setMode(uint64_t mode) { _mm_setcsr((unsigned int)mode); }
+#elif defined(__aarch64__)
+    // FPCR.FZ, which flushes both inputs and results
+    static constexpr uint64_t flushMask = 1ULL << 24;
+    static uint64_t getMode() {
+        uint64_t mode;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode));
+        return mode;
+    }
+    static void setMode(uint64_t mode) { __asm__ __volatile__("msr fpcr, %0" : : "r"(mode)); }
+#elif defined(__arm__) && defined(__VFP_FP__) && !defined(__SOFTFP__)
+    // FPSCR.FZ
+    static constexpr uint64_t flushMask = 1ULL << 24;
+    static uint64_t getMode() {
+        uint32_t mode;
+        __asm__ __volatile__("vmrs %0, fpscr" : "=r"(mode));
+        return mode;
+    }
+    static void setMode(uint64_t mode) { __asm__ __volatile__("vmsr fpscr, %0" : : "r"((uint32_t)mode)); }
+#else
+    static constexpr uint64_t flushMask = 0;
+    static uint64_t getMode() { return 0; }
+    static void setMode(uint64_t mode) {}
+#endif
+
+    uint64_t saved = 0;
+    bool active = false;
+};
+
+#endif
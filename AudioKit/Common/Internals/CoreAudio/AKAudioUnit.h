@@ -143,6 +143,10 @@
     _inputBus.deallocateRenderResources(); \
 } \
 \
+- (BOOL)canProcessInPlace { \
+    return _kernel.canProcessInPlace(); \
+} \
+\
 - (AUInternalRenderBlock)internalRenderBlock { \
     __block AK##str##DSPKernel *state = &_kernel; \
     __block BufferedInputBus *input = &_inputBus; \
@@ -155,7 +159,9 @@
                               const AURenderEvent        *realtimeEventListHead, \
                               AURenderPullInputBlock      pullInputBlock) { \
         AudioUnitRenderActionFlags pullFlags = 0; \
-        AUAudioUnitStatus err = input->pullInput(&pullFlags, timestamp, frameCount, 0, pullInputBlock); \
+        AUAudioUnitStatus err = state->canProcessInPlace() \
+            ? input->pullInputInPlace(&pullFlags, timestamp, frameCount, 0, pullInputBlock, outputData) \
+            : input->pullInput(&pullFlags, timestamp, frameCount, 0, pullInputBlock); \
         if (err != 0) { \
             return err; \
         } \
@@ -0,0 +1,94 @@
+//
+//  AKBufferPool.c
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#include "AKBufferPool.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/// One buffer. The list only grows while anyone retains the pool, so the render thread can walk it freely.
+typedef struct AKBufferPoolEntry {
+    struct AKBufferPoolEntry *_Atomic next;
+    size_t byteSize;
+    void *memory;
+    atomic_bool inUse;
+} AKBufferPoolEntry;
+
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static AKBufferPoolEntry *_Atomic firstEntry = NULL;
+static AKBufferPoolEntry *lastEntry = NULL;
+static int retainCount = 0;
+static size_t largestByteSize = 0;
+
+void AKBufferPoolRetain(size_t byteSize) {
+    pthread_mutex_lock(&poolLock);
+    if (byteSize > largestByteSize) largestByteSize = byteSize;
+
+    // Anonymous mappings are page-aligned and take no memory until they're written
+    AKBufferPoolEntry *entry = calloc(1, sizeof(AKBufferPoolEntry));
+    void *memory = mmap(NULL, largestByteSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (entry && memory != MAP_FAILED) {
+        entry->byteSize = largestByteSize;
+        entry->memory = memory;
+        atomic_init(&entry->inUse, false);
+        // Appended, so the oldest (most used, so most likely resident) buffers are found first
+        if (lastEntry) {
+            atomic_store_explicit(&lastEntry->next, entry, memory_order_release);
+        } else {
+            atomic_store_explicit(&firstEntry, entry, memory_order_release);
+        }
+        lastEntry = entry;
+    } else {
+        free(entry);
+        if (memory != MAP_FAILED) munmap(memory, largestByteSize);
+    }
+    retainCount++;
+    pthread_mutex_unlock(&poolLock);
+}
+
+void AKBufferPoolRelease(void) {
+    pthread_mutex_lock(&poolLock);
+    if (retainCount > 0 && --retainCount == 0) {
+        AKBufferPoolEntry *entry = atomic_exchange(&firstEntry, NULL);
+        while (entry) {
+            AKBufferPoolEntry *next = entry->next;
+            munmap(entry->memory, entry->byteSize);
+            free(entry);
+            entry = next;
+        }
+        lastEntry = NULL;
+        largestByteSize = 0;
+    }
+    pthread_mutex_unlock(&poolLock);
+}
+
+void *AKBufferPoolAcquire(size_t byteSize) {
+    AKBufferPoolEntry *entry = atomic_load_explicit(&firstEntry, memory_order_acquire);
+    while (entry) {
+        if (entry->byteSize >= byteSize &&
+            !atomic_load_explicit(&entry->inUse, memory_order_relaxed) &&
+            !atomic_exchange_explicit(&entry->inUse, true, memory_order_acquire)) {
+            return entry->memory;
+        }
+        entry = atomic_load_explicit(&entry->next, memory_order_acquire);
+    }
+    return NULL;
+}
+
+void AKBufferPoolReturn(void *buffer) {
+    AKBufferPoolEntry *entry = atomic_load_explicit(&firstEntry, memory_order_acquire);
+    while (entry) {
+        if (entry->memory == buffer) {
+            atomic_store_explicit(&entry->inUse, false, memory_order_release);
+            return;
+        }
+        entry = atomic_load_explicit(&entry->next, memory_order_acquire);
+    }
+}
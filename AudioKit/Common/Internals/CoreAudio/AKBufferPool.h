@@ -0,0 +1,43 @@
+//
+//  AKBufferPool.h
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ Scratch buffers shared by every audio unit, for memory that is only needed during a render call
+ (an input to be processed into a separate output, say).
+
+ Each unit that uses the pool retains it when it allocates render resources, adding one page-aligned
+ buffer, and releases it when it deallocates them. A render call acquires a buffer and returns it
+ before it returns, so with upstream units rendering from inside their downstream's render call,
+ at most one buffer per unit on the longest path is ever in use. Buffers are taken lowest first, and
+ memory that's never been touched takes up no space, so the pool's footprint follows that path
+ rather than the number of units.
+ */
+
+/// Control thread: adds a buffer of at least byteSize bytes
+void AKBufferPoolRetain(size_t byteSize);
+
+/// Control thread: the memory is freed once every retain has been released
+void AKBufferPoolRelease(void);
+
+/// Render thread, lock-free. Returns NULL if no free buffer is big enough.
+void *AKBufferPoolAcquire(size_t byteSize);
+
+/// Render thread, lock-free. Returns a buffer from AKBufferPoolAcquire.
+void AKBufferPoolReturn(void *buffer);
+
+#ifdef __cplusplus
+}
+#endif
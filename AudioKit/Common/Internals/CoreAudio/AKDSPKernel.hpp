@@ -70,6 +70,21 @@ public:
         AKOutputBuffered::setBuffer(outBufferList);
         inBufferListPtr = inBufferList;
     }
+
+    /// Kernels whose process() reads each input sample before writing the output at that position can
+    /// return true, and their input is then pulled straight into the output buffers
+    bool canProcessInPlace() { return false; }
+
+    /// Copies input to output, for bypassing; nothing to do when processing in place
+    void passThrough(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) {
+        for (UInt32 i = 0; i < outBufferListPtr->mNumberBuffers && i < inBufferListPtr->mNumberBuffers; ++i) {
+            float *in = (float *)inBufferListPtr->mBuffers[i].mData + bufferOffset;
+            float *out = (float *)outBufferListPtr->mBuffers[i].mData + bufferOffset;
+            if (in != out) {
+                memcpy(out, in, frameCount * sizeof(float));
+            }
+        }
+    }
 };
 
 class AKDSPKernelWithParameters : AKDSPKernel, AKParametricKernel {
@@ -105,6 +105,33 @@ struct BufferedInputBus : BufferedAudioBus {
         return pullInputBlock(actionFlags, timestamp, frameCount, inputBusNumber, mutableAudioBufferList);
     }
 
+    /*
+     Like pullInput, but pulls straight into the output buffers, for kernels that
+     can process in place. Null output pointers are first pointed at this bus's
+     own buffers.
+     */
+    AUAudioUnitStatus pullInputInPlace(AudioUnitRenderActionFlags *actionFlags,
+                                       AudioTimeStamp const *timestamp,
+                                       AVAudioFrameCount frameCount,
+                                       NSInteger inputBusNumber,
+                                       AURenderPullInputBlock pullInputBlock,
+                                       AudioBufferList *outBufferList) {
+        if (pullInputBlock == nullptr) {
+            return kAudioUnitErr_NoConnection;
+        }
+
+        prepareInputBufferList();
+
+        for (UInt32 i = 0; i < mutableAudioBufferList->mNumberBuffers && i < outBufferList->mNumberBuffers; ++i) {
+            if (outBufferList->mBuffers[i].mData == nullptr) {
+                outBufferList->mBuffers[i].mData = mutableAudioBufferList->mBuffers[i].mData;
+            }
+            mutableAudioBufferList->mBuffers[i].mData = outBufferList->mBuffers[i].mData;
+        }
+
+        return pullInputBlock(actionFlags, timestamp, frameCount, inputBusNumber, mutableAudioBufferList);
+    }
+
     /*
      prepareInputBufferList populates the mutableAudioBufferList with the data
      pointers from the originalAudioBufferList.
@@ -7,6 +7,8 @@
  */
 
 #import "DSPKernel.hpp"
+#import "AKScopedFlushToZero.hpp"
+#import "AKRenderStats.h"
 
 void DSPKernel::handleOneEvent(AURenderEvent const *event) {
     switch (event->head.eventType) {
@@ -44,6 +46,9 @@ void DSPKernel::performAllSimultaneousEvents(AUEventSampleTime now, AURenderEven
  */
 void DSPKernel::processWithEvents(AudioTimeStamp const *timestamp, AUAudioFrameCount frameCount, AURenderEvent const *events) {
 
+    // AudioKit: render with subnormal numbers flushed to zero, unless they are being looked for
+    AKScopedFlushToZero flushToZero(!AKDenormalCheckingIsEnabled());
+
     AUEventSampleTime now = AUEventSampleTime(timestamp->mSampleTime);
     AUAudioFrameCount framesRemaining = frameCount;
     AURenderEvent const *event = events;
@@ -124,3 +124,29 @@ void ParameterRamper::stepBy(uint32_t n) {
         data->samplesRemaining -= n;
     }
 }
+
+bool ParameterRamper::isRamping() const {
+    return data->samplesRemaining != 0;
+}
+
+bool ParameterRamper::getAndStepBlock(float *values, uint32_t frameCount) {
+    uint32_t remaining = data->samplesRemaining;
+    if (remaining == 0) {
+        return true;
+    }
+    /*
+     Same line equation as get(), evaluated for each frame. No loop-carried state,
+     so the compiler vectorizes it, and the result matches getAndStep bit for bit.
+     */
+    uint32_t rampFrames = frameCount < remaining ? frameCount : remaining;
+    float const inverseSlope = data->inverseSlope;
+    float const goal = data->goal;
+    for (uint32_t i = 0; i < rampFrames; ++i) {
+        values[i] = inverseSlope * float(remaining - i) + goal;
+    }
+    for (uint32_t i = rampFrames; i < frameCount; ++i) {
+        values[i] = goal;
+    }
+    data->samplesRemaining = remaining - rampFrames;
+    return false;
+}
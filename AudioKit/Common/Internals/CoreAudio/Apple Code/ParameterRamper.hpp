@@ -42,7 +42,17 @@ public:
     float getAndStep();
     
     void stepBy(uint32_t n);
-    
+
+    bool isRamping() const;
+
+    /**
+     Block version of getAndStep, for kernels that compute their controls once per render segment.
+     Returns true, leaving values untouched, when the parameter is constant for the next frameCount
+     samples; get() then holds the value. Otherwise writes frameCount values, identical to what
+     frameCount calls to getAndStep would return, and returns false.
+     */
+    bool getAndStepBlock(float *values, uint32_t frameCount);
+
 };
 
 #endif
@@ -10,6 +10,7 @@
 #pragma once
 
 #import "AKSoundpipeKernel.hpp"
+#import "AKDSPCommandBus.hpp"
 #import <vector>
 
 static inline double pow2(double x) {
@@ -159,15 +160,48 @@ public:
     ParameterRamper vibratoDepthRamper = 0;
     ParameterRamper vibratoRateRamper = 0;
     
+    // Notes arrive from the main thread; they are queued and applied at the start of the next render
+    AKDSPCommandBus commandBus;
+
     // standard bank kernel functions
     void startNote(int note, int velocity) {
-        noteStates[note]->noteOn(note, velocity);
+        startNote(note, velocity, 0.0f);
     }
     void startNote(int note, int velocity, float frequency) {
-        noteStates[note]->noteOn(note, velocity, frequency);
+        AKDSPCommand command;
+        command.type = AKDSPCommandNoteOn;
+        command.sampleTime = AKDSPCommandImmediate;
+        command.note.noteNumber = note;
+        command.note.velocity = velocity;
+        command.note.immediate = false;
+        command.note.frequency = frequency;
+        commandBus.post(command);
     }
     void stopNote(int note) {
-        noteStates[note]->noteOn(note, 0);
+        AKDSPCommand command;
+        command.type = AKDSPCommandNoteOff;
+        command.sampleTime = AKDSPCommandImmediate;
+        command.note.noteNumber = note;
+        command.note.velocity = 0;
+        command.note.immediate = false;
+        command.note.frequency = 0.0f;
+        commandBus.post(command);
+    }
+
+    /// Render thread: apply the notes started and stopped since the last render
+    void performPendingCommands() {
+        AKDSPCommand command;
+        while (commandBus.pop(command)) {
+            int note = command.note.noteNumber;
+            if (note > 127) continue;
+            if (command.type == AKDSPCommandNoteOn && command.note.frequency > 0.0f) {
+                noteStates[note]->noteOn(note, command.note.velocity, command.note.frequency);
+            } else if (command.type == AKDSPCommandNoteOn) {
+                noteStates[note]->noteOn(note, command.note.velocity);
+            } else if (command.type == AKDSPCommandNoteOff) {
+                noteStates[note]->noteOn(note, 0);
+            }
+        }
     }
     void setAttackDuration(float value) {
         attackDuration = clamp(value, 0.0f, 99.0f);
@@ -232,6 +266,7 @@ public:
     }
 
     void standardBankGetAndSteps() {
+        performPendingCommands();
         attackDuration = attackDurationRamper.getAndStep();
         decayDuration = decayDurationRamper.getAndStep();
         sustainLevel = sustainLevelRamper.getAndStep();
@@ -30,6 +30,9 @@ typedef void(^ProcessEventsBlock)(AudioBufferList        * _Nullable inBuffer,
 /** If true, the output buffer samples will be set to zero pre-render, Intended for subclasses to override, defaults to false */
 -(BOOL)shouldClearOutputBuffer;
 
+/** If true, input is pulled straight into the output buffers, so processing must read each input sample before writing the output sample at that position. Intended for subclasses to override, defaults to false */
+-(BOOL)shouldProcessInPlace;
+
 @end
 
 
@@ -7,6 +7,7 @@
 //
 
 #import "BufferedAudioUnit.h"
+#import "AKBufferPool.h"
 
 const int kMaxChannelCount = 16;
 
@@ -19,8 +20,10 @@ static void    bufferListPointChannelDataToBuffer(AudioBufferList *bufferList, f
 
 
 @implementation BufferedAudioUnit {
-    float               *_inputBuffer;
     float               *_ouputBuffer;
+    size_t              _bufferSize;
+    BOOL                _processesInPlace;
+    BOOL                _retainsBufferPool;
     AUAudioUnitBusArray *_inputBusArray;
     AUAudioUnitBusArray *_outputBusArray;
     ProcessEventsBlock  _processEventsBlock;
@@ -58,6 +61,10 @@ static void    bufferListPointChannelDataToBuffer(AudioBufferList *bufferList, f
     return false;
 }
 
+-(BOOL)shouldProcessInPlace {
+    return false;
+}
+
 - (BOOL)allocateRenderResourcesAndReturnError:(NSError **)outError {
     if (![super allocateRenderResourcesAndReturnError:outError]) {
         return NO;
@@ -73,15 +80,18 @@ static void    bufferListPointChannelDataToBuffer(AudioBufferList *bufferList, f
         return NO;
     }
 
-    assert(_inputBuffer == NULL && _ouputBuffer == NULL);
+    assert(_ouputBuffer == NULL);
 
-    size_t bufferSize = sizeof(float) * format.channelCount * self.maximumFramesToRender;
-    if (self.shouldAllocateInputBus) {
-        _inputBuffer = malloc(bufferSize);
-    }
+    // Only used when the host doesn't supply output buffers.
+    _bufferSize = sizeof(float) * format.channelCount * self.maximumFramesToRender;
+    _ouputBuffer = malloc(_bufferSize);
 
-    if (self.canProcessInPlace == false || self.shouldAllocateInputBus == false) {
-        _ouputBuffer = malloc(bufferSize);
+    // Input is pulled straight into the output buffers when processing in place, otherwise into a
+    // scratch buffer from the shared pool for the duration of the render call.
+    _processesInPlace = self.shouldAllocateInputBus && self.shouldProcessInPlace && !_shouldClearOutputBuffer;
+    _retainsBufferPool = self.shouldAllocateInputBus && !_processesInPlace;
+    if (_retainsBufferPool) {
+        AKBufferPoolRetain(_bufferSize);
     }
 
     _processEventsBlock = [self processEventsBlock: format];
@@ -89,15 +99,15 @@ static void    bufferListPointChannelDataToBuffer(AudioBufferList *bufferList, f
 }
 
 -(void)deallocateRenderResources {
-    if (_inputBuffer != NULL) {
-        free(_inputBuffer);
-    }
-
     if (_ouputBuffer != NULL) {
         free(_ouputBuffer);
     }
-    _inputBuffer = NULL;
+
+    if (_retainsBufferPool) {
+        AKBufferPoolRelease();
+    }
     _ouputBuffer = NULL;
+    _retainsBufferPool = NO;
     [super deallocateRenderResources];
 }
 
@@ -138,26 +148,37 @@ static void    bufferListPointChannelDataToBuffer(AudioBufferList *bufferList, f
         // Guard against potential stack overflow.
         assert(channelCount <= kMaxChannelCount);
 
+        // If outputBufferList has null data, point to valid buffer before processing.
+        if (bufferListHasNullData(outputBufferList)) {
+            bufferListPointChannelDataToBuffer(outputBufferList, welf->_ouputBuffer);
+        }
+
         char inputBufferAllocation[bufferListByteSize(outputBufferList->mNumberBuffers)];
         AudioBufferList *inputBufferList = NULL;
+        float *scratchBuffer = NULL;
 
-        if (welf->_inputBuffer != NULL) {
+        if (welf->_inputBusArray != NULL) {
 
-            // Prepare buffer for pull input.
+            // Prepare buffer for pull input, in the output buffers themselves or in pool scratch.
             inputBufferList = (AudioBufferList *)inputBufferAllocation;
             bufferListPrepare(inputBufferList, channelCount, frameCount);
-            bufferListPointChannelDataToBuffer(inputBufferList, welf->_inputBuffer);
+            if (welf->_processesInPlace) {
+                for (int i = 0; i < channelCount; i++) {
+                    inputBufferList->mBuffers[i].mData = outputBufferList->mBuffers[i].mData;
+                }
+            } else {
+                scratchBuffer = AKBufferPoolAcquire(welf->_bufferSize);
+                if (scratchBuffer == NULL) return kAudioUnitErr_CannotDoInCurrentContext;
+                bufferListPointChannelDataToBuffer(inputBufferList, scratchBuffer);
+            }
 
-            // Pull input into _inputBuffer.
+            // Pull input.
             AudioUnitRenderActionFlags flags = 0;
             AUAudioUnitStatus status = pullInputBlock(&flags, timestamp, frameCount, 0, inputBufferList);
-            if (status) return status;
-        }
-
-        // If outputBufferList has null data, point to valid buffer before processing.
-        if (bufferListHasNullData(outputBufferList)) {
-            float *buffer = welf->_ouputBuffer ?: welf->_inputBuffer;
-            bufferListPointChannelDataToBuffer(outputBufferList, buffer);
+            if (status) {
+                if (scratchBuffer) AKBufferPoolReturn(scratchBuffer);
+                return status;
+            }
         }
 
         if (welf->_shouldClearOutputBuffer) {
@@ -165,6 +186,8 @@ static void    bufferListPointChannelDataToBuffer(AudioBufferList *bufferList, f
         }
 
         welf->_processEventsBlock(inputBufferList, outputBufferList, timestamp, frameCount, realtimeEventListHead);
+
+        if (scratchBuffer) AKBufferPoolReturn(scratchBuffer);
         return noErr;
     };
 }
@@ -20,7 +20,9 @@ protected:
     float _target = 0;
     float _value = 0;
     float _startValue = 0;
-    int64_t _duration = 0;  // in samples
+    int64_t _duration = 0;  // in samples, of the ramp in progress
+    int64_t _defaultDuration = 0;  // in samples, for ramps started by setTarget
+    int64_t _pendingDuration = -1;  // in samples, for the ramp requested by startRamp
     int64_t _startSample = 0;
     int _rampType = 0; // see AKSettings.RampType
 
@@ -28,6 +30,8 @@ protected:
         _target = _paramValue;
         _startSample = atSample;
         _startValue = _value;
+        _duration = _pendingDuration >= 0 ? _pendingDuration : _defaultDuration;
+        _pendingDuration = -1;
     }
 
 public:
@@ -64,7 +68,7 @@ public:
     }
 
     void setDurationInSamples(int64_t duration) {
-        if (duration >= 0) _duration = duration;
+        if (duration >= 0) _duration = _defaultDuration = duration;
     }
 
     float getDurationInSamples() {
@@ -72,11 +76,22 @@ public:
     }
 
     void setRampDuration(float seconds, int64_t sampleRate) {
-        _duration = seconds * sampleRate;
+        _duration = _defaultDuration = seconds * sampleRate;
     }
 
     float getRampDuration(int64_t sampleRate) {
-        return (sampleRate == 0) ? 0 : _duration / sampleRate;
+        return (sampleRate == 0) ? 0 : _defaultDuration / sampleRate;
+    }
+
+    /// Ramp to value over duration samples, starting at the next advance, whatever the ramp duration
+    /// setting. Used for AURenderEventParameterRamp, which the render loop delivers on time.
+    void startRamp(float value, int64_t duration) {
+        if (duration <= 0) {
+            setTarget(value, true);
+        } else {
+            _paramValue = value;
+            _pendingDuration = duration;
+        }
     }
 
     float advanceTo(int64_t atSample) {
@@ -27,11 +27,28 @@
 //  3. This notice may not be removed or altered from any source distribution.
 //
 
+#if !defined(__APPLE__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "TPCircularBuffer.h"
-#include <mach/mach.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef __APPLE__
+#include <mach/mach.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+#ifdef __APPLE__
+
 #define reportResult(result,operation) (_reportResult((result),(operation),strrchr(__FILE__, '/')+1,__LINE__))
 static inline bool _reportResult(kern_return_t result, const char *operation, const char* file, int line) {
     if ( result != ERR_SUCCESS ) {
@@ -41,32 +58,27 @@ static inline bool _reportResult(kern_return_t result, const char *operation, co
     return true;
 }
 
-bool _TPCircularBufferInit(TPCircularBuffer *buffer, int32_t length, size_t structSize) {
-
-    assert(length > 0);
-
-    if ( structSize != sizeof(TPCircularBuffer) ) {
-        fprintf(stderr, "TPCircularBuffer: Header version mismatch. Check for old versions of TPCircularBuffer in your project\n");
-        abort();
-    }
+static int32_t _TPCircularBufferRoundLength(int32_t length) {
+    return (int32_t)round_page(length);
+}
 
+// Mach: allocate twice the length, then remap the first half over the second
+static void *_TPCircularBufferMapMirrored(int32_t length) {
     // Keep trying until we get our buffer, needed to handle race conditions
     int retries = 3;
     while ( true ) {
 
-        buffer->length = (int32_t)round_page(length);    // We need whole page sizes
-
         // Temporarily allocate twice the length, so we have the contiguous address space to
         // support a second instance of the buffer directly after
         vm_address_t bufferAddress;
         kern_return_t result = vm_allocate(mach_task_self(),
                                            &bufferAddress,
-                                           buffer->length * 2,
+                                           length * 2,
                                            VM_FLAGS_ANYWHERE); // allocate anywhere it'll fit
         if ( result != ERR_SUCCESS ) {
             if ( retries-- == 0 ) {
                 reportResult(result, "Buffer allocation");
-                return false;
+                return NULL;
             }
             // Try again if we fail
             continue;
@@ -74,24 +86,24 @@ bool _TPCircularBufferInit(TPCircularBuffer *buffer, int32_t length, size_t stru
 
         // Now replace the second half of the allocation with a virtual copy of the first half. Deallocate the second half...
         result = vm_deallocate(mach_task_self(),
-                               bufferAddress + buffer->length,
-                               buffer->length);
+                               bufferAddress + length,
+                               length);
         if ( result != ERR_SUCCESS ) {
             if ( retries-- == 0 ) {
                 reportResult(result, "Buffer deallocation");
-                return false;
+                return NULL;
             }
             // If this fails somehow, deallocate the whole region and try again
-            vm_deallocate(mach_task_self(), bufferAddress, buffer->length);
+            vm_deallocate(mach_task_self(), bufferAddress, length);
             continue;
         }
 
         // Re-map the buffer to the address space immediately after the buffer
-        vm_address_t virtualAddress = bufferAddress + buffer->length;
+        vm_address_t virtualAddress = bufferAddress + length;
         vm_prot_t cur_prot, max_prot;
         result = vm_remap(mach_task_self(),
                           &virtualAddress,   // mirror target
-                          buffer->length,    // size of mirror
+                          length,            // size of mirror
                           0,                 // auto alignment
                           0,                 // force remapping to virtualAddress
                           mach_task_self(),  // same task
@@ -103,40 +115,144 @@ bool _TPCircularBufferInit(TPCircularBuffer *buffer, int32_t length, size_t stru
         if ( result != ERR_SUCCESS ) {
             if ( retries-- == 0 ) {
                 reportResult(result, "Remap buffer memory");
-                return false;
+                return NULL;
             }
             // If this remap failed, we hit a race condition, so deallocate and try again
-            vm_deallocate(mach_task_self(), bufferAddress, buffer->length);
+            vm_deallocate(mach_task_self(), bufferAddress, length);
             continue;
         }
 
-        if ( virtualAddress != bufferAddress+buffer->length ) {
+        if ( virtualAddress != bufferAddress+length ) {
             // If the memory is not contiguous, clean up both allocated buffers and try again
             if ( retries-- == 0 ) {
                 printf("Couldn't map buffer memory to end of buffer\n");
-                return false;
+                return NULL;
             }
 
-            vm_deallocate(mach_task_self(), virtualAddress, buffer->length);
-            vm_deallocate(mach_task_self(), bufferAddress, buffer->length);
+            vm_deallocate(mach_task_self(), virtualAddress, length);
+            vm_deallocate(mach_task_self(), bufferAddress, length);
             continue;
         }
 
-        buffer->buffer = (void*)bufferAddress;
-        buffer->fillCount = 0;
-        buffer->head = buffer->tail = 0;
-        buffer->atomic = true;
+        return (void*)bufferAddress;
+    }
+    return NULL;
+}
 
-        return true;
+static void _TPCircularBufferUnmapMirrored(void *buffer, int32_t length) {
+    vm_deallocate(mach_task_self(), (vm_address_t)buffer, length * 2);
+}
+
+#else
+
+static int32_t _TPCircularBufferRoundLength(int32_t length) {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if ( pageSize <= 0 ) pageSize = 4096;
+    return (int32_t)(((length + pageSize - 1) / pageSize) * pageSize);
+}
+
+// An anonymous file to map twice: memfd where the kernel has it, else an unlinked POSIX shared memory object
+static int _TPCircularBufferCreateFile(void) {
+    int fd = -1;
+#if defined(__linux__) && defined(SYS_memfd_create)
+    fd = (int)syscall(SYS_memfd_create, "TPCircularBuffer", 1 /* MFD_CLOEXEC */);
+    if ( fd >= 0 ) return fd;
+#endif
+    char name[64];
+    for ( int attempt = 0; attempt < 8 && fd < 0; attempt++ ) {
+        snprintf(name, sizeof(name), "/TPCircularBuffer-%ld-%d", (long)getpid(), rand());
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if ( fd >= 0 ) shm_unlink(name);
+        else if ( errno != EEXIST ) break;
     }
-    return false;
+    return fd;
+}
+
+// POSIX: reserve twice the length, then map the same file over both halves
+static void *_TPCircularBufferMapMirrored(int32_t length) {
+    int fd = _TPCircularBufferCreateFile();
+    if ( fd < 0 ) return NULL;
+    if ( ftruncate(fd, length) != 0 ) {
+        close(fd);
+        return NULL;
+    }
+
+    char *reserved = (char*)mmap(NULL, (size_t)length * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ( reserved == MAP_FAILED ) {
+        close(fd);
+        return NULL;
+    }
+
+    // MAP_FIXED replaces the reservation atomically, so nothing else can be mapped in between
+    void *first = mmap(reserved, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void *second = first == MAP_FAILED ? MAP_FAILED
+                 : mmap(reserved + length, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd);
+    if ( first != reserved || second != reserved + length ) {
+        munmap(reserved, (size_t)length * 2);
+        return NULL;
+    }
+    return reserved;
+}
+
+static void _TPCircularBufferUnmapMirrored(void *buffer, int32_t length) {
+    munmap(buffer, (size_t)length * 2);
+}
+
+#endif
+
+bool _TPCircularBufferInit(TPCircularBuffer *buffer, int32_t length, size_t structSize) {
+
+    assert(length > 0);
+
+    if ( structSize != sizeof(TPCircularBuffer) ) {
+        fprintf(stderr, "TPCircularBuffer: Header version mismatch. Check for old versions of TPCircularBuffer in your project\n");
+        abort();
+    }
+
+    buffer->length = _TPCircularBufferRoundLength(length);    // We need whole page sizes
+    buffer->buffer = _TPCircularBufferMapMirrored(buffer->length);
+    buffer->mirrored = buffer->buffer != NULL;
+
+    if ( !buffer->mirrored ) {
+        // Without a virtual mirror, keep a real copy of the buffer after its end, updated as bytes are produced
+        buffer->buffer = malloc((size_t)buffer->length * 2);
+        if ( !buffer->buffer ) {
+            printf("Couldn't allocate buffer memory\n");
+            return false;
+        }
+    }
+
+    buffer->fillCount = 0;
+    buffer->head = buffer->tail = 0;
+    buffer->atomic = true;
+
+    return true;
 }
 
 void TPCircularBufferCleanup(TPCircularBuffer *buffer) {
-    vm_deallocate(mach_task_self(), (vm_address_t)buffer->buffer, buffer->length * 2);
+    if ( buffer->mirrored ) {
+        _TPCircularBufferUnmapMirrored(buffer->buffer, buffer->length);
+    } else {
+        free(buffer->buffer);
+    }
     memset(buffer, 0, sizeof(TPCircularBuffer));
 }
 
+void _TPCircularBufferCopyMirror(TPCircularBuffer *buffer, int32_t amount) {
+    char *base = (char*)buffer->buffer;
+    int32_t start = buffer->head;
+    int32_t end = start + amount;
+    if ( end <= buffer->length ) {
+        // Written within the buffer: copy into the mirror
+        memcpy(base + buffer->length + start, base + start, amount);
+    } else {
+        // Written across the end: the part in the mirror goes to the start, the rest to the mirror
+        memcpy(base + buffer->length + start, base + start, buffer->length - start);
+        memcpy(base, base + buffer->length, end - buffer->length);
+    }
+}
+
 void TPCircularBufferClear(TPCircularBuffer *buffer) {
     int32_t fillCount;
     if ( TPCircularBufferTail(buffer, &fillCount) ) {
@@ -17,6 +17,11 @@
 //  adapted to Darwin by Kurt Revis (http://www.snoize.com,
 //  http://www.snoize.com/Code/PlayBufferedSoundFile.tar.gz)
 //
+//  On Darwin the mirror is made with vm_remap; elsewhere the same file (memfd_create, or POSIX
+//  shared memory) is mapped twice. Where neither works, the buffer falls back to a real copy after
+//  its end that is kept up to date as bytes are produced, so the API behaves identically, at the
+//  cost of copying everything written once more.
+//
 //
 //  Copyright (C) 2012-2013 A Tasty Pixel
 //
@@ -42,9 +47,14 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
 
+#ifndef __deprecated_msg
+#define __deprecated_msg(message) __attribute__((deprecated(message)))
+#endif
+
 #ifdef __cplusplus
     extern "C++" {
         #include <atomic>
@@ -68,6 +78,7 @@ typedef struct {
     int32_t           head;
     volatile atomicInt fillCount;
     bool              atomic;
+    bool              mirrored;   // false when the copy after the end is maintained by copying
 } TPCircularBuffer;
 
 /*!
@@ -77,6 +88,9 @@ typedef struct {
  *  memory mirroring technique works, the true buffer length will
  *  be multiples of the device page size (e.g. 4096 bytes)
  *
+ *  If the platform can't map the buffer twice, twice the length
+ *  is allocated instead and every produced byte is copied once more.
+ *
  *  If you intend to use the AudioBufferList utilities, you should
  *  always allocate a bit more space than you need for pure audio
  *  data, so there's room for the metadata. How much extra is required
@@ -124,6 +138,12 @@ void  TPCircularBufferClear(TPCircularBuffer *buffer);
  */
 void  TPCircularBufferSetAtomic(TPCircularBuffer *buffer, bool atomic);
 
+/*!
+ * Copies newly written bytes between the buffer and its copy after the end.
+ * Called by TPCircularBufferProduce when the buffer is not virtually mirrored.
+ */
+void _TPCircularBufferCopyMirror(TPCircularBuffer *buffer, int32_t amount);
+
 // Reading (consuming)
 
 /*!
@@ -187,6 +207,7 @@ static __inline__ __attribute__((always_inline)) void *TPCircularBufferHead(TPCi
  * @param amount Number of bytes to produce
  */
 static __inline__ __attribute__((always_inline)) void TPCircularBufferProduce(TPCircularBuffer *buffer, int32_t amount) {
+    if ( !buffer->mirrored ) _TPCircularBufferCopyMirror(buffer, amount);
     buffer->head = (buffer->head + amount) % buffer->length;
     if ( buffer->atomic ) {
         atomicFetchAdd(&buffer->fillCount, amount);
@@ -230,6 +251,7 @@ void TPCircularBufferConsumeNoBarrier(TPCircularBuffer *buffer, int32_t amount)
  */
 static __inline__ __attribute__((always_inline)) __deprecated_msg("use TPCircularBufferSetAtomic(false) and TPCircularBufferProduce instead")
 void TPCircularBufferProduceNoBarrier(TPCircularBuffer *buffer, int32_t amount) {
+    if ( !buffer->mirrored ) _TPCircularBufferCopyMirror(buffer, amount);
     buffer->head = (buffer->head + amount) % buffer->length;
     buffer->fillCount += amount;
     assert(buffer->fillCount <= buffer->length);
@@ -10,17 +10,12 @@
 #include <mach/mach_time.h>
 #include <math.h>
 #include <assert.h>
-#include <pthread.h>
 #include <unistd.h>
 
 const AudioTimeStamp AudioTimeZero = {};
 
-typedef struct {
-    Float64         loopStart;
-    Float64         loopEnd;
-    AudioTimeStamp  baseTime;
-    AudioTimeStamp  waitStart;
-}AKTimelineMessage;
+// Set in messagePending when the message it indexes has not been read yet
+#define AKTimelineMessageFresh 4
 
 
 static AudioTimeStamp TimeStampOffset(AudioTimeStamp timeStamp, SInt64 samples, double sampleRate);
@@ -38,8 +33,9 @@ void AKTimelineSynchronize(AKTimeline *timeline);
 void AKTimelineInit(AKTimeline *timeline, AudioStreamBasicDescription format, AKTimelineCallback callback, void *callbackRef) {
     memset(timeline, 0, sizeof(AKTimeline));
     timeline->format = format;
-    TPCircularBufferInit(&timeline->messageQueue, sizeof(AKTimelineMessage) * 32);
-    pthread_mutex_init(&timeline->messageQueueLock, NULL);
+    timeline->messageWriteIndex = 0;
+    timeline->messagePending = 1;
+    timeline->messageReadIndex = 2;
     timeline->callBack = callback;
     timeline->callbackRef = callbackRef;
 }
@@ -168,17 +164,10 @@ AudioTimeStamp AKTimelineAudioTimeAtTime(AKTimeline *timeline, Float64 time) {
 }
 
 static void AKTimelineSendMessage(AKTimeline *timeLine, AKTimelineMessage message) {
-    AKTimelineMessage *head = TPCircularBufferUnitHead(&timeLine->messageQueue, NULL, sizeof(AKTimelineMessage));
-    if (!head) {
-        pthread_mutex_lock(&timeLine->messageQueueLock);
-        while (!head) {
-            TPCircularBufferUnitConsume(&timeLine->messageQueue);
-            head = TPCircularBufferUnitHead(&timeLine->messageQueue, NULL, sizeof(AKTimelineMessage));
-        }
-        pthread_mutex_unlock(&timeLine->messageQueueLock);
-    }
-    *head = message;
-    TPCircularBufferUnitProduce(&timeLine->messageQueue);
+    // Publish the written slot and take back whichever one the render thread is not using.
+    timeLine->messages[timeLine->messageWriteIndex] = message;
+    int previous = atomic_exchange(&timeLine->messagePending, timeLine->messageWriteIndex | AKTimelineMessageFresh);
+    timeLine->messageWriteIndex = previous & 3;
 }
 
 int ABLSize(int bufferCount) {
@@ -214,17 +203,14 @@ void AKTimelineRender(AKTimeline            *timeline,
                       UInt32                inNumberFrames,
                       AudioBufferList       *ioData) {
 
-    if(pthread_mutex_trylock(&timeline->messageQueueLock) == 0) {
-        AKTimelineMessage *message = TPCircularBufferUnitTail(&timeline->messageQueue, NULL, NULL);
-        while (message) {
-            timeline->_baseTime = message->baseTime;
-            timeline->_loopStart = message->loopStart;
-            timeline->_loopEnd = message->loopEnd;
-            timeline->_waitStart = message->waitStart;
-            TPCircularBufferUnitConsume(&timeline->messageQueue);
-            message = TPCircularBufferUnitTail(&timeline->messageQueue, NULL, NULL);
-        }
-        pthread_mutex_unlock(&timeline->messageQueueLock);
+    if (atomic_load(&timeline->messagePending) & AKTimelineMessageFresh) {
+        int pending = atomic_exchange(&timeline->messagePending, timeline->messageReadIndex);
+        timeline->messageReadIndex = pending & 3;
+        AKTimelineMessage *message = &timeline->messages[timeline->messageReadIndex];
+        timeline->_baseTime = message->baseTime;
+        timeline->_loopStart = message->loopStart;
+        timeline->_loopEnd = message->loopEnd;
+        timeline->_waitStart = message->waitStart;
     }
     if (!SampleAndHostTimeValid(timeline->anchorTime)) {
         timeline->anchorTime = *inTimeStamp;
@@ -50,6 +50,14 @@ UInt32          inNumberFrames,
 UInt32          offset,
 AudioBufferList *ioData);
 
+/// State handed from the control thread to the render thread
+typedef struct {
+    Float64         loopStart;
+    Float64         loopEnd;
+    AudioTimeStamp  baseTime;
+    AudioTimeStamp  waitStart;
+}AKTimelineMessage;
+
 typedef struct{
     UInt32          loopStart;
     UInt32          loopEnd;
@@ -69,8 +77,12 @@ typedef struct{
     void            *callbackRef;
     AKTimelineCallback callBack;
 
-    TPCircularBuffer messageQueue;
-    pthread_mutex_t messageQueueLock;
+    // Triple buffer: only the newest message matters, so the control thread never
+    // waits for the render thread and the render thread never takes a lock.
+    AKTimelineMessage   messages[3];
+    int                 messageWriteIndex;
+    int                 messageReadIndex;
+    volatile atomicInt  messagePending;
 
     Float64         idleTime;
 
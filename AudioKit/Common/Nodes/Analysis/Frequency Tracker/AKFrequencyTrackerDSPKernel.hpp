@@ -55,6 +55,8 @@ public:
         }
     }
 
+    bool canProcessInPlace() { return true; }
+
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override {
 
         for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
@@ -0,0 +1,124 @@
+//
+//  AKLoudnessMeter.swift
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+/// Measures loudness (ITU-R BS.1770 / EBU R 128) and the peak, RMS and true peak level of each channel,
+/// passing its input through unchanged. Levels are linear amplitudes, loudness is in LUFS.
+///
+open class AKLoudnessMeter: AKNode, AKToggleable, AKComponent, AKInput {
+    public typealias AKAudioUnitType = AKLoudnessMeterAudioUnit
+    /// Four letter unique description of the node
+    public static let ComponentDescription = AudioComponentDescription(effect: "lufs")
+
+    // MARK: - Properties
+
+    private var internalAU: AKAudioUnitType?
+
+    /// Tells whether the node is processing (ie. started, playing, or active)
+    @objc open dynamic var isStarted: Bool {
+        return self.internalAU?.isPlaying ?? false
+    }
+
+    /// Loudness over the last 400 ms
+    @objc open dynamic var momentaryLoudness: Double {
+        return Double(internalAU?.readings.momentaryLoudness ?? -Float.infinity)
+    }
+
+    /// Loudness over the last 3 s
+    @objc open dynamic var shortTermLoudness: Double {
+        return Double(internalAU?.readings.shortTermLoudness ?? -Float.infinity)
+    }
+
+    /// Gated loudness since the meter was started or last reset
+    @objc open dynamic var integratedLoudness: Double {
+        return Double(internalAU?.readings.integratedLoudness ?? -Float.infinity)
+    }
+
+    /// Highest momentary loudness since the last reset
+    @objc open dynamic var maximumMomentaryLoudness: Double {
+        return Double(internalAU?.readings.maximumMomentaryLoudness ?? -Float.infinity)
+    }
+
+    /// Highest short term loudness since the last reset
+    @objc open dynamic var maximumShortTermLoudness: Double {
+        return Double(internalAU?.readings.maximumShortTermLoudness ?? -Float.infinity)
+    }
+
+    /// Seconds of audio measured since the last reset
+    @objc open dynamic var duration: Double {
+        return internalAU?.readings.duration ?? 0
+    }
+
+    // MARK: - Initialization
+
+    /// Initialize this loudness meter node
+    ///
+    /// - Parameters:
+    ///   - input: AKNode to measure
+    ///
+    @objc public init(_ input: AKNode? = nil) {
+
+        _Self.register()
+
+        super.init()
+        AVAudioUnit._instantiate(with: _Self.ComponentDescription) { [weak self] avAudioUnit in
+            guard let strongSelf = self else {
+                AKLog("Error: self is nil")
+                return
+            }
+            strongSelf.avAudioUnit = avAudioUnit
+            strongSelf.avAudioNode = avAudioUnit
+            strongSelf.internalAU = avAudioUnit.auAudioUnit as? AKAudioUnitType
+
+            input?.connect(to: strongSelf)
+        }
+    }
+
+    // MARK: - Levels
+
+    /// Sample peak of a channel over the last 400 ms
+    @objc open func peak(channel: Int = 0) -> Double {
+        return Double(internalAU?.channelReadings(channel)?.peak ?? 0)
+    }
+
+    /// RMS level of a channel over the last 400 ms
+    @objc open func rms(channel: Int = 0) -> Double {
+        return Double(internalAU?.channelReadings(channel)?.rms ?? 0)
+    }
+
+    /// Peak of a channel over the last 400 ms, including peaks between samples
+    @objc open func truePeak(channel: Int = 0) -> Double {
+        return Double(internalAU?.channelReadings(channel)?.truePeak ?? 0)
+    }
+
+    /// Highest true peak of a channel since the last reset
+    @objc open func maximumTruePeak(channel: Int = 0) -> Double {
+        return Double(internalAU?.channelReadings(channel)?.maximumTruePeak ?? 0)
+    }
+
+    /// Sets how much a channel contributes to the loudness, e.g. 1.41 for the surround channels of a 5.1 mix
+    @objc open func setWeight(_ weight: Double, channel: Int) {
+        internalAU?.setChannelWeight(channel, weight: weight)
+    }
+
+    // MARK: - Control
+
+    /// Clears the integrated loudness, the maximums and the duration
+    @objc open func reset() {
+        internalAU?.resetMeter()
+    }
+
+    /// Function to start, play, or activate the node, all do the same thing
+    @objc open func start() {
+        internalAU?.start()
+    }
+
+    /// Function to stop or bypass the node, both are equivalent
+    @objc open func stop() {
+        internalAU?.stop()
+    }
+}
@@ -0,0 +1,45 @@
+//
+//  AKLoudnessMeterAudioUnit.swift
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+import AVFoundation
+
+public class AKLoudnessMeterAudioUnit: AKAudioUnitBase {
+
+    var readings: AKLoudnessReadings {
+        var readings = AKLoudnessReadings()
+        getLoudnessMeterReadings(dsp, &readings)
+        return readings
+    }
+
+    func channelReadings(_ channel: Int) -> AKChannelMeterReadings? {
+        var readings = AKChannelMeterReadings()
+        return getLoudnessMeterChannelReadings(dsp, Int32(channel), &readings) ? readings : nil
+    }
+
+    func setChannelWeight(_ channel: Int, weight: Double) {
+        setLoudnessMeterChannelWeight(dsp, Int32(channel), Float(weight))
+    }
+
+    func resetMeter() {
+        resetLoudnessMeter(dsp)
+    }
+
+    public override func initDSP(withSampleRate sampleRate: Double,
+                                 channelCount count: AVAudioChannelCount) -> AKDSPRef {
+        return createLoudnessMeterDSP(Int32(count), sampleRate)
+    }
+
+    public override init(componentDescription: AudioComponentDescription,
+                         options: AudioComponentInstantiationOptions = []) throws {
+        try super.init(componentDescription: componentDescription, options: options)
+        setParameterTree(AUParameterTree(children: []))
+    }
+
+    public override var canProcessInPlace: Bool { return true }
+
+}
@@ -0,0 +1,63 @@
+//
+//  AKLoudnessMeterDSP.hpp
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+
+#import <AVFoundation/AVFoundation.h>
+
+#include "AKLoudnessMeter_Typedefs.h"
+
+#ifndef __cplusplus
+
+AKDSPRef createLoudnessMeterDSP(int channelCount, double sampleRate);
+void getLoudnessMeterReadings(AKDSPRef pDSP, AKLoudnessReadings *readings);
+bool getLoudnessMeterChannelReadings(AKDSPRef pDSP, int channel, AKChannelMeterReadings *readings);
+void setLoudnessMeterChannelWeight(AKDSPRef pDSP, int channel, float weight);
+void resetLoudnessMeter(AKDSPRef pDSP);
+
+#else
+
+#import "AKDSPBase.hpp"
+#include "AKLoudnessMeter.hpp"
+#include <vector>
+
+/// Passes its input through unchanged, metering it while started
+struct AKLoudnessMeterDSP : AKDSPBase {
+
+    AKLoudnessMeter meter;
+
+    void init(int channelCount, double sampleRate) override {
+        AKDSPBase::init(channelCount, sampleRate);
+        meter.init(channelCount, sampleRate);
+        inputs.resize(channelCount);
+    }
+
+    void deinit() override {
+        AKDSPBase::deinit();
+        meter.deinit();
+    }
+
+    bool canProcessInPlace() override { return true; }
+
+    void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override {
+        for (int channel = 0; channel < channelCount; ++channel) {
+            float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + bufferOffset;
+            float *out = (float *)outBufferListPtr->mBuffers[channel].mData + bufferOffset;
+            if (in != out) memcpy(out, in, frameCount * sizeof(float));
+            inputs[channel] = in;
+        }
+        if (isStarted && !inputs.empty()) {
+            meter.process(inputs.data(), frameCount);
+        }
+    }
+
+private:
+    std::vector<const float *> inputs;
+};
+
+#endif
@@ -0,0 +1,31 @@
+//
+//  AKLoudnessMeterDSP.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import "AKLoudnessMeterDSP.hpp"
+
+extern "C" AKDSPRef createLoudnessMeterDSP(int channelCount, double sampleRate) {
+    AKLoudnessMeterDSP *dsp = new AKLoudnessMeterDSP();
+    dsp->init(channelCount, sampleRate);
+    return dsp;
+}
+
+extern "C" void getLoudnessMeterReadings(AKDSPRef pDSP, AKLoudnessReadings *readings) {
+    ((AKLoudnessMeterDSP *)pDSP)->meter.getReadings(*readings);
+}
+
+extern "C" bool getLoudnessMeterChannelReadings(AKDSPRef pDSP, int channel, AKChannelMeterReadings *readings) {
+    return ((AKLoudnessMeterDSP *)pDSP)->meter.getChannelReadings(channel, *readings);
+}
+
+extern "C" void setLoudnessMeterChannelWeight(AKDSPRef pDSP, int channel, float weight) {
+    ((AKLoudnessMeterDSP *)pDSP)->meter.setChannelWeight(channel, weight);
+}
+
+extern "C" void resetLoudnessMeter(AKDSPRef pDSP) {
+    ((AKLoudnessMeterDSP *)pDSP)->meter.reset();
+}
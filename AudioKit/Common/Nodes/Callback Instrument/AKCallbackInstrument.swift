@@ -22,11 +22,25 @@ open class AKCallbackInstrument: AKPolyphonicNode, AKComponent {
 
     private var internalAU: AKAudioUnitType?
 
+    /// Called on a dedicated thread (not the audio thread) for every MIDI event the instrument receives
     open var callback: AKMIDICallback = { status, data1, data2 in } {
         willSet {
             internalAU?.callback = newValue
         }
     }
+
+    /// Like callback, but also passes the host time the event is meant to sound at
+    /// and how long after rendering it was delivered, in seconds
+    open var timedCallback: AKMIDITimedCallback? {
+        willSet {
+            internalAU?.timedCallback = newValue
+        }
+    }
+
+    /// Number of events dropped because the callbacks could not keep up with the audio thread
+    open var droppedEventCount: Int {
+        return Int(internalAU?.droppedEventCount ?? 0)
+    }
     // MARK: - Initialization
 
     @objc public override init() {
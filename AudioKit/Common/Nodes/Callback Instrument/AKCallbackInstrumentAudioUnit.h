@@ -11,8 +11,14 @@
 
 typedef void (^AKCMIDICallback)(uint8_t, uint8_t, uint8_t);
 
+/// MIDI callback that also receives the host time at which the event is meant to sound
+/// and the seconds elapsed between rendering the event and dispatching it
+typedef void (^AKCMIDITimedCallback)(uint8_t, uint8_t, uint8_t, uint64_t, double);
+
 @interface AKCallbackInstrumentAudioUnit : AKAudioUnit
 @property (nonatomic) AKCMIDICallback callback;
+@property (nonatomic) AKCMIDITimedCallback timedCallback;
+@property (readonly) int droppedEventCount;
 - (void)destroy;
 - (void)startNote:(uint8_t)note velocity:(uint8_t)velocity;
 - (void)stopNote:(uint8_t)note;
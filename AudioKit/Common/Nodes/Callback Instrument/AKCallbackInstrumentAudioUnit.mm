@@ -26,6 +26,12 @@
 -(void)setCallback:(AKCMIDICallback)callback {
     _kernel.callback = callback;
 }
+-(void)setTimedCallback:(AKCMIDITimedCallback)timedCallback {
+    _kernel.timedCallback = timedCallback;
+}
+-(int)droppedEventCount {
+    return _kernel.getDroppedEventCount();
+}
 - (void)startNote:(uint8_t)note velocity:(uint8_t)velocity {
     _kernel.startNote(note, velocity);
 }
@@ -45,7 +51,37 @@ standardKernelPassthroughs()
     parameterTreeBlock(CallbackInstrument)
 }
 
-AUAudioUnitGeneratorOverrides(CallbackInstrument)
+- (BOOL)allocateRenderResourcesAndReturnError:(NSError **)outError {
+    if (![super allocateRenderResourcesAndReturnError:outError]) {
+        return NO;
+    }
+    _outputBusBuffer.allocateRenderResources(self.maximumFramesToRender);
+    _kernel.init(self.outputBus.format.channelCount, self.outputBus.format.sampleRate);
+    _kernel.reset();
+    return YES;
+}
+
+- (void)deallocateRenderResources {
+    _outputBusBuffer.deallocateRenderResources();
+    [super deallocateRenderResources];
+}
+
+- (AUInternalRenderBlock)internalRenderBlock {
+    __block AKCallbackInstrumentDSPKernel *state = &_kernel;
+    return ^AUAudioUnitStatus(AudioUnitRenderActionFlags *actionFlags,
+                              const AudioTimeStamp       *timestamp,
+                              AVAudioFrameCount           frameCount,
+                              NSInteger                   outputBusNumber,
+                              AudioBufferList            *outputData,
+                              const AURenderEvent        *realtimeEventListHead,
+                              AURenderPullInputBlock      pullInputBlock) {
+        _outputBusBuffer.prepareOutputBufferList(outputData, frameCount, true);
+        state->setBuffer(outputData);
+        state->setRenderTimestamp(timestamp);
+        state->processWithEvents(timestamp, frameCount, realtimeEventListHead);
+        return noErr;
+    };
+}
 
 @end
 
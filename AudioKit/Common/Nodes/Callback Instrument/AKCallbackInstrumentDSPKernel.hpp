@@ -8,21 +8,59 @@
 
 #pragma once
 #import "AKSoundpipeKernel.hpp"
+#import "TPCircularBuffer.h"
+#import "AKDSPCommandBus.hpp"
+#import <dispatch/dispatch.h>
+#import <mach/mach_time.h>
+#import <atomic>
+#import <thread>
+
+/// Number of MIDI events that can wait for the callback thread before new ones are dropped
+#define AKCALLBACKINSTRUMENT_QUEUE_SIZE 1024
+
+/// A MIDI event on its way from the render thread to the callback thread
+struct AKCallbackInstrumentEvent {
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    uint64_t hostTime;          // when the event is meant to sound
+    uint64_t renderHostTime;    // when the render thread queued it
+};
 
+/**
+ The render thread only copies incoming MIDI into a preallocated lock-free queue;
+ the user's callbacks run on a dedicated thread, so however slow they are they
+ cannot make the render cycle miss its deadline. Notes started and stopped from
+ other threads reach that queue through the render thread too, so all callbacks
+ come from the one thread, in order.
+ */
 class AKCallbackInstrumentDSPKernel : public AKSoundpipeKernel, public AKOutputBuffered {
 public:
     // MARK: Member Functions
 
-    AKCallbackInstrumentDSPKernel() {}
+    AKCallbackInstrumentDSPKernel() {
+        TPCircularBufferInit(&eventQueue, AKCALLBACKINSTRUMENT_QUEUE_SIZE * sizeof(AKCallbackInstrumentEvent));
+        wakeup = dispatch_semaphore_create(0);
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        ticksPerSecond = 1.0e9 * (double)timebase.denom / (double)timebase.numer;
+    }
+
+    ~AKCallbackInstrumentDSPKernel() {
+        stopCallbackThread();
+        TPCircularBufferCleanup(&eventQueue);
+    }
 
     void init(int _channels, double _sampleRate) override {
         AKSoundpipeKernel::init(_channels, _sampleRate);
+        startCallbackThread();
     }
 
     void destroy() {
+        stopCallbackThread();
         AKSoundpipeKernel::destroy();
     }
-    
+
     void start() {
         started = true;
     }
@@ -47,48 +85,137 @@ public:
 
     }
 
+    /// Call from the render block before processWithEvents so events can be stamped with host time
+    void setRenderTimestamp(AudioTimeStamp const *timestamp) {
+        renderTimestamp = *timestamp;
+    }
+
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override {
-        //do nothing
-        for (int i = 0; i < frameCount; i++) {
-            count += 1;
-            if (updateTime) {
-                int diff = count - lastFrameCount;
-                printf("debug: time is %i diff is %i\n", count, diff);
-                lastFrameCount = count;
-                updateTime = false;
-            }
+        AKDSPCommand command;
+        while (commandBus.pop(command)) {
+            uint8_t status = command.type == AKDSPCommandNoteOn ? 0x90 : 0x80;
+            AUEventSampleTime sampleTime = (AUEventSampleTime)renderTimestamp.mSampleTime + bufferOffset;
+            queueEvent(status, command.note.noteNumber, command.note.velocity, hostTimeForSampleTime(sampleTime));
+        }
+
+        // Wake the callback thread once per segment rather than once per event
+        if (eventsQueued) {
+            eventsQueued = false;
+            dispatch_semaphore_signal(wakeup);
         }
     }
 
+    // startNote and stopNote come from other threads; the render thread queues them at its next render
     void startNote(int note, int velocity) {
-        doCallback(0x90, note, velocity);
+        postNote(AKDSPCommandNoteOn, note, velocity);
     }
 
     void stopNote(int note) {
-        doCallback(0x80, note, 0);
+        postNote(AKDSPCommandNoteOff, note, 0);
     }
 
     virtual void handleMIDIEvent(AUMIDIEvent const& midiEvent) override {
         if (midiEvent.length != 3) return;
-        uint8_t status = midiEvent.data[0];
-        uint8_t data1 = midiEvent.data[1];
-        uint8_t data2 = midiEvent.data[2];
-        doCallback(status, data1, data2);
+        queueEvent(midiEvent.data[0], midiEvent.data[1], midiEvent.data[2],
+                   hostTimeForSampleTime(midiEvent.eventSampleTime));
     }
 
-    void doCallback(int status, int data1, int data2) {
-        if (callback != NULL){
+    void doCallback(int status, int data1, int data2, uint64_t hostTime, uint64_t renderHostTime) {
+        if (callback != NULL) {
             callback(status, data1, data2);
         }
+        if (timedCallback != NULL) {
+            double latency = (double)((int64_t)(mach_absolute_time() - renderHostTime)) / ticksPerSecond;
+            timedCallback(status, data1, data2, hostTime, latency);
+        }
     }
-    
+
+    /// Events lost because the callback thread fell more than a queue's worth behind
+    int getDroppedEventCount() { return droppedEventCount + commandBus.getDroppedCount(); }
+
 private:
-    int count = 0;
-    int lastFrameCount = 0;
-    bool updateTime = false;
+
+    void postNote(AKDSPCommandType type, int note, int velocity) {
+        AKDSPCommand command;
+        command.type = type;
+        command.sampleTime = AKDSPCommandImmediate;
+        command.note.noteNumber = note;
+        command.note.velocity = velocity;
+        command.note.immediate = false;
+        command.note.frequency = 0.0f;
+        commandBus.post(command);
+    }
+
+    /// Render thread only
+    void queueEvent(uint8_t status, uint8_t data1, uint8_t data2, uint64_t hostTime) {
+        AKCallbackInstrumentEvent event;
+        event.status = status;
+        event.data1 = data1;
+        event.data2 = data2;
+        event.hostTime = hostTime;
+        event.renderHostTime = mach_absolute_time();
+        if (TPCircularBufferProduceBytes(&eventQueue, &event, sizeof(event))) {
+            eventsQueued = true;
+        } else {
+            droppedEventCount++;
+        }
+    }
+
+    uint64_t hostTimeForSampleTime(AUEventSampleTime sampleTime) {
+        if (!(renderTimestamp.mFlags & kAudioTimeStampHostTimeValid)) {
+            return mach_absolute_time();
+        }
+        double offsetSeconds = (double)(sampleTime - (AUEventSampleTime)renderTimestamp.mSampleTime) / sampleRate;
+        return renderTimestamp.mHostTime + (int64_t)(offsetSeconds * ticksPerSecond);
+    }
+
+    void startCallbackThread() {
+        if (callbackThreadRunning) return;
+        callbackThreadRunning = true;
+        callbackThread = std::thread([this] {
+            while (callbackThreadRunning) {
+                dispatch_semaphore_wait(wakeup, DISPATCH_TIME_FOREVER);
+                drainEventQueue();
+            }
+        });
+    }
+
+    void stopCallbackThread() {
+        if (!callbackThreadRunning) return;
+        callbackThreadRunning = false;
+        dispatch_semaphore_signal(wakeup);
+        if (callbackThread.joinable()) {
+            callbackThread.join();
+        }
+    }
+
+    void drainEventQueue() {
+        uint32_t availableBytes = 0;
+        AKCallbackInstrumentEvent *events = (AKCallbackInstrumentEvent *)TPCircularBufferTail(&eventQueue, &availableBytes);
+        while (events != nullptr && availableBytes >= sizeof(AKCallbackInstrumentEvent)) {
+            uint32_t count = availableBytes / sizeof(AKCallbackInstrumentEvent);
+            for (uint32_t i = 0; i < count; i++) {
+                doCallback(events[i].status, events[i].data1, events[i].data2,
+                           events[i].hostTime, events[i].renderHostTime);
+            }
+            TPCircularBufferConsume(&eventQueue, count * sizeof(AKCallbackInstrumentEvent));
+            events = (AKCallbackInstrumentEvent *)TPCircularBufferTail(&eventQueue, &availableBytes);
+        }
+    }
+
+    TPCircularBuffer eventQueue;
+    AKDSPCommandBus commandBus;
+    dispatch_semaphore_t wakeup;
+    std::thread callbackThread;
+    std::atomic<bool> callbackThreadRunning{false};
+    std::atomic<int> droppedEventCount{0};
+    bool eventsQueued = false;
+    AudioTimeStamp renderTimestamp = {};
+    double ticksPerSecond = 1.0e9;
 
 public:
     bool started = false;
     bool resetted = false;
     AKCMIDICallback callback = nullptr;
+    AKCMIDITimedCallback timedCallback = nullptr;
 };
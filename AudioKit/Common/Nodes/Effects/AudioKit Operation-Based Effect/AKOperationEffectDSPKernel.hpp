@@ -97,11 +97,12 @@ public:
         }
     }
 
+    bool canProcessInPlace() { return true; }
+
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override {
 
         if (!started) {
-            outBufferListPtr->mBuffers[0] = inBufferListPtr->mBuffers[0];
-            outBufferListPtr->mBuffers[1] = inBufferListPtr->mBuffers[1];
+            passThrough(frameCount, bufferOffset);
             return;
         }
 
@@ -8,6 +8,7 @@
 
 #include "AKKorgLowPassFilterDSP.hpp"
 #import "AKLinearParameterRamp.hpp"
+#include <algorithm>
 
 extern "C" AKDSPRef createKorgLowPassFilterDSP(int channelCount, double sampleRate) {
     AKKorgLowPassFilterDSP *dsp = new AKKorgLowPassFilterDSP();
@@ -88,8 +89,10 @@ void AKKorgLowPassFilterDSP::deinit() {
 
 void AKKorgLowPassFilterDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) {
 
-    for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+    // The parameters only move every 8 samples, so filter in blocks between those points
+    for (int frameIndex = 0; frameIndex < frameCount;) {
         int frameOffset = int(frameIndex + bufferOffset);
+        int blockFrames = std::min(8 - (frameOffset & 0x7), int(frameCount) - frameIndex);
 
         // do ramping every 8 samples
         if ((frameOffset & 0x7) == 0) {
@@ -105,25 +108,20 @@ void AKKorgLowPassFilterDSP::process(AUAudioFrameCount frameCount, AUAudioFrameC
         data->wpkorg350->saturation = data->saturationRamp.getValue();
         data->wpkorg351->saturation = data->saturationRamp.getValue();
 
-        float *tmpin[2];
-        float *tmpout[2];
         for (int channel = 0; channel < channelCount; ++channel) {
             float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + frameOffset;
             float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
-            if (channel < 2) {
-                tmpin[channel] = in;
-                tmpout[channel] = out;
-            }
             if (!isStarted) {
-                *out = *in;
+                if (in != out) memcpy(out, in, blockFrames * sizeof(float));
                 continue;
             }
 
             if (channel == 0) {
-                sp_wpkorg35_compute(sp, data->wpkorg350, in, out);
+                sp_wpkorg35_compute_block(sp, data->wpkorg350, in, out, blockFrames);
             } else {
-                sp_wpkorg35_compute(sp, data->wpkorg351, in, out);
+                sp_wpkorg35_compute_block(sp, data->wpkorg351, in, out, blockFrames);
             }
         }
+        frameIndex += blockFrames;
     }
 }
@@ -8,6 +8,7 @@
 
 #include "AKMoogLadderDSP.hpp"
 #import "AKLinearParameterRamp.hpp"
+#include <algorithm>
 
 extern "C" AKDSPRef createMoogLadderDSP(int channelCount, double sampleRate) {
     AKMoogLadderDSP *dsp = new AKMoogLadderDSP();
@@ -77,8 +78,10 @@ void AKMoogLadderDSP::deinit() {
 
 void AKMoogLadderDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) {
 
-    for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+    // The parameters only move every 8 samples, so filter in blocks between those points
+    for (int frameIndex = 0; frameIndex < frameCount;) {
         int frameOffset = int(frameIndex + bufferOffset);
+        int blockFrames = std::min(8 - (frameOffset & 0x7), int(frameCount) - frameIndex);
 
         // do ramping every 8 samples
         if ((frameOffset & 0x7) == 0) {
@@ -91,25 +94,20 @@ void AKMoogLadderDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount bu
         data->moogladder0->res = data->resonanceRamp.getValue();
         data->moogladder1->res = data->resonanceRamp.getValue();
 
-        float *tmpin[2];
-        float *tmpout[2];
         for (int channel = 0; channel < channelCount; ++channel) {
             float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + frameOffset;
             float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
-            if (channel < 2) {
-                tmpin[channel] = in;
-                tmpout[channel] = out;
-            }
             if (!isStarted) {
-                *out = *in;
+                if (in != out) memcpy(out, in, blockFrames * sizeof(float));
                 continue;
             }
 
             if (channel == 0) {
-                sp_moogladder_compute(sp, data->moogladder0, in, out);
+                sp_moogladder_compute_block(sp, data->moogladder0, in, out, blockFrames);
             } else {
-                sp_moogladder_compute(sp, data->moogladder1, in, out);
+                sp_moogladder_compute_block(sp, data->moogladder1, in, out, blockFrames);
             }
         }
+        frameIndex += blockFrames;
     }
 }
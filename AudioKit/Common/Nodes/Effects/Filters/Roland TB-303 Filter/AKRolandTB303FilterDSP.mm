@@ -8,6 +8,7 @@
 
 #include "AKRolandTB303FilterDSP.hpp"
 #import "AKLinearParameterRamp.hpp"
+#include <algorithm>
 
 extern "C" AKDSPRef createRolandTB303FilterDSP(int channelCount, double sampleRate) {
     AKRolandTB303FilterDSP *dsp = new AKRolandTB303FilterDSP();
@@ -99,8 +100,10 @@ void AKRolandTB303FilterDSP::deinit() {
 
 void AKRolandTB303FilterDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) {
 
-    for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+    // The parameters only move every 8 samples, so filter in blocks between those points
+    for (int frameIndex = 0; frameIndex < frameCount;) {
         int frameOffset = int(frameIndex + bufferOffset);
+        int blockFrames = std::min(8 - (frameOffset & 0x7), int(frameCount) - frameIndex);
 
         // do ramping every 8 samples
         if ((frameOffset & 0x7) == 0) {
@@ -119,25 +122,20 @@ void AKRolandTB303FilterDSP::process(AUAudioFrameCount frameCount, AUAudioFrameC
         data->tbvcf0->asym = data->resonanceAsymmetryRamp.getValue();
         data->tbvcf1->asym = data->resonanceAsymmetryRamp.getValue();
 
-        float *tmpin[2];
-        float *tmpout[2];
         for (int channel = 0; channel < channelCount; ++channel) {
             float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + frameOffset;
             float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
-            if (channel < 2) {
-                tmpin[channel] = in;
-                tmpout[channel] = out;
-            }
             if (!isStarted) {
-                *out = *in;
+                if (in != out) memcpy(out, in, blockFrames * sizeof(float));
                 continue;
             }
 
             if (channel == 0) {
-                sp_tbvcf_compute(sp, data->tbvcf0, in, out);
+                sp_tbvcf_compute_block(sp, data->tbvcf0, in, out, blockFrames);
             } else {
-                sp_tbvcf_compute(sp, data->tbvcf1, in, out);
+                sp_tbvcf_compute_block(sp, data->tbvcf1, in, out, blockFrames);
             }
         }
+        frameIndex += blockFrames;
     }
 }
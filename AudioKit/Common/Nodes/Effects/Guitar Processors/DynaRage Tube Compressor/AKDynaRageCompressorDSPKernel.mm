@@ -10,6 +10,10 @@
 
 #import "Compressor.h"
 #import "RageProcessor.h"
+#import <algorithm>
+
+// Parameters are ramped a chunk at a time, so constant ones cost nothing per sample
+#define AKDYNARAGE_CHUNKSIZE 64
 
 struct AKDynaRageCompressorDSPKernel::InternalData {
     Compressor *left_compressor;
@@ -157,38 +161,75 @@ void AKDynaRageCompressorDSPKernel::startRamp(AUParameterAddress address, AUValu
 
 void AKDynaRageCompressorDSPKernel::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) {
 
-    for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
-
-        int frameOffset = int(frameIndex + bufferOffset);
-
-        data->ratio = ratioRamper.getAndStep();
-        data->threshold = thresholdRamper.getAndStep();
-        data->attackDuration = attackDurationRamper.getAndStep();
-        data->releaseDuration = releaseDurationRamper.getAndStep();
-        data->rage = rageRamper.getAndStep();
-
-        data->left_compressor->setParameters(data->threshold, data->ratio,
+    float ratio[AKDYNARAGE_CHUNKSIZE];
+    float threshold[AKDYNARAGE_CHUNKSIZE];
+    float attackDuration[AKDYNARAGE_CHUNKSIZE];
+    float releaseDuration[AKDYNARAGE_CHUNKSIZE];
+    float rage[AKDYNARAGE_CHUNKSIZE];
+
+    for (int chunkStart = 0; chunkStart < frameCount; chunkStart += AKDYNARAGE_CHUNKSIZE) {
+        int chunkSize = std::min(int(frameCount) - chunkStart, AKDYNARAGE_CHUNKSIZE);
+
+        // A parameter that is not ramping leaves its array alone and is read once from its ramper
+        bool ratioConstant = ratioRamper.getAndStepBlock(ratio, chunkSize);
+        bool thresholdConstant = thresholdRamper.getAndStepBlock(threshold, chunkSize);
+        bool attackDurationConstant = attackDurationRamper.getAndStepBlock(attackDuration, chunkSize);
+        bool releaseDurationConstant = releaseDurationRamper.getAndStepBlock(releaseDuration, chunkSize);
+        bool rageConstant = rageRamper.getAndStepBlock(rage, chunkSize);
+        bool compressorConstant = ratioConstant && thresholdConstant && attackDurationConstant && releaseDurationConstant;
+
+        if (compressorConstant) {
+            // setParameters recomputes the envelope time constants, so do it once for the whole chunk
+            data->ratio = ratioRamper.get();
+            data->threshold = thresholdRamper.get();
+            data->attackDuration = attackDurationRamper.get();
+            data->releaseDuration = releaseDurationRamper.get();
+            data->left_compressor->setParameters(data->threshold, data->ratio,
                                                  data->attackDuration, data->releaseDuration);
-        data->right_compressor->setParameters(data->threshold, data->ratio,
+            data->right_compressor->setParameters(data->threshold, data->ratio,
                                                   data->attackDuration, data->releaseDuration);
+        }
+        if (rageConstant) {
+            data->rage = rageRamper.get();
+        }
+
+        for (int frameIndex = chunkStart; frameIndex < chunkStart + chunkSize; ++frameIndex) {
 
-        for (int channel = 0; channel < channels; ++channel) {
-            float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + frameOffset;
-            float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
+            int frameOffset = int(frameIndex + bufferOffset);
+            int i = frameIndex - chunkStart;
 
-            if (started) {
-                if (channel == 0) {
+            if (!compressorConstant) {
+                data->ratio = ratioConstant ? ratioRamper.get() : ratio[i];
+                data->threshold = thresholdConstant ? thresholdRamper.get() : threshold[i];
+                data->attackDuration = attackDurationConstant ? attackDurationRamper.get() : attackDuration[i];
+                data->releaseDuration = releaseDurationConstant ? releaseDurationRamper.get() : releaseDuration[i];
+                data->left_compressor->setParameters(data->threshold, data->ratio,
+                                                     data->attackDuration, data->releaseDuration);
+                data->right_compressor->setParameters(data->threshold, data->ratio,
+                                                      data->attackDuration, data->releaseDuration);
+            }
+            if (!rageConstant) {
+                data->rage = rage[i];
+            }
 
-                    float rageSignal = data->left_rageprocessor->doRage(*in, data->rage, data->rage);
-                    float compSignal = data->left_compressor->Process((bool)data->rageIsOn ? rageSignal : *in, false, 1);
-                    *out = compSignal;
+            for (int channel = 0; channel < channels; ++channel) {
+                float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + frameOffset;
+                float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
+
+                if (started) {
+                    if (channel == 0) {
+
+                        float rageSignal = data->left_rageprocessor->doRage(*in, data->rage, data->rage);
+                        float compSignal = data->left_compressor->Process((bool)data->rageIsOn ? rageSignal : *in, false, 1);
+                        *out = compSignal;
+                    } else {
+                        float rageSignal = data->right_rageprocessor->doRage(*in, data->rage, data->rage);
+                        float compSignal = data->right_compressor->Process((bool)data->rageIsOn ? rageSignal : *in, false, 1);
+                        *out = compSignal;
+                    }
                 } else {
-                    float rageSignal = data->right_rageprocessor->doRage(*in, data->rage, data->rage);
-                    float compSignal = data->right_compressor->Process((bool)data->rageIsOn ? rageSignal : *in, false, 1);
-                    *out = compSignal;
+                    *out = *in;
                 }
-            } else {
-                *out = *in;
             }
         }
     }
@@ -62,6 +62,8 @@ public:
 private:
     struct InternalData;
     std::unique_ptr<InternalData> data;
+
+    void updateEqualizers(float lowGain, float midGain, float highGain);
     
 public:
     bool started = true;
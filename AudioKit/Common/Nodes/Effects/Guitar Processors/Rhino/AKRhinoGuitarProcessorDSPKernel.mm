@@ -13,9 +13,13 @@
 #import "Equalisator.h"
 #import <math.h>
 #import <iostream>
+#import <algorithm>
 
 using namespace std;
 
+// Parameters are ramped a chunk at a time, so constant ones cost nothing per sample
+#define AKRHINO_CHUNKSIZE 64
+
 struct AKRhinoGuitarProcessorDSPKernel::InternalData {
     RageProcessor *leftRageProcessor;
     RageProcessor *rightRageProcessor;
@@ -38,6 +42,12 @@ struct AKRhinoGuitarProcessorDSPKernel::InternalData {
     float midGain = 0.0;
     float highGain = 0.0;
     float distortion = 1.0;
+
+    // gains the EQ coefficients were last computed for
+    bool eqCoefficientsValid = false;
+    float eqLowGain = 0.0;
+    float eqMidGain = 0.0;
+    float eqHighGain = 0.0;
 };
 
 AKRhinoGuitarProcessorDSPKernel::AKRhinoGuitarProcessorDSPKernel() : data(new InternalData) {}
@@ -85,6 +95,8 @@ void AKRhinoGuitarProcessorDSPKernel::init(int channelCount, double sampleRate)
     midGainRamper.init();
     highGainRamper.init();
     distortionRamper.init();
+
+    data->eqCoefficientsValid = false;
 }
 
 void AKRhinoGuitarProcessorDSPKernel::start() {
@@ -219,47 +231,91 @@ void AKRhinoGuitarProcessorDSPKernel::startRamp(AUParameterAddress address, AUVa
     }
 }
 
-void AKRhinoGuitarProcessorDSPKernel::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) {
+void AKRhinoGuitarProcessorDSPKernel::updateEqualizers(float lowGain, float midGain, float highGain) {
+    data->lowGain = lowGain;
+    data->midGain = midGain;
+    data->highGain = highGain;
 
-    for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+    // The coefficients only depend on the gains, so skip the trigonometry when they have not moved
+    if (data->eqCoefficientsValid &&
+        lowGain == data->eqLowGain && midGain == data->eqMidGain && highGain == data->eqHighGain) {
+        return;
+    }
+    data->eqCoefficientsValid = true;
+    data->eqLowGain = lowGain;
+    data->eqMidGain = midGain;
+    data->eqHighGain = highGain;
 
-        int frameOffset = int(frameIndex + bufferOffset);
+    data->leftEqLo->calc_filter_coeffs(7, 120, sampleRate, 0.75, -2 * -lowGain, false);
+    data->rightEqLo->calc_filter_coeffs(7, 120, sampleRate, 0.75, -2 * -lowGain, false);
 
-        data->preGain = preGainRamper.getAndStep();
-        data->postGain = postGainRamper.getAndStep();
-        data->lowGain = lowGainRamper.getAndStep();
-        data->midGain = midGainRamper.getAndStep();
-        data->highGain = highGainRamper.getAndStep();
-        data->distortion = distortionRamper.getAndStep();
+    data->leftEqMi->calc_filter_coeffs(6, 2450, sampleRate, 1.7, 2.5 * midGain, true);
+    data->rightEqMi->calc_filter_coeffs(6, 2450, sampleRate, 1.7, 2.5 * midGain, true);
 
-        data->leftEqLo->calc_filter_coeffs(7, 120, sampleRate, 0.75, -2 * -data->lowGain, false);
-        data->rightEqLo->calc_filter_coeffs(7, 120, sampleRate, 0.75, -2 * -data->lowGain, false);
+    data->leftEqHi->calc_filter_coeffs(8, 6100, sampleRate, 1.6, -15 * -highGain, false);
+    data->rightEqHi->calc_filter_coeffs(8, 6100, sampleRate, 1.6, -15 * -highGain, false);
+}
 
-        data->leftEqMi->calc_filter_coeffs(6, 2450, sampleRate, 1.7, 2.5 * data->midGain, true);
-        data->rightEqMi->calc_filter_coeffs(6, 2450, sampleRate, 1.7, 2.5 * data->midGain, true);
+void AKRhinoGuitarProcessorDSPKernel::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) {
 
-        data->leftEqHi->calc_filter_coeffs(8, 6100, sampleRate, 1.6, -15 * -data->highGain, false);
-        data->rightEqHi->calc_filter_coeffs(8, 6100, sampleRate, 1.6, -15 * -data->highGain, false);
+    float preGain[AKRHINO_CHUNKSIZE];
+    float postGain[AKRHINO_CHUNKSIZE];
+    float lowGain[AKRHINO_CHUNKSIZE];
+    float midGain[AKRHINO_CHUNKSIZE];
+    float highGain[AKRHINO_CHUNKSIZE];
+    float distortion[AKRHINO_CHUNKSIZE];
+
+    for (int chunkStart = 0; chunkStart < frameCount; chunkStart += AKRHINO_CHUNKSIZE) {
+        int chunkSize = std::min(int(frameCount) - chunkStart, AKRHINO_CHUNKSIZE);
+
+        // A parameter that is not ramping leaves its array alone and is read once from its ramper
+        bool preGainConstant = preGainRamper.getAndStepBlock(preGain, chunkSize);
+        bool postGainConstant = postGainRamper.getAndStepBlock(postGain, chunkSize);
+        bool lowGainConstant = lowGainRamper.getAndStepBlock(lowGain, chunkSize);
+        bool midGainConstant = midGainRamper.getAndStepBlock(midGain, chunkSize);
+        bool highGainConstant = highGainRamper.getAndStepBlock(highGain, chunkSize);
+        bool distortionConstant = distortionRamper.getAndStepBlock(distortion, chunkSize);
+        bool eqConstant = lowGainConstant && midGainConstant && highGainConstant;
+
+        if (eqConstant) {
+            updateEqualizers(lowGainRamper.get(), midGainRamper.get(), highGainRamper.get());
+        }
 
-        float *tmpin[2];
-        float *tmpout[2];
-        for (int channel = 0; channel < 2; ++channel) {
-            float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + frameOffset;
-            float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
-            if (channel < 2) {
-                tmpin[channel] = in;
-                tmpout[channel] = out;
-            }
-            if (!started) {
-                *out = *in;
-                continue;
+        for (int frameIndex = chunkStart; frameIndex < chunkStart + chunkSize; ++frameIndex) {
+
+            int frameOffset = int(frameIndex + bufferOffset);
+            int i = frameIndex - chunkStart;
+
+            data->preGain = preGainConstant ? preGainRamper.get() : preGain[i];
+            data->postGain = postGainConstant ? postGainRamper.get() : postGain[i];
+            data->distortion = distortionConstant ? distortionRamper.get() : distortion[i];
+
+            if (!eqConstant) {
+                updateEqualizers(lowGainConstant ? lowGainRamper.get() : lowGain[i],
+                                 midGainConstant ? midGainRamper.get() : midGain[i],
+                                 highGainConstant ? highGainRamper.get() : highGain[i]);
             }
 
-            *in = *in * (data->preGain);
-            const float r_Sig = data->leftRageProcessor->doRage(*in, data->distortion * 2, data->distortion * 2);
-            const float e_Sig = data->leftEqLo->filter(data->leftEqMi->filter(data->leftEqHi->filter(r_Sig))) *
-            (1 / (data->distortion*0.8));
-            *out = e_Sig * data->postGain;
+            float *tmpin[2];
+            float *tmpout[2];
+            for (int channel = 0; channel < 2; ++channel) {
+                float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + frameOffset;
+                float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
+                if (channel < 2) {
+                    tmpin[channel] = in;
+                    tmpout[channel] = out;
+                }
+                if (!started) {
+                    *out = *in;
+                    continue;
+                }
+
+                *in = *in * (data->preGain);
+                const float r_Sig = data->leftRageProcessor->doRage(*in, data->distortion * 2, data->distortion * 2);
+                const float e_Sig = data->leftEqLo->filter(data->leftEqMi->filter(data->leftEqHi->filter(r_Sig))) *
+                (1 / (data->distortion*0.8));
+                *out = e_Sig * data->postGain;
+            }
         }
     }
 }
@@ -45,6 +45,8 @@ void AKConvolutionDSP::setUpTable(float *table, UInt32 size) {
 void AKConvolutionDSP::initConvolutionEngine() {
     sp_conv_create(&data->conv0);
     sp_conv_create(&data->conv1);
+    // Both channels, and any other node loaded with the same impulse response,
+    // share one copy of its transformed partitions
     sp_conv_init(sp, data->conv0, data->ftbl, (float)data->partitionLength);
     sp_conv_init(sp, data->conv1, data->ftbl, (float)data->partitionLength);
 }
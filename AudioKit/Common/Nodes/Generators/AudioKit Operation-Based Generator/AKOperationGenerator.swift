@@ -44,6 +44,18 @@ open class AKOperationGenerator: AKNode, AKToggleable, AKComponent {
         }
     }
 
+    /// Number of threads to compute independent parts of the patch on, such as separate voices, including
+    /// the render thread. The default of 1 computes everything on the render thread; more gives this
+    /// generator its own real-time worker threads. Takes effect when AudioKit next starts.
+    @objc open dynamic var threadCount: Int {
+        get {
+            return Int(internalAU?.threadCount ?? 1)
+        }
+        set {
+            internalAU?.threadCount = Int32(newValue)
+        }
+    }
+
     private var customUgens: [AKCustomUgen]
 
     // MARK: - Initializers
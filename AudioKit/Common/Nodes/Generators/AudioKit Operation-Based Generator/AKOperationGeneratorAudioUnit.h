@@ -13,6 +13,7 @@
 
 @interface AKOperationGeneratorAudioUnit : AKAudioUnit
 @property (nonatomic) NSArray *parameters;
+@property (nonatomic) int threadCount;
 - (void)setSporth:(NSString *)sporth;
 - (void)trigger:(int)trigger;
 - (void)addCustomUgen:(AKCustomUgen *)ugen;
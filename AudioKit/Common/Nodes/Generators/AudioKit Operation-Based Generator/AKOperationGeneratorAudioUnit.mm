@@ -46,6 +46,14 @@
     _kernel.setParameters(temporaryParameters);
 }
 
+- (int)threadCount {
+    return _kernel.getThreadCount();
+}
+
+- (void)setThreadCount:(int)threadCount {
+    _kernel.setThreadCount(threadCount);
+}
+
 - (void)addCustomUgen:(AKCustomUgen *)ugen {
     char *cName = (char *)[ugen.name UTF8String];
     _kernel.addCustomUgen({cName, &akCustomUgenFunction, (__bridge void *)ugen});
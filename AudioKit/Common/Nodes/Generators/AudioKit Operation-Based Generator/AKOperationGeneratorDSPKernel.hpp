@@ -8,6 +8,8 @@
 
 #pragma once
 
+#import <algorithm>
+#import <thread>
 #import <vector>
 
 #import "AKSoundpipeKernel.hpp"
@@ -34,6 +36,10 @@ public:
 
         plumber_register(&pd);
         plumber_init(&pd);
+        // Independent parts of a patch, such as separate voices, are computed on worker threads if asked for
+        int cores = (int)std::max(std::thread::hardware_concurrency(), 1u);
+        plumber_parallel_init(&pd, std::min(threadCount, cores), 512);
+        outputs.resize(channelCount);
         if (customUgens.size() > 0) {
             addUgensToFTable(&pd);
         }
@@ -64,6 +70,16 @@ public:
         }
     }
 
+    /// Threads to compute the patch on, including the render thread; 1 computes it all on the render
+    /// thread. Each generator with more than one has its own real-time workers. Takes effect at the next init.
+    void setThreadCount(int count) {
+        threadCount = std::max(count, 1);
+    }
+
+    int getThreadCount() {
+        return threadCount;
+    }
+
     void trigger(int trigger) {
         internalTriggers[trigger] = 1;
     }
@@ -116,30 +132,23 @@ public:
 
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override {
 
-        for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
-
-            int frameOffset = int(frameIndex + bufferOffset);
-
-
-            for (int i = 0; i < 14; i++) {
-                if (internalTriggers[i] == 1) {
-                    pd.p[i] = 1.0;
-                } else {
-                    pd.p[i] = parameters[i];
-                }
+        for (int i = 0; i < 14; i++) {
+            if (internalTriggers[i] == 1) {
+                pd.p[i] = 1.0;
+            } else {
+                pd.p[i] = parameters[i];
             }
+        }
 
-            if (started) {
-                plumber_compute(&pd, PLUMBER_COMPUTE);
-            }
+        for (int channel = 0; channel < channels; ++channel) {
+            outputs[channel] = (float *)outBufferListPtr->mBuffers[channel].mData + bufferOffset;
+        }
 
+        if (started) {
+            plumber_compute_block(&pd, outputs.data(), channels, frameCount);
+        } else {
             for (int channel = 0; channel < channels; ++channel) {
-                float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
-                if (started) {
-                    *out = sporth_stack_pop_float(&pd.sporth.stack);
-                } else {
-                    *out = 0;
-                }
+                memset(outputs[channel], 0, frameCount * sizeof(float));
             }
         }
 
@@ -157,10 +166,12 @@ public:
 private:
 
     int internalTriggers[14] = {0};
+    int threadCount = 1;
 
     plumber_data pd;
     char *sporthCode = nil;
     std::vector<AKCustomUgenInfo> customUgens;
+    std::vector<float *> outputs;
 
 public:
     float parameters[14] = {0};
@@ -17,44 +17,36 @@ protected:
     
     struct NoteState  : public AKBankDSPKernel::NoteState {
 
-        sp_blsquare *blsquare;
+        // The oscillator itself is a lane of the kernel's blepbank, so a note keeps only its phase
+        float frequency = 0;
+        float amplitude = 0;
+        float phase = 0;
+        int lane = 0;
 
-        NoteState() {
-            sp_blsquare_create(&blsquare);
-        }
-        
-        virtual ~NoteState() {
-            sp_blsquare_destroy(&blsquare);
-        }
-        
         void init() override {
             sp_adsr_create(&adsr);
             sp_adsr_init(kernel->getSpData(), adsr);
-            sp_blsquare_init(kernel->getSpData(), blsquare);
-            *blsquare->freq = 0;
-            *blsquare->amp = 0;
-            *blsquare->width = 0.5;
+            frequency = 0;
+            amplitude = 0;
+            phase = 0;
         }
 
         void noteOn(int noteNumber, int velocity, float frequency) override {
             AKBankDSPKernel::NoteState::noteOn(noteNumber, velocity, frequency);
 
             if (velocity != 0) {
-                *blsquare->freq = frequency;
-                *blsquare->amp = (float)pow2(velocity / 127.);
+                this->frequency = frequency;
+                amplitude = (float)pow2(velocity / 127.);
             }
         }
 
+        /// Applies the envelope to this note's lane of the block the kernel has just rendered
         void run(int frameCount, float *outL, float *outR) override
         {
             auto bankKernel = (AKPWMOscillatorBankDSPKernel*)kernel;
-            
-            float originalFrequency = *blsquare->freq;
-            *blsquare->freq *= powf(2, kernel->pitchBend / 12.0);
-            *blsquare->freq = clamp(*blsquare->freq, 0.0f, 22050.0f);
-            float bentFrequency = *blsquare->freq;
-
-            *blsquare->width = bankKernel->pulseWidth;
+            const int stride = bankKernel->blepbank->nvoices;
+            const float *x = bankKernel->oscillatorBuffer.data() + lane;
+            phase = bankKernel->blepbank->phs[lane];
 
             adsr->atk = (float)kernel->attackDuration;
             adsr->dec = (float)kernel->decayDuration;
@@ -62,17 +54,11 @@ protected:
             adsr->rel = (float)kernel->releaseDuration;
 
             for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
-                float x = 0;
-                float depth = kernel->vibratoDepth / 12.0;
-                float variation = sinf((kernel->currentRunningIndex + frameIndex) * 2 * 2 * M_PI * kernel->vibratoRate / kernel->getSampleRate());
-                *blsquare->freq = bentFrequency * powf(2, depth * variation);
                 sp_adsr_compute(kernel->getSpData(), adsr, &internalGate, &amp);
-                sp_blsquare_compute(kernel->getSpData(), blsquare, nil, &x);
-                *outL++ += amp * x;
-                *outR++ += amp * x;
-
+                float sample = amplitude * amp * x[frameIndex * stride];
+                *outL++ += sample;
+                *outR++ += sample;
             }
-            *blsquare->freq = originalFrequency;
             if (stage == stageRelease && amp < 0.00001) {
                 clear();
                 remove();
@@ -96,10 +82,18 @@ public:
             ns.reset(new NoteState);
             ns->kernel = this;
         }
+        oscillatorBuffer.resize(oscillatorBlockSize * noteStates.size());
+    }
+
+    ~AKPWMOscillatorBankDSPKernel() {
+        if (blepbank) sp_blepbank_destroy(&blepbank);
     }
 
     void init(int channelCount, double sampleRate) override {
         AKBankDSPKernel::init(channelCount, sampleRate);
+        if (blepbank) sp_blepbank_destroy(&blepbank);
+        sp_blepbank_create(&blepbank);
+        sp_blepbank_init(sp, blepbank, (int)noteStates.size(), SP_BLEP_SQUARE);
         pulseWidthRamper.init();
     }
 
@@ -151,10 +145,38 @@ public:
         pulseWidth = double(pulseWidthRamper.getAndStep());
         standardBankGetAndSteps();
 
-        AKBankDSPKernel::NoteState *noteState = playingNotes;
-        while (noteState) {
-            noteState->run(frameCount, outL, outR);
-            noteState = noteState->next;
+        float bend = powf(2, pitchBend / 12.0);
+        float depth = vibratoDepth / 12.0;
+        float nyquist = getSampleRate() * 0.5;
+
+        // Every playing note is a lane of the blepbank, filled in again for each block
+        for (AUAudioFrameCount blockStart = 0; blockStart < frameCount; blockStart += oscillatorBlockSize) {
+            int blockFrames = frameCount - blockStart < oscillatorBlockSize ? frameCount - blockStart : oscillatorBlockSize;
+
+            int lane = 0;
+            for (auto noteState = playingNotes; noteState; noteState = noteState->next) {
+                auto state = (NoteState *)noteState;
+                state->lane = lane;
+                blepbank->phs[lane] = state->phase;
+                blepbank->freq[lane] = clamp(state->frequency * bend, 0.0f, nyquist);
+                blepbank->width[lane] = pulseWidth;
+                ++lane;
+            }
+            if (lane == 0) break;
+            blepbank->nvoices = lane;
+
+            // Vibrato is the same for every note, so it scales all the frequencies at once
+            for (int i = 0; i < blockFrames; ++i) {
+                float variation = sinf((currentRunningIndex + blockStart + i) * 2 * 2 * M_PI * vibratoRate / getSampleRate());
+                vibrato[i] = powf(2, depth * variation);
+            }
+            sp_blepbank_compute_block(sp, blepbank, vibrato, oscillatorBuffer.data(), blockFrames);
+
+            AKBankDSPKernel::NoteState *noteState = playingNotes;
+            while (noteState) {
+                noteState->run(blockFrames, outL + blockStart, outR + blockStart);
+                noteState = noteState->next;
+            }
         }
         currentRunningIndex += frameCount / 2;
 
@@ -169,6 +191,11 @@ public:
 private:
     float pulseWidth = 0.5;
 
+    static constexpr AUAudioFrameCount oscillatorBlockSize = 64;
+    sp_blepbank *blepbank = nullptr;
+    std::vector<float> oscillatorBuffer;
+    float vibrato[oscillatorBlockSize];
+
 public:
     ParameterRamper pulseWidthRamper = 0.5;
 };
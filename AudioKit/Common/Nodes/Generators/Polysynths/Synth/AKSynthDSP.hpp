@@ -65,6 +65,9 @@ struct AKSynthDSP : AKDSPBase, AKCoreSynth
 
     void setParameter(uint64_t address, float value, bool immediate) override;
     float getParameter(uint64_t address) override;
+    AKParameterRampBase *getRamp(uint64_t address) override;
+
+    void handleCommand(AKDSPCommand const &command) override;
     
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override;
 };
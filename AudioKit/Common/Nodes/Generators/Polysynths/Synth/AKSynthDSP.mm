@@ -15,17 +15,17 @@ extern "C" void *createAKSynthDSP(int channelCount, double sampleRate) {
 
 extern "C" void doAKSynthPlayNote(void *pDSP, UInt8 noteNumber, UInt8 velocity, float noteFrequency)
 {
-    ((AKSynthDSP*)pDSP)->playNote(noteNumber, velocity, noteFrequency);
+    ((AKSynthDSP*)pDSP)->postNoteOn(noteNumber, velocity, noteFrequency);
 }
 
 extern "C" void doAKSynthStopNote(void *pDSP, UInt8 noteNumber, bool immediate)
 {
-    ((AKSynthDSP*)pDSP)->stopNote(noteNumber, immediate);
+    ((AKSynthDSP*)pDSP)->postNoteOff(noteNumber, immediate);
 }
 
 extern "C" void doAKSynthSustainPedal(void *pDSP, bool pedalDown)
 {
-    ((AKSynthDSP*)pDSP)->sustainPedal(pedalDown);
+    ((AKSynthDSP*)pDSP)->postSustainPedal(pedalDown);
 }
 
 
@@ -107,6 +107,24 @@ void AKSynthDSP::setParameter(uint64_t address, float value, bool immediate)
     }
 }
 
+AKParameterRampBase *AKSynthDSP::getRamp(AUParameterAddress address)
+{
+    // filter resonance is ramped in linear units, so scheduled changes go through setParameter
+    switch (address) {
+        case AKSynthParameterMasterVolume:
+            return &masterVolumeRamp;
+        case AKSynthParameterPitchBend:
+            return &pitchBendRamp;
+        case AKSynthParameterVibratoDepth:
+            return &vibratoDepthRamp;
+        case AKSynthParameterFilterCutoff:
+            return &filterCutoffRamp;
+        case AKSynthParameterFilterStrength:
+            return &filterStrengthRamp;
+    }
+    return nullptr;
+}
+
 float AKSynthDSP::getParameter(uint64_t address)
 {
     switch (address) {
@@ -147,6 +165,28 @@ float AKSynthDSP::getParameter(uint64_t address)
     return 0;
 }
 
+void AKSynthDSP::handleCommand(AKDSPCommand const &command)
+{
+    switch (command.type) {
+        case AKDSPCommandNoteOn:
+            playNote(command.note.noteNumber, command.note.velocity, command.note.frequency);
+            break;
+        case AKDSPCommandNoteOff:
+            stopNote(command.note.noteNumber, command.note.immediate);
+            break;
+        case AKDSPCommandSustainPedal:
+            sustainPedal(command.pedal.down);
+            break;
+        case AKDSPCommandAllNotesOff:
+            for (unsigned noteNumber = 0; noteNumber < 128; noteNumber++)
+                stopNote(noteNumber, true);
+            break;
+        default:
+            AKDSPBase::handleCommand(command);
+            break;
+    }
+}
+
 void AKSynthDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset)
 {
     // process in chunks of maximum length CHUNKSIZE
@@ -155,18 +195,18 @@ void AKSynthDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferO
         int chunkSize = frameCount - frameIndex;
         if (chunkSize > AKSYNTH_CHUNKSIZE) chunkSize = AKSYNTH_CHUNKSIZE;
 
-        // ramp parameters
-        masterVolumeRamp.advanceTo(now + frameOffset);
+        // ramp parameters; now is already the start of this segment, so offset by frameIndex
+        masterVolumeRamp.advanceTo(now + frameIndex);
         masterVolume = (float)masterVolumeRamp.getValue();
-        pitchBendRamp.advanceTo(now + frameOffset);
+        pitchBendRamp.advanceTo(now + frameIndex);
         pitchOffset = (float)pitchBendRamp.getValue();
-        vibratoDepthRamp.advanceTo(now + frameOffset);
+        vibratoDepthRamp.advanceTo(now + frameIndex);
         vibratoDepth = (float)vibratoDepthRamp.getValue();
-        filterCutoffRamp.advanceTo(now + frameOffset);
+        filterCutoffRamp.advanceTo(now + frameIndex);
         cutoffMultiple = (float)filterCutoffRamp.getValue();
-        filterStrengthRamp.advanceTo(now + frameOffset);
+        filterStrengthRamp.advanceTo(now + frameIndex);
         cutoffEnvelopeStrength = (float)filterStrengthRamp.getValue();
-        filterResonanceRamp.advanceTo(now + frameOffset);
+        filterResonanceRamp.advanceTo(now + frameIndex);
         linearResonance = (float)filterResonanceRamp.getValue();
 
         // get data
@@ -62,6 +62,8 @@ public:
         return 0;
     }
 
+    bool canProcessInPlace() override { return true; }
+
     // Largely lifted from the example code, though this is simpler since the Apple code
     // implements a time varying filter
 
@@ -77,8 +79,12 @@ public:
             float amount = amountRamp.getValue();
 
             if (!isStarted) {
-                outBufferListPtr->mBuffers[0] = inBufferListPtr->mBuffers[0];
-                outBufferListPtr->mBuffers[1] = inBufferListPtr->mBuffers[1];
+                // Copied rather than pointing the output at the input, which may be scratch memory
+                for (int channel = 0; channel < channelCount; ++channel) {
+                    float *in  = (float *)inBufferListPtr->mBuffers[channel].mData  + frameOffset;
+                    float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
+                    if (in != out) memcpy(out, in, (frameCount - frameIndex) * sizeof(float));
+                }
                 return;
             }
 
@@ -92,8 +98,11 @@ public:
                     tmpout[channel] = out;
                 }
             }
-            *tmpout[0] = *tmpin[0] * (1.0f - amount / 2.0) + *tmpin[1] * amount / 2.0;
-            *tmpout[1] = *tmpin[1] * (1.0f - amount / 2.0) + *tmpin[0] * amount / 2.0;
+            // Both inputs are read before either output is written, as they may share memory
+            float left = *tmpin[0];
+            float right = *tmpin[1];
+            *tmpout[0] = left * (1.0f - amount / 2.0) + right * amount / 2.0;
+            *tmpout[1] = right * (1.0f - amount / 2.0) + left * amount / 2.0;
         }
     }
 };
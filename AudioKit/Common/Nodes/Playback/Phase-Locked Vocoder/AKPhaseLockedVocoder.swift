@@ -8,7 +8,8 @@
 
 /// This is a phase locked vocoder. It has the ability to play back an audio
 /// file loaded into an ftable like a sampler would. Unlike a typical sampler,
-/// mincer allows time and pitch to be controlled separately.
+/// mincer allows time and pitch to be controlled separately. Stereo files keep
+/// their stereo image, both channels being phase locked together.
 ///
 
 open class AKPhaseLockedVocoder: AKNode, AKComponent {
@@ -173,7 +174,7 @@ open class AKPhaseLockedVocoder: AKNode, AKComponent {
             theOutputFormat.mFormatID = kAudioFormatLinearPCM
             theOutputFormat.mFormatFlags = kLinearPCMFormatFlagIsFloat
             theOutputFormat.mBitsPerChannel = UInt32(MemoryLayout<Float>.stride) * 8
-            theOutputFormat.mChannelsPerFrame = 1 // Mono
+            theOutputFormat.mChannelsPerFrame = theFileFormat.mChannelsPerFrame // Interleaved if stereo
             theOutputFormat.mBytesPerFrame = theOutputFormat.mChannelsPerFrame * UInt32(MemoryLayout<Float>.stride)
             theOutputFormat.mFramesPerPacket = 1
             theOutputFormat.mBytesPerPacket = theOutputFormat.mFramesPerPacket * theOutputFormat.mBytesPerFrame
@@ -217,7 +218,11 @@ open class AKPhaseLockedVocoder: AKNode, AKComponent {
                     let data = UnsafeMutablePointer<Float>(
                         bufferList.mBuffers.mData?.assumingMemoryBound(to: Float.self)
                     )
-                    internalAU?.setupAudioFileTable(data, size: ioNumberFrames)
+                    internalAU?.setupAudioFileTable(data,
+                                                    size: ioNumberFrames,
+                                                    channelCount: theOutputFormat.mChannelsPerFrame)
+                    // The kernel copies the data, and swaps it in on the render thread
+                    theData?.deallocate()
                     internalAU?.start()
                 } else {
                     // failure
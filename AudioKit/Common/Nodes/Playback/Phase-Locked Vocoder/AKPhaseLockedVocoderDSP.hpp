@@ -27,11 +27,16 @@ AKDSPRef createPhaseLockedVocoderDSP(int channelCount, double sampleRate);
 
 class AKPhaseLockedVocoderDSP : public AKSoundpipeDSPBase {
 private:
+    struct Source;
     struct InternalData;
     std::unique_ptr<InternalData> data;
+
+    /// Control thread: free the sources the render thread has swapped out
+    void collectRetiredSources();
  
 public:
     AKPhaseLockedVocoderDSP();
+    ~AKPhaseLockedVocoderDSP();
 
     float positionLowerBound = 0.0;
     float positionUpperBound = 1000.0;
@@ -52,11 +57,12 @@ public:
     // Uses the ParameterAddress as a key
     float getParameter(AUParameterAddress address) override;
     
-    void init(int channelCount, double sampleRate) override;
+    /// Copies the table, and hands it to the render thread with a freshly initialized vocoder
+    void setUpTable(float *table, UInt32 size) override;
 
-    void start() override;
+    void setUpMultichannelTable(float *table, UInt32 frameCount, int channelCount) override;
 
-    void setUpTable(float *table, UInt32 size) override;
+    void *swapBuffer(uint32_t tag, void *buffer) override;
 
     void deinit() override;
 
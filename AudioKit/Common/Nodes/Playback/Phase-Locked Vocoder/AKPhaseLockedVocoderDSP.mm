@@ -8,6 +8,7 @@
 
 #include "AKPhaseLockedVocoderDSP.hpp"
 #import "AKLinearParameterRamp.hpp"
+#include <algorithm>
 
 extern "C" AKDSPRef createPhaseLockedVocoderDSP(int channelCount, double sampleRate) {
     AKPhaseLockedVocoderDSP *dsp = new AKPhaseLockedVocoderDSP();
@@ -15,25 +16,36 @@ extern "C" AKDSPRef createPhaseLockedVocoderDSP(int channelCount, double sampleR
     return dsp;
 }
 
+/// A loaded file and the vocoder reading it. Built and freed on a control thread; the render thread
+/// only ever sees a complete one, handed over with postBufferSwap.
+struct AKPhaseLockedVocoderDSP::Source {
+    sp_pvcore *pv = nullptr;
+    // One per channel of the file; stereo files are phase locked jointly
+    sp_ftbl *ftbl[2] = {nullptr, nullptr};
+    int channelCount = 0;
+
+    ~Source() {
+        if (pv) sp_pvcore_destroy(&pv);
+        for (int i = 0; i < channelCount; i++) {
+            sp_ftbl_destroy(&ftbl[i]);
+        }
+    }
+};
+
 struct AKPhaseLockedVocoderDSP::InternalData {
-    sp_mincer *mincer;
-    sp_ftbl *ftbl;
-    UInt32 ftbl_size = 4096;
+    // Render thread only
+    Source *source = nullptr;
 
     AKLinearParameterRamp positionRamp;
     AKLinearParameterRamp amplitudeRamp;
     AKLinearParameterRamp pitchRatioRamp;
 };
 
-void AKPhaseLockedVocoderDSP::start() {
-    AKSoundpipeDSPBase::start();
-    sp_mincer_init(sp, data->mincer, data->ftbl, 2048);
-    data->mincer->time = defaultPosition;
-    data->mincer->amp = defaultAmplitude;
-    data->mincer->pitch = defaultPitchRatio;
+AKPhaseLockedVocoderDSP::AKPhaseLockedVocoderDSP() : data(new InternalData) {
 }
 
-AKPhaseLockedVocoderDSP::AKPhaseLockedVocoderDSP() : data(new InternalData) {
+AKPhaseLockedVocoderDSP::~AKPhaseLockedVocoderDSP() {
+    deinit();
 }
 
 // Uses the ParameterAddress as a key
@@ -71,20 +83,53 @@ float AKPhaseLockedVocoderDSP::getParameter(uint64_t address) {
     return 0;
 }
 
-void AKPhaseLockedVocoderDSP::init(int channelCount, double sampleRate) {
-    AKSoundpipeDSPBase::init(channelCount, sampleRate);
-    sp_mincer_create(&data->mincer);
+void AKPhaseLockedVocoderDSP::collectRetiredSources() {
+    uint32_t tag;
+    void *buffer;
+    while (collectRetiredBuffer(tag, buffer)) {
+        delete (Source *)buffer;
+    }
 }
 
 void AKPhaseLockedVocoderDSP::setUpTable(float *table, UInt32 size) {
-    data->ftbl_size = size;
-    sp_ftbl_create(sp, &data->ftbl, data->ftbl_size);
-    data->ftbl->tbl = table;
+    setUpMultichannelTable(table, size, 1);
+}
+
+void AKPhaseLockedVocoderDSP::setUpMultichannelTable(float *table, UInt32 frameCount, int channelCount) {
+    Source *source = new Source;
+    source->channelCount = std::min(std::max(channelCount, 1), 2);
+    for (int i = 0; i < source->channelCount; i++) {
+        sp_ftbl_create(sp, &source->ftbl[i], frameCount);
+        for (UInt32 frame = 0; frame < frameCount; frame++) {
+            source->ftbl[i]->tbl[frame] = table[frame * channelCount + i];
+        }
+    }
+    sp_pvcore_create(&source->pv);
+    sp_pvcore_init(sp, source->pv, source->ftbl, source->channelCount, 2048);
+
+    collectRetiredSources();
+    if (!postBufferSwap(0, source)) {
+        delete source;
+    }
+}
+
+void *AKPhaseLockedVocoderDSP::swapBuffer(uint32_t tag, void *buffer) {
+    Source *retired = data->source;
+    data->source = (Source *)buffer;
+    return retired;
 }
 
 void AKPhaseLockedVocoderDSP::deinit() {
-    sp_ftbl_destroy(&data->ftbl);
-    sp_mincer_destroy(&data->mincer);
+    // Rendering has stopped, so sources still queued for the render thread, and the one it was using, are ours
+    AKDSPCommand command;
+    while (commandBus.pop(command)) {
+        if (command.type == AKDSPCommandBufferSwap) {
+            delete (Source *)command.buffer.buffer;
+        }
+    }
+    collectRetiredSources();
+    delete data->source;
+    data->source = nullptr;
 }
 
 void AKPhaseLockedVocoderDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) {
@@ -99,15 +144,18 @@ void AKPhaseLockedVocoderDSP::process(AUAudioFrameCount frameCount, AUAudioFrame
             data->pitchRatioRamp.advanceTo(now + frameOffset);
         }
 
-        data->mincer->time = data->positionRamp.getValue();
-        data->mincer->amp = data->amplitudeRamp.getValue();
-        data->mincer->pitch = data->pitchRatioRamp.getValue();
+        Source *source = data->source;
+        float amplitude = data->amplitudeRamp.getValue();
 
         float *outL = (float *)outBufferListPtr->mBuffers[0].mData  + frameOffset;
         float *outR = (float *)outBufferListPtr->mBuffers[1].mData + frameOffset;
-        if (isStarted) {
-            sp_mincer_compute(sp, data->mincer, NULL, outL);
-            *outR = *outL;
+        if (isStarted && source) {
+            float frame[2];
+            source->pv->time = data->positionRamp.getValue();
+            source->pv->pitch = data->pitchRatioRamp.getValue();
+            sp_pvcore_compute(sp, source->pv, frame);
+            *outL = frame[0] * amplitude;
+            *outR = frame[source->channelCount - 1] * amplitude;
         } else {
             *outL = 0;
             *outR = 0;
@@ -41,6 +41,7 @@
     fileprivate var legatoParameter: AUParameter?
     fileprivate var keyTrackingParameter: AUParameter?
     fileprivate var filterEnvelopeVelocityScalingParameter: AUParameter?
+    fileprivate var voiceNoiseFloorParameter: AUParameter?
 
     /// Ramp Duration represents the speed at which parameters are allowed to change
     @objc open dynamic var rampDuration: Double = AKSettings.rampDuration {
@@ -259,6 +260,15 @@
         }
     }
 
+    /// Voice noise floor (dB, -200.0 to 0.0): voices quieter than this for 0.1 seconds are stopped
+    /// to free them for new notes. -200.0 means voices always play until their envelopes finish.
+    @objc open dynamic var voiceNoiseFloor: Double = -90.0 {
+        willSet {
+            guard voiceNoiseFloor != newValue else { return }
+            internalAU?.voiceNoiseFloor = newValue
+        }
+    }
+
     // MARK: - Initialization
 
     /// Initialize this sampler node
@@ -285,6 +295,7 @@
     ///   - isLegato: (mono mode onl) if true, legato notes will not retrigger
     ///   - keyTracking: -2.0 - 2.0, 1.0 means perfect key tracking, 0.0 means none
     ///   - filterEnvelopeVelocityScaling: fraction, 0.0 - 1.0
+    ///   - voiceNoiseFloor: dB, -200.0 - 0.0, level below which fading voices are stopped early
     ///
     @objc public init(
         masterVolume: Double = 1.0,
@@ -307,7 +318,8 @@
         isMonophonic: Bool = false,
         isLegato: Bool = false,
         keyTracking: Double = 1.0,
-        filterEnvelopeVelocityScaling: Double = 0.0) {
+        filterEnvelopeVelocityScaling: Double = 0.0,
+        voiceNoiseFloor: Double = -90.0) {
 
         self.masterVolume = masterVolume
         self.pitchBend = pitchBend
@@ -330,6 +342,7 @@
         self.isLegato = isLegato
         self.keyTrackingFraction = keyTracking
         self.filterEnvelopeVelocityScaling = filterEnvelopeVelocityScaling
+        self.voiceNoiseFloor = voiceNoiseFloor
 
         AKSampler.register()
 
@@ -371,6 +384,7 @@
         self.legatoParameter = tree["legato"]
         self.keyTrackingParameter = tree["keyTracking"]
         self.filterEnvelopeVelocityScalingParameter = tree["filterEnvelopeVelocityScaling"]
+        self.voiceNoiseFloorParameter = tree["voiceNoiseFloor"]
 
         self.internalAU?.setParameterImmediately(.masterVolume, value: masterVolume)
         self.internalAU?.setParameterImmediately(.pitchBend, value: pitchBend)
@@ -393,6 +407,7 @@
         self.internalAU?.setParameterImmediately(.legato, value: isLegato ? 1.0 : 0.0)
         self.internalAU?.setParameterImmediately(.keyTrackingFraction, value: keyTracking)
         self.internalAU?.setParameterImmediately(.filterEnvelopeVelocityScaling, value: filterEnvelopeVelocityScaling)
+        self.internalAU?.setParameterImmediately(.voiceNoiseFloor, value: voiceNoiseFloor)
     }
 
     @objc open func loadAKAudioFile(from sampleDescriptor: AKSampleDescriptor, file: AKAudioFile) {
@@ -445,6 +460,13 @@
         internalAU?.setLoop(thruRelease: thruRelease)
     }
 
+    /// If true, samples loaded from now on also get band-limited copies at 1/2, 1/4... of their sample rate,
+    /// built in the background and played instead of the sample when a note is an octave or more above it.
+    /// This avoids aliasing at extreme transpositions, and doubles the memory used by those samples.
+    @objc open func setBuildMipmaps(_ buildMipmaps: Bool) {
+        internalAU?.setBuildMipmaps(buildMipmaps)
+    }
+
     @objc open override func play(noteNumber: MIDINoteNumber,
                                   velocity: MIDIVelocity,
                                   channel: MIDIChannel = 0) {
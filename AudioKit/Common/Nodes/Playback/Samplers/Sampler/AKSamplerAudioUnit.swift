@@ -106,6 +106,10 @@ public class AKSamplerAudioUnit: AKGeneratorAudioUnitBase {
         didSet { setParameter(.filterEnvelopeVelocityScaling, value: filterEnvelopeVelocityScaling) }
     }
 
+    var voiceNoiseFloor: Double = -90.0 {
+        didSet { setParameter(.voiceNoiseFloor, value: voiceNoiseFloor) }
+    }
+
     public override func initDSP(withSampleRate sampleRate: Double,
                                  channelCount count: AVAudioChannelCount) -> AKDSPRef {
         return createAKSamplerDSP(Int32(count), sampleRate)
@@ -326,6 +330,16 @@ public class AKSamplerAudioUnit: AKGeneratorAudioUnitBase {
             unit: .generic,
             flags: nonRampFlags)
 
+        parameterAddress += 1
+
+        let voiceNoiseFloorParameter = AUParameter(
+            identifier: "voiceNoiseFloor",
+            name: "Voice Noise Floor (dB)",
+            address: parameterAddress,
+            range: -200.0...0.0,
+            unit: .decibels,
+            flags: nonRampFlags)
+
         setParameterTree(AUParameterTree(children: [masterVolumeParameter,
                                                                    pitchBendParameter,
                                                                    vibratoDepthParameter,
@@ -346,7 +360,8 @@ public class AKSamplerAudioUnit: AKGeneratorAudioUnitBase {
                                                                    monophonicParameter,
                                                                    legatoParameter,
                                                                    keyTrackingParameter,
-                                                                   filterEnvelopeVelocityScalingParameter]))
+                                                                   filterEnvelopeVelocityScalingParameter,
+                                                                   voiceNoiseFloorParameter]))
         masterVolumeParameter.value = 1.0
         pitchBendParameter.value = 0.0
         vibratoDepthParameter.value = 0.0
@@ -368,6 +383,7 @@ public class AKSamplerAudioUnit: AKGeneratorAudioUnitBase {
         legatoParameter.value = 0.0
         keyTrackingParameter.value = 1.0
         filterEnvelopeVelocityScalingParameter.value = 0.0
+        voiceNoiseFloorParameter.value = -90.0
     }
 
     public override var canProcessInPlace: Bool { return true }
@@ -390,6 +406,10 @@ public class AKSamplerAudioUnit: AKGeneratorAudioUnitBase {
         doAKSamplerLoadCompressedFile(dsp, &copy)
     }
 
+    public func loadSFZ(path: String) -> Bool {
+        return doAKSamplerLoadSFZ(dsp, path)
+    }
+
     public func unloadAllSamples() {
         doAKSamplerUnloadAllSamples(dsp)
     }
@@ -410,6 +430,10 @@ public class AKSamplerAudioUnit: AKGeneratorAudioUnitBase {
         doAKSamplerSetLoopThruRelease(dsp, thruRelease)
     }
 
+    public func setBuildMipmaps(_ buildMipmaps: Bool) {
+        doAKSamplerSetBuildMipmaps(dsp, buildMipmaps)
+    }
+
     public func playNote(noteNumber: UInt8, velocity: UInt8) {
         doAKSamplerPlayNote(dsp, noteNumber, velocity)
     }
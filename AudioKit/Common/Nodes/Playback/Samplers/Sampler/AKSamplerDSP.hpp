@@ -36,6 +36,7 @@ typedef NS_ENUM(AUParameterAddress, AKSamplerParameter)
     AKSamplerParameterLegato,
     AKSamplerParameterKeyTrackingFraction,
     AKSamplerParameterFilterEnvelopeVelocityScaling,
+    AKSamplerParameterVoiceNoiseFloor,
     
     // ensure this is always last in the list, to simplify parameter addressing
     AKSamplerParameterRampDuration,
@@ -48,11 +49,13 @@ typedef NS_ENUM(AUParameterAddress, AKSamplerParameter)
 AKDSPRef createAKSamplerDSP(int channelCount, double sampleRate);
 void doAKSamplerLoadData(AKDSPRef pDSP, AKSampleDataDescriptor *pSDD);
 void doAKSamplerLoadCompressedFile(AKDSPRef pDSP, AKSampleFileDescriptor *pSFD);
+bool doAKSamplerLoadSFZ(AKDSPRef pDSP, const char *path);
 void doAKSamplerUnloadAllSamples(AKDSPRef pDSP);
 void doAKSamplerSetNoteFrequency(AKDSPRef pDSP, int noteNumber, float noteFrequency);
 void doAKSamplerBuildSimpleKeyMap(AKDSPRef pDSP);
 void doAKSamplerBuildKeyMap(AKDSPRef pDSP);
 void doAKSamplerSetLoopThruRelease(AKDSPRef pDSP, bool value);
+void doAKSamplerSetBuildMipmaps(AKDSPRef pDSP, bool value);
 void doAKSamplerPlayNote(AKDSPRef pDSP, UInt8 noteNumber, UInt8 velocity);
 void doAKSamplerStopNote(AKDSPRef pDSP, UInt8 noteNumber, bool immediate);
 void doAKSamplerStopAllVoices(AKDSPRef pDSP);
@@ -82,8 +85,11 @@ struct AKSamplerDSP : AKDSPBase, AKCoreSampler
 
     void setParameter(uint64_t address, float value, bool immediate) override;
     float getParameter(uint64_t address) override;
+    AKParameterRampBase *getRamp(uint64_t address) override;
 
     void handleMIDIEvent(AUMIDIEvent const& midiEvent) override;
+    void handleCommand(AKDSPCommand const &command) override;
+    void stopAllNotes();
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override;
 };
 
@@ -9,6 +9,12 @@
 #import "AKSamplerDSP.hpp"
 #include "wavpack.h"
 #include <math.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// voice noise floors (dB) at or below this never stop voices early
+static const float kMinimumVoiceNoiseFloorDb = -200.0f;
 
 extern "C" AKDSPRef createAKSamplerDSP(int channelCount, double sampleRate) {
     return new AKSamplerDSP();
@@ -33,27 +39,34 @@ extern "C" void doAKSamplerLoadCompressedFile(AKDSPRef pDSP, AKSampleFileDescrip
     sdd.sampleRate = (float)WavpackGetSampleRate(wpc);
     sdd.channelCount = WavpackGetReducedChannels(wpc);
     sdd.sampleCount = WavpackGetNumSamples(wpc);
-    sdd.isInterleaved = sdd.channelCount > 1;
+    sdd.isInterleaved = false;
     sdd.data = new float[sdd.channelCount * sdd.sampleCount];
 
-    int mode = WavpackGetMode(wpc);
-    WavpackUnpackSamples(wpc, (int32_t*)sdd.data, sdd.sampleCount);
-    if ((mode & MODE_FLOAT) == 0)
+    // Decode runs of blocks in parallel, each through its own context, straight into planar float
+    uint32_t blockSamples = WavpackGetNumSamplesInFrame(wpc);
+    uint32_t blockCount = blockSamples > 0 ? (sdd.sampleCount + blockSamples - 1) / blockSamples : 1;
+    uint32_t threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), std::min(blockCount, 8u));
+    std::vector<WavpackContext *> contexts(1, wpc);
+    while (contexts.size() < threadCount)
     {
-        // convert samples to floating-point
-        int bps = WavpackGetBitsPerSample(wpc);
-        float scale = 1.0f / (1 << (bps - 1));
-        float *pf = sdd.data;
-        int32_t *pi = (int32_t*)pf;
-        for (int i = 0; i < (sdd.sampleCount * sdd.channelCount); i++)
-            *pf++ = scale * *pi++;
+        WavpackContext *extra = WavpackOpenFileInput(pSFD->path, errMsg, OPEN_2CH_MAX, 0);
+        if (extra == 0) break;
+        contexts.push_back(extra);
     }
-    WavpackCloseFile(wpc);
+
+    float *channels[2] = { sdd.data, sdd.data + sdd.sampleCount };
+    WavpackUnpackParallel(contexts.data(), (int)contexts.size(), channels);
+    for (WavpackContext *context : contexts) WavpackCloseFile(context);
 
     ((AKSamplerDSP*)pDSP)->loadSampleData(sdd);
     delete[] sdd.data;
 }
 
+extern "C" bool doAKSamplerLoadSFZ(AKDSPRef pDSP, const char *path)
+{
+    return ((AKSamplerDSP*)pDSP)->loadSFZ(path);
+}
+
 extern "C" void doAKSamplerUnloadAllSamples(AKDSPRef pDSP)
 {
     ((AKSamplerDSP*)pDSP)->deinit();
@@ -76,14 +89,18 @@ extern "C" void doAKSamplerSetLoopThruRelease(AKDSPRef pDSP, bool value) {
     ((AKSamplerDSP*)pDSP)->setLoopThruRelease(value);
 }
 
+extern "C" void doAKSamplerSetBuildMipmaps(AKDSPRef pDSP, bool value) {
+    ((AKSamplerDSP*)pDSP)->setBuildMipmaps(value);
+}
+
 extern "C" void doAKSamplerPlayNote(AKDSPRef pDSP, UInt8 noteNumber, UInt8 velocity)
 {
-    ((AKSamplerDSP*)pDSP)->playNote(noteNumber, velocity);
+    ((AKSamplerDSP*)pDSP)->postNoteOn(noteNumber, velocity);
 }
 
 extern "C" void doAKSamplerStopNote(AKDSPRef pDSP, UInt8 noteNumber, bool immediate)
 {
-    ((AKSamplerDSP*)pDSP)->stopNote(noteNumber, immediate);
+    ((AKSamplerDSP*)pDSP)->postNoteOff(noteNumber, immediate);
 }
 
 extern "C" void doAKSamplerStopAllVoices(AKDSPRef pDSP)
@@ -98,7 +115,7 @@ extern "C" void doAKSamplerRestartVoices(AKDSPRef pDSP)
 
 extern "C" void doAKSamplerSustainPedal(AKDSPRef pDSP, bool pedalDown)
 {
-    ((AKSamplerDSP*)pDSP)->sustainPedal(pedalDown);
+    ((AKSamplerDSP*)pDSP)->postSustainPedal(pedalDown);
 }
 
 
@@ -202,9 +219,32 @@ void AKSamplerDSP::setParameter(AUParameterAddress address, float value, bool im
         case AKSamplerParameterFilterEnvelopeVelocityScaling:
             filterEnvelopeVelocityScaling = value;
             break;
+        case AKSamplerParameterVoiceNoiseFloor:
+            voiceNoiseFloor = value <= kMinimumVoiceNoiseFloorDb ? 0.0f : pow(10.0, 0.05 * value);
+            break;
     }
 }
 
+AKParameterRampBase *AKSamplerDSP::getRamp(AUParameterAddress address)
+{
+    // filter resonance is ramped in linear units, so scheduled changes go through setParameter
+    switch (address) {
+        case AKSamplerParameterMasterVolume:
+            return &masterVolumeRamp;
+        case AKSamplerParameterPitchBend:
+            return &pitchBendRamp;
+        case AKSamplerParameterVibratoDepth:
+            return &vibratoDepthRamp;
+        case AKSamplerParameterFilterCutoff:
+            return &filterCutoffRamp;
+        case AKSamplerParameterFilterStrength:
+            return &filterStrengthRamp;
+        case AKSamplerParameterGlideRate:
+            return &glideRateRamp;
+    }
+    return nullptr;
+}
+
 float AKSamplerDSP::getParameter(AUParameterAddress address)
 {
     switch (address) {
@@ -255,6 +295,8 @@ float AKSamplerDSP::getParameter(AUParameterAddress address)
             return keyTracking;
         case AKSamplerParameterFilterEnvelopeVelocityScaling:
             return filterEnvelopeVelocityScaling;
+        case AKSamplerParameterVoiceNoiseFloor:
+            return voiceNoiseFloor > 0.0f ? 20.0f * log10(voiceNoiseFloor) : kMinimumVoiceNoiseFloorDb;
     }
     return 0;
 }
@@ -281,13 +323,41 @@ void AKSamplerDSP::handleMIDIEvent(const AUMIDIEvent &midiEvent)
         case 0xB0 : { // control
             uint8_t num = midiEvent.data[1];
             if (num == 123) { // all notes off
-                stopAllVoices();
+                stopAllNotes();
             }
             break;
         }
     }
 }
 
+void AKSamplerDSP::handleCommand(AKDSPCommand const &command)
+{
+    switch (command.type) {
+        case AKDSPCommandNoteOn:
+            playNote(command.note.noteNumber, command.note.velocity);
+            break;
+        case AKDSPCommandNoteOff:
+            stopNote(command.note.noteNumber, command.note.immediate);
+            break;
+        case AKDSPCommandSustainPedal:
+            sustainPedal(command.pedal.down);
+            break;
+        case AKDSPCommandAllNotesOff:
+            stopAllNotes();
+            break;
+        default:
+            AKDSPBase::handleCommand(command);
+            break;
+    }
+}
+
+void AKSamplerDSP::stopAllNotes()
+{
+    // stopAllVoices() waits for the render thread, so it must not be called from it
+    for (unsigned noteNumber = 0; noteNumber < 128; noteNumber++)
+        stopNote(noteNumber, true);
+}
+
 void AKSamplerDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset)
 {
     // process in chunks of maximum length AKCORESAMPLER_CHUNKSIZE
@@ -296,20 +366,20 @@ void AKSamplerDSP::process(AUAudioFrameCount frameCount, AUAudioFrameCount buffe
         int chunkSize = frameCount - frameIndex;
         if (chunkSize > AKCORESAMPLER_CHUNKSIZE) chunkSize = AKCORESAMPLER_CHUNKSIZE;
 
-        // ramp parameters
-        masterVolumeRamp.advanceTo(now + frameOffset);
+        // ramp parameters; now is already the start of this segment, so offset by frameIndex
+        masterVolumeRamp.advanceTo(now + frameIndex);
         masterVolume = (float)masterVolumeRamp.getValue();
-        pitchBendRamp.advanceTo(now + frameOffset);
+        pitchBendRamp.advanceTo(now + frameIndex);
         pitchOffset = (float)pitchBendRamp.getValue();
-        vibratoDepthRamp.advanceTo(now + frameOffset);
+        vibratoDepthRamp.advanceTo(now + frameIndex);
         vibratoDepth = (float)vibratoDepthRamp.getValue();
-        filterCutoffRamp.advanceTo(now + frameOffset);
+        filterCutoffRamp.advanceTo(now + frameIndex);
         cutoffMultiple = (float)filterCutoffRamp.getValue();
-        filterStrengthRamp.advanceTo(now + frameOffset);
+        filterStrengthRamp.advanceTo(now + frameIndex);
         cutoffEnvelopeStrength = (float)filterStrengthRamp.getValue();
-        filterResonanceRamp.advanceTo(now + frameOffset);
+        filterResonanceRamp.advanceTo(now + frameIndex);
         linearResonance = (float)filterResonanceRamp.getValue();
-        glideRateRamp.advanceTo(now + frameOffset);
+        glideRateRamp.advanceTo(now + frameIndex);
         glideRate = (float)glideRateRamp.getValue();
 
         // get data
@@ -106,6 +106,9 @@ open class AKWaveTable: AKNode, AKComponent {
 
     /// Number of samples in the audio stored in memory
     open var size: Sample {
+        if let buffer = adoptedBuffer {
+            return Sample(buffer.frameLength)
+        }
         if avAudiofile != nil {
             return Sample(avAudiofile!.samplesCount)
         }
@@ -114,6 +117,9 @@ open class AKWaveTable: AKNode, AKComponent {
 
     /// originalSampleRate
     open var originalSampleRate: Double? {
+        if let buffer = adoptedBuffer {
+            return buffer.format.sampleRate
+        }
         return avAudiofile?.sampleRate
     }
 
@@ -135,6 +141,7 @@ open class AKWaveTable: AKNode, AKComponent {
     }
 
     fileprivate var avAudiofile: AVAudioFile?
+    fileprivate var adoptedBuffer: AVAudioPCMBuffer?
     fileprivate var maximumSamples: Int = 0
 
     open var loadCompletionHandler: AKCallback = {} {
@@ -163,7 +170,7 @@ open class AKWaveTable: AKNode, AKComponent {
     ///   - endPoint: Point in samples at which to stop playback
     ///   - rate: Multiplication factor from original speed (Default: 1)
     ///   - volume: Multiplication factor of the overall amplitude (Default: 1)
-    ///   - maximumSamples: Largest number of samples that will be loaded into the sample player
+    ///   - maximumSamples: Size to report before anything is loaded. Files are played in place, so it doesn't limit them
     ///   - completionHandler: Callback to run when the sample playback is completed
     ///
     @objc public init(file: AKAudioFile? = nil,
@@ -276,7 +283,7 @@ open class AKWaveTable: AKNode, AKComponent {
         return point
     }
 
-    /// Load a new audio file into memory
+    /// Load a new audio file into memory. The player plays the decoded buffer in place rather than copying it.
     open func load(file: AKAudioFile) {
         if file.channelCount > 2 || file.channelCount < 1 {
             AKLog("AKWaveTable currently only supports mono or stereo samples")
@@ -291,22 +298,34 @@ open class AKWaveTable: AKNode, AKComponent {
                 AKLog("Load audio file failed. Error was: \(error)")
                 return
             }
-            let sizeToUse = UInt32(file.samplesCount * 2)
-            if maximumSamples == 0 {
-                maximumSamples = Int(file.samplesCount)
-                internalAU?.setupAudioFileTable(sizeToUse)
-            }
+            load(buffer: buf)
             avAudiofile = file
-            startPoint = 0
-            endPoint = Sample(file.samplesCount)
-            loopStartPoint = 0
-            loopEndPoint = Sample(file.samplesCount)
-            let data = buf.floatChannelData
-            internalAU?.loadAudioData(data?.pointee, size: UInt32(file.samplesCount) * file.channelCount,
-                                      sampleRate: Float(file.sampleRate), numChannels: file.channelCount)
         }
     }
 
+    /// Play a buffer in place, without copying it into the player's memory, so loading costs nothing however
+    /// long the audio is. The player keeps the buffer alive until it has switched to something else; don't
+    /// change its contents meanwhile.
+    open func load(buffer: AVAudioPCMBuffer) {
+        guard let data = buffer.floatChannelData,
+            !buffer.format.isInterleaved,
+            buffer.format.channelCount >= 1,
+            buffer.format.channelCount <= 2 else {
+            AKLog("AKWaveTable can only play mono or stereo, non-interleaved float buffers in place")
+            return
+        }
+        adoptedBuffer = buffer
+        avAudiofile = nil
+        startPoint = 0
+        endPoint = Sample(buffer.frameLength)
+        loopStartPoint = 0
+        loopEndPoint = Sample(buffer.frameLength)
+        internalAU?.adoptAudioData(data, frames: buffer.frameLength,
+                                   sampleRate: Float(buffer.format.sampleRate),
+                                   numChannels: buffer.format.channelCount,
+                                   owner: buffer)
+    }
+
     deinit {
         internalAU?.destroy()
     }
@@ -27,6 +27,7 @@ typedef void (^AKCCallback)(void);
 
 - (void)setupAudioFileTable:(UInt32)size;
 - (void)loadAudioData:(float *)data size:(UInt32)size sampleRate:(float)sampleRate numChannels:(UInt32)numChannels;
+- (void)adoptAudioData:(float *const *)channelData frames:(UInt32)frames sampleRate:(float)sampleRate numChannels:(UInt32)numChannels owner:(id)owner;
 - (int)size;
 - (double)position;
 - (void)destroy;
@@ -61,6 +61,9 @@
 - (void)loadAudioData:(float *)data size:(UInt32)size sampleRate:(float)sampleRate numChannels:(UInt32)numChannels {
     _kernel.loadAudioData(data, size, sampleRate, numChannels);
 }
+- (void)adoptAudioData:(float *const *)channelData frames:(UInt32)frames sampleRate:(float)sampleRate numChannels:(UInt32)numChannels owner:(id)owner {
+    _kernel.adoptAudioData(channelData, frames, sampleRate, numChannels, (__bridge CFTypeRef)owner);
+}
 - (int)size {
     return _kernel.ftbl_size;
 }
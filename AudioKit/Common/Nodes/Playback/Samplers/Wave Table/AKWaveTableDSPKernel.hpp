@@ -8,6 +8,9 @@
 
 #pragma once
 #import "AKSoundpipeKernel.hpp"
+#import "AKDSPCommandBus.hpp"
+#import <CoreFoundation/CoreFoundation.h>
+#import <algorithm>
 
 enum {
     startPointAddress = 0,
@@ -18,6 +21,21 @@ enum {
     volumeAddress = 5
 };
 
+/// A table the player reads: planar channels (the same one twice for mono), their length and sample rate.
+/// The render thread swaps a whole table in at once, and hands the old one back to be freed.
+struct AKWaveTableData {
+    float const *channels[2] = { nullptr, nullptr };
+    UInt32 frames = 0;
+    float sampleRate = 0;
+    float *samples = nullptr;       // owned copy, for data loaded by copying
+    CFTypeRef owner = nullptr;      // retained holder of adopted data, released with the table
+
+    ~AKWaveTableData() {
+        delete[] samples;
+        if (owner) CFRelease(owner);
+    }
+};
+
 class AKWaveTableDSPKernel : public AKSoundpipeKernel, public AKOutputBuffered {
 public:
     // MARK: Member Functions
@@ -27,29 +45,22 @@ public:
     void init(int channelCount, double sampleRate) override {
         AKSoundpipeKernel::init(channelCount, sampleRate);
 
-        sp_tabread_create(&tabread1);
-        sp_tabread_create(&tabread2);
-        
         rateRamper.init();
         volumeRamper.init();
     }
 
 
     void destroy() {
-        sp_tabread_destroy(&tabread1);
-        sp_tabread_destroy(&tabread2);
-        sp_ftbl_destroy(&ftbl1);
-        sp_ftbl_destroy(&ftbl2);;
+        collectRetiredTables();
+        AKDSPCommand command;
+        while (tableBus.pop(command)) delete (AKWaveTableData *)command.buffer.buffer;
+        delete table;
+        table = nullptr;
         AKSoundpipeKernel::destroy();
     }
     void start() {
         started = true;
 
-        sp_tabread_init(sp, tabread1, ftbl1, 1);
-        sp_tabread_init(sp, tabread2, ftbl2, 1);
-        tabread1->mode = 0;
-        tabread2->mode = 0;
-        
         lastPosition = 0.0;
         inLoopPhase = false;
         position = startPointViaRate();
@@ -62,31 +73,68 @@ public:
         useTempEndPoint = false;
     }
 
+    /// Loads copied later on are cut to size samples per channel
     void setUpTable(UInt32 size) {
-        if (current_size <= 2) {
-            current_size = size / 2;
-            ftbl_size = size / 2;
-            sp_ftbl_create(sp, &ftbl1, ftbl_size);
-            sp_ftbl_create(sp, &ftbl2, ftbl_size);
+        if (maximumFrames == 0) {
+            maximumFrames = size / 2;
+            ftbl_size = maximumFrames;
         }
     }
 
-    void loadAudioData(float *table, UInt32 size, float sampleRate, UInt32 numChannels) {
-        sourceSampleRate = sampleRate;
-        current_size = size / numChannels;
-        for (int i = 0; i < current_size; i++) {
-            ftbl1->tbl[i] = table[i];
-            if (numChannels == 1){ //mono - copy chanel to both buffers
-                ftbl2->tbl[i] = table[i];
-            }else if (numChannels == 2){
-                ftbl2->tbl[i] = table[i + current_size]; //stereo - right data comes after left data
-            }
+    void loadAudioData(float *data, UInt32 size, float sampleRate, UInt32 numChannels) {
+        if (maximumFrames == 0) return;
+        AKWaveTableData *newTable = new AKWaveTableData();
+        UInt32 frames = std::min(size / numChannels, maximumFrames);
+        newTable->samples = new float[frames * numChannels];
+        //stereo - right data comes after left data
+        for (UInt32 channel = 0; channel < numChannels; ++channel) {
+            memcpy(newTable->samples + channel * frames, data + channel * (size / numChannels), frames * sizeof(float));
+        }
+        newTable->channels[0] = newTable->samples;
+        //mono - both channels read the one table
+        newTable->channels[1] = numChannels == 2 ? newTable->samples + frames : newTable->samples;
+        newTable->frames = frames;
+        newTable->sampleRate = sampleRate;
+        ftbl_size = maximumFrames;
+        postTable(newTable);
+    }
+
+    /// Plays the caller's planar channels in place, without copying them. They must stay unchanged while
+    /// playing; owner, if any, is retained to keep them alive until the render thread has let go of them.
+    void adoptAudioData(float *const *channelData, UInt32 frames, float sampleRate, UInt32 numChannels,
+                        CFTypeRef owner) {
+        AKWaveTableData *newTable = new AKWaveTableData();
+        newTable->channels[0] = channelData[0];
+        newTable->channels[1] = numChannels >= 2 ? channelData[1] : channelData[0];
+        newTable->frames = frames;
+        newTable->sampleRate = sampleRate;
+        newTable->owner = owner ? CFRetain(owner) : nullptr;
+        ftbl_size = frames;
+        postTable(newTable);
+    }
+
+    /// Control thread: hands newTable to the render thread, which installs it at its next render
+    void postTable(AKWaveTableData *newTable) {
+        collectRetiredTables();
+        AKDSPCommand command = {};
+        command.type = AKDSPCommandBufferSwap;
+        command.sampleTime = AKDSPCommandImmediate;
+        command.buffer.buffer = newTable;
+        if (!tableBus.post(command)) {
+            delete newTable;
+            return;
         }
         if (loadCompletionHandler != nil){
             loadCompletionHandler();
         }
     }
 
+    /// Control thread: frees the tables the render thread has replaced
+    void collectRetiredTables() {
+        AKDSPCommand command;
+        while (retiredTableBus.pop(command)) delete (AKWaveTableData *)command.buffer.buffer;
+    }
+
     void reset() {
         resetted = true;
         rateRamper.reset();
@@ -166,50 +214,94 @@ public:
     long loopPhase = -1;
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override {
 
-        for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
-
-            int frameOffset = int(frameIndex + bufferOffset);
-            
-            rate = double(rateRamper.getAndStep());
-            volume = double(volumeRamper.getAndStep());
-
-            float startPointToUse = startPointViaRate();
-            float endPointToUse = endPointViaRate();
-            double nextPosition = position + sampleRateRatio() * rate;
-
-            if (started){
-                calculateMainPlayComplete(nextPosition);
-                if (loop){
-                    calculateLoopPhase(nextPosition);
-                    if (inLoopPhase){
-                        startPointToUse = loopStartPointViaRate();
-                        endPointToUse = loopEndPointViaRate();
-                        calculateShouldLoop(nextPosition);
+        // Install the newest table; the ones it replaces go back to the control thread
+        AKDSPCommand command;
+        while (tableBus.pop(command)) {
+            AKDSPCommand retired = command;
+            retired.buffer.buffer = table;
+            table = (AKWaveTableData *)command.buffer.buffer;
+            if (retired.buffer.buffer) retiredTableBus.post(retired);
+        }
+
+        blockSampleRateRatio = table ? table->sampleRate / AKSettings.sampleRate : 0.0;
+
+        for (AUAudioFrameCount done = 0; done < frameCount; done += blockSize) {
+            int count = (int)std::min(frameCount - done, (AUAudioFrameCount)blockSize);
+            int playing = 0;
+
+            for (int frameIndex = 0; frameIndex < count; ++frameIndex) {
+
+                rate = double(rateRamper.getAndStep());
+                volume = double(volumeRamper.getAndStep());
+
+                float startPointToUse = startPointViaRate();
+                float endPointToUse = endPointViaRate();
+                double nextPosition = position + sampleRateRatio() * rate;
+
+                if (started){
+                    calculateMainPlayComplete(nextPosition);
+                    if (loop){
+                        calculateLoopPhase(nextPosition);
+                        if (inLoopPhase){
+                            startPointToUse = loopStartPointViaRate();
+                            endPointToUse = loopEndPointViaRate();
+                            calculateShouldLoop(nextPosition);
+                        }
+                    }
+                    if (!loop && calculateHasEnded(nextPosition)) {
+                        stop();
+                        completionHandler();
+                    } else {
+                        lastPosition = position;
                     }
                 }
-                if (!loop && calculateHasEnded(nextPosition)) {
-                    stop();
-                    completionHandler();
+
+                if (started) {
+                    blockPositions[frameIndex] = position;
+                    blockGains[frameIndex] = volume;
+                    position += sampleStep();
+                    playing++;
                 } else {
-                    lastPosition = position;
+                    blockPositions[frameIndex] = 0;
+                    blockGains[frameIndex] = 0;
                 }
             }
-            
+
+            readBlock(playing > 0 ? count : 0, count, int(bufferOffset + done));
+        }
+    }
+
+    /// Interpolates every output channel at the positions of the block. Each frame's index and fraction are
+    /// worked out once and shared by all the channels, and the channel loops have no branches. With nothing
+    /// to read, the block is silent.
+    void readBlock(int count, int blockCount, int frameOffset) {
+        int index[blockSize], nextIndex[blockSize];
+        float fraction[blockSize];
+        int const frames = table ? (int)table->frames : 0;
+
+        if (frames == 0 || count == 0) {
             for (int channel = 0; channel < channels; ++channel) {
                 float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
-                if (started) {
-                    if (channel == 0) {
-                        tabread1->index = position;
-                        tabread2->index = position;
-                        sp_tabread_compute(sp, tabread1, NULL, out);
-                        position += sampleStep();
-                    } else {
-                        sp_tabread_compute(sp, tabread2, NULL, out);
-                    }
-                    *out *= volume;
-                } else {
-                    *out = 0;
-                }
+                memset(out, 0, blockCount * sizeof(float));
+            }
+            return;
+        }
+
+        double const last = frames - 1;
+        for (int i = 0; i < count; ++i) {
+            double p = std::min(std::max(blockPositions[i], 0.0), last);
+            int n = (int)p;
+            index[i] = n;
+            nextIndex[i] = std::min(n + 1, frames - 1);
+            fraction[i] = float(p - n);
+        }
+
+        for (int channel = 0; channel < channels; ++channel) {
+            float *out = (float *)outBufferListPtr->mBuffers[channel].mData + frameOffset;
+            float const *samples = table->channels[channel == 0 ? 0 : 1];
+            for (int i = 0; i < count; ++i) {
+                float x1 = samples[index[i]], x2 = samples[nextIndex[i]];
+                out[i] = (x1 + (x2 - x1) * fraction[i]) * blockGains[i];
             }
         }
     }
@@ -251,7 +343,7 @@ public:
         return sampleRateRatio() * abs(rate) * reverseMultiplier;
     }
     double sampleRateRatio(){
-        return sourceSampleRate / AKSettings.sampleRate;
+        return blockSampleRateRatio;
     }
     // MARK: Member Variables
     
@@ -315,10 +407,17 @@ public:
     }
 private:
 
-    sp_tabread *tabread1;
-    sp_tabread *tabread2;
-    sp_ftbl *ftbl1;
-    sp_ftbl *ftbl2;
+    static constexpr int blockSize = 256;
+
+    // the table being played, render thread only; new ones arrive on tableBus and old ones leave on
+    // retiredTableBus. A retired table is only freed once a later load or destroy collects it.
+    AKWaveTableData *table = nullptr;
+    AKDSPCommandBus tableBus{16};
+    AKDSPCommandBus retiredTableBus{16};
+    UInt32 maximumFrames = 0;
+    double blockPositions[blockSize];
+    float blockGains[blockSize];
+    double blockSampleRateRatio = 1.0;
 
     float startPoint = 0;
     float endPoint = 1;
@@ -333,7 +432,6 @@ private:
     bool loop = false;
     bool mainPlayComplete = false;  //has the sample played through once without looping
     bool inLoopPhase = false;       //has the main play completed and now we are in loop phase
-    float sourceSampleRate = 0.0;
 
 public:
     bool started = false;
@@ -344,7 +442,6 @@ public:
     AKCCallback loadCompletionHandler = nullptr;
     AKCCallback loopCallback = nullptr;
     UInt32 ftbl_size = 2;
-    UInt32 current_size = 2;
     double position = 0.0;
     double rate = 1;
 };
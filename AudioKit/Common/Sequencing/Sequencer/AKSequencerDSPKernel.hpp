@@ -9,11 +9,17 @@
 #include <stdio.h>
 #pragma once
 #include <vector>
+#include <atomic>
+#include <algorithm>
+#include "AKDSPCommandBus.hpp"
 using std::vector;
 
 #define NOTEON 0x90
 #define NOTEOFF 0x80
 
+/// Maximum number of notes that can be sounding at once on one track
+#define AKSEQUENCER_MAX_PLAYING_NOTES 512
+
 struct MIDIEvent {
     uint8_t status;
     uint8_t data1;
@@ -26,6 +32,27 @@ struct MIDINote {
     struct MIDIEvent noteOff;
 };
 
+/// One entry of the render timeline: a MIDI event (or note on) resolved to a sample position.
+/// Note ons carry their note off so the render thread never has to look anything up.
+struct SequencerTimelineEvent {
+    long sampleTime;
+    long offSampleTime;     // -1 for plain events
+    MIDINote note;          // noteOff is unused for plain events
+};
+
+/// Immutable, sample-indexed snapshot of a track, sorted by sampleTime.
+/// Built on the control thread and handed to the render thread whole.
+struct SequencerTimeline {
+    vector<SequencerTimelineEvent> events;
+
+    /// Index of the first event at or after sampleTime, O(log n)
+    size_t indexOf(long sampleTime) const {
+        auto it = std::lower_bound(events.begin(), events.end(), sampleTime,
+                                   [](const SequencerTimelineEvent &e, long time) { return e.sampleTime < time; });
+        return it - events.begin();
+    }
+};
+
 enum {
     startPointAddress = 0,
 };
@@ -35,8 +62,14 @@ public:
 
     AKSequencerEngineDSPKernel() {}
 
-    void init(int channelCount, double sampleRate) override {
+    ~AKSequencerEngineDSPKernel() {
+        delete pendingTimeline.exchange(nullptr);
+        collectRetiredTimelines();
+        delete activeTimeline;
+    }
 
+    void init(int channelCount, double sampleRate) override {
+        publishTimeline();
     }
 
     void setTargetAU(AudioUnit target) {
@@ -44,6 +77,9 @@ public:
     }
 
     void start() {
+        if (timelineDirty) {
+            publishTimeline();
+        }
         started = true;
         isPlaying = true;
     }
@@ -61,6 +97,7 @@ public:
         double lastPosition = currentPositionInBeats(); // 1) save where we are before we manipulate time
         tempo = newValue;                               // 2) manipulate time
         seekTo(lastPosition);                           // 3) go back to where we were before time manipulation
+        timelineChanged();                              // 4) sample positions of all events have moved
     }
 
     void reset() {
@@ -101,23 +138,77 @@ public:
         }
     }
 
-    void addPlayingNote(MIDINote note, int offset) {
+    void addPlayingNote(const SequencerTimelineEvent &event, int offset, long windowEnd) {
+        const MIDINote &note = event.note;
         if (note.noteOn.data2 > 0) {
             sendMidiData(note.noteOn.status, note.noteOn.data1, note.noteOn.data2, offset, note.noteOn.beat);
-            playingNotes.push_back(note);
+            long offTime = noteOffTime(event.offSampleTime);
+            if (event.sampleTime < offTime && offTime < windowEnd) {
+                // note is shorter than what is left of this buffer
+                sendMidiData(note.noteOff.status, note.noteOff.data1, note.noteOff.data2,
+                             offset + (int)(offTime - event.sampleTime), note.noteOff.beat);
+            } else if (playingNoteCount < AKSEQUENCER_MAX_PLAYING_NOTES) {
+                playingNotes[playingNoteCount].note = note;
+                playingNotes[playingNoteCount].offSampleTime = offTime;
+                playingNoteCount++;
+            } else {
+                // table full: end the note now rather than leave it hanging
+                sendMidiData(note.noteOff.status, note.noteOff.data1, note.noteOff.data2, offset, note.noteOff.beat);
+            }
         } else {
             sendMidiData(note.noteOff.status, note.noteOff.data1, note.noteOff.data2, offset, note.noteOn.beat);
         }
     }
 
-    void stopPlayingNote(MIDINote note, int offset, int index) {
+    void stopPlayingNote(int offset, int index) {
+        MIDINote &note = playingNotes[index].note;
         sendMidiData(note.noteOff.status, note.noteOff.data1, note.noteOff.data2, offset, note.noteOff.beat);
-        playingNotes.erase(playingNotes.begin() + index);
+        playingNotes[index] = playingNotes[--playingNoteCount];
+    }
+
+    /// Sends everything due in [startSample, endSample) of the loop, offset by bufferOffset frames
+    void renderSegment(long startSample, long endSample, int bufferOffset) {
+        // Note offs first, so a note retriggered at the same time is not cut by its predecessor
+        int i = 0;
+        while (i < playingNoteCount) {
+            long triggerTime = playingNotes[i].offSampleTime;
+            if (startSample <= triggerTime && triggerTime < endSample) {
+                stopPlayingNote(bufferOffset + (int)(triggerTime - startSample), i);
+                continue;
+            }
+            i++;
+        }
+
+        if (activeTimeline == nullptr) {
+            return;
+        }
+        const vector<SequencerTimelineEvent> &events = activeTimeline->events;
+        if (cursorSample != startSample) {
+            cursor = activeTimeline->indexOf(startSample);
+        }
+        while (cursor < events.size() && events[cursor].sampleTime < endSample) {
+            const SequencerTimelineEvent &event = events[cursor];
+            int offset = bufferOffset + (int)(event.sampleTime - startSample);
+            if (event.offSampleTime < 0) {
+                sendMidiData(event.note.noteOn.status, event.note.noteOn.data1, event.note.noteOn.data2,
+                             offset, event.note.noteOn.beat);
+            } else {
+                addPlayingNote(event, offset, endSample);
+            }
+            cursor++;
+        }
+        cursorSample = endSample;
     }
 
     void process(AUAudioFrameCount frameCount, AUAudioFrameCount bufferOffset) override {
+        adoptPendingTimeline();
+        if (stopAllRequested.exchange(false)) {
+            stopPlayingNotesNow();
+        }
+
         if (isPlaying) {
-            if (positionInSamples >= lengthInSamples()){
+            long length = lengthInSamples();
+            if (positionInSamples >= length){
                 if (!loopEnabled) { //stop if played enough
                     stop();
                     return;
@@ -125,66 +216,17 @@ public:
             }
             long currentStartSample = positionModulo();
             long currentEndSample = currentStartSample + frameCount;
-            for (int i = 0; i < events.size(); i++) {
-                // go through every event
-                int triggerTime = beatToSamples(events[i].beat);
-                if (currentStartSample <= triggerTime && triggerTime < currentEndSample) {
-                    // this event is supposed to trigger between currentStartSample and currentEndSample
-                    int offset = (int)(triggerTime - currentStartSample);
-                    sendMidiData(events[i].status, events[i].data1, events[i].data2,
-                                 offset, events[i].beat);
-                } else if (currentEndSample > lengthInSamples() && loopEnabled) {
-                    // this buffer extends beyond the length of the loop and looping is on
-                    int loopRestartInBuffer = (int)(lengthInSamples() - currentStartSample);
-                    int samplesOfBufferForNewLoop = frameCount - loopRestartInBuffer;
-                    if (triggerTime < samplesOfBufferForNewLoop) {
-                        // this event would trigger early enough in the next loop that it should happen in this buffer
-                        // ie. this buffer contains events from the previous loop, and the next loop
-                        int offset = (int)triggerTime + loopRestartInBuffer;
-                        sendMidiData(events[i].status, events[i].data1, events[i].data2,
-                                     offset, events[i].beat);
-                    }
-                }
-            }
-
-            // Check scheduled notes for note ons
-            for (int i = 0; i < notes.size(); i++) {
-                int triggerTime = beatToSamples(notes[i].noteOn.beat);
-                if (currentStartSample <= triggerTime && triggerTime < currentEndSample) {
-                    int offset = (int)(triggerTime - currentStartSample);
-                    addPlayingNote(notes[i], offset);
-                } else if (currentEndSample > lengthInSamples() && loopEnabled) {
-                    int loopRestartInBuffer = (int)(lengthInSamples() - currentStartSample);
-                    int samplesOfBufferForNewLoop = frameCount - loopRestartInBuffer;
-                    if (triggerTime < samplesOfBufferForNewLoop) {
-                        int offset = (int)triggerTime + loopRestartInBuffer;
-                        addPlayingNote(notes[i], offset);
-                    }
-                }
-            }
-
-            // Check the playing notes for note offs
-            int i = 0;
-
-            while (i < playingNotes.size()) {
-                int triggerTime = beatToSamples(playingNotes[i].noteOff.beat);
-                if (currentStartSample <= triggerTime && triggerTime < currentEndSample) {
-                    int offset = (int)(triggerTime - currentStartSample);
-                    stopPlayingNote(playingNotes[i], offset, i);
-                    continue;
-                }
-
-                if (currentEndSample > lengthInSamples() && loopEnabled) {
-                    int loopRestartInBuffer = (int)(lengthInSamples() - currentStartSample);
-                    int samplesOfBufferForNewLoop = frameCount - loopRestartInBuffer;
-                    if (triggerTime < samplesOfBufferForNewLoop) {
-                        int offset = (int)triggerTime + loopRestartInBuffer;
-                        stopPlayingNote(playingNotes[i], offset, i);
-                        continue;
-                    }
-                }
-                i++;
+            int segmentOffset = (int)bufferOffset;
+
+            // this buffer extends beyond the length of the loop and looping is on:
+            // finish the current pass and continue from the top of the loop
+            while (loopEnabled && length > 0 && currentEndSample > length) {
+                renderSegment(currentStartSample, length, segmentOffset);
+                segmentOffset += (int)(length - currentStartSample);
+                currentEndSample -= length;
+                currentStartSample = 0;
             }
+            renderSegment(currentStartSample, currentEndSample, segmentOffset);
 
             positionInSamples += frameCount;
         }
@@ -198,6 +240,7 @@ public:
         newEvent.data2 = data2;
         newEvent.beat = beat;
         events.push_back(newEvent);
+        timelineChanged();
     }
 
     void addMIDINote(uint8_t number, uint8_t velocity, double beat, double duration) {
@@ -214,17 +257,18 @@ public:
         newNote.noteOff.beat = beat + duration;
 
         notes.push_back(newNote);
+        timelineChanged();
     }
 
     void clear() {
         notes.clear();
         events.clear();
+        timelineChanged();
     }
 
+    /// Safe to call from any thread, the notes are stopped at the start of the next render
     void stopPlayingNotes() {
-        while (playingNotes.size() > 0) {
-            stopPlayingNote(playingNotes[0], 0, 0);
-        }
+        stopAllRequested = true;
     }
 
     void sendMidiData(UInt8 status, UInt8 data1, UInt8 data2, double offset, double time) {
@@ -273,11 +317,107 @@ public:
 
 private:
 
+    struct PlayingNote {
+        MIDINote note;
+        long offSampleTime;
+    };
+
+    /// Note offs past the end of the loop sound in the next pass
+    long noteOffTime(long offSampleTime) {
+        long length = lengthInSamples();
+        if (loopEnabled && length > 0 && offSampleTime >= length) {
+            return offSampleTime % length;
+        }
+        return offSampleTime;
+    }
+
+    void stopPlayingNotesNow() {
+        while (playingNoteCount > 0) {
+            stopPlayingNote(0, playingNoteCount - 1);
+        }
+    }
+
+    /// Control thread: rebuild now if the render thread may be reading, otherwise on the next start()
+    void timelineChanged() {
+        if (isPlaying) {
+            publishTimeline();
+        } else {
+            timelineDirty = true;
+        }
+    }
+
+    /// Control thread: sort the edited track into a new snapshot and hand it to the render thread
+    void publishTimeline() {
+        timelineDirty = false;
+        SequencerTimeline *timeline = new SequencerTimeline;
+        timeline->events.reserve(events.size() + notes.size());
+        for (const MIDIEvent &event : events) {
+            SequencerTimelineEvent entry;
+            entry.sampleTime = beatToSamples(event.beat);
+            entry.offSampleTime = -1;
+            entry.note.noteOn = event;
+            entry.note.noteOff = event;
+            timeline->events.push_back(entry);
+        }
+        for (const MIDINote &note : notes) {
+            SequencerTimelineEvent entry;
+            entry.sampleTime = beatToSamples(note.noteOn.beat);
+            entry.offSampleTime = beatToSamples(note.noteOff.beat);
+            entry.note = note;
+            timeline->events.push_back(entry);
+        }
+        // stable, so plain events keep sounding before notes at the same position
+        std::stable_sort(timeline->events.begin(), timeline->events.end(),
+                         [](const SequencerTimelineEvent &a, const SequencerTimelineEvent &b) {
+                             return a.sampleTime < b.sampleTime;
+                         });
+
+        // a snapshot still pending was never seen by the render thread, so it can be freed here
+        collectRetiredTimelines();
+        delete pendingTimeline.exchange(timeline, std::memory_order_acq_rel);
+    }
+
+    /// Control thread: free the snapshots the render thread has replaced
+    void collectRetiredTimelines() {
+        AKDSPCommand command;
+        while (retiredTimelineBus.pop(command)) delete (SequencerTimeline *)command.buffer.buffer;
+    }
+
+    /// Render thread: swap in the newest snapshot, never allocates or frees
+    void adoptPendingTimeline() {
+        if (pendingTimeline.load(std::memory_order_relaxed) == nullptr) {
+            return;
+        }
+        SequencerTimeline *timeline = pendingTimeline.exchange(nullptr, std::memory_order_acq_rel);
+        if (activeTimeline != nullptr) {
+            AKDSPCommand retired = {};
+            retired.type = AKDSPCommandBufferSwap;
+            retired.buffer.buffer = activeTimeline;
+            retiredTimelineBus.post(retired);
+        }
+        activeTimeline = timeline;
+        cursorSample = -1;
+    }
+
     float startPoint = 0;
     AudioUnit targetAU;
     UInt64 framesCounted = 0;
     long positionInSamples = 0;
 
+    // The newest snapshot waits in pendingTimeline, replacing any the render thread hasn't taken yet.
+    // The ones it replaces on the render thread come back on retiredTimelineBus, to be freed by the next
+    // publish; the render thread takes at most one snapshot per publish, so the bus never fills.
+    std::atomic<SequencerTimeline *> pendingTimeline{nullptr};
+    AKDSPCommandBus retiredTimelineBus{16};
+    SequencerTimeline *activeTimeline = nullptr;    // render thread only
+    bool timelineDirty = false;
+    size_t cursor = 0;
+    long cursorSample = -1;
+
+    PlayingNote playingNotes[AKSEQUENCER_MAX_PLAYING_NOTES];
+    int playingNoteCount = 0;
+    std::atomic<bool> stopAllRequested{false};
+
 public:
     bool started = false;
     bool resetted = false;
@@ -287,9 +427,8 @@ public:
     MIDIPortRef midiPort;
     MIDIEndpointRef midiEndpoint;
     AKCCallback loopCallback = nullptr;
-    vector<MIDIEvent> events;
-    vector<MIDINote> notes;
-    vector<MIDINote> playingNotes;
+    vector<MIDIEvent> events;   // control thread only; the render thread reads the published timeline
+    vector<MIDINote> notes;     // control thread only
     int maximumPlayCount = 0;
     double length = 4.0;
     double tempo = 120.0;
@@ -0,0 +1,85 @@
+//
+//  AKWavpackRecorder.hpp
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+#ifdef __cplusplus
+
+#import <AudioToolbox/AudioToolbox.h>
+#import <memory>
+
+/**
+ Records any number of tracks to Wavpack files, lossless or hybrid, without the render thread
+ ever waiting on compression or the disk.
+
+ The render thread only copies each track's planar float blocks into that track's lock-free
+ ring buffer. Every track has its own encoder thread, which drains the ring, compresses and
+ writes, so tracks are encoded in parallel. If an encoder falls so far behind that its ring
+ fills, the blocks that don't fit are dropped and counted rather than waited for.
+
+ Add tracks, then start; write from the render thread; stop from a control thread to drain
+ the rings and finish the files. Tracks cannot be added while recording.
+ */
+class AKWavpackRecorder {
+public:
+
+    struct Settings {
+        /// 16 or 24 for integer samples (clipped to +/- 1.0), 32 to store the floats themselves
+        int bitsPerSample = 24;
+        /// 0 for lossless; otherwise the hybrid mode's bitrate in kbps
+        float hybridBitrate = 0;
+        /// In hybrid mode, also write a .wvc correction file next to each track, making it lossless again
+        bool createCorrectionFile = false;
+        /// Better compression for more encoder time
+        bool highQuality = false;
+        /// Length of each track's ring buffer; the most the encoder may lag before blocks are dropped
+        double queueSeconds = 2.0;
+    };
+
+    struct TrackStats {
+        uint64_t framesWritten;     // accepted from the render thread
+        uint64_t framesDropped;     // refused because the ring was full
+        uint64_t framesEncoded;
+        uint64_t bytesEncoded;
+        double encoderLag;          // seconds of audio waiting to be encoded
+        double queueDepth;          // fraction of the ring in use
+        double maximumQueueDepth;
+        bool failed;                // the file couldn't be opened or written
+    };
+
+    AKWavpackRecorder(double sampleRate);
+    AKWavpackRecorder(double sampleRate, Settings settings);
+    ~AKWavpackRecorder();
+
+    AKWavpackRecorder(const AKWavpackRecorder &) = delete;
+    AKWavpackRecorder &operator=(const AKWavpackRecorder &) = delete;
+
+    /// Control thread, while stopped. Up to 18 channels. Returns the track index, or -1 if the recorder is running.
+    int addTrack(const char *path, int channelCount);
+
+    /// Control thread. Opens the files and starts the encoder threads. Returns false if any track failed to open.
+    bool start();
+
+    /// Control thread. Encodes whatever is still queued, finishes the files and joins the encoders.
+    void stop();
+
+    bool isRecording();
+
+    /// Render thread. Never blocks; returns false if the block was dropped.
+    bool write(int track, const float *const *channels, AUAudioFrameCount frameCount);
+    bool write(int track, const AudioBufferList *bufferList, AUAudioFrameCount frameCount);
+
+    /// Any thread
+    TrackStats getStats(int track);
+    int getTrackCount();
+
+private:
+    struct InternalData;
+    std::unique_ptr<InternalData> data;
+};
+
+#endif
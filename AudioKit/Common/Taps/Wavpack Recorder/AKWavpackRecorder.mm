@@ -0,0 +1,352 @@
+//
+//  AKWavpackRecorder.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import "AKWavpackRecorder.hpp"
+#import "TPCircularBuffer.h"
+#import "wavpack.h"
+
+#import <dispatch/dispatch.h>
+#import <pthread.h>
+#import <atomic>
+#import <cmath>
+#import <string>
+#import <thread>
+#import <vector>
+
+/// Frames compressed per WavpackPackSamples call
+#define AKWAVPACKRECORDER_CHUNK_FRAMES 4096
+
+/// Channels per track, the most a Wavpack channel mask can describe
+#define AKWAVPACKRECORDER_MAX_CHANNELS 18
+
+/// One compressed stream and the first block written to it, which gets the final length when it's done
+struct AKWavpackRecorderOutput {
+    FILE *file = nullptr;
+    std::vector<char> firstBlock;
+    std::atomic<uint64_t> *bytesEncoded = nullptr;
+    bool failed = false;
+};
+
+static int writeBlock(void *id, void *data, int32_t byteCount) {
+    AKWavpackRecorderOutput *output = (AKWavpackRecorderOutput *)id;
+    if (output->firstBlock.empty()) {
+        output->firstBlock.assign((char *)data, (char *)data + byteCount);
+    }
+    if (fwrite(data, 1, byteCount, output->file) != (size_t)byteCount) {
+        output->failed = true;
+        return false;
+    }
+    output->bytesEncoded->fetch_add(byteCount, std::memory_order_relaxed);
+    return true;
+}
+
+struct AKWavpackRecorderTrack {
+    std::string path;
+    int channelCount;
+
+    // Render thread to encoder thread
+    TPCircularBuffer ring;
+    bool ringAllocated = false;
+    dispatch_semaphore_t wakeup;
+
+    // Encoder thread
+    std::thread encoder;
+    WavpackContext *context = nullptr;
+    AKWavpackRecorderOutput output;
+    AKWavpackRecorderOutput correctionOutput;
+    std::vector<int32_t> samples;
+
+    std::atomic<uint64_t> framesWritten{0};
+    std::atomic<uint64_t> framesDropped{0};
+    std::atomic<uint64_t> framesEncoded{0};
+    std::atomic<uint64_t> bytesEncoded{0};
+    std::atomic<int32_t> maximumFill{0};
+    std::atomic<bool> failed{false};
+
+    AKWavpackRecorderTrack(const char *path, int channelCount) : path(path), channelCount(channelCount) {
+        wakeup = dispatch_semaphore_create(0);
+        output.bytesEncoded = &bytesEncoded;
+        correctionOutput.bytesEncoded = &bytesEncoded;
+    }
+
+    ~AKWavpackRecorderTrack() {
+        if (ringAllocated) TPCircularBufferCleanup(&ring);
+    }
+};
+
+struct AKWavpackRecorder::InternalData {
+    double sampleRate;
+    Settings settings;
+    std::vector<std::unique_ptr<AKWavpackRecorderTrack>> tracks;
+
+    std::atomic<bool> recording{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<int> activeWriters{0};
+
+    bool openTrack(AKWavpackRecorderTrack &track);
+    void encode(AKWavpackRecorderTrack &track);
+    void drain(AKWavpackRecorderTrack &track);
+    void finish(AKWavpackRecorderTrack &track);
+};
+
+AKWavpackRecorder::AKWavpackRecorder(double sampleRate) : AKWavpackRecorder(sampleRate, Settings()) {}
+
+AKWavpackRecorder::AKWavpackRecorder(double sampleRate, Settings settings) : data(new InternalData) {
+    data->sampleRate = sampleRate;
+    data->settings = settings;
+    if (data->settings.bitsPerSample != 16 && data->settings.bitsPerSample != 32) {
+        data->settings.bitsPerSample = 24;
+    }
+}
+
+AKWavpackRecorder::~AKWavpackRecorder() {
+    stop();
+}
+
+int AKWavpackRecorder::addTrack(const char *path, int channelCount) {
+    if (data->recording || channelCount < 1 || channelCount > AKWAVPACKRECORDER_MAX_CHANNELS) return -1;
+    data->tracks.emplace_back(new AKWavpackRecorderTrack(path, channelCount));
+    return (int)data->tracks.size() - 1;
+}
+
+int AKWavpackRecorder::getTrackCount() {
+    return (int)data->tracks.size();
+}
+
+bool AKWavpackRecorder::isRecording() {
+    return data->recording;
+}
+
+bool AKWavpackRecorder::InternalData::openTrack(AKWavpackRecorderTrack &track) {
+    const Settings &s = settings;
+    bool hybrid = s.hybridBitrate > 0;
+
+    double ringBytes = std::ceil(s.queueSeconds * sampleRate) * track.channelCount * sizeof(float);
+    if (ringBytes > INT32_MAX / 2) ringBytes = INT32_MAX / 2;
+    if (!track.ringAllocated) {
+        if (!TPCircularBufferInit(&track.ring, (int32_t)ringBytes)) return false;
+        track.ringAllocated = true;
+    }
+    TPCircularBufferClear(&track.ring);
+    track.samples.resize(AKWAVPACKRECORDER_CHUNK_FRAMES * track.channelCount);
+
+    track.output.file = fopen(track.path.c_str(), "wb");
+    if (!track.output.file) return false;
+    if (hybrid && s.createCorrectionFile) {
+        track.correctionOutput.file = fopen((track.path + "c").c_str(), "wb");
+        if (!track.correctionOutput.file) return false;
+    }
+
+    track.context = WavpackOpenFileOutput(writeBlock, &track.output,
+                                          track.correctionOutput.file ? &track.correctionOutput : nullptr);
+    if (!track.context) return false;
+
+    WavpackConfig config;
+    memset(&config, 0, sizeof(config));
+    config.bits_per_sample = s.bitsPerSample;
+    config.bytes_per_sample = s.bitsPerSample / 8;
+    config.float_norm_exp = s.bitsPerSample == 32 ? 127 : 0;
+    config.num_channels = track.channelCount;
+    config.sample_rate = (int32_t)sampleRate;
+    config.channel_mask = track.channelCount == 1 ? 0x4 : (1 << track.channelCount) - 1;
+    if (s.highQuality) config.flags |= CONFIG_HIGH_FLAG;
+    if (hybrid) {
+        config.flags |= CONFIG_HYBRID_FLAG | CONFIG_BITRATE_KBPS;
+        config.bitrate = s.hybridBitrate;
+        if (track.correctionOutput.file) config.flags |= CONFIG_CREATE_WVC;
+    }
+
+    // The length isn't known yet; finish() writes it into the first block
+    return WavpackSetConfiguration(track.context, &config, (uint32_t)-1) && WavpackPackInit(track.context);
+}
+
+bool AKWavpackRecorder::start() {
+    if (data->recording) return true;
+    bool allOpened = true;
+    for (auto &track : data->tracks) {
+        track->framesWritten = 0;
+        track->framesDropped = 0;
+        track->framesEncoded = 0;
+        track->bytesEncoded = 0;
+        track->maximumFill = 0;
+        track->failed = false;
+        track->output = AKWavpackRecorderOutput{nullptr, {}, &track->bytesEncoded, false};
+        track->correctionOutput = AKWavpackRecorderOutput{nullptr, {}, &track->bytesEncoded, false};
+        if (!data->openTrack(*track)) {
+            track->failed = true;
+            data->finish(*track);
+            allOpened = false;
+        }
+    }
+    data->stopping = false;
+    for (auto &track : data->tracks) {
+        if (!track->failed) {
+            AKWavpackRecorderTrack *t = track.get();
+            track->encoder = std::thread([this, t] { data->encode(*t); });
+        }
+    }
+    data->recording = true;
+    return allOpened;
+}
+
+void AKWavpackRecorder::stop() {
+    if (!data->recording) return;
+    data->recording = false;
+    // A write that saw recording before it was cleared finishes before the encoders take their last look
+    while (data->activeWriters.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+    data->stopping = true;
+    for (auto &track : data->tracks) {
+        dispatch_semaphore_signal(track->wakeup);
+    }
+    for (auto &track : data->tracks) {
+        if (track->encoder.joinable()) track->encoder.join();
+    }
+}
+
+void AKWavpackRecorder::InternalData::encode(AKWavpackRecorderTrack &track) {
+#ifdef __APPLE__
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+    while (true) {
+        dispatch_semaphore_wait(track.wakeup, dispatch_time(DISPATCH_TIME_NOW, 50 * NSEC_PER_MSEC));
+        bool last = stopping.load(std::memory_order_acquire);
+        drain(track);
+        if (last) break;
+    }
+    finish(track);
+}
+
+void AKWavpackRecorder::InternalData::drain(AKWavpackRecorderTrack &track) {
+    int channelCount = track.channelCount;
+    int32_t frameBytes = channelCount * sizeof(float);
+    float scale = (float)(1 << (settings.bitsPerSample - 1));
+    float maximum = scale - 1.0f;
+
+    int32_t availableBytes;
+    float *queued;
+    while (!track.failed && (queued = (float *)TPCircularBufferTail(&track.ring, &availableBytes))) {
+        int32_t frameCount = std::min(availableBytes / frameBytes, AKWAVPACKRECORDER_CHUNK_FRAMES);
+        int32_t sampleCount = frameCount * channelCount;
+        int32_t *samples = track.samples.data();
+
+        if (settings.bitsPerSample == 32) {
+            memcpy(samples, queued, sampleCount * sizeof(float));
+        } else {
+            for (int32_t i = 0; i < sampleCount; i++) {
+                samples[i] = (int32_t)lrintf(std::max(-scale, std::min(maximum, queued[i] * scale)));
+            }
+        }
+        TPCircularBufferConsume(&track.ring, frameCount * frameBytes);
+
+        if (!WavpackPackSamples(track.context, samples, frameCount)) {
+            track.failed = true;
+            break;
+        }
+        track.framesEncoded.fetch_add(frameCount, std::memory_order_relaxed);
+    }
+}
+
+static void rewriteFirstBlock(AKWavpackRecorderOutput &output, WavpackContext *context) {
+    if (!output.file || output.firstBlock.empty()) return;
+    WavpackUpdateNumSamples(context, output.firstBlock.data());
+    if (fseek(output.file, 0, SEEK_SET) != 0 ||
+        fwrite(output.firstBlock.data(), 1, output.firstBlock.size(), output.file) != output.firstBlock.size()) {
+        output.failed = true;
+    }
+}
+
+void AKWavpackRecorder::InternalData::finish(AKWavpackRecorderTrack &track) {
+    if (track.context) {
+        if (!track.failed && WavpackFlushSamples(track.context)) {
+            rewriteFirstBlock(track.output, track.context);
+            rewriteFirstBlock(track.correctionOutput, track.context);
+        }
+        WavpackCloseFile(track.context);
+        track.context = nullptr;
+    }
+    for (AKWavpackRecorderOutput *output : { &track.output, &track.correctionOutput }) {
+        if (output->failed) track.failed = true;
+        if (output->file) fclose(output->file);
+        output->file = nullptr;
+        output->firstBlock.clear();
+    }
+}
+
+bool AKWavpackRecorder::write(int track, const float *const *channels, AUAudioFrameCount frameCount) {
+    data->activeWriters.fetch_add(1, std::memory_order_acq_rel);
+    if (!data->recording.load(std::memory_order_acquire) || track < 0 || track >= (int)data->tracks.size()) {
+        data->activeWriters.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+    AKWavpackRecorderTrack &t = *data->tracks[track];
+    if (t.failed) {
+        data->activeWriters.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    int channelCount = t.channelCount;
+    int32_t bytes = frameCount * channelCount * sizeof(float);
+    int32_t space;
+    float *head = (float *)TPCircularBufferHead(&t.ring, &space);
+    if (!head || space < bytes) {
+        t.framesDropped.fetch_add(frameCount, std::memory_order_relaxed);
+        data->activeWriters.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    for (int channel = 0; channel < channelCount; channel++) {
+        const float *source = channels[channel];
+        float *destination = head + channel;
+        for (AUAudioFrameCount i = 0; i < frameCount; i++, destination += channelCount) {
+            *destination = source[i];
+        }
+    }
+    TPCircularBufferProduce(&t.ring, bytes);
+
+    int32_t fill = t.ring.fillCount;
+    int32_t maximumFill = t.maximumFill.load(std::memory_order_relaxed);
+    while (fill > maximumFill && !t.maximumFill.compare_exchange_weak(maximumFill, fill, std::memory_order_relaxed)) {}
+    t.framesWritten.fetch_add(frameCount, std::memory_order_relaxed);
+    dispatch_semaphore_signal(t.wakeup);
+
+    data->activeWriters.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+bool AKWavpackRecorder::write(int track, const AudioBufferList *bufferList, AUAudioFrameCount frameCount) {
+    if (track < 0 || track >= (int)data->tracks.size()) return false;
+    int channelCount = data->tracks[track]->channelCount;
+    if ((int)bufferList->mNumberBuffers < channelCount) return false;
+
+    const float *channels[AKWAVPACKRECORDER_MAX_CHANNELS];
+    for (int channel = 0; channel < channelCount; channel++) {
+        channels[channel] = (const float *)bufferList->mBuffers[channel].mData;
+    }
+    return write(track, channels, frameCount);
+}
+
+AKWavpackRecorder::TrackStats AKWavpackRecorder::getStats(int track) {
+    TrackStats stats = {};
+    if (track < 0 || track >= (int)data->tracks.size()) return stats;
+    AKWavpackRecorderTrack &t = *data->tracks[track];
+
+    stats.framesWritten = t.framesWritten.load(std::memory_order_relaxed);
+    stats.framesDropped = t.framesDropped.load(std::memory_order_relaxed);
+    stats.framesEncoded = t.framesEncoded.load(std::memory_order_relaxed);
+    stats.bytesEncoded = t.bytesEncoded.load(std::memory_order_relaxed);
+    stats.failed = t.failed;
+    if (t.ringAllocated && t.ring.length > 0) {
+        int32_t fill = t.ring.fillCount;
+        stats.encoderLag = (double)fill / (t.channelCount * sizeof(float)) / data->sampleRate;
+        stats.queueDepth = (double)fill / t.ring.length;
+        stats.maximumQueueDepth = (double)t.maximumFill.load(std::memory_order_relaxed) / t.ring.length;
+    }
+    return stats;
+}
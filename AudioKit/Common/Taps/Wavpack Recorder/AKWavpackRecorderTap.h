@@ -0,0 +1,86 @@
+//
+//  AKWavpackRecorderTap.h
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <AVFoundation/AVFoundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+
+/*!
+ * Records a node's output to a Wavpack file with an AKWavpackRecorder.
+ *
+ * The render notify only queues each block; compression and disk writes
+ * happen on the recorder's encoder thread. Set the properties before
+ * the first call to start.
+ */
+@interface AKWavpackRecorderTap : NSObject
+
+/*!
+ * Initializes a tap by adding a render notify callback to the node's
+ * underlying audioUnit.
+ *
+ * The render notify will be removed on dealloc.
+ *
+ * @param node The AVAudioNode whose output will be recorded.
+ * @param path Where to write the .wv file.
+ * @return An AKWavpackRecorderTap if successful in adding the renderNotify.
+ */
+-(instancetype _Nullable)initWithNode:(AVAudioNode * _Nonnull)node path:(NSString * _Nonnull)path;
+
+/*!
+ * Initializes a tap by adding a render notify callback to the audioUnit.
+ *
+ * The render notify will be removed on dealloc.
+ *
+ * @param audioUnit The audioUnit whose output will be recorded.
+ * @param path Where to write the .wv file.
+ * @return An AKWavpackRecorderTap if successful in adding the renderNotify.
+ */
+-(instancetype _Nullable)initWithAudioUnit:(AudioUnit _Nonnull)audioUnit path:(NSString * _Nonnull)path NS_DESIGNATED_INITIALIZER;
+-(instancetype _Nonnull)init NS_UNAVAILABLE;
+
+/// 16 or 24 for integer samples (clipped to +/- 1.0), 32 to store the floats themselves. Defaults to 24.
+@property int bitsPerSample;
+
+/// 0 for lossless; otherwise the hybrid mode's bitrate in kbps
+@property float hybridBitrate;
+
+/// In hybrid mode, also write a .wvc correction file next to the .wv
+@property BOOL createCorrectionFile;
+
+/// Better compression for more encoder time
+@property BOOL highQuality;
+
+/// The most audio the encoder may lag before blocks are dropped. Defaults to 2 seconds.
+@property double queueSeconds;
+
+/*!
+ * Opens the file and starts recording. Starting again overwrites the file.
+ *
+ * @return False if the file couldn't be opened.
+ */
+-(BOOL)start;
+
+/*!
+ * Encodes whatever is still queued and finishes the file.
+ */
+-(void)stop;
+
+@property (readonly) BOOL isRecording;
+
+/// Frames accepted from the render thread since start
+@property (readonly) UInt64 framesWritten;
+
+/// Frames refused because the encoder had fallen queueSeconds behind
+@property (readonly) UInt64 framesDropped;
+
+@property (readonly) UInt64 bytesEncoded;
+
+/// Whether the file couldn't be opened or written
+@property (readonly) BOOL failed;
+
+@end
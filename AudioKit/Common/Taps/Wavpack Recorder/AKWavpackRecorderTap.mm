@@ -0,0 +1,142 @@
+//
+//  AKWavpackRecorderTap.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import "AKWavpackRecorderTap.h"
+#import "AKWavpackRecorder.hpp"
+#import "AKRenderTap.h"
+#import <atomic>
+
+@implementation AKWavpackRecorderTap {
+    NSString *path;
+    double sampleRate;
+    int channelCount;
+    // Made on the first start, from the properties as they are then. Heap allocated, as the render notify
+    // may still be reading it after the tap is gone; dealloc frees both once it can't be.
+    std::atomic<AKWavpackRecorder *> *recorder;
+    AKRenderTap *tap;
+}
+
+-(instancetype _Nullable)initWithAudioUnit:(AudioUnit)audioUnit path:(NSString *)filePath {
+    self = [super init];
+    if (self) {
+        UInt32 propSize = sizeof(AudioStreamBasicDescription);
+        AudioStreamBasicDescription asbd;
+        OSStatus status = AudioUnitGetProperty(audioUnit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Output, 0, &asbd, &propSize);
+        if (status) {
+            printf("%s OSStatus %d %d\n",__FILE__,(int)status,__LINE__);
+            return nil;
+        }
+        if (asbd.mFormatID != kAudioFormatLinearPCM || !(asbd.mFormatFlags & kAudioFormatFlagIsFloat) ||
+            !(asbd.mFormatFlags & kAudioFormatFlagIsNonInterleaved) || asbd.mBitsPerChannel != 32) {
+            NSLog(@"AKWavpackRecorderTap needs deinterleaved float output");
+            return nil;
+        }
+
+        path = [filePath copy];
+        sampleRate = asbd.mSampleRate;
+        channelCount = asbd.mChannelsPerFrame;
+        recorder = new std::atomic<AKWavpackRecorder *>(nullptr);
+
+        AKWavpackRecorder::Settings defaults;
+        _bitsPerSample = defaults.bitsPerSample;
+        _hybridBitrate = defaults.hybridBitrate;
+        _createCorrectionFile = defaults.createCorrectionFile;
+        _highQuality = defaults.highQuality;
+        _queueSeconds = defaults.queueSeconds;
+
+        tap = [[AKRenderTap alloc]initWithAudioUnit:audioUnit renderNotify:[self renderNotifyBlock]];
+        if (!tap) return nil;
+    }
+    return self;
+}
+-(instancetype)initWithNode:(AVAudioNode *)node path:(NSString *)filePath {
+    AVAudioUnit *avAudioUnit = (AVAudioUnit *)node;
+    if (![avAudioUnit respondsToSelector:@selector(audioUnit)]) {
+        NSLog(@"%@ doesn't have an accessible audioUnit",NSStringFromClass(node.class));
+        return nil;
+    }
+    return [self initWithAudioUnit:avAudioUnit.audioUnit path:filePath];
+}
+
+-(AKRenderNotifyBlock)renderNotifyBlock {
+    // Captures the holder rather than self, so the tap doesn't keep itself alive
+    std::atomic<AKWavpackRecorder *> *recorderRef = recorder;
+    return ^(AudioUnitRenderActionFlags *ioActionFlags,
+             const AudioTimeStamp *inTimeStamp,
+             UInt32 inBusNumber,
+             UInt32 inNumberFrames,
+             AudioBufferList *ioData) {
+        if (!(*ioActionFlags & kAudioUnitRenderAction_PostRender)) return;
+        AKWavpackRecorder *active = recorderRef->load(std::memory_order_acquire);
+        if (active) active->write(0, ioData, inNumberFrames);
+    };
+}
+
+- (void)dealloc {
+    //Cleanup should happen after at least two render cycles so that nothing is deallocated mid-render
+    double timeFromNow = 0.2;
+    std::atomic<AKWavpackRecorder *> *dRecorder = recorder;
+    if (!dRecorder) return;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeFromNow * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        delete dRecorder->load();
+        delete dRecorder;
+    });
+}
+
+-(BOOL)start {
+    AKWavpackRecorder *active = recorder->load(std::memory_order_acquire);
+    if (!active) {
+        AKWavpackRecorder::Settings settings;
+        settings.bitsPerSample = _bitsPerSample;
+        settings.hybridBitrate = _hybridBitrate;
+        settings.createCorrectionFile = _createCorrectionFile;
+        settings.highQuality = _highQuality;
+        settings.queueSeconds = _queueSeconds;
+        active = new AKWavpackRecorder(sampleRate, settings);
+        if (active->addTrack(path.fileSystemRepresentation, channelCount) < 0) {
+            delete active;
+            return NO;
+        }
+        recorder->store(active, std::memory_order_release);
+    }
+    return active->start();
+}
+
+-(void)stop {
+    AKWavpackRecorder *active = recorder->load(std::memory_order_acquire);
+    if (active) active->stop();
+}
+
+-(BOOL)isRecording {
+    AKWavpackRecorder *active = recorder->load(std::memory_order_acquire);
+    return active && active->isRecording();
+}
+
+-(AKWavpackRecorder::TrackStats)stats {
+    AKWavpackRecorder *active = recorder->load(std::memory_order_acquire);
+    if (active) return active->getStats(0);
+    return AKWavpackRecorder::TrackStats{};
+}
+
+-(UInt64)framesWritten {
+    return [self stats].framesWritten;
+}
+
+-(UInt64)framesDropped {
+    return [self stats].framesDropped;
+}
+
+-(UInt64)bytesEncoded {
+    return [self stats].bytesEncoded;
+}
+
+-(BOOL)failed {
+    return [self stats].failed;
+}
+
+@end
@@ -59,6 +59,7 @@ namespace AudioKitCore
         void reset();       // reset to idle state
         bool isIdle() { return env.getCurrentSegmentIndex() == kIdle; }
         bool isPreStarting() { return env.getCurrentSegmentIndex() == kSilence; }
+        bool isAttacking() { return env.getCurrentSegmentIndex() == kAttack; }
         bool isReleasing() { return env.getCurrentSegmentIndex() == kRelease; }
 
         inline float getValue()
@@ -0,0 +1,484 @@
+//
+//  AKLoudnessMeter.cpp
+//  AudioKit Core
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#include "AKLoudnessMeter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+namespace
+{
+    const int kBlockFrames = 256;           // longest run metered at once, bounding the scratch buffers
+    const int kLanes = 8;                   // independent accumulators, so the level loops vectorize
+    const int kOversampling = 4;
+    const int kTruePeakTaps = 12;           // per phase of the oversampling filter
+    const int kLevelSegments = 4;           // peak and RMS window, counting the segment in progress
+    const int kMomentarySegments = 4;
+    const int kShortTermSegments = 30;
+    const int kHistogramBins = 1000;        // gating blocks, in 0.1 LU steps up from the absolute gate
+    const double kAbsoluteGate = -70.0;
+    const double kRelativeGate = -10.0;
+
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    inline double loudness(double energy)
+    {
+        return energy > 0.0 ? -0.691 + 10.0 * log10(energy) : -INFINITY;
+    }
+
+    inline float largerOf(float a, float b) { return a > b ? a : b; }
+
+    // Largest absolute value, in kLanes lanes
+    float peakOf(const float *x, int count)
+    {
+        float lanes[kLanes] = {};
+        int i = 0;
+        for (; i + kLanes <= count; i += kLanes) {
+            for (int k = 0; k < kLanes; ++k) lanes[k] = largerOf(lanes[k], fabsf(x[i + k]));
+        }
+        for (; i < count; ++i) lanes[0] = largerOf(lanes[0], fabsf(x[i]));
+        float peak = 0.0f;
+        for (int k = 0; k < kLanes; ++k) peak = largerOf(peak, lanes[k]);
+        return peak;
+    }
+
+    // Largest absolute value and sum of squares together, in kLanes lanes
+    void peakAndSquaresOf(const float *x, int count, float &peak, double &squares)
+    {
+        float peaks[kLanes] = {}, sums[kLanes] = {};
+        int i = 0;
+        for (; i + kLanes <= count; i += kLanes) {
+            for (int k = 0; k < kLanes; ++k) {
+                float value = x[i + k];
+                peaks[k] = largerOf(peaks[k], fabsf(value));
+                sums[k] += value * value;
+            }
+        }
+        for (; i < count; ++i) {
+            peaks[0] = largerOf(peaks[0], fabsf(x[i]));
+            sums[0] += x[i] * x[i];
+        }
+        for (int k = 0; k < kLanes; ++k) {
+            peak = largerOf(peak, peaks[k]);
+            squares += sums[k];
+        }
+    }
+}
+
+struct AKLoudnessMeter::InternalData
+{
+    struct Channel
+    {
+        std::atomic<float> weight { 1.0f };
+
+        // K-weighting filter state, direct form II transposed
+        double shelfState[2], highPassState[2];
+        // the last input samples, which the oversampling filter still reaches back to
+        float history[kTruePeakTaps - 1];
+
+        // the segment in progress
+        float peak, truePeak;
+        double squares, weightedSquares;
+
+        // the last completed segments, in a ring
+        float recentPeak[kLevelSegments - 1], recentTruePeak[kLevelSegments - 1];
+        double recentSquares[kLevelSegments - 1];
+
+        float maximumPeak, maximumTruePeak;
+    };
+
+    Biquad shelf, highPass;
+    float truePeakFilter[kOversampling][kTruePeakTaps];
+
+    std::unique_ptr<Channel[]> channels;
+    int segmentFrames = 0;
+    int segmentPosition = 0;
+    int recentIndex = 0;
+    int recentCount = 0;
+
+    // Weighted mean square of every channel together, for each of the last completed segments
+    double segmentEnergy[kShortTermSegments];
+    int energyIndex = 0;
+    long segmentCount = 0;
+
+    // Gating blocks since the last reset, by loudness
+    uint32_t histogramCount[kHistogramBins];
+    double histogramEnergy[kHistogramBins];
+    long framesSinceReset = 0;
+
+    AKLoudnessReadings readings;
+    std::atomic<bool> resetRequested { false };
+
+    // What readers see, behind a sequence lock. init and deinit change the channel count under it
+    // too. A reader may still be copying from the channel array when init replaces it, so the array
+    // is only replaced by a larger one, and the replaced ones are kept until the meter is destroyed.
+    AKLoudnessReadings publishedReadings;
+    std::atomic<AKChannelMeterReadings *> publishedChannels { nullptr };
+    std::atomic<int> publishedChannelCount { 0 };
+    int publishedCapacity = 0;
+    std::vector<std::unique_ptr<AKChannelMeterReadings[]>> channelArrays;
+    std::atomic<uint32_t> sequence { 0 };
+
+    void designFilters(double sampleRate);
+    void clearTotals(int channelCount);
+    void meterChannel(Channel &channel, const float *input, int frameCount);
+    void completeSegment(int channelCount);
+    double integratedEnergy();
+    void publish(int channelCount, double sampleRate);
+
+    void beginWrite()
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void endWrite()
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
+
+AKLoudnessMeter::AKLoudnessMeter()
+: channelCount(0)
+, sampleRate(44100.0)
+, data(new InternalData)
+{
+}
+
+AKLoudnessMeter::~AKLoudnessMeter()
+{
+    deinit();
+}
+
+void AKLoudnessMeter::init(int channelCount, double sampleRate)
+{
+    this->channelCount = 0;
+    this->sampleRate = sampleRate;
+
+    data->designFilters(sampleRate);
+    data->channels.reset(new InternalData::Channel[channelCount]);
+    for (int c = 0; c < channelCount; ++c) {
+        InternalData::Channel &channel = data->channels[c];
+        memset(channel.shelfState, 0, sizeof(channel.shelfState));
+        memset(channel.highPassState, 0, sizeof(channel.highPassState));
+        memset(channel.history, 0, sizeof(channel.history));
+        channel.peak = channel.truePeak = 0.0f;
+        channel.squares = channel.weightedSquares = 0.0;
+        memset(channel.recentPeak, 0, sizeof(channel.recentPeak));
+        memset(channel.recentTruePeak, 0, sizeof(channel.recentTruePeak));
+        memset(channel.recentSquares, 0, sizeof(channel.recentSquares));
+    }
+
+    data->segmentFrames = (int)lround(0.1 * sampleRate);
+    if (data->segmentFrames < 1) data->segmentFrames = 1;
+    data->segmentPosition = 0;
+    data->recentIndex = data->recentCount = 0;
+    memset(data->segmentEnergy, 0, sizeof(data->segmentEnergy));
+    data->energyIndex = 0;
+    data->segmentCount = 0;
+    data->readings.momentaryLoudness = data->readings.shortTermLoudness = -INFINITY;
+    data->clearTotals(channelCount);
+    data->resetRequested = false;
+
+    data->beginWrite();
+    if (channelCount > data->publishedCapacity) {
+        data->channelArrays.emplace_back(new AKChannelMeterReadings[channelCount]);
+        data->publishedChannels.store(data->channelArrays.back().get(), std::memory_order_relaxed);
+        data->publishedCapacity = channelCount;
+    }
+    AKChannelMeterReadings *published = data->publishedChannels.load(std::memory_order_relaxed);
+    for (int c = 0; c < channelCount; ++c) memset(&published[c], 0, sizeof(AKChannelMeterReadings));
+    data->publishedChannelCount.store(channelCount, std::memory_order_relaxed);
+    data->publishedReadings = data->readings;
+    data->endWrite();
+
+    this->channelCount = channelCount;
+}
+
+void AKLoudnessMeter::deinit()
+{
+    channelCount = 0;
+    data->beginWrite();
+    data->publishedChannelCount.store(0, std::memory_order_relaxed);
+    data->endWrite();
+    data->channels.reset();
+}
+
+void AKLoudnessMeter::setChannelWeight(int channel, float weight)
+{
+    if (channel >= 0 && channel < channelCount) data->channels[channel].weight = weight;
+}
+
+void AKLoudnessMeter::reset()
+{
+    data->resetRequested = true;
+}
+
+void AKLoudnessMeter::InternalData::designFilters(double sampleRate)
+{
+    // BS.1770's two K-weighting stages, from their analog prototypes so any sample rate works
+    double K = tan(M_PI * 1681.974450955533 / sampleRate);
+    double Q = 0.7071752369554196;
+    double Vh = pow(10.0, 3.999843853973347 / 20.0);
+    double Vb = pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+    shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+    shelf.b1 = 2.0 * (K * K - Vh) / a0;
+    shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+    shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+    shelf.a2 = (1.0 - K / Q + K * K) / a0;
+
+    K = tan(M_PI * 38.13547087602444 / sampleRate);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    highPass.b0 = 1.0;
+    highPass.b1 = -2.0;
+    highPass.b2 = 1.0;
+    highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+    highPass.a2 = (1.0 - K / Q + K * K) / a0;
+
+    // True peak: a 48 tap Kaiser-windowed sinc interpolating by 4, split into its four phases,
+    // each normalized to unity gain at DC
+    const int length = kOversampling * kTruePeakTaps;
+    const double beta = 6.0;
+    auto besselI0 = [](double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 30; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+    for (int p = 0; p < kOversampling; ++p) {
+        double sum = 0.0;
+        double taps[kTruePeakTaps];
+        for (int k = 0; k < kTruePeakTaps; ++k) {
+            int m = k * kOversampling + p;
+            double t = (m - 0.5 * (length - 1)) / kOversampling;
+            double sinc = t == 0.0 ? 1.0 : sin(M_PI * t) / (M_PI * t);
+            double r = 2.0 * m / (length - 1) - 1.0;
+            taps[k] = sinc * besselI0(beta * sqrt(1.0 - r * r)) / besselI0(beta);
+            sum += taps[k];
+        }
+        for (int k = 0; k < kTruePeakTaps; ++k) truePeakFilter[p][k] = (float)(taps[k] / sum);
+    }
+}
+
+void AKLoudnessMeter::InternalData::clearTotals(int channelCount)
+{
+    memset(histogramCount, 0, sizeof(histogramCount));
+    memset(histogramEnergy, 0, sizeof(histogramEnergy));
+    framesSinceReset = 0;
+    readings.integratedLoudness = -INFINITY;
+    readings.maximumMomentaryLoudness = -INFINITY;
+    readings.maximumShortTermLoudness = -INFINITY;
+    readings.duration = 0.0;
+    for (int c = 0; c < channelCount; ++c) {
+        channels[c].maximumPeak = channels[c].maximumTruePeak = 0.0f;
+    }
+}
+
+void AKLoudnessMeter::InternalData::meterChannel(Channel &channel, const float *input, int frameCount)
+{
+    peakAndSquaresOf(input, frameCount, channel.peak, channel.squares);
+
+    // K-weighting; a recursion in time, so one sample after another
+    double s0 = channel.shelfState[0], s1 = channel.shelfState[1];
+    double h0 = channel.highPassState[0], h1 = channel.highPassState[1];
+    double weightedSquares = 0.0;
+    for (int i = 0; i < frameCount; ++i) {
+        double x = input[i];
+        double y = shelf.b0 * x + s0;
+        s0 = shelf.b1 * x - shelf.a1 * y + s1;
+        s1 = shelf.b2 * x - shelf.a2 * y;
+        double z = highPass.b0 * y + h0;
+        h0 = highPass.b1 * y - highPass.a1 * z + h1;
+        h1 = highPass.b2 * y - highPass.a2 * z;
+        weightedSquares += z * z;
+    }
+    // The high pass rings down towards denormals after the input stops
+    if (fabs(s0) < 1e-30 && fabs(s1) < 1e-30) s0 = s1 = 0.0;
+    if (fabs(h0) < 1e-30 && fabs(h1) < 1e-30) h0 = h1 = 0.0;
+    channel.shelfState[0] = s0;
+    channel.shelfState[1] = s1;
+    channel.highPassState[0] = h0;
+    channel.highPassState[1] = h1;
+    channel.weightedSquares += weightedSquares;
+
+    // True peak: each phase of the oversampling filter over the whole run, so the loops vectorize
+    float buffer[kTruePeakTaps - 1 + kBlockFrames];
+    float interpolated[kBlockFrames];
+    memcpy(buffer, channel.history, sizeof(channel.history));
+    memcpy(buffer + kTruePeakTaps - 1, input, frameCount * sizeof(float));
+    float truePeak = channel.truePeak;
+    for (int p = 0; p < kOversampling; ++p) {
+        memset(interpolated, 0, frameCount * sizeof(float));
+        for (int k = 0; k < kTruePeakTaps; ++k) {
+            const float h = truePeakFilter[p][k];
+            const float *x = buffer + k;
+            for (int i = 0; i < frameCount; ++i) interpolated[i] += h * x[i];
+        }
+        truePeak = largerOf(truePeak, peakOf(interpolated, frameCount));
+    }
+    memcpy(channel.history, buffer + frameCount, sizeof(channel.history));
+    // None of the phases falls on the input samples themselves
+    channel.truePeak = largerOf(truePeak, channel.peak);
+
+    channel.maximumPeak = largerOf(channel.maximumPeak, channel.peak);
+    channel.maximumTruePeak = largerOf(channel.maximumTruePeak, channel.truePeak);
+}
+
+void AKLoudnessMeter::InternalData::completeSegment(int channelCount)
+{
+    double energy = 0.0;
+    for (int c = 0; c < channelCount; ++c) {
+        Channel &channel = channels[c];
+        energy += channel.weight.load(std::memory_order_relaxed) * channel.weightedSquares / segmentFrames;
+        channel.recentPeak[recentIndex] = channel.peak;
+        channel.recentTruePeak[recentIndex] = channel.truePeak;
+        channel.recentSquares[recentIndex] = channel.squares;
+        channel.peak = channel.truePeak = 0.0f;
+        channel.squares = channel.weightedSquares = 0.0;
+    }
+    recentIndex = (recentIndex + 1) % (kLevelSegments - 1);
+    if (recentCount < kLevelSegments - 1) ++recentCount;
+    segmentPosition = 0;
+
+    segmentEnergy[energyIndex] = energy;
+    energyIndex = (energyIndex + 1) % kShortTermSegments;
+    ++segmentCount;
+
+    // Windows reach back past the first segment into silence, as the meter has heard nothing earlier
+    double momentaryEnergy = 0.0, shortTermEnergy = 0.0;
+    for (int i = 0; i < kShortTermSegments; ++i) {
+        int index = (energyIndex - 1 - i + kShortTermSegments) % kShortTermSegments;
+        if (i < kMomentarySegments) momentaryEnergy += segmentEnergy[index];
+        shortTermEnergy += segmentEnergy[index];
+    }
+    momentaryEnergy /= kMomentarySegments;
+    shortTermEnergy /= kShortTermSegments;
+    readings.momentaryLoudness = (float)loudness(momentaryEnergy);
+    readings.shortTermLoudness = (float)loudness(shortTermEnergy);
+    readings.maximumMomentaryLoudness = std::max(readings.maximumMomentaryLoudness, readings.momentaryLoudness);
+    readings.maximumShortTermLoudness = std::max(readings.maximumShortTermLoudness, readings.shortTermLoudness);
+
+    // Each momentary window is a gating block: 400 ms, overlapping the previous by 75%
+    if (segmentCount < kMomentarySegments) return;
+    double blockLoudness = loudness(momentaryEnergy);
+    if (blockLoudness < kAbsoluteGate) return;
+    int bin = (int)((blockLoudness - kAbsoluteGate) * 10.0);
+    if (bin >= kHistogramBins) bin = kHistogramBins - 1;
+    histogramCount[bin]++;
+    histogramEnergy[bin] += momentaryEnergy;
+    readings.integratedLoudness = (float)loudness(integratedEnergy());
+}
+
+double AKLoudnessMeter::InternalData::integratedEnergy()
+{
+    double energy = 0.0;
+    uint64_t count = 0;
+    for (int bin = 0; bin < kHistogramBins; ++bin) {
+        energy += histogramEnergy[bin];
+        count += histogramCount[bin];
+    }
+    if (count == 0) return 0.0;
+
+    // The relative gate, to the nearest 0.1 LU
+    double gate = loudness(energy / count) + kRelativeGate;
+    int first = (int)ceil((gate - kAbsoluteGate) * 10.0);
+    if (first < 0) first = 0;
+    energy = 0.0;
+    count = 0;
+    for (int bin = first; bin < kHistogramBins; ++bin) {
+        energy += histogramEnergy[bin];
+        count += histogramCount[bin];
+    }
+    return count > 0 ? energy / count : 0.0;
+}
+
+void AKLoudnessMeter::InternalData::publish(int channelCount, double sampleRate)
+{
+    readings.duration = framesSinceReset / sampleRate;
+    int frames = recentCount * segmentFrames + segmentPosition;
+
+    beginWrite();
+    publishedReadings = readings;
+    AKChannelMeterReadings *published = publishedChannels.load(std::memory_order_relaxed);
+    for (int c = 0; c < channelCount; ++c) {
+        const Channel &channel = channels[c];
+        AKChannelMeterReadings &levels = published[c];
+        float peak = channel.peak, truePeak = channel.truePeak;
+        double squares = channel.squares;
+        for (int i = 0; i < kLevelSegments - 1; ++i) {
+            peak = largerOf(peak, channel.recentPeak[i]);
+            truePeak = largerOf(truePeak, channel.recentTruePeak[i]);
+            squares += channel.recentSquares[i];
+        }
+        levels.peak = peak;
+        levels.truePeak = truePeak;
+        levels.rms = frames > 0 ? (float)sqrt(squares / frames) : 0.0f;
+        levels.maximumPeak = channel.maximumPeak;
+        levels.maximumTruePeak = channel.maximumTruePeak;
+    }
+    endWrite();
+}
+
+void AKLoudnessMeter::process(const float *const *inputs, int frameCount)
+{
+    if (channelCount == 0) return;
+    InternalData &d = *data;
+    if (d.resetRequested.exchange(false)) d.clearTotals(channelCount);
+
+    int offset = 0;
+    while (offset < frameCount) {
+        int count = std::min(frameCount - offset, std::min(kBlockFrames, d.segmentFrames - d.segmentPosition));
+        for (int c = 0; c < channelCount; ++c) {
+            d.meterChannel(d.channels[c], inputs[c] + offset, count);
+        }
+        d.segmentPosition += count;
+        d.framesSinceReset += count;
+        offset += count;
+        if (d.segmentPosition == d.segmentFrames) d.completeSegment(channelCount);
+    }
+
+    d.publish(channelCount, sampleRate);
+}
+
+void AKLoudnessMeter::getReadings(AKLoudnessReadings &readings)
+{
+    uint32_t before, after;
+    do {
+        before = data->sequence.load(std::memory_order_acquire);
+        memcpy(&readings, &data->publishedReadings, sizeof(readings));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = data->sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+bool AKLoudnessMeter::getChannelReadings(int channel, AKChannelMeterReadings &readings)
+{
+    uint32_t before, after;
+    bool valid;
+    do {
+        before = data->sequence.load(std::memory_order_acquire);
+        valid = channel >= 0 && channel < data->publishedChannelCount.load(std::memory_order_relaxed);
+        if (valid) {
+            memcpy(&readings, data->publishedChannels.load(std::memory_order_relaxed) + channel, sizeof(readings));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = data->sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return valid;
+}
@@ -0,0 +1,58 @@
+//
+//  AKLoudnessMeter.hpp
+//  AudioKit Core
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#ifdef __cplusplus
+#pragma once
+
+#include "AKLoudnessMeter_Typedefs.h"
+
+#import <memory>
+
+/**
+ Block-based metering of any number of channels: sample peak, RMS and 4x oversampled true peak per
+ channel, and K-weighted momentary, short-term and gated integrated loudness of the channels together.
+
+ Everything is measured in 100 ms segments; momentary and short-term loudness are updated as each
+ segment completes, and per-channel levels after every process call. The render thread is the only
+ writer and never waits: readers on any thread take a consistent copy with a sequence lock.
+ */
+class AKLoudnessMeter
+{
+public:
+    AKLoudnessMeter();
+    ~AKLoudnessMeter();
+
+    /// Control thread
+    void init(int channelCount, double sampleRate);
+    void deinit();
+
+    /// Any thread. A channel's weight in the loudness sum: BS.1770 uses 1 for the front channels,
+    /// 1.41 for the surrounds and 0 for LFE. All channels weigh 1 until set.
+    void setChannelWeight(int channel, float weight);
+
+    /// Any thread. Clears the integrated loudness and the maxima, at the start of the next process call.
+    void reset();
+
+    /// Render thread. Meters frameCount frames of each of the channels given to init.
+    void process(const float *const *channels, int frameCount);
+
+    /// Any thread, lock-free
+    int getChannelCount() { return channelCount; }
+    void getReadings(AKLoudnessReadings &readings);
+    /// Returns false if channel isn't metered, which is every channel while the meter isn't initialized
+    bool getChannelReadings(int channel, AKChannelMeterReadings &readings);
+
+protected:
+    int channelCount;
+    double sampleRate;
+
+    struct InternalData;
+    std::unique_ptr<InternalData> data;
+};
+
+#endif
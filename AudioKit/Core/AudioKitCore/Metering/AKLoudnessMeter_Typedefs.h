@@ -0,0 +1,34 @@
+//
+//  AKLoudnessMeter_Typedefs.h
+//  AudioKit Core
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+// This file is safe to include in either (Objective-)C or C++ contexts.
+
+#pragma once
+
+/// Loudness of all the metered channels together, per EBU R128 / ITU-R BS.1770-4, in LUFS.
+/// Silence reads as -infinity.
+typedef struct
+{
+    float momentaryLoudness;            // over the last 400 ms
+    float shortTermLoudness;            // over the last 3 s
+    float integratedLoudness;           // gated, since the last reset
+    float maximumMomentaryLoudness;     // since the last reset
+    float maximumShortTermLoudness;     // since the last reset
+    double duration;                    // seconds metered since the last reset
+
+} AKLoudnessReadings;
+
+/// Levels of one channel, as linear amplitudes
+typedef struct
+{
+    float peak;                         // largest absolute sample over the last 400 ms
+    float rms;                          // over the last 400 ms
+    float truePeak;                     // largest 4x oversampled absolute value over the last 400 ms
+    float maximumPeak;                  // since the last reset
+    float maximumTruePeak;              // since the last reset
+
+} AKChannelMeterReadings;
@@ -10,6 +10,12 @@
 #include "SamplerVoice.hpp"
 #include "FunctionTable.hpp"
 #include "SustainPedalLogic.hpp"
+#include "SFZLoader.hpp"
+#ifdef AUDIOKIT
+#include "AKRenderStats.h"
+#else
+#define AK_REALTIME_UNSAFE(kind, where)
+#endif
 
 #include <math.h>
 #include <list>
@@ -20,6 +26,9 @@
 // MIDI offers 128 distinct note numbers
 #define MIDI_NOTENUMBERS 128
 
+// how long a voice must stay below the noise floor before it is stopped
+#define QUIET_SECONDS_BEFORE_STOP 0.1f
+
 // Convert MIDI note to Hz, for 12-tone equal temperament
 #define NOTE_HZ(midiNoteNumber) ( 440.0f * pow(2.0f, ((midiNoteNumber) - 69.0f)/12.0f) )
 
@@ -62,6 +71,9 @@ AKCoreSampler::AKCoreSampler()
 , filterEnvelopeVelocityScaling(0.0f)
 , linearResonance(0.5f)
 , loopThruRelease(false)
+, buildMipmaps(false)
+, voiceNoiseFloor(0.0f)
+, quietChunkLimit(1)
 , stoppingAllVoices(false)
 , data(new InternalData)
 {
@@ -89,6 +101,7 @@ int AKCoreSampler::init(double sampleRate)
     data->filterEnvelopeParameters.updateSampleRate((float)(sampleRate/AKCORESAMPLER_CHUNKSIZE));
     data->vibratoLFO.waveTable.sinusoid();
     data->vibratoLFO.init(sampleRate/AKCORESAMPLER_CHUNKSIZE, 5.0f);
+    quietChunkLimit = (unsigned)ceilf(QUIET_SECONDS_BEFORE_STOP * (float)sampleRate / AKCORESAMPLER_CHUNKSIZE);
     
     for (int i=0; i<MAX_POLYPHONY; i++)
         data->voice[i].init(sampleRate);
@@ -109,10 +122,6 @@ void AKCoreSampler::deinit()
 void AKCoreSampler::loadSampleData(AKSampleDataDescriptor& sdd)
 {
     AudioKitCore::KeyMappedSampleBuffer *pBuf = new AudioKitCore::KeyMappedSampleBuffer();
-    pBuf->minimumNoteNumber = sdd.sampleDescriptor.minimumNoteNumber;
-    pBuf->maximumNoteNumber = sdd.sampleDescriptor.maximumNoteNumber;
-    pBuf->minimumVelocity = sdd.sampleDescriptor.minimumVelocity;
-    pBuf->maximumVelocity = sdd.sampleDescriptor.maximumVelocity;
     data->sampleBufferList.push_back(pBuf);
     
     pBuf->init(sdd.sampleRate, sdd.channelCount, sdd.sampleCount);
@@ -126,22 +135,36 @@ void AKCoreSampler::loadSampleData(AKSampleDataDescriptor& sdd)
     {
         pBuf->setData(i, *pData++);
     }
-    pBuf->noteNumber = sdd.sampleDescriptor.noteNumber;
-    pBuf->noteFrequency = sdd.sampleDescriptor.noteFrequency;
+    pBuf->setSampleDescriptor(sdd.sampleDescriptor);
     
-    if (sdd.sampleDescriptor.startPoint > 0.0f) pBuf->startPoint = sdd.sampleDescriptor.startPoint;
-    if (sdd.sampleDescriptor.endPoint > 0.0f)   pBuf->endPoint = sdd.sampleDescriptor.endPoint;
+    if (buildMipmaps) pBuf->buildMipmapInBackground();
+}
+
+void AKCoreSampler::replaceSamples(std::vector<AudioKitCore::KeyMappedSampleBuffer*>& buffers)
+{
+    std::list<AudioKitCore::KeyMappedSampleBuffer*> oldBuffers;
     
-    pBuf->isLooping = sdd.sampleDescriptor.isLooping;
-    if (pBuf->isLooping)
-    {
-        // loopStartPoint, loopEndPoint are usually sample indices, but values 0.0-1.0
-        // are interpreted as fractions of the total sample length.
-        if (sdd.sampleDescriptor.loopStartPoint > 1.0f) pBuf->loopStartPoint = sdd.sampleDescriptor.loopStartPoint;
-        else pBuf->loopStartPoint = pBuf->endPoint * sdd.sampleDescriptor.loopStartPoint;
-        if (sdd.sampleDescriptor.loopEndPoint > 1.0f) pBuf->loopEndPoint = sdd.sampleDescriptor.loopEndPoint;
-        else pBuf->loopEndPoint = pBuf->endPoint * sdd.sampleDescriptor.loopEndPoint;
-    }
+    // new notes wait only while the buffers are swapped and mapped, not while they load
+    stopAllVoices();
+    oldBuffers.swap(data->sampleBufferList);
+    data->sampleBufferList.assign(buffers.begin(), buffers.end());
+    buildKeyMap();
+    restartVoices();
+    
+    buffers.clear();
+    for (AudioKitCore::KeyMappedSampleBuffer *pBuf : oldBuffers)
+        delete pBuf;
+}
+
+bool AKCoreSampler::loadSFZ(const char *path, unsigned threadCount)
+{
+    std::vector<AudioKitCore::SFZRegion> regions;
+    if (!AudioKitCore::SFZLoader::parse(path, regions)) return false;
+    
+    std::vector<AudioKitCore::KeyMappedSampleBuffer*> buffers;
+    AudioKitCore::SFZLoader::decode(regions, buffers, threadCount, buildMipmaps);
+    replaceSamples(buffers);
+    return true;
 }
 
 AudioKitCore::KeyMappedSampleBuffer *AKCoreSampler::lookupSample(unsigned noteNumber, unsigned velocity)
@@ -380,6 +403,8 @@ void AKCoreSampler::stop(unsigned noteNumber, bool immediate)
 
 void AKCoreSampler::stopAllVoices()
 {
+    AK_REALTIME_UNSAFE(AKRealtimeViolationLock, "AKCoreSampler::stopAllVoices waits for the render thread");
+
     // Lock out starting any new notes, and tell Render() to stop all active notes
     stoppingAllVoices = true;
     
@@ -418,7 +443,9 @@ void AKCoreSampler::render(unsigned channelCount, unsigned sampleCount, float *o
             if (stoppingAllVoices ||
                 pVoice->prepToGetSamples(sampleCount, masterVolume, pitchDev, cutoffMul, keyTracking,
                                          cutoffEnvelopeStrength, filterEnvelopeVelocityScaling, linearResonance) ||
-                (pVoice->getSamples(sampleCount, pOutLeft, pOutRight) && allowSampleRunout))
+                (pVoice->getSamples(sampleCount, pOutLeft, pOutRight) && allowSampleRunout) ||
+                // stop voices whose tails have faded below the noise floor, e.g. under the sustain pedal
+                (allowSampleRunout && pVoice->isInaudible(voiceNoiseFloor, quietChunkLimit)))
             {
                 stopNote(nn, true);
             }
@@ -10,9 +10,11 @@
 #ifdef _WIN32
 #include "AKSampler_Typedefs.h"
 #include <memory>
+#include <vector>
 #else
 #import "AKSampler_Typedefs.h"
 #import <memory>
+#import <vector>
 #endif
 
 // process samples in "chunks" this size
@@ -43,6 +45,14 @@ public:
     /// call to load samples
     void loadSampleData(AKSampleDataDescriptor& sdd);
     
+    /// call to replace all samples at once with buffers loaded elsewhere, which the sampler takes over,
+    /// and map them as buildKeyMap() does; notes are held off only while the two are swapped
+    void replaceSamples(std::vector<AudioKitCore::KeyMappedSampleBuffer*>& buffers);
+    
+    /// load an SFZ instrument in place of all samples, decoding its sample files on threadCount worker
+    /// threads (0 means one per core); returns false, leaving the samples alone, if it can't be read
+    bool loadSFZ(const char *path, unsigned threadCount = 0);
+    
     // after loading samples, call one of these to build the key map
     
     /// call for noteNumber 0-127 to define tuning table (defaults to standard 12-tone equal temperament)
@@ -57,6 +67,10 @@ public:
     /// optionally call this to make samples continue looping after note-release
     void setLoopThruRelease(bool value) { loopThruRelease = value; }
     
+    /// optionally call this before loading samples, to give them band-limited half-rate copies for
+    /// playing them an octave or more above their pitch (doubles their memory use)
+    void setBuildMipmaps(bool value) { buildMipmaps = value; }
+    
     void playNote(unsigned noteNumber, unsigned velocity);
     void stopNote(unsigned noteNumber, bool immediate);
     void sustainPedal(bool down);
@@ -134,6 +148,15 @@ protected:
     // if true, sample continue looping thru note release phase
     bool loopThruRelease;
     
+    // if true, samples are mipmapped as they are loaded
+    bool buildMipmaps;
+    
+    // voices whose output stays below this level (linear, 0.0 means never) are stopped early
+    float voiceNoiseFloor;
+    
+    // number of chunks a voice must stay below voiceNoiseFloor before it is stopped
+    unsigned quietChunkLimit;
+    
     // temporary state
     bool stoppingAllVoices;
     
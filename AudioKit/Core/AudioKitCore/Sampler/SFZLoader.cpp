@@ -0,0 +1,664 @@
+//
+//  SFZLoader.cpp
+//  AudioKit Core
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#include "SFZLoader.hpp"
+#include "SampleBuffer.hpp"
+#include "wavpack.h"
+#include "dr_wav.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
+
+// #include nesting deeper than this is taken to be a loop
+#define SFZ_MAX_INCLUDE_DEPTH 16
+
+// frames read from a WAV or AIFF file at a time
+#define SFZ_READ_CHUNK_FRAMES 4096
+
+namespace AudioKitCore
+{
+
+    namespace
+    {
+        // opcodes in effect at one level of the header hierarchy, with their SFZ defaults
+        struct Opcodes
+        {
+            std::string sample;
+            int lowKey = 0, highKey = 127, keyCenter = 60;
+            int lowVelocity = 0, highVelocity = 127;
+            float transpose = 0.0f, tune = 0.0f;
+            bool isLooping = false;
+            float loopStart = 0.0f, loopEnd = 0.0f;
+            float offset = 0.0f, end = 0.0f;
+        };
+
+        // levels whose opcodes regions inherit, then the ones whose opcodes they don't
+        enum Level { kGlobal, kMaster, kGroup, kRegion, kLevelCount, kControl = kLevelCount, kOtherHeader };
+
+        bool readFile(const std::string &path, std::string &text)
+        {
+            FILE *file = fopen(path.c_str(), "rb");
+            if (file == 0) return false;
+            char chunk[4096];
+            size_t count;
+            text.clear();
+            while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) text.append(chunk, count);
+            fclose(file);
+            return true;
+        }
+
+        bool fileExists(const std::string &path)
+        {
+            FILE *file = fopen(path.c_str(), "rb");
+            if (file == 0) return false;
+            fclose(file);
+            return true;
+        }
+
+        std::string directoryOf(const std::string &path)
+        {
+            size_t slash = path.find_last_of('/');
+            return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+        }
+
+        std::string withForwardSlashes(std::string path)
+        {
+            std::replace(path.begin(), path.end(), '\\', '/');
+            return path;
+        }
+
+        bool isIdentifierChar(char c)
+        {
+            return isalnum((unsigned char)c) || c == '_' || c == '$';
+        }
+
+        bool parseFloat(const std::string &value, float &result)
+        {
+            char *end;
+            float f = strtof(value.c_str(), &end);
+            if (end == value.c_str() || *end != 0) return false;
+            result = f;
+            return true;
+        }
+
+        // a MIDI note number, or a note name such as c4 (60), f#3 or eb-1
+        bool parseKey(const std::string &value, int &key)
+        {
+            const char *s = value.c_str();
+            char *end;
+            long number = strtol(s, &end, 10);
+            if (end != s && *end == 0)
+            {
+                key = (int)number;
+                return true;
+            }
+
+            static const int pitchClasses[] = { 9, 11, 0, 2, 4, 5, 7 };     // a-g
+            char letter = (char)tolower((unsigned char)*s++);
+            if (letter < 'a' || letter > 'g') return false;
+            int pitchClass = pitchClasses[letter - 'a'];
+            if (*s == '#') { pitchClass++; s++; }
+            else if (*s == 'b') { pitchClass--; s++; }
+            long octave = strtol(s, &end, 10);
+            if (end == s || *end != 0) return false;
+            key = (int)(12 * (octave + 1) + pitchClass);
+            return true;
+        }
+
+        int clampMIDI(int value)
+        {
+            return std::min(std::max(value, 0), 127);
+        }
+
+        struct Parser
+        {
+            std::vector<SFZRegion> &regions;
+            std::string directory;      // of the SFZ file, which #include and sample paths are relative to
+            std::string defaultPath;
+            std::vector<std::pair<std::string, std::string>> defines;   // longest names first
+            Opcodes levels[kLevelCount];
+            int level = kGlobal;
+            bool inRegion = false;
+
+            Parser(std::vector<SFZRegion> &regions, const std::string &directory)
+            : regions(regions), directory(directory) {}
+
+            void parse(const std::string &text, int depth);
+            void finish() { endRegion(); }
+
+        private:
+            size_t endOfValue(const std::string &text, size_t start, size_t lineEnd);
+            size_t directive(const std::string &text, size_t start, int depth);
+            std::string substitute(std::string value);
+            void header(const std::string &name);
+            void opcode(const std::string &name, const std::string &value);
+            void setOpcode(Opcodes &o, const std::string &name, const std::string &value);
+            void endRegion();
+        };
+
+        void Parser::parse(const std::string &text, int depth)
+        {
+            size_t i = 0, n = text.size();
+            while (i < n)
+            {
+                char c = text[i];
+                if (isspace((unsigned char)c))
+                {
+                    i++;
+                }
+                else if (text.compare(i, 2, "//") == 0)
+                {
+                    i = std::min(text.find('\n', i), n);
+                }
+                else if (text.compare(i, 2, "/*") == 0)
+                {
+                    size_t end = text.find("*/", i + 2);
+                    i = end == std::string::npos ? n : end + 2;
+                }
+                else if (c == '<')
+                {
+                    size_t end = text.find('>', i);
+                    if (end == std::string::npos) break;
+                    header(text.substr(i + 1, end - i - 1));
+                    i = end + 1;
+                }
+                else if (c == '#')
+                {
+                    i = directive(text, i, depth);
+                }
+                else
+                {
+                    // name=value, where only the value may contain spaces
+                    size_t nameEnd = i;
+                    while (nameEnd < n && isIdentifierChar(text[nameEnd])) nameEnd++;
+                    if (nameEnd == i || nameEnd == n || text[nameEnd] != '=')
+                    {
+                        // not an opcode: skip the word
+                        while (i < n && !isspace((unsigned char)text[i])) i++;
+                        continue;
+                    }
+                    size_t lineEnd = std::min(text.find_first_of("\r\n", nameEnd), n);
+                    size_t valueEnd = endOfValue(text, nameEnd + 1, lineEnd);
+                    opcode(substitute(text.substr(i, nameEnd - i)),
+                           substitute(text.substr(nameEnd + 1, valueEnd - nameEnd - 1)));
+                    i = valueEnd;
+                }
+            }
+        }
+
+        // A value runs to the end of the line, or to the next header, comment or opcode on it.
+        size_t Parser::endOfValue(const std::string &text, size_t start, size_t lineEnd)
+        {
+            size_t valueEnd = start;
+            for (size_t i = start; i < lineEnd; )
+            {
+                if (text[i] == '<') break;
+                if (!isspace((unsigned char)text[i]))
+                {
+                    valueEnd = ++i;
+                    continue;
+                }
+                while (i < lineEnd && isspace((unsigned char)text[i])) i++;
+                if (i == lineEnd || text[i] == '<' || text.compare(i, 2, "//") == 0) break;
+                size_t word = i;
+                while (word < lineEnd && isIdentifierChar(text[word])) word++;
+                if (word > i && word < lineEnd && text[word] == '=') break;
+            }
+            return valueEnd;
+        }
+
+        size_t Parser::directive(const std::string &text, size_t start, int depth)
+        {
+            size_t lineEnd = std::min(text.find_first_of("\r\n", start), text.size());
+            std::string line = text.substr(start, lineEnd - start);
+
+            if (line.compare(0, 7, "#define") == 0)
+            {
+                size_t nameStart = line.find_first_not_of(" \t", 7);
+                size_t nameEnd = line.find_first_of(" \t", nameStart);
+                size_t valueStart = line.find_first_not_of(" \t", nameEnd);
+                if (valueStart != std::string::npos)
+                {
+                    size_t valueEnd = std::min(line.find_first_of(" \t", valueStart), line.size());
+                    std::string name = line.substr(nameStart, nameEnd - nameStart);
+                    std::string value = substitute(line.substr(valueStart, valueEnd - valueStart));
+                    defines.erase(std::remove_if(defines.begin(), defines.end(),
+                                                 [&](const std::pair<std::string, std::string> &define)
+                                                 { return define.first == name; }),
+                                  defines.end());
+                    defines.emplace_back(name, value);
+                    std::stable_sort(defines.begin(), defines.end(),
+                                     [](const std::pair<std::string, std::string> &a,
+                                        const std::pair<std::string, std::string> &b)
+                                     { return a.first.size() > b.first.size(); });
+                }
+            }
+            else if (line.compare(0, 8, "#include") == 0)
+            {
+                size_t open = line.find('"', 8);
+                size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+                std::string included;
+                if (close == std::string::npos) {}
+                else if (depth >= SFZ_MAX_INCLUDE_DEPTH)
+                {
+                    printf("SFZ: #include nested too deeply at %s\n", line.c_str());
+                }
+                else if (readFile(directory + withForwardSlashes(substitute(line.substr(open + 1, close - open - 1))),
+                                  included))
+                {
+                    parse(included, depth + 1);
+                }
+                else
+                {
+                    printf("SFZ: could not read %s\n", line.c_str());
+                }
+            }
+            return lineEnd;
+        }
+
+        std::string Parser::substitute(std::string value)
+        {
+            for (const std::pair<std::string, std::string> &define : defines)
+            {
+                for (size_t at = value.find(define.first); at != std::string::npos;
+                     at = value.find(define.first, at + define.second.size()))
+                {
+                    value.replace(at, define.first.size(), define.second);
+                }
+            }
+            return value;
+        }
+
+        void Parser::header(const std::string &name)
+        {
+            endRegion();
+            if (name == "region")
+            {
+                levels[kRegion] = levels[kGroup];
+                level = kRegion;
+                inRegion = true;
+            }
+            else if (name == "group")
+            {
+                levels[kGroup] = levels[kMaster];
+                level = kGroup;
+            }
+            else if (name == "master")
+            {
+                levels[kGroup] = levels[kMaster] = levels[kGlobal];
+                level = kMaster;
+            }
+            else if (name == "global")
+            {
+                levels[kGroup] = levels[kMaster] = levels[kGlobal] = Opcodes();
+                level = kGlobal;
+            }
+            else level = name == "control" ? kControl : kOtherHeader;
+        }
+
+        void Parser::opcode(const std::string &name, const std::string &value)
+        {
+            if (level == kControl)
+            {
+                if (name == "default_path") defaultPath = withForwardSlashes(value);
+                return;
+            }
+            if (level == kOtherHeader) return;
+
+            // the levels below this one haven't started yet, and inherit what it has so far
+            for (int l = level; l < kLevelCount; l++) setOpcode(levels[l], name, value);
+        }
+
+        void Parser::setOpcode(Opcodes &o, const std::string &name, const std::string &value)
+        {
+            int key;
+            if (name == "sample") o.sample = withForwardSlashes(value);
+            else if (name == "key")
+            {
+                if (parseKey(value, key)) o.lowKey = o.highKey = o.keyCenter = key;
+            }
+            else if (name == "lokey") parseKey(value, o.lowKey);
+            else if (name == "hikey") parseKey(value, o.highKey);
+            else if (name == "pitch_keycenter") parseKey(value, o.keyCenter);
+            else if (name == "lovel") parseKey(value, o.lowVelocity);
+            else if (name == "hivel") parseKey(value, o.highVelocity);
+            else if (name == "transpose") parseFloat(value, o.transpose);
+            else if (name == "tune") parseFloat(value, o.tune);
+            else if (name == "offset") parseFloat(value, o.offset);
+            else if (name == "end") parseFloat(value, o.end);
+            else if (name == "loop_mode" || name == "loopmode")
+                o.isLooping = value == "loop_continuous" || value == "loop_sustain";
+            else if (name == "loop_start" || name == "loopstart") parseFloat(value, o.loopStart);
+            else if (name == "loop_end" || name == "loopend") parseFloat(value, o.loopEnd);
+        }
+
+        void Parser::endRegion()
+        {
+            if (!inRegion) return;
+            inRegion = false;
+            const Opcodes &o = levels[kRegion];
+            if (o.sample.empty()) return;
+
+            SFZRegion region;
+            AKSampleDescriptor &sd = region.sampleDescriptor;
+            sd.noteNumber = clampMIDI(o.keyCenter);
+            sd.noteFrequency = (float)(440.0 * pow(2.0, (o.keyCenter - o.transpose - 0.01 * o.tune - 69.0) / 12.0));
+            sd.minimumNoteNumber = clampMIDI(o.lowKey);
+            sd.maximumNoteNumber = clampMIDI(o.highKey);
+            sd.minimumVelocity = clampMIDI(o.lowVelocity);
+            sd.maximumVelocity = clampMIDI(o.highVelocity);
+            sd.isLooping = o.isLooping;
+            sd.loopStartPoint = o.loopStart;
+            sd.loopEndPoint = o.loopEnd;
+            if (o.isLooping && o.loopEnd <= o.loopStart)
+            {
+                // no loop given: loop the whole sample
+                sd.loopStartPoint = 0.0f;
+                sd.loopEndPoint = 1.0f;
+            }
+            sd.startPoint = o.offset;
+            sd.endPoint = o.end;
+
+            std::string path = o.sample[0] == '/' ? o.sample : directory + defaultPath + o.sample;
+
+            // prefer a Wavpack-compressed copy of an uncompressed sample
+            size_t dot = path.find_last_of('.');
+            if (dot != std::string::npos && path.find('/', dot) == std::string::npos)
+            {
+                std::string extension = path.substr(dot);
+                std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+                if (extension == ".wav" || extension == ".aif" || extension == ".aiff")
+                {
+                    std::string compressedPath = path.substr(0, dot) + ".wv";
+                    if (fileExists(compressedPath)) path = compressedPath;
+                }
+            }
+            region.samplePath = path;
+            regions.push_back(region);
+        }
+
+        // decoding
+
+        uint32_t bigEndian32(const unsigned char *bytes)
+        {
+            return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+        }
+
+        // 80-bit IEEE extended, as AIFF stores its sample rate
+        double bigEndianExtended(const unsigned char *bytes)
+        {
+            int exponent = ((bytes[0] & 0x7f) << 8) | bytes[1];
+            uint64_t mantissa = ((uint64_t)bigEndian32(bytes + 2) << 32) | bigEndian32(bytes + 6);
+            double value = ldexp((double)mantissa, exponent - 16383 - 63);
+            return (bytes[0] & 0x80) ? -value : value;
+        }
+
+        void silenceFrom(KeyMappedSampleBuffer *pBuf, int frame)
+        {
+            for (int channel = 0; channel < pBuf->channelCount; channel++)
+            {
+                float *samples = pBuf->samples + channel * pBuf->sampleCount;
+                std::fill(samples + frame, samples + pBuf->sampleCount, 0.0f);
+            }
+        }
+
+        KeyMappedSampleBuffer *decodeWavpack(const std::string &path)
+        {
+            char errMsg[100];
+            WavpackContext *wpc = WavpackOpenFileInput(path.c_str(), errMsg, OPEN_2CH_MAX | OPEN_NORMALIZE, 0);
+            if (wpc == 0)
+            {
+                printf("Wavpack error loading %s: %s\n", path.c_str(), errMsg);
+                return 0;
+            }
+
+            int channelCount = WavpackGetReducedChannels(wpc);
+            int sampleCount = (int)WavpackGetNumSamples(wpc);
+            if (channelCount < 1 || channelCount > 2 || sampleCount <= 0)
+            {
+                WavpackCloseFile(wpc);
+                return 0;
+            }
+
+            KeyMappedSampleBuffer *pBuf = new KeyMappedSampleBuffer();
+            pBuf->init((float)WavpackGetSampleRate(wpc), channelCount, sampleCount);
+            float *channels[2] = { pBuf->samples, pBuf->samples + sampleCount };
+            int unpacked = (int)WavpackUnpackSamplesFloat(wpc, channels, 0, sampleCount);
+            WavpackCloseFile(wpc);
+            silenceFrom(pBuf, unpacked);
+            return pBuf;
+        }
+
+        KeyMappedSampleBuffer *decodeWav(const std::string &path)
+        {
+            drwav wav;
+            if (!drwav_init_file(&wav, path.c_str())) return 0;
+
+            int fileChannelCount = wav.channels;
+            int sampleCount = fileChannelCount > 0 ? (int)(wav.totalSampleCount / fileChannelCount) : 0;
+            if (sampleCount <= 0)
+            {
+                drwav_uninit(&wav);
+                return 0;
+            }
+
+            KeyMappedSampleBuffer *pBuf = new KeyMappedSampleBuffer();
+            int channelCount = std::min(fileChannelCount, 2);
+            pBuf->init((float)wav.sampleRate, channelCount, sampleCount);
+
+            std::vector<float> chunk(SFZ_READ_CHUNK_FRAMES * fileChannelCount);
+            int frame = 0;
+            while (frame < sampleCount)
+            {
+                int request = std::min(SFZ_READ_CHUNK_FRAMES, sampleCount - frame);
+                int count = (int)(drwav_read_f32(&wav, request * fileChannelCount, chunk.data()) / fileChannelCount);
+                for (int channel = 0; channel < channelCount; channel++)
+                {
+                    float *samples = pBuf->samples + channel * sampleCount + frame;
+                    for (int i = 0; i < count; i++) samples[i] = chunk[i * fileChannelCount + channel];
+                }
+                frame += count;
+                if (count < request) break;
+            }
+            drwav_uninit(&wav);
+            silenceFrom(pBuf, frame);
+            return pBuf;
+        }
+
+        KeyMappedSampleBuffer *decodeAiff(const std::string &path)
+        {
+            FILE *file = fopen(path.c_str(), "rb");
+            if (file == 0) return 0;
+
+            unsigned char header[12];
+            if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, "FORM", 4) != 0 ||
+                (memcmp(header + 8, "AIFF", 4) != 0 && memcmp(header + 8, "AIFC", 4) != 0))
+            {
+                fclose(file);
+                return 0;
+            }
+
+            int fileChannelCount = 0, bitsPerSample = 0, sampleCount = 0;
+            double sampleRate = 0.0;
+            bool isLittleEndian = false, isFloat = false, isSupported = true;
+            long dataOffset = -1;
+            unsigned char chunkHeader[8];
+            while (fread(chunkHeader, 1, sizeof(chunkHeader), file) == sizeof(chunkHeader))
+            {
+                uint32_t size = bigEndian32(chunkHeader + 4);
+                long next = ftell(file) + (long)size + (long)(size & 1);
+                if (memcmp(chunkHeader, "COMM", 4) == 0 && size >= 18)
+                {
+                    unsigned char comm[22];
+                    size_t count = fread(comm, 1, std::min(size, (uint32_t)sizeof(comm)), file);
+                    if (count < 18) break;
+                    fileChannelCount = (comm[0] << 8) | comm[1];
+                    sampleCount = (int)bigEndian32(comm + 2);
+                    bitsPerSample = (comm[6] << 8) | comm[7];
+                    sampleRate = bigEndianExtended(comm + 8);
+                    if (count == 22)
+                    {
+                        // AIFF-C compression type
+                        isLittleEndian = memcmp(comm + 18, "sowt", 4) == 0;
+                        isFloat = memcmp(comm + 18, "fl32", 4) == 0 || memcmp(comm + 18, "FL32", 4) == 0;
+                        isSupported = isLittleEndian || isFloat ||
+                            memcmp(comm + 18, "NONE", 4) == 0 || memcmp(comm + 18, "twos", 4) == 0;
+                    }
+                }
+                else if (memcmp(chunkHeader, "SSND", 4) == 0 && size >= 8)
+                {
+                    unsigned char ssnd[8];
+                    if (fread(ssnd, 1, sizeof(ssnd), file) != sizeof(ssnd)) break;
+                    dataOffset = ftell(file) + (long)bigEndian32(ssnd);
+                }
+                fseek(file, next, SEEK_SET);
+            }
+
+            if (!isSupported || fileChannelCount < 1 || sampleCount <= 0 || sampleRate <= 0.0 || dataOffset < 0 ||
+                bitsPerSample < 1 || bitsPerSample > 32 || (isFloat && bitsPerSample != 32) ||
+                fseek(file, dataOffset, SEEK_SET) != 0)
+            {
+                fclose(file);
+                return 0;
+            }
+
+            KeyMappedSampleBuffer *pBuf = new KeyMappedSampleBuffer();
+            int channelCount = std::min(fileChannelCount, 2);
+            pBuf->init((float)sampleRate, channelCount, sampleCount);
+
+            int bytesPerSample = (bitsPerSample + 7) / 8;
+            int bytesPerFrame = bytesPerSample * fileChannelCount;
+            int shift = 32 - 8 * bytesPerSample;
+            std::vector<unsigned char> chunk(SFZ_READ_CHUNK_FRAMES * bytesPerFrame);
+            int frame = 0;
+            while (frame < sampleCount)
+            {
+                int request = std::min(SFZ_READ_CHUNK_FRAMES, sampleCount - frame);
+                int count = (int)(fread(chunk.data(), bytesPerFrame, request, file));
+                for (int channel = 0; channel < channelCount; channel++)
+                {
+                    float *samples = pBuf->samples + channel * sampleCount + frame;
+                    const unsigned char *bytes = chunk.data() + channel * bytesPerSample;
+                    for (int i = 0; i < count; i++, bytes += bytesPerFrame)
+                    {
+                        uint32_t word = 0;
+                        for (int b = 0; b < bytesPerSample; b++)
+                            word = (word << 8) | bytes[isLittleEndian ? bytesPerSample - 1 - b : b];
+                        if (isFloat) memcpy(&samples[i], &word, sizeof(float));
+                        else samples[i] = (float)(int32_t)(word << shift) * (1.0f / 2147483648.0f);
+                    }
+                }
+                frame += count;
+                if (count < request) break;
+            }
+            fclose(file);
+            silenceFrom(pBuf, frame);
+            return pBuf;
+        }
+
+        // decodes a sample file, whatever its name, by what it contains
+        KeyMappedSampleBuffer *decodeFile(const std::string &path)
+        {
+            unsigned char magic[4] = { 0 };
+            FILE *file = fopen(path.c_str(), "rb");
+            if (file == 0) return 0;
+            size_t count = fread(magic, 1, sizeof(magic), file);
+            fclose(file);
+            if (count < sizeof(magic)) return 0;
+
+            if (memcmp(magic, "wvpk", 4) == 0) return decodeWavpack(path);
+            if (memcmp(magic, "FORM", 4) == 0) return decodeAiff(path);
+            return decodeWav(path);
+        }
+    }
+
+    bool SFZLoader::parse(const char *path, std::vector<SFZRegion> &regions)
+    {
+        std::string text;
+        if (!readFile(path, text)) return false;
+        parse(text, directoryOf(path), regions);
+        return true;
+    }
+
+    void SFZLoader::parse(const std::string &text, const std::string &directory, std::vector<SFZRegion> &regions)
+    {
+        std::string base = directory;
+        if (!base.empty() && base.back() != '/') base += '/';
+        Parser parser(regions, base);
+        parser.parse(text, 0);
+        parser.finish();
+    }
+
+    void SFZLoader::decode(const std::vector<SFZRegion> &regions,
+                           std::vector<KeyMappedSampleBuffer*> &buffers,
+                           unsigned threadCount, bool buildMipmaps)
+    {
+        // each file is decoded once, for all of the regions which play it
+        std::vector<std::vector<size_t>> files;
+        std::map<std::string, size_t> fileIndex;
+        for (size_t r = 0; r < regions.size(); r++)
+        {
+            auto inserted = fileIndex.emplace(regions[r].samplePath, files.size());
+            if (inserted.second) files.emplace_back();
+            files[inserted.first->second].push_back(r);
+        }
+
+        std::vector<KeyMappedSampleBuffer*> decoded(regions.size(), nullptr);
+        std::atomic<size_t> nextFile(0);
+        auto work = [&]()
+        {
+            for (size_t f; (f = nextFile.fetch_add(1)) < files.size(); )
+            {
+                const std::vector<size_t> &fileRegions = files[f];
+                const std::string &path = regions[fileRegions[0]].samplePath;
+                KeyMappedSampleBuffer *pBuf = decodeFile(path);
+                if (pBuf == 0)
+                {
+                    printf("SFZ: could not load %s\n", path.c_str());
+                    continue;
+                }
+                if (fileRegions.size() == 1)
+                {
+                    pBuf->setSampleDescriptor(regions[fileRegions[0]].sampleDescriptor);
+                    if (buildMipmaps) pBuf->buildMipmapNow();
+                    decoded[fileRegions[0]] = pBuf;
+                    continue;
+                }
+
+                // the regions share one copy of the samples and mipmap
+                std::shared_ptr<SampleBuffer> pData(pBuf);
+                if (buildMipmaps) pData->buildMipmapNow();
+                for (size_t region : fileRegions)
+                {
+                    KeyMappedSampleBuffer *pRegionBuf = new KeyMappedSampleBuffer();
+                    pRegionBuf->shareData(pData);
+                    pRegionBuf->setSampleDescriptor(regions[region].sampleDescriptor);
+                    decoded[region] = pRegionBuf;
+                }
+            }
+        };
+
+        if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+        threadCount = (unsigned)std::max<size_t>(1, std::min<size_t>(threadCount, files.size()));
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threadCount; i++) workers.emplace_back(work);
+        work();
+        for (std::thread &worker : workers) worker.join();
+
+        for (KeyMappedSampleBuffer *pBuf : decoded)
+            if (pBuf) buffers.push_back(pBuf);
+    }
+
+}
@@ -0,0 +1,55 @@
+//
+//  SFZLoader.hpp
+//  AudioKit Core
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#pragma once
+#include "AKSampler_Typedefs.h"
+#include <string>
+#include <vector>
+
+namespace AudioKitCore
+{
+    struct KeyMappedSampleBuffer;
+
+    // One <region> of an SFZ instrument: how to map and play it, and the file holding its sample.
+    struct SFZRegion
+    {
+        AKSampleDescriptor sampleDescriptor;
+        std::string samplePath;
+    };
+
+    // SFZLoader reads an SFZ instrument without any help from the platform, so the whole of it can
+    // be loaded and handed to a sampler at once.
+    //
+    // The SFZ file is parsed in a single pass, with <global>, <master> and <group> opcodes inherited
+    // by the regions below them, #define and #include, and note names as well as numbers. The opcodes
+    // understood are sample, key, lokey, hikey, pitch_keycenter, lovel, hivel, transpose, tune,
+    // offset, end, loop_mode, loop_start and loop_end, plus default_path in <control>; others are
+    // ignored. As before, a .wv file next to a .wav or .aif sample is used in its place.
+    //
+    // The sample files are then decoded (WAV, AIFF or Wavpack) on a pool of worker threads, each
+    // file only once, straight into the buffers the sampler plays. Regions playing the same file
+    // share its samples and mipmap rather than each holding a copy.
+    struct SFZLoader
+    {
+        // Parses the SFZ file at path into regions, in the order they appear. Returns false if the
+        // file can't be read.
+        static bool parse(const char *path, std::vector<SFZRegion> &regions);
+
+        // As above, for SFZ text whose sample paths are relative to directory.
+        static void parse(const std::string &text, const std::string &directory,
+                          std::vector<SFZRegion> &regions);
+
+        // Decodes the samples of regions on threadCount threads (0 means one per core), including
+        // the calling one, and adds a buffer to buffers for each region whose sample could be read,
+        // in the order of the regions. The caller owns the buffers. If buildMipmaps is true each
+        // buffer's mipmap is built on the same threads.
+        static void decode(const std::vector<SFZRegion> &regions,
+                           std::vector<KeyMappedSampleBuffer*> &buffers,
+                           unsigned threadCount = 0, bool buildMipmaps = false);
+    };
+}
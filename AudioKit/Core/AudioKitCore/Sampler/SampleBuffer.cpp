@@ -6,11 +6,97 @@
 //  Copyright © 2018 AudioKit. All rights reserved.
 //
 
+#ifndef _USE_MATH_DEFINES
+  #define _USE_MATH_DEFINES
+#endif
 #include "SampleBuffer.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// half-length of the low-pass filter used to build each mipmap level
+#define MIPMAP_FILTER_HALF_LENGTH 32
+
+// cutoff of that filter, as a fraction of the sample rate of the level it filters
+#define MIPMAP_FILTER_CUTOFF 0.22
+
+// levels shorter than this are not worth building
+#define MIPMAP_MIN_SAMPLE_COUNT 64
 
 namespace AudioKitCore
 {
 
+    // One thread, started on first use, building queued mipmaps one after another, so loading
+    // a whole instrument doesn't start a thread per sample.
+    class MipmapBuilder
+    {
+    public:
+        static MipmapBuilder &shared()
+        {
+            static MipmapBuilder builder;
+            return builder;
+        }
+        
+        void add(SampleBuffer *buffer)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!worker.joinable()) worker = std::thread(&MipmapBuilder::work, this);
+            queue.push_back(buffer);
+            wake.notify_one();
+        }
+        
+        // Takes buffer off the queue, or if it's being built, waits until it's done
+        void remove(SampleBuffer *buffer)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (auto it = queue.begin(); it != queue.end(); ++it)
+            {
+                if (*it == buffer)
+                {
+                    queue.erase(it);
+                    return;
+                }
+            }
+            finished.wait(lock, [&] { return building != buffer; });
+        }
+        
+    private:
+        std::mutex mutex;
+        std::condition_variable wake, finished;
+        std::deque<SampleBuffer *> queue;
+        SampleBuffer *building = nullptr;
+        bool stopping = false;
+        std::thread worker;
+        
+        ~MipmapBuilder()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                wake.notify_one();
+            }
+            if (worker.joinable()) worker.join();
+        }
+        
+        void work()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                wake.wait(lock, [&] { return stopping || !queue.empty(); });
+                if (stopping) return;
+                building = queue.front();
+                queue.pop_front();
+                lock.unlock();
+                building->buildMipmap();
+                lock.lock();
+                building = nullptr;
+                finished.notify_all();
+            }
+        }
+    };
+
     SampleBuffer::SampleBuffer()
     : samples(0)
     , channelCount(0)
@@ -20,7 +106,9 @@ namespace AudioKitCore
     , isLooping(false)
     , loopStartPoint(0.0f)
     , loopEndPoint(0.0f)
+    , mipmapLevelCount(0)
     {
+        for (int i=0; i < kMaxMipmapLevels; i++) mipmapSamples[i] = 0;
     }
     
     SampleBuffer::~SampleBuffer()
@@ -33,7 +121,7 @@ namespace AudioKitCore
         this->sampleRate = sampleRate;
         this->sampleCount = sampleCount;
         this->channelCount = channelCount;
-        if (samples) delete[] samples;
+        deinit();
         samples = new float[channelCount * sampleCount];
         loopStartPoint = startPoint = 0.0f;
         loopEndPoint = endPoint = (float)sampleCount;
@@ -41,6 +129,15 @@ namespace AudioKitCore
     
     void SampleBuffer::deinit()
     {
+        if (sharedData)
+        {
+            samples = 0;
+            mipmapLevelCount.store(0, std::memory_order_release);
+            for (int i=0; i < kMaxMipmapLevels; i++) mipmapSamples[i] = 0;
+            sharedData.reset();
+            return;
+        }
+        deleteMipmap();
         if (samples) delete[] samples;
         samples = 0;
     }
@@ -53,4 +150,122 @@ namespace AudioKitCore
         }
     }
     
+    void SampleBuffer::shareData(const std::shared_ptr<SampleBuffer> &source)
+    {
+        deinit();
+        sharedData = source;
+        sampleRate = source->sampleRate;
+        channelCount = source->channelCount;
+        sampleCount = source->sampleCount;
+        samples = source->samples;
+        int levelCount = source->getMipmapLevelCount();
+        for (int i=0; i < levelCount; i++)
+        {
+            mipmapSamples[i] = source->mipmapSamples[i];
+            mipmapSampleCount[i] = source->mipmapSampleCount[i];
+        }
+        mipmapLevelCount.store(levelCount, std::memory_order_release);
+        loopStartPoint = startPoint = 0.0f;
+        loopEndPoint = endPoint = (float)sampleCount;
+    }
+    
+    void SampleBuffer::buildMipmapInBackground()
+    {
+        if (sharedData) return;
+        deleteMipmap();
+        if (samples == 0 || sampleCount < 2 * MIPMAP_MIN_SAMPLE_COUNT) return;
+        MipmapBuilder::shared().add(this);
+    }
+    
+    void SampleBuffer::buildMipmapNow()
+    {
+        if (sharedData) return;
+        deleteMipmap();
+        if (samples == 0 || sampleCount < 2 * MIPMAP_MIN_SAMPLE_COUNT) return;
+        buildMipmap();
+    }
+    
+    void SampleBuffer::buildMipmap()
+    {
+        // windowed-sinc (Blackman) low-pass, normalized to unity gain at DC
+        const int halfLength = MIPMAP_FILTER_HALF_LENGTH;
+        float coefficients[2 * MIPMAP_FILTER_HALF_LENGTH + 1];
+        double sum = 0.0;
+        for (int k = -halfLength; k <= halfLength; k++)
+        {
+            double x = 2.0 * M_PI * MIPMAP_FILTER_CUTOFF * k;
+            double sinc = k == 0 ? 1.0 : sin(x) / x;
+            double phase = M_PI * (k + halfLength) / halfLength;
+            double window = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase);
+            coefficients[k + halfLength] = (float)(sinc * window);
+            sum += sinc * window;
+        }
+        for (int k = 0; k <= 2 * halfLength; k++) coefficients[k] /= (float)sum;
+        
+        const float *input = samples;
+        int inputCount = sampleCount;
+        int levelCount = 0;
+        while (levelCount < kMaxMipmapLevels && inputCount >= 2 * MIPMAP_MIN_SAMPLE_COUNT)
+        {
+            int outputCount = (inputCount + 1) / 2;
+            float *output = new float[channelCount * outputCount];
+            for (int channel = 0; channel < channelCount; channel++)
+            {
+                const float *in = input + channel * inputCount;
+                float *out = output + channel * outputCount;
+                for (int i = 0; i < outputCount; i++)
+                {
+                    // data beyond either end counts as silence
+                    int center = 2 * i;
+                    int first = center - halfLength < 0 ? halfLength - center : 0;
+                    int last = center + halfLength >= inputCount ? inputCount - 1 - center + halfLength : 2 * halfLength;
+                    float acc = 0.0f;
+                    for (int k = first; k <= last; k++) acc += coefficients[k] * in[center - halfLength + k];
+                    out[i] = acc;
+                }
+            }
+            mipmapSamples[levelCount] = output;
+            mipmapSampleCount[levelCount] = outputCount;
+            levelCount++;
+            input = output;
+            inputCount = outputCount;
+        }
+        mipmapLevelCount.store(levelCount, std::memory_order_release);
+    }
+    
+    void SampleBuffer::deleteMipmap()
+    {
+        MipmapBuilder::shared().remove(this);
+        mipmapLevelCount.store(0, std::memory_order_release);
+        for (int i=0; i < kMaxMipmapLevels; i++)
+        {
+            if (mipmapSamples[i]) delete[] mipmapSamples[i];
+            mipmapSamples[i] = 0;
+        }
+    }
+    
+    void KeyMappedSampleBuffer::setSampleDescriptor(const AKSampleDescriptor &sd)
+    {
+        minimumNoteNumber = sd.minimumNoteNumber;
+        maximumNoteNumber = sd.maximumNoteNumber;
+        minimumVelocity = sd.minimumVelocity;
+        maximumVelocity = sd.maximumVelocity;
+        noteNumber = sd.noteNumber;
+        noteFrequency = sd.noteFrequency;
+        
+        if (sd.startPoint > 0.0f) startPoint = sd.startPoint;
+        if (sd.endPoint > 0.0f)   endPoint = sd.endPoint;
+        
+        isLooping = sd.isLooping;
+        if (isLooping)
+        {
+            // loopStartPoint, loopEndPoint are usually sample indices, but values 0.0-1.0
+            // are interpreted as fractions of the total sample length.
+            if (sd.loopStartPoint > 1.0f) loopStartPoint = sd.loopStartPoint;
+            else loopStartPoint = endPoint * sd.loopStartPoint;
+            if (sd.loopEndPoint > 1.0f) loopEndPoint = sd.loopEndPoint;
+            else loopEndPoint = endPoint * sd.loopEndPoint;
+        }
+    }
+    
 }
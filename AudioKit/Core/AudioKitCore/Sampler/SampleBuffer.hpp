@@ -7,11 +7,22 @@
 //
 
 #pragma once
+#include "AKSampler_Typedefs.h"
+#include <math.h>
+#include <atomic>
+#include <memory>
+
 namespace AudioKitCore
 {
+    class MipmapBuilder;
 
     // SampleBuffer represents an array of sample data, which can be addressed with a real-valued
     // "index" via linear interpolation.
+    //
+    // Optionally, a SampleBuffer can also hold a "mipmap": successively band-limited copies of its
+    // data at 1/2, 1/4, 1/8... of its sample rate, built in the background. Playing a level
+    // instead of the full-rate data avoids aliasing (and needless memory traffic) when a sample is
+    // pitched up an octave or more. Altogether the levels take as much memory as the sample itself.
     
     struct SampleBuffer
     {
@@ -24,6 +35,8 @@ namespace AudioKitCore
         float loopStartPoint, loopEndPoint;
         float noteFrequency;
         
+        static const int kMaxMipmapLevels = 10;
+        
         SampleBuffer();
         ~SampleBuffer();
         
@@ -32,43 +45,81 @@ namespace AudioKitCore
         
         void setData(unsigned index, float data);
         
+        // Plays source's samples, and whatever of its mipmap has been built, without copying them.
+        // The data is freed with the last buffer using it. A buffer sharing data doesn't build a
+        // mipmap of its own, so build source's first (with buildMipmapNow) if one is wanted.
+        void shareData(const std::shared_ptr<SampleBuffer> &source);
+        
+        // Call after all data has been set, to queue the mipmap to be built in the background.
+        // All samples share one builder thread, which builds them in the order they were queued.
+        void buildMipmapInBackground();
+        
+        // As above, but builds the mipmap on the calling thread, e.g. a loader's worker thread.
+        void buildMipmapNow();
+        
+        // Number of mipmap levels available to play (not counting the full-rate data), 0 until
+        // the background build finishes.
+        inline int getMipmapLevelCount() { return mipmapLevelCount.load(std::memory_order_acquire); }
+        
         // Use double for the real-valued index, because oscillators will need the extra precision.
         inline float interp(double fIndex, float gain)
         {
             if (samples == 0 || sampleCount == 0) return 0.0f;
-            
+            return interp(samples, sampleCount, fIndex, gain);
+        }
+        
+        inline void interp(double fIndex, float *leftOutput, float *rightOutput, float gain)
+        {
+            interp(samples, sampleCount, fIndex, leftOutput, rightOutput, gain);
+        }
+        
+        // As above, but reading mipmap level 1 (half rate) or higher. fIndex is still in units of
+        // full-rate samples.
+        inline void interp(double fIndex, float *leftOutput, float *rightOutput, float gain, int level)
+        {
+            if (level <= 0)
+            {
+                interp(samples, sampleCount, fIndex, leftOutput, rightOutput, gain);
+                return;
+            }
+            interp(mipmapSamples[level - 1], mipmapSampleCount[level - 1], fIndex / double(1 << level),
+                   leftOutput, rightOutput, gain);
+        }
+        
+    protected:
+        // levels, each laid out like samples, and their lengths
+        float *mipmapSamples[kMaxMipmapLevels];
+        int mipmapSampleCount[kMaxMipmapLevels];
+        std::atomic<int> mipmapLevelCount;
+        
+        // set while this buffer plays another's data, which it must not free
+        std::shared_ptr<SampleBuffer> sharedData;
+        
+        friend class MipmapBuilder;
+        void buildMipmap();
+        void deleteMipmap();
+        
+        inline static float interp(const float *data, int count, double fIndex, float gain)
+        {
             int ri = int(fIndex);
             double f = fIndex - ri;
             int rj = ri + 1;
             
-            float si = ri < sampleCount ? samples[ri] : 0.0f;
-            float sj = rj < sampleCount ? samples[rj] : 0.0f;
+            float si = ri < count ? data[ri] : 0.0f;
+            float sj = rj < count ? data[rj] : 0.0f;
             return (float)(gain * ((1.0 - f) * si + f * sj));
         }
         
-        inline void interp(double fIndex, float *leftOutput, float *rightOutput, float gain)
+        inline void interp(const float *data, int count, double fIndex,
+                           float *leftOutput, float *rightOutput, float gain)
         {
-            if (samples == 0 || sampleCount == 0)
+            if (data == 0 || count == 0)
             {
                 *leftOutput = *rightOutput = 0.0f;
                 return;
             }
-            if (channelCount == 1)
-            {
-                *leftOutput = *rightOutput = interp(fIndex, gain);
-                return;
-            }
-            
-            int ri = int(fIndex);
-            double f = fIndex - ri;
-            int rj = ri + 1;
-            
-            float si = ri < sampleCount ? samples[ri] : 0.0f;
-            float sj = rj < sampleCount ? samples[rj] : 0.0f;
-            *leftOutput = (float)(gain * ((1.0 - f) * si + f * sj));
-            si = ri < sampleCount ? samples[sampleCount + ri] : 0.0f;
-            sj = rj < sampleCount ? samples[sampleCount + rj] : 0.0f;
-            *rightOutput = (float)(gain * ((1.0f - f) * si + f * sj));
+            *leftOutput = interp(data, count, fIndex, gain);
+            *rightOutput = channelCount == 1 ? *leftOutput : interp(data + count, count, fIndex, gain);
         }
     };
     
@@ -79,6 +130,9 @@ namespace AudioKitCore
         int noteNumber;     // closest MIDI note-number to this sample's frequency (noteFrequency)
         int minimumNoteNumber, maximumNoteNumber;     // bounding note numbers for mapping
         int minimumVelocity, maximumVelocity;       // min/max MIDI velocities for mapping
+        
+        // Call after init(), to take the pitch, mapping, start/end and loop points of a sample
+        void setSampleDescriptor(const AKSampleDescriptor &sampleDescriptor);
     };
 
 }
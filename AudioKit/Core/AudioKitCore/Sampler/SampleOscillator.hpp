@@ -20,9 +20,26 @@ namespace AudioKitCore
         double indexPoint;  // use double so we don't lose precision when indexPoint becomes much larger than increment
         double increment;   // 1.0 = play at original speed
         double multiplier;  // multiplier applied to increment for pitch bend, vibrato
+        int mipmapLevel;    // 0 = play the sample itself, 1 = its half-rate copy, etc.
         
         void setPitchOffsetSemitones(double semitones) { multiplier = pow(2.0, semitones/12.0); }
         
+        // When pitched up an octave or more, play a band-limited copy of the sample at a lower rate
+        // instead, if it has one. Copies keep frequencies up to 0.44 of their own sample rate, so
+        // stepping through one up to 1.125 samples at a time does not alias.
+        void selectMipmapLevel(SampleBuffer *sampleBuffer)
+        {
+            int levelCount = sampleBuffer ? sampleBuffer->getMipmapLevelCount() : 0;
+            double step = multiplier * increment;
+            mipmapLevel = 0;
+            if (step < 2.0) return;
+            while (mipmapLevel < levelCount && step > 1.125)
+            {
+                step *= 0.5;
+                mipmapLevel++;
+            }
+        }
+        
         // return true if we run out of samples
         inline bool getSample(SampleBuffer *sampleBuffer, int sampleCount, float *output, float gain)
         {
@@ -42,7 +59,7 @@ namespace AudioKitCore
         inline bool getSamplePair(SampleBuffer *sampleBuffer, int sampleCount, float *leftOutput, float *rightOutput, float gain)
         {
             if (sampleBuffer == NULL || indexPoint > sampleBuffer->endPoint) return true;
-            sampleBuffer->interp(indexPoint, leftOutput, rightOutput, gain);
+            sampleBuffer->interp(indexPoint, leftOutput, rightOutput, gain, mipmapLevel);
             
             indexPoint += multiplier * increment;
             if (sampleBuffer->isLooping && isLooping)
@@ -22,6 +22,8 @@ namespace AudioKitCore
         filterEnvelope.init();
         volumeRamper.init(0.0f);
         tempGain = 0.0f;
+        outputPeak = 0.0f;
+        quietChunkCount = 0;
     }
 
     void SamplerVoice::start(unsigned note, float sampleRate, float frequency, float volume, SampleBuffer *buffer)
@@ -30,11 +32,13 @@ namespace AudioKitCore
         oscillator.indexPoint = buffer->startPoint;
         oscillator.increment = (buffer->sampleRate / sampleRate) * (frequency / buffer->noteFrequency);
         oscillator.multiplier = 1.0;
+        oscillator.mipmapLevel = 0;
         oscillator.isLooping = buffer->isLooping;
         
         noteVolume = volume;
         adsrEnvelope.start();
         volumeRamper.init(0.0f);
+        quietChunkCount = 0;
         
         samplingRate = sampleRate;
         leftFilter.updateSampleRate(double(samplingRate));
@@ -69,6 +73,7 @@ namespace AudioKitCore
         noteFrequency = frequency;
         noteNumber = note;
         tempNoteVolume = noteVolume;
+        quietChunkCount = 0;
         newSampleBuffer = buffer;
         adsrEnvelope.restart();
         noteVolume = volume;
@@ -96,6 +101,7 @@ namespace AudioKitCore
     void SamplerVoice::restartSameNote(float volume, SampleBuffer *buffer)
     {
         tempNoteVolume = noteVolume;
+        quietChunkCount = 0;
         newSampleBuffer = buffer;
         adsrEnvelope.restart();
         noteVolume = volume;
@@ -160,6 +166,7 @@ namespace AudioKitCore
             }
         }
         oscillator.setPitchOffsetSemitones(pitchOffset + glideSemitones);
+        oscillator.selectMipmapLevel(sampleBuffer);
 
         // negative value of cutoffMultiple means filters are disabled
         if (cutoffMultiple < 0.0f)
@@ -182,6 +189,7 @@ namespace AudioKitCore
     
     bool SamplerVoice::getSamples(int sampleCount, float *leftOutput, float *rightOutput)
     {
+        float peak = 0.0f;
         for (int i=0; i < sampleCount; i++)
         {
             float gain = tempGain * volumeRamper.getNextValue();
@@ -190,16 +198,27 @@ namespace AudioKitCore
                 return true;
             if (isFilterEnabled)
             {
-                *leftOutput++ += leftFilter.process(leftSample);
-                *rightOutput++ += rightFilter.process(rightSample);
-            }
-            else
-            {
-                *leftOutput++ += leftSample;
-                *rightOutput++ += rightSample;
+                leftSample = leftFilter.process(leftSample);
+                rightSample = rightFilter.process(rightSample);
             }
+            *leftOutput++ += leftSample;
+            *rightOutput++ += rightSample;
+            peak = fmaxf(peak, fmaxf(fabsf(leftSample), fabsf(rightSample)));
         }
+        outputPeak = peak;
         return false;
     }
 
+    bool SamplerVoice::isInaudible(float noiseFloor, unsigned chunkLimit)
+    {
+        // a note may start quietly, so only its decay, sustain and release are judged
+        if (noiseFloor <= 0.0f || outputPeak >= noiseFloor ||
+            adsrEnvelope.isPreStarting() || adsrEnvelope.isAttacking())
+        {
+            quietChunkCount = 0;
+            return false;
+        }
+        return ++quietChunkCount >= chunkLimit;
+    }
+
 }
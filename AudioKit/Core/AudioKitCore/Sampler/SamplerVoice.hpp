@@ -62,7 +62,13 @@ namespace AudioKitCore
 
         /// true if filter should be used
         bool isFilterEnabled;
-        
+
+        /// largest absolute output sample in the last chunk
+        float outputPeak;
+
+        /// number of consecutive chunks whose output peak was below the noise floor
+        unsigned quietChunkCount;
+
         SamplerVoice() : noteNumber(-1) {}
 
         void init(double sampleRate);
@@ -92,6 +98,9 @@ namespace AudioKitCore
                               float resLinear);
 
         bool getSamples(int sampleCount, float *leftOutput, float *rightOutput);
+
+        // return true once output has stayed below noiseFloor for chunkLimit chunks after the attack
+        bool isInaudible(float noiseFloor, unsigned chunkLimit);
     };
 
 }
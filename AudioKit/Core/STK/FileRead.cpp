@@ -37,6 +37,11 @@
 #include <cstring>
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifdef AUDIOKIT
+#include "AKRenderStats.h"
+#else
+#define AK_REALTIME_UNSAFE(kind, where)
+#endif
 
 namespace stk {
 
@@ -78,6 +83,7 @@ void FileRead::open(std::string fileName, bool typeRaw, unsigned int nChannels,
   close();
 
   // Try to open the file.
+  AK_REALTIME_UNSAFE(AKRealtimeViolationFileIO, "stk::FileRead::open opens a file");
   fd_ = fopen(fileName.c_str(), "rb");
   if (!fd_) {
     oStream_ << "FileRead::open: could not open or find file (" << fileName
@@ -0,0 +1,128 @@
+/*
+ * fastmath
+ *
+ * Single precision approximations of the transcendentals used inside the
+ * nonlinear filters, cheap enough to call per sample (and per oversampled
+ * step). They use selects rather than branches, so loops calling them over
+ * independent values vectorize (with clang's defaults; GCC also needs
+ * -fno-trapping-math).
+ *
+ * Error bounds, measured against double precision libm over every float in
+ * the stated range:
+ *
+ * sp_fast_exp2  relative error < 1.1e-7, x in [-126, 127]; clamped outside
+ *               that range, so never returns inf or a denormal
+ * sp_fast_exp   relative error < 3.1e-7 for |x| <= 4, growing to 4e-6 at
+ *               the ends of [-87, 88] from the rounding of x * log2(e)
+ * sp_fast_log2  absolute error < 1.2e-7 for x in [0.5, 2], relative error
+ *               < 1e-7 elsewhere; x must be positive and normal
+ * sp_fast_log   absolute error < 1e-7 for x in [0.5, 2], relative error
+ *               < 1.5e-7 elsewhere; x must be positive and normal
+ * sp_fast_pow   relative error < 1e-7 * (1 + |y| + |y log2(x)|) over the tested
+ *               range (x in [0.01, 200], y in [-3, 3]); x must be positive
+ *               and normal
+ * sp_fast_tanh  absolute error < 4.2e-7, relative error < 3e-7 for
+ *               |x| < 1, and exactly +/-1 beyond |x| = 7.906
+ *
+ * These are float functions whatever SPFLOAT is.
+ */
+
+#ifndef SP_FASTMATH_H
+#define SP_FASTMATH_H
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+static inline float sp_fast_as_float(int32_t i)
+{
+    float f;
+    memcpy(&f, &i, sizeof(f));
+    return f;
+}
+
+static inline int32_t sp_fast_as_int(float f)
+{
+    int32_t i;
+    memcpy(&i, &f, sizeof(i));
+    return i;
+}
+
+/* 2^x as 2^n * 2^f, n = round(x), the fraction from the cephes exp2f polynomial */
+static inline float sp_fast_exp2(float x)
+{
+    float n, f, p;
+    x = x < -126.0f ? -126.0f : x;
+    x = x > 127.0f ? 127.0f : x;
+    n = (float)(int32_t)(x + (x < 0.0f ? -0.5f : 0.5f));
+    f = x - n;
+    p = 1.535336188319500e-4f;
+    p = p * f + 1.339887440266574e-3f;
+    p = p * f + 9.618437357674640e-3f;
+    p = p * f + 5.550332471162809e-2f;
+    p = p * f + 2.402264791363012e-1f;
+    p = p * f + 6.931472028550421e-1f;
+    p = p * f + 1.0f;
+    return p * sp_fast_as_float(((int32_t)n + 127) << 23);
+}
+
+static inline float sp_fast_exp(float x)
+{
+    return sp_fast_exp2(x * 1.442695040888963f);
+}
+
+/* log2 of the exponent plus an atanh series for the mantissa, taken in [sqrt(1/2), sqrt(2)) */
+static inline float sp_fast_log2(float x)
+{
+    int32_t bits = sp_fast_as_int(x);
+    int32_t e = ((bits >> 23) & 0xff) - 127;
+    float m = sp_fast_as_float((bits & 0x007fffff) | 0x3f800000);
+    int big = m > 1.414213562f;
+    float s, s2, p;
+    m = big ? 0.5f * m : m;
+    e = big ? e + 1 : e;
+    s = (m - 1.0f) / (m + 1.0f);
+    s2 = s * s;
+    p = 0.3205976091f;                 /* 2 / (9 ln 2) */
+    p = p * s2 + 0.4121968939f;        /* 2 / (7 ln 2) */
+    p = p * s2 + 0.5770780164f;        /* 2 / (5 ln 2) */
+    p = p * s2 + 0.9617966940f;        /* 2 / (3 ln 2) */
+    p = p * s2 + 2.8853900818f;        /* 2 / ln 2 */
+    return (float)e + s * p;
+}
+
+static inline float sp_fast_log(float x)
+{
+    return sp_fast_log2(x) * 0.6931471805599453f;
+}
+
+static inline float sp_fast_pow(float x, float y)
+{
+    return sp_fast_exp2(y * sp_fast_log2(x));
+}
+
+/* The [13/6] minimax rational approximation used by Eigen, on x clamped to +/-7.9 */
+static inline float sp_fast_tanh(float x)
+{
+    float x2, p, q, t;
+    x = x < -7.90531110763549805f ? -7.90531110763549805f : x;
+    x = x > 7.90531110763549805f ? 7.90531110763549805f : x;
+    x2 = x * x;
+    p = -2.76076847742355e-16f;
+    p = p * x2 + 2.00018790482477e-13f;
+    p = p * x2 - 8.60467152213735e-11f;
+    p = p * x2 + 5.12229709037114e-08f;
+    p = p * x2 + 1.48572235717979e-05f;
+    p = p * x2 + 6.37261928875436e-04f;
+    p = p * x2 + 4.89352455891786e-03f;
+    p = p * x;
+    q = 1.19825839466702e-06f;
+    q = q * x2 + 1.18534705686654e-04f;
+    q = q * x2 + 2.26843463243900e-03f;
+    q = q * x2 + 4.89352518554385e-03f;
+    t = p / q;
+    /* tiny inputs, where tanh(x) rounds to x */
+    return fabsf(x) < 0.0004f ? x : t;
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * blepbank
+ *
+ * A bank of band-limited saw, pulse and triangle oscillators, rendered
+ * together a block at a time. The discontinuities of the naive waveforms
+ * are smoothed with two-sample polynomial corrections: PolyBLEP for the
+ * jumps of the saw and pulse, and its integral, PolyBLAMP, for the corners
+ * of the triangle.
+ *
+ * Voices are kept in structure-of-arrays form and the output is time
+ * major, one row of nvoices samples per frame. The inner loop runs across
+ * voices and uses selects rather than branches, so it vectorizes, with
+ * each SIMD lane rendering a different voice.
+ *
+ * The only state is each voice's phase. A caller whose set of voices
+ * changes can fill the first nvoices entries of phs, freq and width from
+ * its own voices before each block and read the phases back afterwards.
+ *
+ * The pulse is the difference of two saws, as in blsquare, so its levels
+ * are 2 * width and 2 * width - 2 and it has no DC offset.
+ *
+ */
+
+#include <stdlib.h>
+#include "soundpipe.h"
+
+int sp_blepbank_create(sp_blepbank **p)
+{
+    *p = malloc(sizeof(sp_blepbank));
+    return SP_OK;
+}
+
+int sp_blepbank_destroy(sp_blepbank **p)
+{
+    sp_blepbank *pp = *p;
+    sp_auxdata_free(&pp->aux);
+    free(*p);
+    return SP_OK;
+}
+
+int sp_blepbank_init(sp_data *sp, sp_blepbank *p, int maxvoices, int shape)
+{
+    char *mem;
+    size_t n;
+
+    if(maxvoices < 1) maxvoices = 1;
+    /* rounded up so every array stays 16 byte aligned */
+    n = (maxvoices + 3) & ~3;
+
+    p->maxvoices = maxvoices;
+    p->nvoices = 0;
+    p->shape = shape;
+    p->onedsr = 1.0 / sp->sr;
+
+    sp_auxdata_alloc(&p->aux, n * 3 * sizeof(SPFLOAT));
+    mem = p->aux.ptr;
+    p->phs = (SPFLOAT *)mem; mem += n * sizeof(SPFLOAT);
+    p->freq = (SPFLOAT *)mem; mem += n * sizeof(SPFLOAT);
+    p->width = (SPFLOAT *)mem;
+    return SP_OK;
+}
+
+/* the PolyBLEP residual of a rising step of 2 at phase 0, for phase t and
+ * increment dt (rdt = 1 / dt) */
+static inline SPFLOAT blep(SPFLOAT t, SPFLOAT dt, SPFLOAT rdt)
+{
+    SPFLOAT a = t * rdt, b = (t - 1) * rdt;
+    SPFLOAT after = 2 * a - a * a - 1;
+    SPFLOAT before = b * b + 2 * b + 1;
+    return t < dt ? after : (t > 1 - dt ? before : 0);
+}
+
+/* the PolyBLAMP residual of a slope change of 1 per sample at phase 0 */
+static inline SPFLOAT blamp(SPFLOAT t, SPFLOAT dt, SPFLOAT rdt)
+{
+    SPFLOAT a = 1 - t * rdt, b = (t - 1) * rdt + 1;
+    SPFLOAT after = a * a * a * (SPFLOAT)(1.0 / 6);
+    SPFLOAT before = b * b * b * (SPFLOAT)(1.0 / 6);
+    return t < dt ? after : (t > 1 - dt ? before : 0);
+}
+
+/* one frame of every voice, with the shape fixed so the branch on it leaves
+ * the loop */
+#define SP_BLEPBANK_LOOP(SHAPE) \
+    for(v = 0; v < n; v++) { \
+        SPFLOAT ph = phs[v], dt, rdt, x; \
+        /* the corrections overlap above half the sample rate */ \
+        dt = freq[v] * fscale; \
+        dt = dt < 0 ? 0 : (dt > 0.5 ? 0.5 : dt); \
+        rdt = 1 / (dt > 1e-9 ? dt : 1e-9); \
+        SHAPE \
+        row[v] = x; \
+        ph += dt; \
+        phs[v] = ph >= 1 ? ph - 1 : ph; \
+    }
+
+int sp_blepbank_compute_block(sp_data *sp, sp_blepbank *p, const SPFLOAT *fmul,
+    SPFLOAT *out, int nframes)
+{
+    SPFLOAT *restrict phs = p->phs;
+    const SPFLOAT *restrict freq = p->freq;
+    const SPFLOAT *restrict width = p->width;
+    const SPFLOAT onedsr = p->onedsr;
+    const int n = p->nvoices < p->maxvoices ? p->nvoices : p->maxvoices;
+    int t, v;
+
+    for(t = 0; t < nframes; t++) {
+        SPFLOAT *restrict row = out + (size_t)t * n;
+        SPFLOAT fscale = (fmul != NULL ? fmul[t] : 1) * onedsr;
+        switch(p->shape) {
+            case SP_BLEP_SQUARE:
+                SP_BLEPBANK_LOOP(
+                    SPFLOAT ph2 = ph - width[v];
+                    ph2 = ph2 < 0 ? ph2 + 1 : ph2;
+                    x = 2 * (ph - ph2) - blep(ph, dt, rdt) + blep(ph2, dt, rdt);
+                )
+                break;
+            case SP_BLEP_TRIANGLE:
+                /* -1 at phase 0 and 1 at phase 0.5, its slope turning by
+                 * 8 * dt per sample at each */
+                SP_BLEPBANK_LOOP(
+                    SPFLOAT ph2 = ph >= 0.5 ? ph - 0.5 : ph + 0.5;
+                    x = 1 - 4 * (ph > 0.5 ? ph - 0.5 : 0.5 - ph);
+                    x += 8 * dt * (blamp(ph, dt, rdt) - blamp(ph2, dt, rdt));
+                )
+                break;
+            default:
+                SP_BLEPBANK_LOOP(
+                    x = 2 * ph - 1 - blep(ph, dt, rdt);
+                )
+                break;
+        }
+    }
+
+    return SP_OK;
+}
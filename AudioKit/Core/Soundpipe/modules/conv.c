@@ -8,13 +8,150 @@
  * Year: 2005
  * Location: Opcodes/ftconv.c
  *
+ * The transformed partitions of an impulse response only depend on its
+ * samples and the partition size, so they are kept in a cache keyed by a
+ * hash of both and shared read-only by every instance convolving with the
+ * same response, whichever table it was loaded into. The samples are kept
+ * too, so a hash collision can't hand out another response. Each instance
+ * only owns its input ring buffer and output buffers.
+ *
  */
 
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include "soundpipe.h"
 
+#define CONV_FNV_OFFSET 14695981039346656037ULL
+#define CONV_FNV_PRIME 1099511628211ULL
+
+typedef struct sp_conv_ir {
+    uint64_t hash;
+    int len, partSize, nPartitions, refs;
+    /* the transformed partitions, followed by a copy of the samples */
+    SPFLOAT *data, *samples;
+    struct sp_conv_ir *next;
+} sp_conv_ir;
+
+static pthread_mutex_t ir_lock = PTHREAD_MUTEX_INITIALIZER;
+static sp_conv_ir *ir_list = NULL;
+
+static uint64_t ir_hash(const SPFLOAT *tbl, int len, int partSize)
+{
+    const unsigned char *b = (const unsigned char *)tbl;
+    uint64_t h = CONV_FNV_OFFSET;
+    size_t i, n = (size_t)len * sizeof(SPFLOAT);
+
+    for (i = 0; i < n; i++) h = (h ^ b[i]) * CONV_FNV_PRIME;
+    h = (h ^ (uint64_t)partSize) * CONV_FNV_PRIME;
+    h = (h ^ (uint64_t)len) * CONV_FNV_PRIME;
+    return h;
+}
+
+/* must be called with ir_lock held */
+static sp_conv_ir *ir_find(const SPFLOAT *tbl, uint64_t hash, int len,
+                           int partSize)
+{
+    sp_conv_ir *ir;
+    for (ir = ir_list; ir != NULL; ir = ir->next) {
+        if (ir->hash == hash && ir->len == len && ir->partSize == partSize &&
+            memcmp(ir->samples, tbl, sizeof(SPFLOAT) * len) == 0)
+            return ir;
+    }
+    return NULL;
+}
+
+/* partitions and transforms the first len samples of tbl */
+static sp_conv_ir *ir_build(sp_fft *fft, const SPFLOAT *tbl, int len,
+                            int partSize, uint64_t hash)
+{
+    sp_conv_ir *ir;
+    int i, k, n;
+
+    ir = malloc(sizeof(sp_conv_ir));
+    if (ir == NULL) return NULL;
+    ir->hash = hash;
+    ir->len = len;
+    ir->partSize = partSize;
+    ir->nPartitions = (len + (partSize - 1)) / partSize;
+    ir->refs = 0;
+    n = (partSize << 1) * ir->nPartitions;
+    ir->data = malloc(sizeof(SPFLOAT) * (n + len));
+    if (ir->data == NULL) {
+        free(ir);
+        return NULL;
+    }
+    ir->samples = ir->data + n;
+    memcpy(ir->samples, tbl, sizeof(SPFLOAT) * len);
+
+    /* partitions are stored last first, the order they are multiplied in */
+    i = 0;
+    n = (partSize << 1) * (ir->nPartitions - 1);
+    do {
+        for (k = 0; k < partSize; k++, i++) {
+            ir->data[n + k] = i < len ? tbl[i] : 0.0;
+        }
+        /* pad second half of IR to zero */
+        for (k = partSize; k < (partSize << 1); k++) {
+            ir->data[n + k] = 0.0;
+        }
+        /* calculate FFT */
+        sp_fftr(fft, &ir->data[n], (partSize << 1));
+        n -= (partSize << 1);
+    } while (n >= 0);
+    return ir;
+}
+
+static sp_conv_ir *ir_acquire(sp_fft *fft, const SPFLOAT *tbl, int len,
+                              int partSize)
+{
+    uint64_t hash = ir_hash(tbl, len, partSize);
+    sp_conv_ir *ir, *built;
+
+    pthread_mutex_lock(&ir_lock);
+    ir = ir_find(tbl, hash, len, partSize);
+    if (ir != NULL) ir->refs++;
+    pthread_mutex_unlock(&ir_lock);
+    if (ir != NULL) return ir;
+
+    /* transformed without the lock, so long responses don't hold up other
+     * instances. If another one got there first, its copy is used. */
+    built = ir_build(fft, tbl, len, partSize, hash);
+    if (built == NULL) return NULL;
+
+    pthread_mutex_lock(&ir_lock);
+    ir = ir_find(tbl, hash, len, partSize);
+    if (ir == NULL) {
+        ir = built;
+        ir->next = ir_list;
+        ir_list = ir;
+        built = NULL;
+    }
+    ir->refs++;
+    pthread_mutex_unlock(&ir_lock);
+
+    if (built != NULL) {
+        free(built->data);
+        free(built);
+    }
+    return ir;
+}
+
+static void ir_release(sp_conv_ir *ir)
+{
+    sp_conv_ir **link;
+
+    pthread_mutex_lock(&ir_lock);
+    if (--ir->refs == 0) {
+        for (link = &ir_list; *link != ir; link = &(*link)->next);
+        *link = ir->next;
+        free(ir->data);
+        free(ir);
+    }
+    pthread_mutex_unlock(&ir_lock);
+}
+
 static void multiply_fft_buffers(SPFLOAT *outBuf, SPFLOAT *ringBuf,
                                  SPFLOAT *IR_Data, int partSize, int nPartitions,
                                  int ringBuf_startPos)
@@ -76,7 +213,6 @@ static int buf_bytes_alloc(int nChannels, int partSize, int nPartitions)
 
     nSmps = (partSize << 1);                                /* tmpBuf     */
     nSmps += ((partSize << 1) * nPartitions);               /* ringBuf    */
-    nSmps += ((partSize << 1) * nChannels * nPartitions);   /* IR_Data    */
     nSmps += ((partSize << 1) * nChannels);                 /* outBuffers */
 
     return ((int) sizeof(SPFLOAT) * nSmps);
@@ -93,10 +229,6 @@ static void set_buf_pointers(sp_conv *p,
     ptr += (partSize << 1);
     p->ringBuf = ptr;
     ptr += ((partSize << 1) * nPartitions);
-    for (i = 0; i < nChannels; i++) {
-      p->IR_Data[i] = ptr;
-      ptr += ((partSize << 1) * nPartitions);
-    }
     for (i = 0; i < nChannels; i++) {
       p->outBuffers[i] = ptr;
       ptr += (partSize << 1);
@@ -105,13 +237,14 @@ static void set_buf_pointers(sp_conv *p,
 
 int sp_conv_create(sp_conv **p)
 {
-    *p = malloc(sizeof(sp_conv));
+    *p = calloc(1, sizeof(sp_conv));
     return SP_OK;
 }
 
 int sp_conv_destroy(sp_conv **p)
 {
     sp_conv *pp = *p;
+    if (pp->ir != NULL) ir_release(pp->ir);
     sp_auxdata_free(&pp->auxData);
     sp_fft_destroy(&pp->fft);
     free(*p);
@@ -120,8 +253,19 @@ int sp_conv_destroy(sp_conv **p)
 
 int sp_conv_init(sp_data *sp, sp_conv *p, sp_ftbl *ft, SPFLOAT iPartLen)
 {
-    int     i, j, k, n, nBytes, skipSamples;
-    SPFLOAT FFTscale;
+    int     j, n, nBytes, skipSamples;
+
+    /* initialising again starts over with the new response */
+    if (p->ir != NULL) {
+        ir_release(p->ir);
+        p->ir = NULL;
+    }
+    if (p->fft.utbl != NULL) {
+        sp_fft_destroy(&p->fft);
+        memset(&p->fft, 0, sizeof(sp_fft));
+    }
+    sp_auxdata_free(&p->auxData);
+    p->auxData.ptr = NULL;
 
     p->iTotLen = ft->size;
     p->iSkipSamples = 0;
@@ -149,11 +293,18 @@ int sp_conv_init(sp_data *sp, sp_conv *p, sp_ftbl *ft, SPFLOAT iPartLen)
         return SP_NOT_OK;
     }
 
-    p->nPartitions = (n + (p->partSize - 1)) / p->partSize;
+    /* the cache holds mono responses, which is all conv reads */
+    p->ir = ir_acquire(&p->fft, &ft->tbl[skipSamples], n, p->partSize);
+    if (p->ir == NULL) {
+        fprintf(stderr, "conv: could not allocate impulse response.\n");
+        return SP_NOT_OK;
+    }
+    p->IR_Data[0] = p->ir->data;
+
+    p->nPartitions = p->ir->nPartitions;
     /* calculate the amount of aux space to allocate (in bytes) */
     nBytes = buf_bytes_alloc(p->nChannels, p->partSize, p->nPartitions);
     sp_auxdata_alloc(&p->auxData, nBytes);
-    /* if skipping samples: check for possible truncation of IR */
     /* initialise buffer pointers */
     set_buf_pointers(p, p->nChannels, p->partSize, p->nPartitions);
     /* clear ring buffer to zero */
@@ -161,34 +312,9 @@ int sp_conv_init(sp_data *sp, sp_conv *p, sp_ftbl *ft, SPFLOAT iPartLen)
     memset(p->ringBuf, 0, n*sizeof(SPFLOAT));
     p->cnt = 0;
     p->rbCnt = 0;
-    FFTscale = 1.0;
-    for (j = 0; j < p->nChannels; j++) {
-        /* table read position */
-        i = (skipSamples * p->nChannels) + j;
-        /* IR write position */
-        n = (p->partSize << 1) * (p->nPartitions - 1);
-        do {
-            for (k = 0; k < p->partSize; k++) {
-                if (i >= 0 && i < (int) ft->size) {
-                    p->IR_Data[j][n + k] = ft->tbl[i] * FFTscale;
-                } else {
-                    p->IR_Data[j][n + k] = 0.0;
-                }
-                i += p->nChannels;
-            }
-        /* pad second half of IR to zero */
-            for (k = p->partSize; k < (p->partSize << 1); k++) {
-                p->IR_Data[j][n + k] = 0.0;
-            }
-            /* calculate FFT */
-            sp_fftr(&p->fft, &(p->IR_Data[j][n]), (p->partSize << 1));
-            n -= (p->partSize << 1);
-        } while (n >= 0);
-    }
     /* clear output buffers to zero */
     for (j = 0; j < p->nChannels; j++) {
-        for (i = 0; i < (p->partSize << 1); i++)
-        p->outBuffers[j][i] = 0.0;
+        memset(p->outBuffers[j], 0, (p->partSize << 1) * sizeof(SPFLOAT));
     }
     p->initDone = 1;
 
@@ -143,35 +143,47 @@ int sp_diode_init(sp_data *sp, sp_diode *p)
     /* update filter coefs */
 
     sp_diode_update(sp, p);
+    p->pfreq = p->freq;
     return SP_OK;
 }
 
 int sp_diode_compute(sp_data *sp, sp_diode *p, SPFLOAT *in, SPFLOAT *out)
 {
-    int i;
+    return sp_diode_compute_block(sp, p, in, out, 1);
+}
+
+/* freq and res are read once per block */
+int sp_diode_compute_block(sp_data *sp, sp_diode *p, const SPFLOAT *in, SPFLOAT *out, int nframes)
+{
+    int i, n;
     SPFLOAT sigma;
     SPFLOAT un;
     SPFLOAT tmp = 0.0;
 
-    /* update filter coefficients */
+    /* update filter coefficients, only when the cutoff moves */
     p->K = p->res * 17;
-    sp_diode_update(sp, p);
-
-    p->opva_fdbk[2] = sp_diode_opva_fdbk_out(sp, p, 3);
-    p->opva_fdbk[1] = sp_diode_opva_fdbk_out(sp, p, 2);
-    p->opva_fdbk[0] = sp_diode_opva_fdbk_out(sp, p, 1);
-
-    sigma =
-        p->SG[0] * sp_diode_opva_fdbk_out(sp, p, 0) +
-        p->SG[1] * sp_diode_opva_fdbk_out(sp, p, 1) +
-        p->SG[2] * sp_diode_opva_fdbk_out(sp, p, 2) +
-        p->SG[3] * sp_diode_opva_fdbk_out(sp, p, 3);
+    if (p->freq != p->pfreq) {
+        sp_diode_update(sp, p);
+        p->pfreq = p->freq;
+    }
 
-    un = (*in - p->K * sigma) / (1 + p->K * p->gamma);
-    tmp = un;
-    for(i = 0; i < 4; i++) {
-        tmp = sp_diode_opva_compute(sp, p, tmp, i);
+    for (n = 0; n < nframes; n++) {
+        p->opva_fdbk[2] = sp_diode_opva_fdbk_out(sp, p, 3);
+        p->opva_fdbk[1] = sp_diode_opva_fdbk_out(sp, p, 2);
+        p->opva_fdbk[0] = sp_diode_opva_fdbk_out(sp, p, 1);
+
+        sigma =
+            p->SG[0] * sp_diode_opva_fdbk_out(sp, p, 0) +
+            p->SG[1] * sp_diode_opva_fdbk_out(sp, p, 1) +
+            p->SG[2] * sp_diode_opva_fdbk_out(sp, p, 2) +
+            p->SG[3] * sp_diode_opva_fdbk_out(sp, p, 3);
+
+        un = (in[n] - p->K * sigma) / (1 + p->K * p->gamma);
+        tmp = un;
+        for(i = 0; i < 4; i++) {
+            tmp = sp_diode_opva_compute(sp, p, tmp, i);
+        }
+        out[n] = tmp;
     }
-    *out = tmp;
     return SP_OK;
 }
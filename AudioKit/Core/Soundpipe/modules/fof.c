@@ -15,8 +15,6 @@
 #include <math.h>
 #include "soundpipe.h"
 
-#define PFRAC1(x)   ((SPFLOAT)((x) & ftp1->lomask) * ftp1->lodiv)
-
 #ifndef M_PI
 #define M_PI		3.14159265358979323846
 #endif
@@ -45,22 +43,22 @@ static SPFLOAT intpow(SPFLOAT x, int32_t n)
 
 
 static int newpulse(sp_data *sp,
-                    sp_fof *p, sp_fof_overlap *ovp, SPFLOAT amp, SPFLOAT fund, SPFLOAT form)
+                    sp_fof *p, sp_grain *grain, SPFLOAT amp, SPFLOAT fund, SPFLOAT form)
 {
     SPFLOAT   octamp = amp, oct;
     int32_t   rismps, newexp = 0;
 
-    ovp->timrem = p->dur * sp->sr;
+    grain->dur = p->dur * sp->sr;
 
     if ((oct = p->oct) > 0.0) {
         int32_t ioct = (int32_t)oct, bitpat = (int) ~(-1L << ioct);
         if (bitpat & ++p->fofcount) return(0);
         if ((bitpat += 1) & p->fofcount) octamp *= (1.0 + ioct - oct);
     }
-    if (fund == 0.0) ovp->formphs = 0;
-    else ovp->formphs = (int32_t)(p->fundphs * form / fund) & SP_FT_PHMASK;
+    if (fund == 0.0) grain->phs = 0;
+    else grain->phs = (int32_t)(p->fundphs * form / fund) & SP_FT_PHMASK;
 
-    ovp->forminc = (int32_t)(form * p->ftp1->sicvt);
+    grain->inc = (int32_t)(form * p->ftp1->sicvt);
 
     if (p->band != p->prvband) {
         p->prvband = p->band;
@@ -71,14 +69,15 @@ static int newpulse(sp_data *sp,
     the kris (ifnb) initial index go negative and crash csound.
     So insert another if-test with compensating code. */
     if (p->ris >= (1.0 / sp->sr) && form != 0.0) {
-        if (form < 0.0 && ovp->formphs != 0)
-            ovp->risphs = (int32_t)((SP_FT_MAXLEN - ovp->formphs) / -form / p->ris);
-        else ovp->risphs = (int32_t)(ovp->formphs / form / p->ris);
+        if (form < 0.0 && grain->phs != 0)
+            grain->risphs = (int32_t)((SP_FT_MAXLEN - grain->phs) / -form / p->ris);
+        else grain->risphs = (int32_t)(grain->phs / form / p->ris);
 
-        ovp->risinc = (int32_t)(p->ftp1->sicvt / p->ris);
-        rismps = SP_FT_MAXLEN / ovp->risinc;
+        grain->risinc = (int32_t)(p->ftp1->sicvt / p->ris);
+        rismps = SP_FT_MAXLEN / grain->risinc;
     } else {
-        ovp->risphs = SP_FT_MAXLEN;
+        grain->risphs = SP_FT_MAXLEN;
+        grain->risinc = 0;
         rismps = 0;
     }
 
@@ -88,24 +87,28 @@ static int newpulse(sp_data *sp,
         else p->preamp = 1.0;
     }
 
-    ovp->curamp = octamp * p->preamp;
-    ovp->expamp = p->expamp;
-    if ((ovp->dectim = (int32_t)(p->dec * sp->sr)) > 0)
-        ovp->decinc = (int32_t)(p->ftp1->sicvt / p->dec);
-    ovp->decphs = SP_FT_PHMASK;
+    grain->amp = octamp * p->preamp;
+    grain->expamp = p->expamp;
+    grain->decinc = 0;
+    if ((grain->dectim = (int32_t)(p->dec * sp->sr)) > 0)
+        grain->decinc = (int32_t)(p->ftp1->sicvt / p->dec);
+    grain->pos = grain->speed = 0;
     return 1;
 }
 
 int sp_fof_create(sp_fof **p)
 {
     *p = malloc(sizeof(sp_fof));
+    /* here rather than in init, so that init can be run again and destroy
+     * can be run without it */
+    sp_grainpool_create(&(*p)->pool);
     return SP_OK;
 }
 
 int sp_fof_destroy(sp_fof **p)
 {
     sp_fof *pp = *p;
-    sp_auxdata_free(&pp->auxch);
+    sp_grainpool_destroy(&pp->pool);
     free(*p);
     return SP_OK;
 }
@@ -125,28 +128,12 @@ int sp_fof_init(sp_data *sp, sp_fof *p, sp_ftbl *sine, sp_ftbl *win, int iolaps,
     p->ftp1 = sine;
     p->ftp2 = win;
 
-    sp_fof_overlap *ovp, *nxtovp;
-    int32_t olaps;
-
     if (p->iphs == 0.0) p->fundphs = SP_FT_MAXLEN;
     else p->fundphs = (int32_t)(p->iphs * SP_FT_MAXLEN) & SP_FT_PHMASK;
 
-    olaps = (int32_t)p->iolaps;
-
-    if (p->iphs >= 0.0) {
-        sp_auxdata_alloc(&p->auxch, (size_t)olaps * sizeof(sp_fof_overlap));
-    }
-
-    ovp = &p->basovrlap;
-    nxtovp = (sp_fof_overlap *) p->auxch.ptr;
+    /* iolaps is the most grains that can sound at once */
+    sp_grainpool_init(sp, p->pool, sine, win, iolaps, SP_GRAIN_PHASE);
 
-    do {
-        ovp->nxtact = NULL;
-        ovp->nxtfree = nxtovp;
-        ovp = nxtovp++;
-    } while (--olaps);
-    ovp->nxtact = NULL;
-    ovp->nxtfree = NULL;
     p->fofcount = -1;
     p->prvband = 0.0;
     p->expamp = 1.0;
@@ -158,76 +145,45 @@ int sp_fof_init(sp_data *sp, sp_fof *p, sp_ftbl *sine, sp_ftbl *win, int iolaps,
     p->formcod  = 1;
     p->xincod   = p->ampcod || p->fundcod || p->formcod;
     p->fmtmod = 0;
-    p->foftype = 1;
     return SP_OK;
 }
 
 int sp_fof_compute(sp_data *sp, sp_fof *p, SPFLOAT *in, SPFLOAT *out)
 {
-    sp_fof_overlap *ovp;
-    sp_ftbl *ftp1, *ftp2;
+    return sp_fof_compute_block(sp, p, out, 1);
+}
+
+/* amp, fund and form are read once per block */
+int sp_fof_compute_block(sp_data *sp, sp_fof *p, SPFLOAT *out, int nframes)
+{
     SPFLOAT amp, fund, form;
     int32_t fund_inc, form_inc;
-    SPFLOAT v1, fract ,*ftab;
+    sp_grain grain;
+    int i, start = 0;
 
     amp = p->amp;
     fund = p->fund;
     form = p->form;
-    ftp1 = p->ftp1;
-    ftp2 = p->ftp2;
-    fund_inc = (int32_t)(fund * ftp1->sicvt);
-    form_inc = (int32_t)(form * ftp1->sicvt);
-
-    if (p->fundphs & SP_FT_MAXLEN) {
-        p->fundphs &= SP_FT_PHMASK;
-        ovp = p->basovrlap.nxtfree;
-        if (newpulse(sp, p, ovp, amp, fund, form)) {
-            ovp->nxtact = p->basovrlap.nxtact;
-            p->basovrlap.nxtact = ovp;
-            p->basovrlap.nxtfree = ovp->nxtfree;
-        }
+    fund_inc = (int32_t)(fund * p->ftp1->sicvt);
+    form_inc = (int32_t)(form * p->ftp1->sicvt);
+
+    /* formant modulation moves the grains already sounding too */
+    if (p->fmtmod) {
+        for (i = 0; i < p->pool->ngrains; i++) p->pool->inc[i] = form_inc;
     }
-    *out = 0.0;
-    ovp = &p->basovrlap;
-    while (ovp->nxtact != NULL) {
-        SPFLOAT  result;
-        sp_fof_overlap *prvact = ovp;
-        ovp = ovp->nxtact;
-        fract = PFRAC1(ovp->formphs);
-        ftab = ftp1->tbl + (ovp->formphs >> ftp1->lobits);
-        v1 = *ftab++;
-        result = v1 + (*ftab - v1) * fract;
-        if (p->foftype) {
-            if (p->fmtmod)
-            ovp->formphs += form_inc;
-            else ovp->formphs += ovp->forminc;
-        }
-        else {
-            /* SPFLOAT ovp->glissbas = kgliss / grain length. ovp->sampct is
-             incremented each sample. We add glissbas * sampct to the
-             pitch of grain at each a-rate pass (ovp->formphs is the
-             index into ifna; ovp->forminc is the stepping factor that
-             decides pitch) */
-            ovp->formphs += (int32_t)(ovp->forminc + ovp->glissbas * ovp->sampct++);
-        }
-        ovp->formphs &= SP_FT_PHMASK;
-        if (ovp->risphs < SP_FT_MAXLEN) {
-            result *= *(ftp2->tbl + (ovp->risphs >> ftp2->lobits) );
-            ovp->risphs += ovp->risinc;
-        }
-        if (ovp->timrem <= ovp->dectim) {
-            result *= *(ftp2->tbl + (ovp->decphs >> ftp2->lobits) );
-            if ((ovp->decphs -= ovp->decinc) < 0) ovp->decphs = 0;
-        }
-        *out += (result * ovp->curamp);
-        if (--ovp->timrem) ovp->curamp *= ovp->expamp;
-        else {
-            prvact->nxtact = ovp->nxtact;
-            ovp->nxtfree = p->basovrlap.nxtfree;
-            p->basovrlap.nxtfree = ovp;
-            ovp = prvact;
+
+    /* render up to each new grain, then start it */
+    for (i = 0; i < nframes; i++) {
+        if (p->fundphs & SP_FT_MAXLEN) {
+            p->fundphs &= SP_FT_PHMASK;
+            if (newpulse(sp, p, &grain, amp, fund, form)) {
+                sp_grainpool_compute_block(sp, p->pool, out + start, i - start);
+                start = i;
+                sp_grainpool_add(sp, p->pool, &grain);
+            }
         }
+        p->fundphs += fund_inc;
     }
-    p->fundphs += fund_inc;
+    sp_grainpool_compute_block(sp, p->pool, out + start, nframes - start);
     return SP_OK;
 }
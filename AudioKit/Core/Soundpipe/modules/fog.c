@@ -11,8 +11,6 @@
 #include "soundpipe.h"
 
 
-#define PFRAC1(x)   ((SPFLOAT)((x) & ftp1->lomask) * ftp1->lodiv)
-
 #ifndef M_PI
 #define M_PI		3.14159265358979323846
 #endif
@@ -39,13 +37,13 @@ static SPFLOAT intpow(SPFLOAT x, int32_t n)
     return intpow1(x, n);
 }
 
-static int newpulse(sp_data *sp, sp_fog *p, sp_fog_overlap *ovp, SPFLOAT amp,
+static int newpulse(sp_data *sp, sp_fog *p, sp_grain *grain, SPFLOAT amp,
                     SPFLOAT fund, SPFLOAT ptch)
 {
     SPFLOAT octamp = amp, oct;
     SPFLOAT form = ptch / p->ftp1->sicvt, fogcvt = p->fogcvt;
     int32_t rismps, newexp = 0;
-    ovp->timrem = (int32_t)(p->dur * sp->sr);
+    grain->dur = (int32_t)(p->dur * sp->sr);
 
     if ((oct = p->oct) > 0.0) {
         int32_t ioct = (int32_t)oct, bitpat = (int) ~(-1L << ioct);
@@ -53,10 +51,10 @@ static int newpulse(sp_data *sp, sp_fog *p, sp_fog_overlap *ovp, SPFLOAT amp,
         if ((bitpat += 1) & p->fofcount) octamp *= (1.0) + ioct - oct;
     }
 
-    if (fund == 0.0) ovp->formphs = 0;
-    else ovp->formphs = (int32_t)(p->fundphs * form / fund) & SP_FT_PHMASK;
+    if (fund == 0.0) grain->phs = 0;
+    else grain->phs = (int32_t)(p->fundphs * form / fund) & SP_FT_PHMASK;
 
-    ovp->forminc = (int32_t)(ptch * fogcvt);
+    grain->inc = (int32_t)(ptch * fogcvt);
 
     if (p->band != p->prvband) {
         p->prvband = p->band;
@@ -65,32 +63,32 @@ static int newpulse(sp_data *sp, sp_fog *p, sp_fog_overlap *ovp, SPFLOAT amp,
     }
 
     if (p->ris >= (1.0 / sp->sr)  && form != 0.0) {
-        ovp->risphs = (uint32_t)(ovp->formphs / (fabs(form))
+        grain->risphs = (uint32_t)(grain->phs / (fabs(form))
                                     / p->ris);
-        ovp->risinc = (int32_t)(p->ftp1->sicvt / p->ris);
-        rismps = SP_FT_MAXLEN / ovp->risinc;
+        grain->risinc = (int32_t)(p->ftp1->sicvt / p->ris);
+        rismps = SP_FT_MAXLEN / grain->risinc;
     } else {
-        ovp->risphs = SP_FT_MAXLEN;
+        grain->risphs = SP_FT_MAXLEN;
+        grain->risinc = 0;
         rismps = 0;
     }
-    ovp->formphs = (ovp->formphs + p->spdphs) & SP_FT_PHMASK;
+    grain->phs = (grain->phs + p->spdphs) & SP_FT_PHMASK;
 
     if (newexp || rismps != p->prvsmps) {
         if ((p->prvsmps = rismps)) p->preamp = intpow(p->expamp, -rismps);
         else p->preamp = 1.0;
     }
 
-    ovp->curamp = octamp * p->preamp;
-    ovp->expamp = p->expamp;
+    grain->amp = octamp * p->preamp;
+    grain->expamp = p->expamp;
 
-    if ((ovp->dectim = (int32_t)(p->dec * sp->sr )) > 0) {
-        ovp->decinc = (int32_t)(p->ftp1->sicvt / p->dec);
+    grain->decinc = 0;
+    if ((grain->dectim = (int32_t)(p->dec * sp->sr )) > 0) {
+        grain->decinc = (int32_t)(p->ftp1->sicvt / p->dec);
     }
 
-    ovp->decphs = SP_FT_PHMASK;
-
-    ovp->pos = p->spd * p->ftp1->size;
-    ovp->inc = p->trans;
+    grain->pos = p->spd * p->ftp1->size;
+    grain->speed = p->trans;
 
     return 1;
 }
@@ -98,13 +96,16 @@ static int newpulse(sp_data *sp, sp_fog *p, sp_fog_overlap *ovp, SPFLOAT amp,
 int sp_fog_create(sp_fog **p)
 {
     *p = malloc(sizeof(sp_fog));
+    /* here rather than in init, so that init can be run again and destroy
+     * can be run without it */
+    sp_grainpool_create(&(*p)->pool);
     return SP_OK;
 }
 
 int sp_fog_destroy(sp_fog **p)
 {
     sp_fog *pp = *p;
-    sp_auxdata_free(&pp->auxch);
+    sp_grainpool_destroy(&pp->pool);
     free(*p);
     return SP_OK;
 }
@@ -125,27 +126,14 @@ int sp_fog_init(sp_data *sp, sp_fog *p, sp_ftbl *wav, sp_ftbl *win, int iolaps,
     p->ftp1 = wav;
     p->ftp2 = win;
 
-    sp_fog_overlap *ovp, *nxtovp;
-    int32_t olaps;
     p->fogcvt = SP_FT_MAXLEN/(p->ftp1)->size;
     p->spdphs = 0L;
     if (p->iphs == 0.0) p->fundphs = SP_FT_MAXLEN;
     else p->fundphs = (int32_t)(p->iphs * SP_FT_MAXLEN) & SP_FT_PHMASK;
 
-    olaps = (int32_t)p->iolaps;
-
-    sp_auxdata_alloc(&p->auxch, (size_t)olaps * sizeof(sp_fog_overlap));
-    ovp = &p->basovrlap;
-    nxtovp = (sp_fog_overlap *) p->auxch.ptr;
+    /* iolaps is the most grains that can sound at once */
+    sp_grainpool_init(sp, p->pool, wav, win, iolaps, SP_GRAIN_POSITION);
 
-    do {
-        ovp->nxtact = NULL;
-        ovp->nxtfree = nxtovp;
-        ovp = nxtovp++;
-    } while (--olaps);
-
-    ovp->nxtact  = NULL;
-    ovp->nxtfree = NULL;
     p->fofcount = -1;
     p->prvband = 0.0;
     p->expamp = 1.0;
@@ -157,88 +145,37 @@ int sp_fog_init(sp_data *sp, sp_fog *p, sp_ftbl *wav, sp_ftbl *win, int iolaps,
 
 int sp_fog_compute(sp_data *sp, sp_fog *p, SPFLOAT *in, SPFLOAT *out)
 {
-    sp_fog_overlap *ovp;
-    sp_ftbl *ftp1,  *ftp2;
-    SPFLOAT  amp, fund, ptch, speed;
-    SPFLOAT fract;
-    int32_t fund_inc;
-    int32_t incr;
-
-    int32_t ndx;
-    SPFLOAT x1, x2;
+    return sp_fog_compute_block(sp, p, out, 1);
+}
 
+/* amp, dens, trans and spd are read once per block */
+int sp_fog_compute_block(sp_data *sp, sp_fog *p, SPFLOAT *out, int nframes)
+{
+    SPFLOAT amp, fund, ptch, speed;
+    int32_t fund_inc;
+    sp_grain grain;
+    int i, start = 0;
 
     amp = p->amp;
     fund = p->dens;
     ptch = p->trans;
     speed = p->spd;
-    ftp1 = p->ftp1;
-    ftp2 = p->ftp2;
-    fund_inc = (int32_t)(fund * ftp1->sicvt);
-
-    if (p->fundphs & SP_FT_MAXLEN) {
-        p->fundphs &= SP_FT_PHMASK;
-        ovp = p->basovrlap.nxtfree;
-        if (newpulse(sp, p, ovp, amp, fund, ptch)) {
-            ovp->nxtact = p->basovrlap.nxtact;
-            p->basovrlap.nxtact = ovp;
-            p->basovrlap.nxtfree = ovp->nxtfree;
-        }
-    }
-    *out = 0.0;
-    ovp = &p->basovrlap;
-    while (ovp->nxtact != NULL) {
-        SPFLOAT result;
-        sp_fog_overlap *prvact = ovp;
-        ovp = ovp->nxtact;
-        ndx = floor(ovp->pos);
-        fract = ovp->pos - ndx;
-
-        while(ndx >= ftp1->size) {
-            ndx -= ftp1->size;
-        }
-
-        while(ndx < 0) ndx += ftp1->size;
-
-        x1 = ftp1->tbl[ndx];
-        x2 = ftp1->tbl[ndx + 1];
-
-        result = x1 + (x2 - x1) * fract;
-
-        ovp->pos += ovp->inc;
-
-        if (ovp->risphs < SP_FT_MAXLEN) {
-            /* bounds checking so it doesn't segfault */
-            incr = (ovp->risphs >> ftp2->lobits);
-            if(incr <= ftp2->size) {
-                result *= *(ftp2->tbl + incr );
-            } else {
-                result = 0;
-            }
-            ovp->risphs += ovp->risinc;
-        }
-        if (ovp->timrem <= ovp->dectim) {
-            incr = (ovp->decphs >> ftp2->lobits);
-            if(incr <= ftp2->size) {
-                result *= *(ftp2->tbl + incr );
-            } else {
-                result = 0;
+    fund_inc = (int32_t)(fund * p->ftp1->sicvt);
+
+    /* render up to each new grain, then start it */
+    for (i = 0; i < nframes; i++) {
+        if (p->fundphs & SP_FT_MAXLEN) {
+            p->fundphs &= SP_FT_PHMASK;
+            if (newpulse(sp, p, &grain, amp, fund, ptch)) {
+                sp_grainpool_compute_block(sp, p->pool, out + start, i - start);
+                start = i;
+                sp_grainpool_add(sp, p->pool, &grain);
             }
-            if ((ovp->decphs -= ovp->decinc) < 0)
-            ovp->decphs = 0;
-        }
-        *out += (result * ovp->curamp);
-        if (--ovp->timrem) ovp->curamp *= ovp->expamp;
-        else {
-            prvact->nxtact = ovp->nxtact;
-            ovp->nxtfree = p->basovrlap.nxtfree;
-            p->basovrlap.nxtfree = ovp;
-            ovp = prvact;
         }
+        p->fundphs += fund_inc;
+        p->spdphs = (int32_t)(speed * SP_FT_MAXLEN);
+        p->spdphs &= SP_FT_PHMASK;
     }
-
-    p->fundphs += fund_inc;
-    p->spdphs = (int32_t)(speed * SP_FT_MAXLEN);
-    p->spdphs &= SP_FT_PHMASK;
+    sp_grainpool_compute_block(sp, p->pool, out + start, nframes - start);
     return SP_OK;
 }
@@ -0,0 +1,213 @@
+/*
+ * grainpool
+ *
+ * A fixed pool of grains for granular and FOF synthesis. Grains are kept
+ * in structure-of-arrays form and rendered a block at a time, one grain
+ * after another, with each grain's state held in registers for the whole
+ * block. A grain's block is split where its attack ends and its release
+ * begins, so most samples are rendered by a loop that only reads the
+ * source table. Grains that finish are removed at the end of the block by
+ * moving the last grain into their slot.
+ *
+ * Each grain reads a source table, either by a fixed point phase that
+ * wraps every SP_FT_MAXLEN (FOF style), or by a sample position and speed
+ * (FOG style). Its envelope is an attack read forwards through the window
+ * table, an exponential decay applied every sample, and a release read
+ * backwards through the window table over the grain's last samples.
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "soundpipe.h"
+
+int sp_grainpool_create(sp_grainpool **p)
+{
+    *p = malloc(sizeof(sp_grainpool));
+    (*p)->aux.ptr = NULL;
+    (*p)->maxgrains = (*p)->ngrains = 0;
+    return SP_OK;
+}
+
+int sp_grainpool_destroy(sp_grainpool **p)
+{
+    sp_grainpool *pp = *p;
+    sp_auxdata_free(&pp->aux);
+    free(*p);
+    return SP_OK;
+}
+
+int sp_grainpool_init(sp_data *sp, sp_grainpool *p, sp_ftbl *src, sp_ftbl *win,
+    int maxgrains, int mode)
+{
+    char *mem;
+    size_t n;
+
+    if(maxgrains < 1) maxgrains = 1;
+    /* rounded up so every array stays 16 byte aligned */
+    n = (maxgrains + 3) & ~3;
+
+    p->src = src;
+    p->win = win;
+    p->maxgrains = maxgrains;
+    p->ngrains = 0;
+    p->mode = mode;
+
+    /* init again replaces the grains */
+    sp_auxdata_free(&p->aux);
+    sp_auxdata_alloc(&p->aux, n * (8 * sizeof(int32_t) + 4 * sizeof(SPFLOAT)));
+    mem = p->aux.ptr;
+    p->phs = (int32_t *)mem; mem += n * sizeof(int32_t);
+    p->inc = (int32_t *)mem; mem += n * sizeof(int32_t);
+    p->risphs = (uint32_t *)mem; mem += n * sizeof(uint32_t);
+    p->risinc = (int32_t *)mem; mem += n * sizeof(int32_t);
+    p->decphs = (int32_t *)mem; mem += n * sizeof(int32_t);
+    p->decinc = (int32_t *)mem; mem += n * sizeof(int32_t);
+    p->dectim = (int32_t *)mem; mem += n * sizeof(int32_t);
+    p->timrem = (int32_t *)mem; mem += n * sizeof(int32_t);
+    p->pos = (SPFLOAT *)mem; mem += n * sizeof(SPFLOAT);
+    p->speed = (SPFLOAT *)mem; mem += n * sizeof(SPFLOAT);
+    p->curamp = (SPFLOAT *)mem; mem += n * sizeof(SPFLOAT);
+    p->expamp = (SPFLOAT *)mem;
+    return SP_OK;
+}
+
+int sp_grainpool_add(sp_data *sp, sp_grainpool *p, const sp_grain *grain)
+{
+    int g = p->ngrains;
+    SPFLOAT size = p->src->size;
+
+    if(g >= p->maxgrains || grain->dur <= 0) return SP_NOT_OK;
+
+    p->phs[g] = grain->phs & SP_FT_PHMASK;
+    p->inc[g] = grain->inc;
+    /* positions are kept within the table, and speeds within it either way,
+     * so that one addition or subtraction wraps them */
+    p->pos[g] = grain->pos - size * floor(grain->pos / size);
+    p->speed[g] = fmod(grain->speed, size);
+    p->curamp[g] = grain->amp;
+    p->expamp[g] = grain->expamp;
+    p->timrem[g] = grain->dur;
+    p->risphs[g] = grain->risphs;
+    p->risinc[g] = grain->risinc;
+    p->dectim[g] = grain->dectim;
+    p->decinc[g] = grain->dectim > 0 ? grain->decinc : 0;
+    p->decphs[g] = SP_FT_PHMASK;
+    p->ngrains = g + 1;
+    return SP_OK;
+}
+
+static void remove_finished(sp_grainpool *p)
+{
+    int g = 0, last;
+    while(g < p->ngrains) {
+        if(p->timrem[g] > 0) {
+            g++;
+            continue;
+        }
+        last = --p->ngrains;
+        p->phs[g] = p->phs[last];
+        p->inc[g] = p->inc[last];
+        p->pos[g] = p->pos[last];
+        p->speed[g] = p->speed[last];
+        p->curamp[g] = p->curamp[last];
+        p->expamp[g] = p->expamp[last];
+        p->timrem[g] = p->timrem[last];
+        p->risphs[g] = p->risphs[last];
+        p->risinc[g] = p->risinc[last];
+        p->dectim[g] = p->dectim[last];
+        p->decinc[g] = p->decinc[last];
+        p->decphs[g] = p->decphs[last];
+    }
+}
+
+/* renders count samples of one grain, over which it is either rising or not,
+ * and either releasing or not */
+static void render(sp_grainpool *p, int g, SPFLOAT *restrict out, int count,
+    int rising, int releasing)
+{
+    const SPFLOAT *restrict src = p->src->tbl;
+    const SPFLOAT *restrict win = p->win->tbl;
+    const uint32_t slobits = p->src->lobits, slomask = p->src->lomask;
+    const int32_t smaxndx = (int32_t)p->src->size - 1;
+    const SPFLOAT slodiv = p->src->lodiv;
+    const SPFLOAT ssize = p->src->size;
+    const uint32_t wlobits = p->win->lobits;
+    const uint32_t wmaxndx = p->win->size;
+    int32_t phs = p->phs[g], inc = p->inc[g];
+    SPFLOAT pos = p->pos[g], speed = p->speed[g];
+    uint32_t risphs = p->risphs[g];
+    int32_t risinc = p->risinc[g];
+    int32_t decphs = p->decphs[g], decinc = p->decinc[g];
+    SPFLOAT curamp = p->curamp[g], expamp = p->expamp[g];
+    const int mode = p->mode;
+    int t;
+
+    for(t = 0; t < count; t++) {
+        int32_t ndx;
+        SPFLOAT fract, x, env = curamp;
+        if(mode == SP_GRAIN_PHASE) {
+            ndx = (int32_t)((uint32_t)phs >> slobits);
+            fract = (SPFLOAT)(phs & slomask) * slodiv;
+            phs = (phs + inc) & SP_FT_PHMASK;
+        } else {
+            ndx = (int32_t)pos;
+            fract = pos - ndx;
+            pos += speed;
+            pos = pos >= ssize ? pos - ssize : (pos < 0 ? pos + ssize : pos);
+        }
+        ndx = ndx < smaxndx ? ndx : smaxndx;
+        x = src[ndx] + (src[ndx + 1] - src[ndx]) * fract;
+        if(rising) {
+            uint32_t w = risphs >> wlobits;
+            env *= win[w < wmaxndx ? w : wmaxndx];
+            risphs += risinc;
+        }
+        if(releasing) {
+            uint32_t w = (uint32_t)decphs >> wlobits;
+            env *= win[w < wmaxndx ? w : wmaxndx];
+            decphs -= decinc;
+            decphs = decphs < 0 ? 0 : decphs;
+        }
+        out[t] += x * env;
+        curamp *= expamp;
+    }
+
+    p->phs[g] = phs;
+    p->pos[g] = pos;
+    p->risphs[g] = risphs;
+    p->decphs[g] = decphs;
+    p->curamp[g] = curamp;
+    p->timrem[g] -= count;
+}
+
+int sp_grainpool_compute_block(sp_data *sp, sp_grainpool *p, SPFLOAT *out, int nframes)
+{
+    int g;
+
+    memset(out, 0, nframes * sizeof(SPFLOAT));
+
+    for(g = 0; g < p->ngrains; g++) {
+        int t = 0, len = p->timrem[g] < nframes ? p->timrem[g] : nframes;
+        while(t < len) {
+            int32_t timrem = p->timrem[g];
+            int rising = p->risphs[g] < SP_FT_MAXLEN;
+            int releasing = timrem <= p->dectim[g];
+            int count = len - t;
+            /* up to the end of the attack, or the start of the release */
+            if(rising && p->risinc[g] > 0) {
+                int64_t left = ((int64_t)SP_FT_MAXLEN - p->risphs[g] + p->risinc[g] - 1) / p->risinc[g];
+                if(left < count) count = (int)left;
+            }
+            if(!releasing && timrem - p->dectim[g] < count) {
+                count = timrem - p->dectim[g];
+            }
+            render(p, g, out + t, count, rising, releasing);
+            t += count;
+        }
+    }
+
+    remove_finished(p);
+    return SP_OK;
+}
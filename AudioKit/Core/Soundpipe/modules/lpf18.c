@@ -13,6 +13,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include "soundpipe.h"
+#include "fastmath.h"
 
 int sp_lpf18_create(sp_lpf18 **p)
 {
@@ -41,54 +42,48 @@ int sp_lpf18_init(sp_data *sp, sp_lpf18 *p)
 }
 
 int sp_lpf18_compute(sp_data *sp, sp_lpf18 *p, SPFLOAT *in, SPFLOAT *out)
+{
+    return sp_lpf18_compute_block(sp, p, in, out, 1);
+}
+
+/* cutoff, res and dist are read once per block */
+int sp_lpf18_compute_block(sp_data *sp, sp_lpf18 *p, const SPFLOAT *in, SPFLOAT *out, int nframes)
 {
     SPFLOAT ay1 = p->ay1;
     SPFLOAT ay2 = p->ay2;
     SPFLOAT aout = p->aout;
     SPFLOAT lastin = p->lastin;
-    double value = 0.0;
-    int   flag = 1;
-    SPFLOAT lfc=0, lrs=0, kres=0, kfcn=0, kp=0, kp1=0,  kp1h=0;
-    double lds = 0.0;
-
+    SPFLOAT value;
+    SPFLOAT kres, kfcn, kp, kp1, kp1h;
     SPFLOAT fco, res, dist;
-    SPFLOAT ax1  = lastin;
-    SPFLOAT ay11 = ay1;
-    SPFLOAT ay31 = ay2;
+    SPFLOAT ax1, ay11, ay31;
+    int i;
+
     fco = p->cutoff;
     res = p->res;
     dist = p->dist;
 
-    if (fco != lfc || flag) {
-        lfc = fco;
-        kfcn = 2.0 * fco * p->onedsr;
-        kp = ((-2.7528 * kfcn + 3.0429) * kfcn +
-                1.718) * kfcn - 0.9984;
-        kp1 = kp + 1.0;
-        kp1h = 0.5 * kp1;
-        flag = 1;
-    }
+    kfcn = 2.0 * fco * p->onedsr;
+    kp = ((-2.7528 * kfcn + 3.0429) * kfcn +
+            1.718) * kfcn - 0.9984;
+    kp1 = kp + 1.0;
+    kp1h = 0.5 * kp1;
+    kres = res * (((-2.7079 * kp1 + 10.963) * kp1
+                       - 14.934) * kp1 + 8.4974);
+    value = 1.0 + (dist * (1.5 + 2.0 * res * (1.0 - kfcn)));
 
-    if (res != lrs || flag) {
-        lrs = res;
-        kres = res * (((-2.7079 * kp1 + 10.963) * kp1
-                           - 14.934) * kp1 + 8.4974);
-        flag = 1;
-    }
+    for (i = 0; i < nframes; i++) {
+        ax1  = lastin;
+        ay11 = ay1;
+        ay31 = ay2;
+        lastin = in[i] - sp_fast_tanh(kres*aout);
+        ay1 = kp1h * (lastin + ax1) - kp * ay1;
+        ay2 = kp1h * (ay1 + ay11) - kp * ay2;
+        aout = kp1h * (ay2 + ay31) - kp * aout;
 
-    if (dist != lds || flag) {
-        lds = dist;
-        value = 1.0 + (dist * (1.5 + 2.0 * res * (1.0 - kfcn)));
+        out[i] = sp_fast_tanh(aout * value);
     }
 
-    flag = 0;
-    lastin = *in - tanh(kres*aout);
-    ay1 = kp1h * (lastin + ax1) - kp * ay1;
-    ay2 = kp1h * (ay1 + ay11) - kp * ay2;
-    aout = kp1h * (ay2 + ay31) - kp * aout;
-
-    *out = tanh(aout * value);
-
     p->ay1 = ay1;
     p->ay2 = ay2;
     p->aout = aout;
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include "soundpipe.h"
+#include "fastmath.h"
 
 #ifndef M_PI
 #define M_PI		3.14159265358979323846
@@ -21,26 +22,6 @@
 #define SPFLOAT2LONG(x) lrintf(x)
 
 
-/* John ffitch tanh function to speed up inner loop */
-
-static double my_tanh(double x)
-{
-    /* use the fact that tanh(-x) = - tanh(x)
-       and if x>~4 tanh is approx constant 1
-       and for small x tanh(x) =~ x
-       So giving a cheap approximation */
-    int sign = 1;
-    if (x<0) {
-        sign=-1;
-        x= -x;
-    }
-    if (x>=4.0) {
-      return sign;
-    }
-    if (x<0.5) return x*sign;
-    return sign*tanh(x);
-}
-
 int sp_moogladder_create(sp_moogladder **t){
     *t = malloc(sizeof(sp_moogladder));
     return SP_OK;
@@ -69,15 +50,19 @@ int sp_moogladder_init(sp_data *sp, sp_moogladder *p){
 }
 
 int sp_moogladder_compute(sp_data *sp, sp_moogladder *p, SPFLOAT *in, SPFLOAT *out){
+    return sp_moogladder_compute_block(sp, p, in, out, 1);
+}
+
+/* freq and res are read once per block */
+int sp_moogladder_compute_block(sp_data *sp, sp_moogladder *p, const SPFLOAT *in, SPFLOAT *out, int nframes){
     SPFLOAT freq = p->freq;
     SPFLOAT res = p->res;
     SPFLOAT res4;
-    SPFLOAT *delay = p->delay;
-    SPFLOAT *tanhstg = p->tanhstg;
+    SPFLOAT delay[6], tanhstg[3];
     SPFLOAT stg[4], input;
     SPFLOAT acr, tune;
-#define THERMAL (0.000025) /* (1.0 / 40000.0) transistor thermal voltage  */
-    int     j, k;
+#define THERMAL (0.000025f) /* (1.0 / 40000.0) transistor thermal voltage  */
+    int     i, j, k;
 
     if (res < 0) res = 0;
 
@@ -92,7 +77,7 @@ int sp_moogladder_compute(sp_data *sp, sp_moogladder *p, SPFLOAT *in, SPFLOAT *o
         /* frequency & amplitude correction  */
         fcr = 1.8730*fc3 + 0.4955*fc2 - 0.6490*fc + 0.9988;
         acr = -3.9364*fc2 + 1.8409*fc + 0.9968;
-        tune = (1.0 - exp(-((2 * M_PI)*f*fcr))) / THERMAL;   /* filter tuning  */
+        tune = (1.0 - sp_fast_exp(-((2 * M_PI)*f*fcr))) / THERMAL;   /* filter tuning  */
         p->oldres = res;
         p->oldacr = acr;
         p->oldtune = tune;
@@ -103,22 +88,31 @@ int sp_moogladder_compute(sp_data *sp, sp_moogladder *p, SPFLOAT *in, SPFLOAT *o
     }
     res4 = 4.0*(SPFLOAT)res*acr;
 
-    /* oversampling  */
-    for (j = 0; j < 2; j++) {
-        /* filter stages  */
-        input = *in - res4 /*4.0*res*acr*/ *delay[5];
-        delay[0] = stg[0] = delay[0] + tune*(my_tanh(input*THERMAL) - tanhstg[0]);
-        for (k = 1; k < 4; k++) {
-          input = stg[k-1];
-          stg[k] = delay[k]
-            + tune*((tanhstg[k-1] = my_tanh(input*THERMAL))
-                    - (k != 3 ? tanhstg[k] : my_tanh(delay[k]*THERMAL)));
-          delay[k] = stg[k];
+    /* state in locals for the block, so the compiler can keep it in registers */
+    for (k = 0; k < 6; k++) delay[k] = p->delay[k];
+    for (k = 0; k < 3; k++) tanhstg[k] = p->tanhstg[k];
+
+    for (i = 0; i < nframes; i++) {
+        /* oversampling  */
+        for (j = 0; j < 2; j++) {
+            /* filter stages  */
+            input = in[i] - res4 /*4.0*res*acr*/ *delay[5];
+            delay[0] = stg[0] = delay[0] + tune*(sp_fast_tanh(input*THERMAL) - tanhstg[0]);
+            for (k = 1; k < 4; k++) {
+              input = stg[k-1];
+              stg[k] = delay[k]
+                + tune*((tanhstg[k-1] = sp_fast_tanh(input*THERMAL))
+                        - (k != 3 ? tanhstg[k] : sp_fast_tanh(delay[k]*THERMAL)));
+              delay[k] = stg[k];
+            }
+            /* 1/2-sample delay for phase compensation  */
+            delay[5] = (stg[3] + delay[4])*0.5;
+            delay[4] = stg[3];
         }
-        /* 1/2-sample delay for phase compensation  */
-        delay[5] = (stg[3] + delay[4])*0.5;
-        delay[4] = stg[3];
+        out[i] = (SPFLOAT) delay[5];
     }
-    *out = (SPFLOAT) delay[5];
+
+    for (k = 0; k < 6; k++) p->delay[k] = delay[k];
+    for (k = 0; k < 3; k++) p->tanhstg[k] = tanhstg[k];
     return SP_OK;
 }
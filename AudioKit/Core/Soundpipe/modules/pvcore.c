@@ -0,0 +1,384 @@
+/*
+ * pvcore
+ *
+ * The phase-locked vocoder at the heart of mincer, for any number of
+ * channels reading the same position in their own tables.
+ *
+ * Each hop takes two windowed frames a hop apart from every table, and
+ * gives the front frame the phase it would have had if it had followed on
+ * from the previous output frame. Everything stays in cartesian form: the
+ * phase difference is a unit complex number, so no bin ever goes through
+ * atan2 or sincos, and the per bin loops have no branches.
+ *
+ * Channels are locked jointly: the phase advance of each bin is worked out
+ * once from all the channels together, weighted by their magnitudes, and
+ * applied to every channel, so the phase differences between channels (the
+ * stereo image) come through untouched.
+ *
+ * Windows and FFT tables only depend on the window size, so they are built
+ * once and shared by every instance using that size.
+ *
+ * sp_pvcore_render runs the vocoder over a whole table offline, splitting
+ * the output into chunks rendered on separate threads. Each chunk starts a
+ * few windows early, so its phases have settled by the time its output is
+ * used, and is crossfaded over one window into the chunk after it.
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "soundpipe.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct sp_pvshared {
+    int N, refs;
+    SPFLOAT *win;
+    sp_fft fft;
+    struct sp_pvshared *next;
+} sp_pvshared;
+
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static sp_pvshared *shared_list = NULL;
+
+static int find_power(int n) {
+    int pow = -1;
+    while(n > 0) {
+        n >>= 1;
+        pow++;
+    }
+    return pow;
+}
+
+static sp_pvshared *shared_get(int N)
+{
+    sp_pvshared *s;
+    int i;
+
+    pthread_mutex_lock(&shared_lock);
+    for(s = shared_list; s != NULL; s = s->next) {
+        if(s->N == N) break;
+    }
+    if(s == NULL) {
+        s = malloc(sizeof(sp_pvshared));
+        s->N = N;
+        s->refs = 0;
+        s->win = malloc(N * sizeof(SPFLOAT));
+        for(i = 0; i < N; i++) s->win[i] = 0.5 - 0.5 * cos(i * 2.0 * M_PI / N);
+        sp_fft_init(&s->fft, find_power(N));
+        s->next = shared_list;
+        shared_list = s;
+    }
+    s->refs++;
+    pthread_mutex_unlock(&shared_lock);
+    return s;
+}
+
+static void shared_release(sp_pvshared *s)
+{
+    sp_pvshared **link;
+
+    pthread_mutex_lock(&shared_lock);
+    if(--s->refs == 0) {
+        for(link = &shared_list; *link != s; link = &(*link)->next);
+        *link = s->next;
+        sp_fft_destroy(&s->fft);
+        free(s->win);
+        free(s);
+    }
+    pthread_mutex_unlock(&shared_lock);
+}
+
+int sp_pvcore_create(sp_pvcore **p)
+{
+    *p = malloc(sizeof(sp_pvcore));
+    (*p)->shared = NULL;
+    return SP_OK;
+}
+
+int sp_pvcore_destroy(sp_pvcore **p)
+{
+    sp_pvcore *pp = *p;
+    if(pp->shared != NULL) {
+        shared_release(pp->shared);
+        sp_auxdata_free(&pp->aux);
+    }
+    free(*p);
+    return SP_OK;
+}
+
+int sp_pvcore_init(sp_data *sp, sp_pvcore *p, sp_ftbl **ft, int nchan, int winsize)
+{
+    int N = winsize, decim = 4, c, k;
+    size_t bins = N + 2;
+    SPFLOAT *mem;
+
+    if(nchan < 1 || nchan > SP_PVCORE_MAXCHAN) return SP_NOT_OK;
+
+    if(p->shared != NULL) {
+        shared_release(p->shared);
+        sp_auxdata_free(&p->aux);
+    }
+    p->shared = shared_get(N);
+
+    p->N = N;
+    p->decim = decim;
+    p->hsize = N / decim;
+    p->cnt = p->hsize;
+    p->curframe = 0;
+    p->nchan = nchan;
+    p->time = 0;
+    p->pitch = 1;
+    p->lock = 1;
+
+    sp_auxdata_alloc(&p->aux,
+        (nchan * (3 * bins + decim * N) + 2 * bins) * sizeof(SPFLOAT) +
+        decim * sizeof(int));
+    mem = p->aux.ptr;
+    for(c = 0; c < nchan; c++) {
+        p->ft[c] = ft[c];
+        p->fwin[c] = mem; mem += bins;
+        p->bwin[c] = mem; mem += bins;
+        p->prev[c] = mem; mem += bins;
+        p->outframe[c] = mem; mem += decim * N;
+    }
+    p->ref = mem; mem += bins;
+    p->lck = mem; mem += bins;
+    p->framecount = (int *)mem;
+    for(k = 0; k < decim; k++) p->framecount[k] = k * N;
+    return SP_OK;
+}
+
+static SPFLOAT readtab(const SPFLOAT *tab, int size, SPFLOAT pos)
+{
+    int post = (int)floor(pos);
+    SPFLOAT frac = pos - post;
+    post %= size;
+    if(post < 0) post += size;
+    if(post + 1 < size) return tab[post] + frac * (tab[post + 1] - tab[post]);
+    return tab[post];
+}
+
+/* a new output frame, for every channel */
+static void hop(sp_data *sp, sp_pvcore *p)
+{
+    const int N = p->N, hsize = p->hsize, nbins = N / 2 + 1;
+    const SPFLOAT *win = p->shared->win;
+    const SPFLOAT pitch = p->pitch;
+    sp_fft *fft = &p->shared->fft;
+    SPFLOAT *restrict ref = p->ref, *restrict lck = p->lck;
+    int size = (int)p->ft[0]->size;
+    long spos;
+    int c, i, k;
+
+    /* reading position in samples, a whole number of hops */
+    spos = hsize * (long)(p->time * sp->sr / hsize);
+    while(spos > size) spos -= size;
+    while(spos <= 0) spos += size;
+
+    /* front and back frames, one hop apart, then their spectra,
+     * with the Nyquist bin moved from 1 to N */
+    for(c = 0; c < p->nchan; c++) {
+        const SPFLOAT *tab = p->ft[c]->tbl;
+        SPFLOAT *fwin = p->fwin[c], *bwin = p->bwin[c];
+        SPFLOAT pos = spos;
+        for(i = 0; i < N; i++) {
+            fwin[i] = readtab(tab, size, pos) * win[i];
+            bwin[i] = readtab(tab, size, pos - hsize * pitch) * win[i];
+            pos += pitch;
+        }
+        sp_fftr(fft, bwin, N);
+        bwin[N] = bwin[1];
+        bwin[N + 1] = 0.0;
+        sp_fftr(fft, fwin, N);
+        fwin[N] = fwin[1];
+        fwin[N + 1] = 0.0;
+    }
+
+    /* each bin's phase advance, from the previous output frame to the back
+     * frame, summed over the channels */
+    memset(ref, 0, 2 * nbins * sizeof(SPFLOAT));
+    for(c = 0; c < p->nchan; c++) {
+        const SPFLOAT *restrict bwin = p->bwin[c], *restrict prev = p->prev[c];
+        for(k = 0; k < nbins; k++) {
+            SPFLOAT pr = prev[2 * k], pi = prev[2 * k + 1];
+            SPFLOAT br = bwin[2 * k], bi = bwin[2 * k + 1];
+            SPFLOAT divi = 1.0f / (sqrtf(pr * pr + pi * pi) + 1e-20f);
+            pr *= divi;
+            pi *= divi;
+            ref[2 * k] += br * pr + bi * pi;
+            ref[2 * k + 1] += br * pi - bi * pr;
+        }
+    }
+
+    /* phase locking: each bin follows the sum of itself and its neighbours */
+    if(p->lock) {
+        lck[0] = ref[0] + ref[2];
+        lck[1] = 0;
+        for(k = 1; k < nbins - 1; k++) {
+            lck[2 * k] = ref[2 * k - 2] + ref[2 * k] + ref[2 * k + 2];
+            lck[2 * k + 1] = ref[2 * k - 1] + ref[2 * k + 1] + ref[2 * k + 3];
+        }
+        lck[N] = ref[N] + ref[N - 2];
+        lck[N + 1] = 0;
+    } else {
+        memcpy(lck, ref, 2 * nbins * sizeof(SPFLOAT));
+    }
+
+    /* as unit phasors */
+    for(k = 0; k < nbins; k++) {
+        SPFLOAT re = lck[2 * k] + 1e-15f, im = lck[2 * k + 1];
+        SPFLOAT divi = 1.0f / sqrtf(re * re + im * im);
+        lck[2 * k] = re * divi;
+        lck[2 * k + 1] = im * divi;
+    }
+
+    /* front frames advanced by those phases are the output, and the
+     * reference for the next hop */
+    for(c = 0; c < p->nchan; c++) {
+        SPFLOAT *restrict fwin = p->fwin[c], *restrict prev = p->prev[c];
+        SPFLOAT *restrict outframe = p->outframe[c] + p->curframe * N;
+        for(k = 0; k < nbins; k++) {
+            SPFLOAT fr = fwin[2 * k], fi = fwin[2 * k + 1];
+            SPFLOAT lr = lck[2 * k], li = lck[2 * k + 1];
+            prev[2 * k] = fwin[2 * k] = fr * lr - fi * li;
+            prev[2 * k + 1] = fwin[2 * k + 1] = fr * li + fi * lr;
+        }
+        fwin[1] = fwin[N];
+        sp_ifftr(fft, fwin, N);
+        for(i = 0; i < N; i++) outframe[i] = win[i] * fwin[i];
+    }
+
+    p->framecount[p->curframe] = p->curframe * N;
+    p->cnt = 0;
+    if(++p->curframe == p->decim) p->curframe = 0;
+}
+
+int sp_pvcore_compute(sp_data *sp, sp_pvcore *p, SPFLOAT *out)
+{
+    const SPFLOAT scaling = (8.0 / p->decim) / 3.0;
+    int c, i;
+
+    if(p->cnt == p->hsize) hop(sp, p);
+
+    for(c = 0; c < p->nchan; c++) {
+        SPFLOAT sum = 0;
+        for(i = 0; i < p->decim; i++) sum += p->outframe[c][p->framecount[i]];
+        out[c] = sum * scaling;
+    }
+    for(i = 0; i < p->decim; i++) p->framecount[i]++;
+    p->cnt++;
+    return SP_OK;
+}
+
+typedef struct {
+    sp_data *sp;
+    sp_ftbl **ft;
+    int nchan, winsize, lock;
+    SPFLOAT start, speed, pitch;
+    SPFLOAT **out;
+    /* frames [first, last) are written to out, then the next xfade frames to tail */
+    int from, first, last, xfade;
+    SPFLOAT *tail;
+    int threaded;
+} render_chunk;
+
+static void *render_thread(void *arg)
+{
+    render_chunk *ch = arg;
+    sp_pvcore *pv;
+    SPFLOAT frame[SP_PVCORE_MAXCHAN];
+    int t, c;
+
+    sp_pvcore_create(&pv);
+    sp_pvcore_init(ch->sp, pv, ch->ft, ch->nchan, ch->winsize);
+    pv->pitch = ch->pitch;
+    pv->lock = ch->lock;
+    for(t = ch->from; t < ch->last + ch->xfade; t++) {
+        pv->time = ch->start + ch->speed * t / ch->sp->sr;
+        sp_pvcore_compute(ch->sp, pv, frame);
+        if(t < ch->first) continue;
+        for(c = 0; c < ch->nchan; c++) {
+            if(t < ch->last) ch->out[c][t] = frame[c];
+            else ch->tail[c * ch->xfade + t - ch->last] = frame[c];
+        }
+    }
+    sp_pvcore_destroy(&pv);
+    return NULL;
+}
+
+int sp_pvcore_render(sp_data *sp, sp_ftbl **ft, int nchan, int winsize,
+    SPFLOAT start, SPFLOAT speed, SPFLOAT pitch, int lock,
+    SPFLOAT **out, int nframes, int nthreads)
+{
+    const int hsize = winsize / 4, xfade = winsize, warmup = 2 * winsize;
+    render_chunk *chunks;
+    pthread_t *threads;
+    int nchunks, len, k, c, j;
+
+    if(nchan < 1 || nchan > SP_PVCORE_MAXCHAN) return SP_NOT_OK;
+
+    /* chunks are whole hops, and long enough that the warmup and crossfade
+     * are a small part of them */
+    nchunks = nframes / (8 * winsize);
+    if(nchunks > nthreads) nchunks = nthreads;
+    if(nchunks < 1) nchunks = 1;
+    len = (nframes / nchunks + hsize - 1) / hsize * hsize;
+    if(len < hsize) len = hsize;
+    nchunks = (nframes + len - 1) / len;
+    if(nchunks < 1) nchunks = 1;
+
+    chunks = calloc(nchunks, sizeof(render_chunk));
+    threads = calloc(nchunks, sizeof(pthread_t));
+    for(k = 0; k < nchunks; k++) {
+        render_chunk *ch = &chunks[k];
+        ch->sp = sp;
+        ch->ft = ft;
+        ch->nchan = nchan;
+        ch->winsize = winsize;
+        ch->lock = lock;
+        ch->start = start;
+        ch->speed = speed;
+        ch->pitch = pitch;
+        ch->out = out;
+        ch->first = k * len;
+        ch->last = k == nchunks - 1 ? nframes : (k + 1) * len;
+        ch->from = ch->first > warmup ? ch->first - warmup : 0;
+        ch->xfade = k == nchunks - 1 ? 0 : xfade;
+        if(ch->xfade > 0) ch->tail = malloc(nchan * xfade * sizeof(SPFLOAT));
+    }
+
+    /* the first chunk is rendered on the calling thread, and any chunk
+     * that can't have a thread of its own after it */
+    for(k = 1; k < nchunks; k++) {
+        chunks[k].threaded =
+            pthread_create(&threads[k], NULL, render_thread, &chunks[k]) == 0;
+    }
+    render_thread(&chunks[0]);
+    for(k = 1; k < nchunks; k++) {
+        if(chunks[k].threaded) pthread_join(threads[k], NULL);
+        else render_thread(&chunks[k]);
+    }
+
+    /* each chunk's tail fades into the start of the next, at equal power
+     * since their phases are unrelated */
+    for(k = 0; k < nchunks - 1; k++) {
+        int first = chunks[k + 1].first;
+        for(c = 0; c < nchan; c++) {
+            for(j = 0; j < xfade && first + j < nframes; j++) {
+                SPFLOAT w = (j + 0.5) * M_PI / (2 * xfade);
+                out[c][first + j] = cos(w) * chunks[k].tail[c * xfade + j] +
+                    sin(w) * out[c][first + j];
+            }
+        }
+        free(chunks[k].tail);
+    }
+
+    free(threads);
+    free(chunks);
+    return SP_OK;
+}
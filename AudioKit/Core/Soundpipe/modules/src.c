@@ -0,0 +1,403 @@
+/*
+ * src
+ *
+ * Sample rate conversion with a windowed-sinc polyphase filter bank, for
+ * files loaded at one rate and played at another, converted once at load
+ * time or streamed a block at a time.
+ *
+ * When both rates are whole numbers whose ratio reduces to L / M with L no
+ * larger than SP_SRC_MAXPHASES, the bank has one phase for each of the L
+ * output positions between two input samples and the read position steps
+ * exactly, M / L input samples per output sample. Any other ratio uses a
+ * bank of SP_SRC_MAXPHASES phases, interpolating linearly between the two
+ * phases either side of the read position.
+ *
+ * Each phase is a Kaiser windowed sinc with its cutoff below the lower of
+ * the two Nyquist frequencies, normalized to unity gain at DC. The quality
+ * presets trade its length, and so its cost, against its stopband and how
+ * close the passband reaches to Nyquist.
+ *
+ * Banks only depend on the preset, the number of phases and the cutoff, so
+ * they are kept in a list shared by every instance converting between the
+ * same rates.
+ *
+ * Output sample n is the input read at time n * inrate / outrate, so
+ * converted files line up with the originals. A stream's output lags its
+ * input by half the filter length: sp_src_needed gives how much input has
+ * to be supplied for a block of output, and a NULL input pushes silence to
+ * flush the end of a file through.
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "soundpipe.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* input frames buffered per channel beyond the filter length */
+#define SRC_CHUNK 512
+
+typedef struct sp_src_bank {
+    int quality, nphases, taps, refs;
+    double cutoff;
+    /* nphases + 1 phases of taps coefficients each; the last is the first
+     * one delayed by a sample, so interpolation never wraps */
+    SPFLOAT *coefs;
+    struct sp_src_bank *next;
+} sp_src_bank;
+
+static const struct {
+    int taps;
+    double beta, rolloff;
+} presets[] = {
+    /* about 60, 85 and 100 dB of stopband */
+    { 16, 6.0, 0.77 },
+    { 64, 8.6, 0.91 },
+    { 128, 10.0, 0.95 },
+};
+
+static pthread_mutex_t bank_lock = PTHREAD_MUTEX_INITIALIZER;
+static sp_src_bank *bank_list = NULL;
+
+static double bessel_i0(double x)
+{
+    double sum = 1, term = 1, q = x * x / 4;
+    int k;
+    for(k = 1; k < 50 && term > sum * 1e-12; k++) {
+        term *= q / ((double)k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+static sp_src_bank *bank_build(int quality, int nphases, double cutoff)
+{
+    int taps = presets[quality].taps, half = taps / 2, ph, k;
+    double beta = presets[quality].beta, norm = 1 / bessel_i0(beta);
+    sp_src_bank *b;
+
+    b = malloc(sizeof(sp_src_bank));
+    if(b == NULL) return NULL;
+    b->coefs = malloc(sizeof(SPFLOAT) * (nphases + 1) * taps);
+    if(b->coefs == NULL) {
+        free(b);
+        return NULL;
+    }
+    b->quality = quality;
+    b->nphases = nphases;
+    b->taps = taps;
+    b->cutoff = cutoff;
+    b->refs = 0;
+
+    for(ph = 0; ph <= nphases; ph++) {
+        SPFLOAT *row = b->coefs + (size_t)ph * taps;
+        double sum = 0;
+        for(k = 0; k < taps; k++) {
+            /* distance from tap k to the read position, in input samples */
+            double d = half - 1 + (double)ph / nphases - k;
+            double x = d / half, w, s;
+            w = x * x < 1 ? bessel_i0(beta * sqrt(1 - x * x)) * norm : 0;
+            s = d == 0 ? cutoff : sin(M_PI * cutoff * d) / (M_PI * d);
+            row[k] = s * w;
+            sum += row[k];
+        }
+        for(k = 0; k < taps; k++) row[k] /= sum;
+    }
+    return b;
+}
+
+/* must be called with bank_lock held */
+static sp_src_bank *bank_find(int quality, int nphases, double cutoff)
+{
+    sp_src_bank *b;
+    for(b = bank_list; b != NULL; b = b->next) {
+        if(b->quality == quality && b->nphases == nphases && b->cutoff == cutoff)
+            return b;
+    }
+    return NULL;
+}
+
+static sp_src_bank *bank_acquire(int quality, int nphases, double cutoff)
+{
+    sp_src_bank *b, *built;
+
+    pthread_mutex_lock(&bank_lock);
+    b = bank_find(quality, nphases, cutoff);
+    if(b != NULL) b->refs++;
+    pthread_mutex_unlock(&bank_lock);
+    if(b != NULL) return b;
+
+    /* built without the lock; if another instance got there first, its
+     * bank is used */
+    built = bank_build(quality, nphases, cutoff);
+    if(built == NULL) return NULL;
+
+    pthread_mutex_lock(&bank_lock);
+    b = bank_find(quality, nphases, cutoff);
+    if(b == NULL) {
+        b = built;
+        b->next = bank_list;
+        bank_list = b;
+    }
+    b->refs++;
+    pthread_mutex_unlock(&bank_lock);
+
+    if(b != built) {
+        free(built->coefs);
+        free(built);
+    }
+    return b;
+}
+
+static void bank_release(sp_src_bank *b)
+{
+    sp_src_bank **link;
+
+    pthread_mutex_lock(&bank_lock);
+    if(--b->refs == 0) {
+        for(link = &bank_list; *link != b; link = &(*link)->next);
+        *link = b->next;
+        free(b->coefs);
+        free(b);
+    }
+    pthread_mutex_unlock(&bank_lock);
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b)
+{
+    while(b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+int sp_src_create(sp_src **p)
+{
+    *p = malloc(sizeof(sp_src));
+    (*p)->bank = NULL;
+    return SP_OK;
+}
+
+int sp_src_destroy(sp_src **p)
+{
+    sp_src *pp = *p;
+    if(pp->bank != NULL) {
+        bank_release(pp->bank);
+        sp_auxdata_free(&pp->aux);
+    }
+    free(*p);
+    return SP_OK;
+}
+
+int sp_src_init(sp_data *sp, sp_src *p, SPFLOAT inrate, SPFLOAT outrate,
+    int nchan, int quality)
+{
+    double ratio, cutoff;
+    int nphases, c;
+
+    if(nchan < 1 || nchan > SP_SRC_MAXCHAN ||
+        !(inrate > 0) || !(outrate > 0)) {
+        return SP_NOT_OK;
+    }
+    if(quality < SP_SRC_FAST) quality = SP_SRC_FAST;
+    if(quality > SP_SRC_BEST) quality = SP_SRC_BEST;
+
+    if(p->bank != NULL) {
+        bank_release(p->bank);
+        sp_auxdata_free(&p->aux);
+        p->bank = NULL;
+    }
+
+    ratio = (double)outrate / inrate;
+    p->rational = 0;
+    if(inrate == floor(inrate) && outrate == floor(outrate)) {
+        uint64_t g = gcd((uint64_t)inrate, (uint64_t)outrate);
+        uint64_t L = (uint64_t)outrate / g, M = (uint64_t)inrate / g;
+        if(L <= SP_SRC_MAXPHASES && M <= UINT32_MAX / 2) {
+            p->rational = 1;
+            p->L = (uint32_t)L;
+            p->M = (uint32_t)M;
+        }
+    }
+    nphases = p->rational ? (int)p->L : SP_SRC_MAXPHASES;
+    cutoff = (ratio < 1 ? ratio : 1) * presets[quality].rolloff;
+
+    p->bank = bank_acquire(quality, nphases, cutoff);
+    if(p->bank == NULL) return SP_NOT_OK;
+
+    p->nchan = nchan;
+    p->taps = p->bank->taps;
+    p->step = 1 / ratio;
+    p->size = p->taps + SRC_CHUNK;
+    sp_auxdata_alloc(&p->aux, sizeof(SPFLOAT) * p->size * nchan);
+    for(c = 0; c < nchan; c++) {
+        p->buf[c] = (SPFLOAT *)p->aux.ptr + (size_t)c * p->size;
+    }
+    sp_src_reset(sp, p);
+    return SP_OK;
+}
+
+int sp_src_reset(sp_data *sp, sp_src *p)
+{
+    int c;
+    /* the first output reads input time 0, with silence before it */
+    p->fill = p->taps / 2 - 1;
+    for(c = 0; c < p->nchan; c++) {
+        memset(p->buf[c], 0, sizeof(SPFLOAT) * p->fill);
+    }
+    p->pos = 0;
+    p->phase = 0;
+    p->frac = 0;
+    return SP_OK;
+}
+
+int sp_src_needed(sp_src *p, int nout)
+{
+    int64_t last;
+    if(nout < 1) return 0;
+    if(p->rational) {
+        last = p->pos + ((uint64_t)p->phase + (uint64_t)(nout - 1) * p->M) / p->L;
+    } else {
+        last = p->pos + (int64_t)floor(p->frac + (nout - 1) * p->step);
+    }
+    last += p->taps - p->fill;
+    return last > 0 ? (int)last : 0;
+}
+
+/* four partial sums, so the loop vectorizes without reassociating */
+static inline SPFLOAT dot(const SPFLOAT *restrict h, const SPFLOAT *restrict x,
+    int taps)
+{
+    SPFLOAT s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int k;
+    for(k = 0; k < taps; k += 4) {
+        s0 += h[k] * x[k];
+        s1 += h[k + 1] * x[k + 1];
+        s2 += h[k + 2] * x[k + 2];
+        s3 += h[k + 3] * x[k + 3];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+/* computes outputs until the filter runs past the buffered input */
+static int render(sp_src *p, SPFLOAT **out, int offset, int nout)
+{
+    const SPFLOAT *coefs = p->bank->coefs;
+    const int taps = p->taps, nchan = p->nchan;
+    int n = offset, c;
+
+    if(p->rational) {
+        const uint32_t L = p->L, M = p->M;
+        for(; n < nout && p->pos + taps <= p->fill; n++) {
+            const SPFLOAT *h = coefs + (size_t)p->phase * taps;
+            for(c = 0; c < nchan; c++) {
+                out[c][n] = dot(h, p->buf[c] + p->pos, taps);
+            }
+            p->phase += M;
+            p->pos += p->phase / L;
+            p->phase %= L;
+        }
+    } else {
+        const int nphases = p->bank->nphases;
+        for(; n < nout && p->pos + taps <= p->fill; n++) {
+            double f = p->frac * nphases;
+            int ph = (int)f;
+            SPFLOAT w = f - ph;
+            const SPFLOAT *h = coefs + (size_t)ph * taps;
+            for(c = 0; c < nchan; c++) {
+                SPFLOAT a = dot(h, p->buf[c] + p->pos, taps);
+                SPFLOAT b = dot(h + taps, p->buf[c] + p->pos, taps);
+                out[c][n] = a + w * (b - a);
+            }
+            p->frac += p->step;
+            f = floor(p->frac);
+            p->pos += (int)f;
+            p->frac -= f;
+        }
+    }
+    return n;
+}
+
+int sp_src_compute_block(sp_data *sp, sp_src *p, SPFLOAT **in, int nin,
+    SPFLOAT **out, int nout, int *inused, int *outmade)
+{
+    int used = 0, made = 0, c, k, n;
+
+    for(;;) {
+        made = render(p, out, made, nout);
+        if(made >= nout || used >= nin) break;
+
+        /* drop what the read position has passed, then skip any input it
+         * has passed without it being buffered */
+        k = p->pos < p->fill ? p->pos : p->fill;
+        if(k > 0) {
+            for(c = 0; c < p->nchan; c++) {
+                memmove(p->buf[c], p->buf[c] + k,
+                    sizeof(SPFLOAT) * (p->fill - k));
+            }
+            p->pos -= k;
+            p->fill -= k;
+        }
+        if(p->pos > 0) {
+            n = nin - used < p->pos ? nin - used : p->pos;
+            used += n;
+            p->pos -= n;
+            if(used >= nin) break;
+        }
+
+        n = p->size - p->fill;
+        if(n > nin - used) n = nin - used;
+        for(c = 0; c < p->nchan; c++) {
+            if(in != NULL) {
+                memcpy(p->buf[c] + p->fill, in[c] + used, sizeof(SPFLOAT) * n);
+            } else {
+                memset(p->buf[c] + p->fill, 0, sizeof(SPFLOAT) * n);
+            }
+        }
+        p->fill += n;
+        used += n;
+    }
+
+    if(inused != NULL) *inused = used;
+    if(outmade != NULL) *outmade = made;
+    return SP_OK;
+}
+
+int sp_src_convert(sp_data *sp, SPFLOAT **in, int nin, SPFLOAT inrate,
+    SPFLOAT **out, int nout, SPFLOAT outrate, int nchan, int quality)
+{
+    sp_src *src;
+    int used, made, total = 0, c;
+    SPFLOAT *i[SP_SRC_MAXCHAN], *o[SP_SRC_MAXCHAN];
+
+    sp_src_create(&src);
+    if(sp_src_init(sp, src, inrate, outrate, nchan, quality) != SP_OK) {
+        sp_src_destroy(&src);
+        return SP_NOT_OK;
+    }
+
+    for(c = 0; c < nchan; c++) i[c] = in[c];
+    while(total < nout) {
+        for(c = 0; c < nchan; c++) o[c] = out[c] + total;
+        if(nin > 0) {
+            sp_src_compute_block(sp, src, i, nin, o, nout - total, &used, &made);
+            for(c = 0; c < nchan; c++) i[c] += used;
+            nin -= used;
+        } else {
+            /* past the end of the input, the filter is fed silence */
+            sp_src_compute_block(sp, src, NULL, sp_src_needed(src, nout - total),
+                o, nout - total, &used, &made);
+        }
+        total += made;
+    }
+
+    sp_src_destroy(&src);
+    return SP_OK;
+}
@@ -21,6 +21,7 @@
 #endif
 
 #include "soundpipe.h"
+#include "fastmath.h"
 
 int sp_tbvcf_create(sp_tbvcf **p)
 {
@@ -55,57 +56,44 @@ int sp_tbvcf_init(sp_data *sp, sp_tbvcf *p)
     return SP_OK;
 }
 
-/* TODO: clean up code here. */
 int sp_tbvcf_compute(sp_data *sp, sp_tbvcf *p, SPFLOAT *in, SPFLOAT *out)
+{
+    return sp_tbvcf_compute_block(sp, p, in, out, 1);
+}
+
+/* fco, res, dist and asym are read once per block */
+int sp_tbvcf_compute_block(sp_data *sp, sp_tbvcf *p, const SPFLOAT *in, SPFLOAT *out, int nframes)
 {
     SPFLOAT x;
     SPFLOAT fco, res, dist, asym;
     SPFLOAT y = p->y, y1 = p->y1, y2 = p->y2;
-    /* The initialisations are fake to fool compiler warnings */
     SPFLOAT ih, fdbk, d, ad;
-    SPFLOAT fc=0.0, fco1=0.0, q=0.0, q1=0.0;
+    SPFLOAT fc, fco1, q, q1, gain;
+    int i;
 
     ih  = 0.001; /* ih is the incremental factor */
 
- /* Set up the pointers
-    fcoptr  = p->fco;
-    resptr  = p->res;
-    distptr = p->dist;
-    asymptr = p->asym; */
-
- /* Get the values for the k-rate variables
-    fco  = (SPFLOAT)*fcoptr;
-    res  = (SPFLOAT)*resptr;
-    dist = (SPFLOAT)*distptr;
-    asym = (SPFLOAT)*asymptr; */
-
-    /* This should work in sp world */
     fco = p->fco;
     res = p->res;
     dist = p->dist;
     asym = p->asym;
 
- /* Try to decouple the variables */
-    if ((p->rezcod==0) && (p->fcocod==0)) { /* Calc once only */
-        q1   = res/(1.0 + sqrt(dist));
-        fco1 = pow(fco*260.0/(1.0+q1*0.5),0.58);
-        q    = q1*fco1*fco1*0.0005;
-        fc   = fco1*p->onedsr*(p->sr/8.0);
-    }
-    if ((p->rezcod!=0) || (p->fcocod!=0)) {
-        q1  = res/(1.0 + sqrt(dist));
-        fco1 = pow(fco*260.0/(1.0+q1*0.5),0.58);
-        q  = q1*fco1*fco1*0.0005;
-        fc  = fco1*p->onedsr*(p->sr/8.0);
+    q1   = res/(1.0 + sqrt(dist));
+    fco1 = sp_fast_pow(fco*260.0/(1.0+q1*0.5),0.58);
+    q    = q1*fco1*fco1*0.0005;
+    fc   = fco1*p->onedsr*(p->sr/8.0);
+    gain = fc/1000.0*(1.0 + q1)*3.2;
+
+    for (i = 0; i < nframes; i++) {
+        x  = in[i];
+        fdbk = q*y/(1.0 + sp_fast_exp(-3.0*y)*asym);
+        y1  = y1 + ih*((x - y1)*fc - fdbk);
+        d  = -0.1*y*20.0;
+        ad  = (d*d*d + y2)*100.0*dist;
+        y2  = y2 + ih*((y1 - y2)*fc + ad);
+        y  = y + ih*((y2 - y)*fc);
+        out[i] = y*gain;
     }
-    x  = *in;
-    fdbk = q*y/(1.0 + exp(-3.0*y)*asym);
-    y1  = y1 + ih*((x - y1)*fc - fdbk);
-    d  = -0.1*y*20.0;
-    ad  = (d*d*d + y2)*100.0*dist;
-    y2  = y2 + ih*((y1 - y2)*fc + ad);
-    y  = y + ih*((y2 - y)*fc);
-    *out = (y*fc/1000.0*(1.0 + q1)*3.2);
 
     p->y = y; p->y1 = y1; p->y2 = y2;
     return SP_OK;
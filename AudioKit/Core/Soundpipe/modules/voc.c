@@ -1,4 +1,19 @@
-
+/*
+ * voc
+ *
+ * Pink Trombone's glottis and vocal tract. The tract is a Kelly-Lochbaum
+ * waveguide: 44 oral and 28 nasal segments, scattering at each junction
+ * between them, stepped twice per sample.
+ *
+ * The scattering state is kept segment major, element i of lane v at
+ * i * W + v, for W tracts at once, and each step writes into the other half
+ * of a pair of buffers instead of going through junction arrays. One
+ * voice (W = 1) vectorizes along its segments. sp_voc_compute_voices
+ * renders voices whose 512 sample blocks start together in lockstep,
+ * VOC_LANES at a time, each SIMD lane a different voice, so a choir costs
+ * less per voice than the voices rendered one by one.
+ *
+ */
 
 #include <stdlib.h>
 #include <math.h>
@@ -21,6 +36,18 @@
 
 #define MAX_TRANSIENTS 4
 
+/* voices rendered in lockstep */
+#define VOC_LANES 4
+
+/* the damping of the oral tract at every step */
+#define VOC_DAMPING ((SPFLOAT)0.999)
+
+#if defined(__GNUC__)
+#define VOC_INLINE static inline __attribute__((always_inline))
+#else
+#define VOC_INLINE static inline
+#endif
+
 
 
 typedef struct {
@@ -71,12 +98,12 @@ typedef struct {
     SPFLOAT  rest_diameter[44];
     SPFLOAT  target_diameter[44];
     SPFLOAT  new_diameter[44];
-    SPFLOAT  R[44];
-    SPFLOAT  L[44];
+    /* right and left going waves, read from [cur] and written to [!cur] */
+    SPFLOAT  R[2][44];
+    SPFLOAT  L[2][44];
+    int cur;
     SPFLOAT  reflection[45];
     SPFLOAT  new_reflection[45];
-    SPFLOAT  junction_outL[45];
-    SPFLOAT  junction_outR[45];
     SPFLOAT  A[44];
 
     int nose_length;
@@ -85,10 +112,8 @@ typedef struct {
     int nose_start;
 
     int tip_start;
-    SPFLOAT  noseL[28];
-    SPFLOAT  noseR[28];
-    SPFLOAT  nose_junc_outL[29];
-    SPFLOAT  nose_junc_outR[29];
+    SPFLOAT  noseL[2][28];
+    SPFLOAT  noseR[2][28];
     SPFLOAT  nose_reflection[29];
     SPFLOAT  nose_diameter[28];
     SPFLOAT  noseA[28];
@@ -456,17 +481,14 @@ static void tract_init(sp_data *sp, tract *tr)
     memset(tr->rest_diameter, 0, tr->n * sizeof(SPFLOAT));
     memset(tr->target_diameter, 0, tr->n * sizeof(SPFLOAT));
     memset(tr->new_diameter, 0, tr->n * sizeof(SPFLOAT));
-    memset(tr->L, 0, tr->n * sizeof(SPFLOAT));
-    memset(tr->R, 0, tr->n * sizeof(SPFLOAT));
+    memset(tr->L, 0, sizeof(tr->L));
+    memset(tr->R, 0, sizeof(tr->R));
+    tr->cur = 0;
     memset(tr->reflection, 0, (tr->n + 1) * sizeof(SPFLOAT));
     memset(tr->new_reflection, 0, (tr->n + 1) * sizeof(SPFLOAT));
-    memset(tr->junction_outL, 0, (tr->n + 1) * sizeof(SPFLOAT));
-    memset(tr->junction_outR, 0, (tr->n + 1) * sizeof(SPFLOAT));
     memset(tr->A, 0, tr->n * sizeof(SPFLOAT));
-    memset(tr->noseL, 0, tr->nose_length * sizeof(SPFLOAT));
-    memset(tr->noseR, 0, tr->nose_length * sizeof(SPFLOAT));
-    memset(tr->nose_junc_outL, 0, (tr->nose_length + 1) * sizeof(SPFLOAT));
-    memset(tr->nose_junc_outR, 0, (tr->nose_length + 1) * sizeof(SPFLOAT));
+    memset(tr->noseL, 0, sizeof(tr->noseL));
+    memset(tr->noseR, 0, sizeof(tr->noseR));
     memset(tr->nose_diameter, 0, tr->nose_length * sizeof(SPFLOAT));
     memset(tr->noseA, 0, tr->nose_length * sizeof(SPFLOAT));
 
@@ -521,77 +543,216 @@ static void tract_init(sp_data *sp, tract *tr)
 }
 
 
-static void tract_compute(sp_data *sp, tract *tr,
-    SPFLOAT  in,
-    SPFLOAT  lambda)
+/* adds the clicks of released obstructions to one tract's waves, lane v of
+ * W */
+static void tract_transients(tract *tr, SPFLOAT *R, SPFLOAT *L, int W, int v)
 {
-     SPFLOAT  r, w;
     int i;
     SPFLOAT  amp;
     int current_size;
     transient_pool *pool;
     transient *n;
 
-
-
-        pool = &tr->tpool;
-        current_size = pool->size;
-        n = pool->root;
-        for(i = 0; i < current_size; i++) {
-            amp = n->strength * pow(2, -1.0 * n->exponent * n->time_alive);
-            tr->L[n->position] += amp * 0.5;
-            tr->R[n->position] += amp * 0.5;
-            n->time_alive += tr->T * 0.5;
-            if(n->time_alive > n->lifetime) {
-                 remove_transient(pool, n->id);
-            }
-            n = n->next;
+    pool = &tr->tpool;
+    current_size = pool->size;
+    n = pool->root;
+    for(i = 0; i < current_size; i++) {
+        amp = n->strength * pow(2, -1.0 * n->exponent * n->time_alive);
+        L[n->position * W + v] += amp * 0.5;
+        R[n->position * W + v] += amp * 0.5;
+        n->time_alive += tr->T * 0.5;
+        if(n->time_alive > n->lifetime) {
+             remove_transient(pool, n->id);
         }
+        n = n->next;
+    }
+}
 
+/* the reflections of the three way junction into the nose: left, right and
+ * nose, as they were and as they will be by the end of the block */
+typedef struct {
+    SPFLOAT left, right, nose;
+    SPFLOAT new_left, new_right, new_nose;
+} nose_junction;
+
+/* steps W tracts, segment major, from R, L, noseR and noseL into nR, nL,
+ * nnoseR and nnoseL. The nasal reflections are the same for every tract, as
+ * they are set once at init. */
+VOC_INLINE void tract_scatter(const int W, const int n, const int nose_length,
+    const int nose_start, SPFLOAT lambda,
+    const SPFLOAT *restrict in, SPFLOAT glottal_reflection, SPFLOAT lip_reflection,
+    const SPFLOAT *restrict reflection, const SPFLOAT *restrict new_reflection,
+    const nose_junction *restrict junc, const SPFLOAT *restrict nose_reflection,
+    const SPFLOAT *restrict R, const SPFLOAT *restrict L,
+    const SPFLOAT *restrict noseR, const SPFLOAT *restrict noseL,
+    SPFLOAT *restrict nR, SPFLOAT *restrict nL,
+    SPFLOAT *restrict nnoseR, SPFLOAT *restrict nnoseL,
+    SPFLOAT *restrict out)
+{
+    const SPFLOAT mix = 1 - lambda;
+    int i, v;
 
-    tr->junction_outR[0] = tr->L[0] * tr->glottal_reflection + in;
-    tr->junction_outL[tr->n] = tr->R[tr->n - 1] * tr->lip_reflection;
+    for(v = 0; v < W; v++) {
+        nR[v] = (L[v] * glottal_reflection + in[v]) * VOC_DAMPING;
+        nL[(n - 1) * W + v] = R[(n - 1) * W + v] * lip_reflection * VOC_DAMPING;
+    }
 
-    for(i = 1; i < tr->n; i++) {
-        r = tr->reflection[i] * (1 - lambda) + tr->new_reflection[i] * lambda;
-        w = r * (tr->R[i - 1] + tr->L[i]);
-        tr->junction_outR[i] = tr->R[i - 1] - w;
-        tr->junction_outL[i] = tr->L[i] + w;
+    for(i = 1; i < n; i++) {
+        for(v = 0; v < W; v++) {
+            SPFLOAT r = reflection[i * W + v] * mix + new_reflection[i * W + v] * lambda;
+            SPFLOAT w = r * (R[(i - 1) * W + v] + L[i * W + v]);
+            nR[i * W + v] = (R[(i - 1) * W + v] - w) * VOC_DAMPING;
+            nL[(i - 1) * W + v] = (L[i * W + v] + w) * VOC_DAMPING;
+        }
     }
 
+    /* the junction with the nose replaces the plain one at nose_start */
+    i = nose_start;
+    for(v = 0; v < W; v++) {
+        SPFLOAT Ri = R[(i - 1) * W + v], Li = L[i * W + v], nose = noseL[v], r;
+        r = junc[v].new_left * mix + junc[v].left * lambda;
+        nL[(i - 1) * W + v] = (r * Ri + (1 + r) * (nose + Li)) * VOC_DAMPING;
+        r = junc[v].new_right * mix + junc[v].right * lambda;
+        nR[i * W + v] = (r * Li + (1 + r) * (Ri + nose)) * VOC_DAMPING;
+        r = junc[v].new_nose * mix + junc[v].nose * lambda;
+        nnoseR[v] = r * nose + (1 + r) * (Li + Ri);
+    }
 
-    i = tr->nose_start;
-    r = tr->new_reflection_left * (1-lambda) + tr->reflection_left*lambda;
-    tr->junction_outL[i] = r*tr->R[i-1] + (1+r)*(tr->noseL[0]+tr->L[i]);
-    r = tr->new_reflection_right * (1 - lambda) + tr->reflection_right * lambda;
-    tr->junction_outR[i] = r*tr->L[i] + (1+r)*(tr->R[i-1]+tr->noseL[0]);
-    r = tr->new_reflection_nose * (1 - lambda) + tr->reflection_nose * lambda;
-    tr->nose_junc_outR[0] = r * tr->noseL[0]+(1+r)*(tr->L[i]+tr->R[i-1]);
+    for(v = 0; v < W; v++) {
+        nnoseL[(nose_length - 1) * W + v] = noseR[(nose_length - 1) * W + v] * lip_reflection;
+    }
 
+    for(i = 1; i < nose_length; i++) {
+        for(v = 0; v < W; v++) {
+            SPFLOAT w = nose_reflection[i] * (noseR[(i - 1) * W + v] + noseL[i * W + v]);
+            nnoseR[i * W + v] = noseR[(i - 1) * W + v] - w;
+            nnoseL[(i - 1) * W + v] = noseL[i * W + v] + w;
+        }
+    }
 
-    for(i = 0; i < tr->n; i++) {
-        tr->R[i] = tr->junction_outR[i]*0.999;
-        tr->L[i] = tr->junction_outL[i + 1]*0.999;
+    /* lip and nose output */
+    for(v = 0; v < W; v++) {
+        out[v] = nR[(n - 1) * W + v] + nnoseR[(nose_length - 1) * W + v];
     }
-    tr->lip_output = tr->R[tr->n - 1];
+}
+
+static void tract_junction(const tract *tr, nose_junction *junc)
+{
+    junc->left = tr->reflection_left;
+    junc->right = tr->reflection_right;
+    junc->nose = tr->reflection_nose;
+    junc->new_left = tr->new_reflection_left;
+    junc->new_right = tr->new_reflection_right;
+    junc->new_nose = tr->new_reflection_nose;
+}
 
+static SPFLOAT tract_compute(sp_data *sp, tract *tr,
+    SPFLOAT  in,
+    SPFLOAT  lambda)
+{
+    const int cur = tr->cur;
+    nose_junction junc;
+    SPFLOAT out;
 
-    tr->nose_junc_outL[tr->nose_length] =
-        tr->noseR[tr->nose_length-1] * tr->lip_reflection;
+    tract_transients(tr, tr->R[cur], tr->L[cur], 1, 0);
+    tract_junction(tr, &junc);
+    tract_scatter(1, tr->n, tr->nose_length, tr->nose_start, lambda,
+        &in, tr->glottal_reflection, tr->lip_reflection,
+        tr->reflection, tr->new_reflection, &junc, tr->nose_reflection,
+        tr->R[cur], tr->L[cur], tr->noseR[cur], tr->noseL[cur],
+        tr->R[!cur], tr->L[!cur], tr->noseR[!cur], tr->noseL[!cur], &out);
+    tr->cur = !cur;
+    tr->lip_output = tr->R[!cur][tr->n - 1];
+    tr->nose_output = tr->noseR[!cur][tr->nose_length - 1];
+    return out;
+}
 
-    for(i = 1; i < tr->nose_length; i++) {
-        w = tr->nose_reflection[i] * (tr->noseR[i-1] + tr->noseL[i]);
-        tr->nose_junc_outR[i] = tr->noseR[i - 1] - w;
-        tr->nose_junc_outL[i] = tr->noseL[i] + w;
+/* the waves and reflections of up to VOC_LANES tracts, lane major */
+typedef struct {
+    SPFLOAT R[2][44 * VOC_LANES], L[2][44 * VOC_LANES];
+    SPFLOAT noseR[2][28 * VOC_LANES], noseL[2][28 * VOC_LANES];
+    SPFLOAT reflection[45 * VOC_LANES], new_reflection[45 * VOC_LANES];
+    nose_junction junc[VOC_LANES];
+} tract_lanes;
+
+/* renders the next 512 samples of up to VOC_LANES voices into their
+ * buffers, as sp_voc_compute would one at a time */
+static void voc_compute_lanes(sp_data *sp, sp_voc **voc, int nv)
+{
+    tract_lanes lanes;
+    SPFLOAT in[VOC_LANES], out1[VOC_LANES], out2[VOC_LANES];
+    SPFLOAT lambda1, lambda2;
+    const tract *t0 = &voc[0]->tr;
+    const int n = t0->n, nose_length = t0->nose_length;
+    int i, v, cur = 0;
+
+    memset(&lanes, 0, sizeof(lanes));
+    memset(in, 0, sizeof(in));
+
+    for(v = 0; v < nv; v++) {
+        tract *tr = &voc[v]->tr;
+        tract_reshape(tr);
+        tract_calculate_reflections(tr);
+        /* the glottis first, so the noise is drawn in the same order */
+        for(i = 0; i < 512; i++) {
+            voc[v]->buf[i] = glottis_compute(sp, &voc[v]->glot, (SPFLOAT) i / 512);
+        }
+        for(i = 0; i < n; i++) {
+            lanes.R[0][i * VOC_LANES + v] = tr->R[tr->cur][i];
+            lanes.L[0][i * VOC_LANES + v] = tr->L[tr->cur][i];
+            lanes.reflection[i * VOC_LANES + v] = tr->reflection[i];
+            lanes.new_reflection[i * VOC_LANES + v] = tr->new_reflection[i];
+        }
+        for(i = 0; i < nose_length; i++) {
+            lanes.noseR[0][i * VOC_LANES + v] = tr->noseR[tr->cur][i];
+            lanes.noseL[0][i * VOC_LANES + v] = tr->noseL[tr->cur][i];
+        }
+        tract_junction(tr, &lanes.junc[v]);
     }
 
+    for(i = 0; i < 512; i++) {
+        lambda1 = (SPFLOAT) i / 512;
+        lambda2 = (SPFLOAT) (i + 0.5) / 512;
+        for(v = 0; v < nv; v++) in[v] = voc[v]->buf[i];
 
-    for(i = 0; i < tr->nose_length; i++) {
-        tr->noseR[i] = tr->nose_junc_outR[i];
-        tr->noseL[i] = tr->nose_junc_outL[i + 1];
+        for(v = 0; v < nv; v++) {
+            tract_transients(&voc[v]->tr, lanes.R[cur], lanes.L[cur], VOC_LANES, v);
+        }
+        tract_scatter(VOC_LANES, n, nose_length, t0->nose_start, lambda1,
+            in, t0->glottal_reflection, t0->lip_reflection,
+            lanes.reflection, lanes.new_reflection, lanes.junc, t0->nose_reflection,
+            lanes.R[cur], lanes.L[cur], lanes.noseR[cur], lanes.noseL[cur],
+            lanes.R[!cur], lanes.L[!cur], lanes.noseR[!cur], lanes.noseL[!cur], out1);
+        cur = !cur;
+
+        for(v = 0; v < nv; v++) {
+            tract_transients(&voc[v]->tr, lanes.R[cur], lanes.L[cur], VOC_LANES, v);
+        }
+        tract_scatter(VOC_LANES, n, nose_length, t0->nose_start, lambda2,
+            in, t0->glottal_reflection, t0->lip_reflection,
+            lanes.reflection, lanes.new_reflection, lanes.junc, t0->nose_reflection,
+            lanes.R[cur], lanes.L[cur], lanes.noseR[cur], lanes.noseL[cur],
+            lanes.R[!cur], lanes.L[!cur], lanes.noseR[!cur], lanes.noseL[!cur], out2);
+        cur = !cur;
+
+        for(v = 0; v < nv; v++) {
+            voc[v]->buf[i] = (out1[v] + out2[v]) * 0.125;
+        }
     }
-    tr->nose_output = tr->noseR[tr->nose_length - 1];
 
+    for(v = 0; v < nv; v++) {
+        tract *tr = &voc[v]->tr;
+        for(i = 0; i < n; i++) {
+            tr->R[tr->cur][i] = lanes.R[cur][i * VOC_LANES + v];
+            tr->L[tr->cur][i] = lanes.L[cur][i * VOC_LANES + v];
+        }
+        for(i = 0; i < nose_length; i++) {
+            tr->noseR[tr->cur][i] = lanes.noseR[cur][i * VOC_LANES + v];
+            tr->noseL[tr->cur][i] = lanes.noseL[cur][i * VOC_LANES + v];
+        }
+        tr->lip_output = tr->R[tr->cur][n - 1];
+        tr->nose_output = tr->noseR[tr->cur][nose_length - 1];
+    }
 }
 
 
@@ -620,35 +781,65 @@ int sp_voc_init(sp_data *sp, sp_voc *voc)
 }
 
 
-int sp_voc_compute(sp_data *sp, sp_voc *voc, SPFLOAT *out)
+/* renders the next 512 samples of one voice into its buffer */
+static void voc_compute_block(sp_data *sp, sp_voc *voc)
 {
     SPFLOAT vocal_output, glot;
     SPFLOAT lambda1, lambda2;
     int i;
 
+    tract_reshape(&voc->tr);
+    tract_calculate_reflections(&voc->tr);
+    for(i = 0; i < 512; i++) {
+        vocal_output = 0;
+        lambda1 = (SPFLOAT) i / 512;
+        lambda2 = (SPFLOAT) (i + 0.5) / 512;
+        glot = glottis_compute(sp, &voc->glot, lambda1);
+
+        vocal_output += tract_compute(sp, &voc->tr, glot, lambda1);
+        vocal_output += tract_compute(sp, &voc->tr, glot, lambda2);
+        voc->buf[i] = vocal_output * 0.125;
+    }
+}
 
 
-    if(voc->counter == 0) {
-        tract_reshape(&voc->tr);
-        tract_calculate_reflections(&voc->tr);
-        for(i = 0; i < 512; i++) {
-            vocal_output = 0;
-            lambda1 = (SPFLOAT) i / 512;
-            lambda2 = (SPFLOAT) (i + 0.5) / 512;
-            glot = glottis_compute(sp, &voc->glot, lambda1);
+int sp_voc_compute(sp_data *sp, sp_voc *voc, SPFLOAT *out)
+{
+    if(voc->counter == 0) voc_compute_block(sp, voc);
+
+    *out = voc->buf[voc->counter];
+    voc->counter = (voc->counter + 1) % 512;
+    return SP_OK;
+}
 
-            tract_compute(sp, &voc->tr, glot, lambda1);
-            vocal_output += voc->tr.lip_output + voc->tr.nose_output;
 
-            tract_compute(sp, &voc->tr, glot, lambda2);
-            vocal_output += voc->tr.lip_output + voc->tr.nose_output;
-            voc->buf[i] = vocal_output * 0.125;
+static void voc_compute_group(sp_data *sp, sp_voc **group, int ng)
+{
+    /* a voice on its own is quicker vectorized along its tract */
+    if(ng == 1) voc_compute_block(sp, group[0]);
+    else if(ng > 1) voc_compute_lanes(sp, group, ng);
+}
+
+
+int sp_voc_compute_voices(sp_data *sp, sp_voc **voc, int nvoices, SPFLOAT *out)
+{
+    sp_voc *group[VOC_LANES];
+    int v, ng = 0;
+
+    for(v = 0; v < nvoices; v++) {
+        if(voc[v]->counter != 0) continue;
+        group[ng++] = voc[v];
+        if(ng == VOC_LANES) {
+            voc_compute_group(sp, group, ng);
+            ng = 0;
         }
     }
+    voc_compute_group(sp, group, ng);
 
-
-    *out = voc->buf[voc->counter];
-    voc->counter = (voc->counter + 1) % 512;
+    for(v = 0; v < nvoices; v++) {
+        out[v] = voc[v]->buf[voc[v]->counter];
+        voc[v]->counter = (voc[v]->counter + 1) % 512;
+    }
     return SP_OK;
 }
 
@@ -667,10 +858,8 @@ int sp_voc_tract_compute(sp_data *sp, sp_voc *voc, SPFLOAT *in, SPFLOAT *out)
     lambda1 = (SPFLOAT) voc->counter / 512;
     lambda2 = (SPFLOAT) (voc->counter + 0.5) / 512;
 
-    tract_compute(sp, &voc->tr, *in, lambda1);
-    vocal_output += voc->tr.lip_output + voc->tr.nose_output;
-    tract_compute(sp, &voc->tr, *in, lambda2);
-    vocal_output += voc->tr.lip_output + voc->tr.nose_output;
+    vocal_output += tract_compute(sp, &voc->tr, *in, lambda1);
+    vocal_output += tract_compute(sp, &voc->tr, *in, lambda2);
 
 
     *out = vocal_output * 0.125;
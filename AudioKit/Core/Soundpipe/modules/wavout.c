@@ -1,6 +1,11 @@
 #include <stdlib.h>
 #include "soundpipe.h"
 #include "dr_wav.h"
+#ifdef AUDIOKIT
+#include "AKRenderStats.h"
+#else
+#define AK_REALTIME_UNSAFE(kind, where)
+#endif
 
 #define WAVOUT_BUFSIZE 1024
 
@@ -44,6 +49,7 @@ int sp_wavout_compute(sp_data *sp, sp_wavout *p, SPFLOAT *in, SPFLOAT *out)
 {
     *out = *in;
     if(p->count == WAVOUT_BUFSIZE) {
+        AK_REALTIME_UNSAFE(AKRealtimeViolationFileIO, "sp_wavout_compute writes to disk");
         drwav_write(p->wav, WAVOUT_BUFSIZE, p->buf);
         p->count = 0;
     }
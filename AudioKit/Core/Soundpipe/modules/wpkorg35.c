@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include "soundpipe.h"
+#include "fastmath.h"
 
 #ifndef M_PI
 #define M_PI		3.14159265358979323846
@@ -87,54 +88,64 @@ int sp_wpkorg35_init(sp_data *sp, sp_wpkorg35 *p)
 
 int sp_wpkorg35_compute(sp_data *sp, sp_wpkorg35 *p, SPFLOAT *in, SPFLOAT *out)
 {
-    /* TODO: add previous values */
+    return sp_wpkorg35_compute_block(sp, p, in, out, 1);
+}
+
+/* cutoff, res and saturation are read once per block */
+int sp_wpkorg35_compute_block(sp_data *sp, sp_wpkorg35 *p, const SPFLOAT *in, SPFLOAT *out, int nframes)
+{
+    SPFLOAT lpf1_z, lpf2_z, hpf_z;
+    SPFLOAT saturation, norm;
+    int i;
 
     if(p->pcutoff != p->cutoff || p->pres != p->res) update(sp, p);
 
-    /* initialize variables */
-    SPFLOAT y1 = 0.0;
-    SPFLOAT S35 = 0.0;
-    SPFLOAT u = 0.0;
-    SPFLOAT y = 0.0;
-    SPFLOAT vn = 0.0;
+    lpf1_z = p->lpf1_z;
+    lpf2_z = p->lpf2_z;
+    hpf_z = p->hpf_z;
+    saturation = p->saturation;
+    norm = p->res > 0 ? 1.0 / p->res : 1.0;
 
-    /* process input through LPF1 */
-    vn = (*in - p->lpf1_z) * p->lpf1_a;
-    y1 = vn + p->lpf1_z;
-    p->lpf1_z = y1 + vn;
+    for (i = 0; i < nframes; i++) {
+        SPFLOAT y1, S35, u, y, vn;
 
-    /* form feedback value */
+        /* process input through LPF1 */
+        vn = (in[i] - lpf1_z) * p->lpf1_a;
+        y1 = vn + lpf1_z;
+        lpf1_z = y1 + vn;
 
-    S35 = (p->hpf_z * p->hpf_b) + (p->lpf2_z * p->lpf2_b);
+        /* form feedback value */
 
-    /* Calculate u */
-    u = p->alpha * (y1 + S35);
+        S35 = (hpf_z * p->hpf_b) + (lpf2_z * p->lpf2_b);
 
-    /* Naive NLP */
+        /* Calculate u */
+        u = p->alpha * (y1 + S35);
 
-    if(p->saturation > 0) {
-        u = tanh(p->saturation * u);
-    }
+        /* Naive NLP */
 
-    /* Feed it to LPF2 */
-    vn = (u - p->lpf2_z) * p->lpf2_a;
-    y = (vn + p->lpf2_z);
-    p->lpf2_z = y + vn;
-    y *= p->res;
+        if(saturation > 0) {
+            u = sp_fast_tanh(saturation * u);
+        }
 
-    /* Feed y to HPF2 */
+        /* Feed it to LPF2 */
+        vn = (u - lpf2_z) * p->lpf2_a;
+        y = (vn + lpf2_z);
+        lpf2_z = y + vn;
+        y *= p->res;
 
-    vn = (y - p->hpf_z) * p->hpf_a;
-    p->hpf_z = vn + (vn + p->hpf_z);
+        /* Feed y to HPF2 */
 
-    /* Auto-normalize */
+        vn = (y - hpf_z) * p->hpf_a;
+        hpf_z = vn + (vn + hpf_z);
 
-    if(p->res > 0) {
-        y *= 1.0 / p->res;
-    }
+        /* Auto-normalize */
 
-    *out = y;
+        out[i] = y * norm;
+    }
 
+    p->lpf1_z = lpf1_z;
+    p->lpf2_z = lpf2_z;
+    p->hpf_z = hpf_z;
     p->pcutoff = p->cutoff;
     p->pres = p->res;
     return SP_OK;
@@ -253,6 +253,25 @@ int sp_bltriangle_create(sp_bltriangle **p);
 int sp_bltriangle_destroy(sp_bltriangle **p);
 int sp_bltriangle_init(sp_data *sp, sp_bltriangle *p);
 int sp_bltriangle_compute(sp_data *sp, sp_bltriangle *p, SPFLOAT *in, SPFLOAT *out);
+
+#define SP_BLEP_SAW 0
+#define SP_BLEP_SQUARE 1
+#define SP_BLEP_TRIANGLE 2
+
+typedef struct {
+    int maxvoices, nvoices, shape;
+    SPFLOAT onedsr;
+    sp_auxdata aux;
+    /* per voice: phase in [0, 1), frequency in Hz, and pulse width in
+     * [0, 1] (SP_BLEP_SQUARE only) */
+    SPFLOAT *phs, *freq, *width;
+} sp_blepbank;
+
+int sp_blepbank_create(sp_blepbank **p);
+int sp_blepbank_destroy(sp_blepbank **p);
+int sp_blepbank_init(sp_data *sp, sp_blepbank *p, int maxvoices, int shape);
+int sp_blepbank_compute_block(sp_data *sp, sp_blepbank *p, const SPFLOAT *fmul,
+    SPFLOAT *out, int nframes);
 typedef struct {
     SPFLOAT incr;
     SPFLOAT index;
@@ -407,6 +426,7 @@ typedef struct {
     sp_auxdata auxData;
     sp_ftbl *ftbl;
     sp_fft fft;
+    struct sp_conv_ir *ir;
 } sp_conv;
 
 int sp_conv_create(sp_conv **p);
@@ -462,12 +482,14 @@ typedef struct {
     SPFLOAT freq;
     SPFLOAT K;
     SPFLOAT res;
+    SPFLOAT pfreq;
 } sp_diode;
 
 int sp_diode_create(sp_diode **p);
 int sp_diode_destroy(sp_diode **p);
 int sp_diode_init(sp_data *sp, sp_diode *p);
 int sp_diode_compute(sp_data *sp, sp_diode *p, SPFLOAT *in, SPFLOAT *out);
+int sp_diode_compute_block(sp_data *sp, sp_diode *p, const SPFLOAT *in, SPFLOAT *out, int nframes);
 typedef struct sp_dist{
     SPFLOAT pregain, postgain, shape1, shape2, mode;
 } sp_dist;
@@ -585,55 +607,36 @@ int sp_expon_create(sp_expon **p);
 int sp_expon_destroy(sp_expon **p);
 int sp_expon_init(sp_data *sp, sp_expon *p);
 int sp_expon_compute(sp_data *sp, sp_expon *p, SPFLOAT *in, SPFLOAT *out);
-typedef struct sp_fof_overlap {
-        struct sp_fof_overlap *nxtact, *nxtfree;
-        int32_t timrem, dectim, formphs, forminc, risphs, risinc, decphs, decinc;
-        SPFLOAT curamp, expamp;
-        SPFLOAT glissbas;
-        int32_t sampct;
-} sp_fof_overlap;
-
 typedef struct {
     SPFLOAT amp, fund, form, oct, band, ris, dur, dec;
     SPFLOAT iolaps, iphs;
     int32_t durtogo, fundphs, fofcount, prvsmps;
     SPFLOAT prvband, expamp, preamp;
-    int16_t foftype;
     int16_t xincod, ampcod, fundcod, formcod, fmtmod;
-    sp_auxdata auxch;
     sp_ftbl *ftp1, *ftp2;
-    sp_fof_overlap basovrlap;
+    struct sp_grainpool *pool;
 } sp_fof;
 
 int sp_fof_create(sp_fof **p);
 int sp_fof_destroy(sp_fof **p);
 int sp_fof_init(sp_data *sp, sp_fof *p, sp_ftbl *sine, sp_ftbl *win, int iolaps, SPFLOAT iphs);
 int sp_fof_compute(sp_data *sp, sp_fof *p, SPFLOAT *in, SPFLOAT *out);
-typedef struct sp_fog_overlap {
-    struct sp_fog_overlap *nxtact;
-    struct sp_fog_overlap *nxtfree;
-    int32_t timrem, dectim, formphs, forminc;
-    uint32_t risphs;
-    int32_t risinc, decphs, decinc;
-    SPFLOAT curamp, expamp;
-    SPFLOAT pos, inc;
-} sp_fog_overlap;
-
+int sp_fof_compute_block(sp_data *sp, sp_fof *p, SPFLOAT *out, int nframes);
 typedef struct {
     SPFLOAT amp, dens, trans, spd, oct, band, ris, dur, dec;
     SPFLOAT iolaps, iphs, itmode;
-    sp_fog_overlap basovrlap;
     int32_t durtogo, fundphs, fofcount, prvsmps, spdphs;
     SPFLOAT prvband, expamp, preamp, fogcvt;
     int16_t formcod, fmtmod, speedcod;
-    sp_auxdata auxch;
     sp_ftbl *ftp1, *ftp2;
+    struct sp_grainpool *pool;
 } sp_fog;
 
 int sp_fog_create(sp_fog **p);
 int sp_fog_destroy(sp_fog **p);
 int sp_fog_init(sp_data *sp, sp_fog *p, sp_ftbl *wav, sp_ftbl *win, int iolaps, SPFLOAT iphs);
 int sp_fog_compute(sp_data *sp, sp_fog *p, SPFLOAT *in, SPFLOAT *out);
+int sp_fog_compute_block(sp_data *sp, sp_fog *p, SPFLOAT *out, int nframes);
 typedef struct{
     SPFLOAT freq, atk, dec, istor;
     SPFLOAT tpidsr;
@@ -677,6 +680,42 @@ int sp_gbuzz_create(sp_gbuzz **p);
 int sp_gbuzz_destroy(sp_gbuzz **p);
 int sp_gbuzz_init(sp_data *sp, sp_gbuzz *p, sp_ftbl *ft, SPFLOAT iphs);
 int sp_gbuzz_compute(sp_data *sp, sp_gbuzz *p, SPFLOAT *in, SPFLOAT *out);
+
+#define SP_GRAIN_PHASE 0
+#define SP_GRAIN_POSITION 1
+
+typedef struct {
+    /* source: fixed point phase and increment (SP_GRAIN_PHASE), or
+     * position and speed in samples (SP_GRAIN_POSITION) */
+    int32_t phs, inc;
+    SPFLOAT pos, speed;
+    /* initial amplitude, and its multiplier per sample */
+    SPFLOAT amp, expamp;
+    /* length in samples */
+    int32_t dur;
+    /* window phase for the attack; none if risphs >= SP_FT_MAXLEN */
+    uint32_t risphs;
+    int32_t risinc;
+    /* release over the last dectim samples, reading the window backwards */
+    int32_t dectim, decinc;
+} sp_grain;
+
+typedef struct sp_grainpool {
+    int maxgrains, ngrains, mode;
+    sp_ftbl *src, *win;
+    sp_auxdata aux;
+    int32_t *phs, *inc;
+    uint32_t *risphs;
+    int32_t *risinc, *decphs, *decinc, *dectim, *timrem;
+    SPFLOAT *pos, *speed, *curamp, *expamp;
+} sp_grainpool;
+
+int sp_grainpool_create(sp_grainpool **p);
+int sp_grainpool_destroy(sp_grainpool **p);
+int sp_grainpool_init(sp_data *sp, sp_grainpool *p, sp_ftbl *src, sp_ftbl *win,
+    int maxgrains, int mode);
+int sp_grainpool_add(sp_data *sp, sp_grainpool *p, const sp_grain *grain);
+int sp_grainpool_compute_block(sp_data *sp, sp_grainpool *p, SPFLOAT *out, int nframes);
 typedef struct {
     SPFLOAT xnm1[12], ynm1[12], coef[12];
 } sp_hilbert;
@@ -744,6 +783,7 @@ int sp_lpf18_create(sp_lpf18 **p);
 int sp_lpf18_destroy(sp_lpf18 **p);
 int sp_lpf18_init(sp_data *sp, sp_lpf18 *p);
 int sp_lpf18_compute(sp_data *sp, sp_lpf18 *p, SPFLOAT *in, SPFLOAT *out);
+int sp_lpf18_compute_block(sp_data *sp, sp_lpf18 *p, const SPFLOAT *in, SPFLOAT *out, int nframes);
 typedef struct sp_maygate{
     SPFLOAT prob;
     SPFLOAT gate;
@@ -766,18 +806,9 @@ int sp_metro_destroy(sp_metro **p);
 int sp_metro_init(sp_data *sp, sp_metro *p);
 int sp_metro_compute(sp_data *sp, sp_metro *p, SPFLOAT *in, SPFLOAT *out);
 typedef struct {
-    SPFLOAT time, amp, pitch, lock, iN,
-        idecim, onset, offset, dbthresh;
-    int cnt, hsize, curframe, N, decim,tscale;
-    SPFLOAT pos;
-    SPFLOAT accum;
-    sp_auxdata outframe, win, bwin, fwin,
-    nwin, prev, framecount, indata[2];
-    SPFLOAT *tab;
-    int curbuf;
-    SPFLOAT resamp;
+    SPFLOAT time, amp, pitch, lock, iN;
     sp_ftbl *ft;
-    sp_fft fft;
+    struct sp_pvcore *pv;
 } sp_mincer;
 
 int sp_mincer_create(sp_mincer **p);
@@ -810,6 +841,7 @@ int sp_moogladder_create(sp_moogladder **t);
 int sp_moogladder_destroy(sp_moogladder **t);
 int sp_moogladder_init(sp_data *sp, sp_moogladder *p);
 int sp_moogladder_compute(sp_data *sp, sp_moogladder *p, SPFLOAT *in, SPFLOAT *out);
+int sp_moogladder_compute_block(sp_data *sp, sp_moogladder *p, const SPFLOAT *in, SPFLOAT *out, int nframes);
 typedef struct{
     SPFLOAT amp;
 }sp_noise;
@@ -1170,6 +1202,30 @@ int sp_ptrack_create(sp_ptrack **p);
 int sp_ptrack_destroy(sp_ptrack **p);
 int sp_ptrack_init(sp_data *sp, sp_ptrack *p, int ihopsize, int ipeaks);
 int sp_ptrack_compute(sp_data *sp, sp_ptrack *p, SPFLOAT *in, SPFLOAT *freq, SPFLOAT *amp);
+
+#define SP_PVCORE_MAXCHAN 8
+
+typedef struct sp_pvcore {
+    /* read position in seconds, transposition, and phase locking on or off;
+     * read at the start of every hop */
+    SPFLOAT time, pitch, lock;
+    int N, hsize, decim, cnt, curframe, nchan;
+    sp_ftbl *ft[SP_PVCORE_MAXCHAN];
+    struct sp_pvshared *shared;
+    sp_auxdata aux;
+    SPFLOAT *fwin[SP_PVCORE_MAXCHAN], *bwin[SP_PVCORE_MAXCHAN];
+    SPFLOAT *prev[SP_PVCORE_MAXCHAN], *outframe[SP_PVCORE_MAXCHAN];
+    SPFLOAT *ref, *lck;
+    int *framecount;
+} sp_pvcore;
+
+int sp_pvcore_create(sp_pvcore **p);
+int sp_pvcore_destroy(sp_pvcore **p);
+int sp_pvcore_init(sp_data *sp, sp_pvcore *p, sp_ftbl **ft, int nchan, int winsize);
+int sp_pvcore_compute(sp_data *sp, sp_pvcore *p, SPFLOAT *out);
+int sp_pvcore_render(sp_data *sp, sp_ftbl **ft, int nchan, int winsize,
+    SPFLOAT start, SPFLOAT speed, SPFLOAT pitch, int lock,
+    SPFLOAT **out, int nframes, int nthreads);
 typedef struct {
     SPFLOAT freq;
     SPFLOAT min, max;
@@ -1383,6 +1439,39 @@ int sp_smoothdelay_destroy(sp_smoothdelay **p);
 int sp_smoothdelay_init(sp_data *sp, sp_smoothdelay *p,
         SPFLOAT maxdel, uint32_t interp);
 int sp_smoothdelay_compute(sp_data *sp, sp_smoothdelay *p, SPFLOAT *in, SPFLOAT *out);
+
+#define SP_SRC_MAXCHAN 8
+#define SP_SRC_MAXPHASES 512
+
+#define SP_SRC_FAST 0
+#define SP_SRC_MEDIUM 1
+#define SP_SRC_BEST 2
+
+typedef struct {
+    int nchan, taps, rational;
+    /* exact stepping when the ratio reduces to L / M: phase counts in
+     * 1 / L of an input sample */
+    uint32_t L, M, phase;
+    /* otherwise the input samples per output sample and the fraction of
+     * one past pos */
+    double step, frac;
+    /* first tap of the next output, frames buffered, and room for them */
+    int pos, fill, size;
+    struct sp_src_bank *bank;
+    sp_auxdata aux;
+    SPFLOAT *buf[SP_SRC_MAXCHAN];
+} sp_src;
+
+int sp_src_create(sp_src **p);
+int sp_src_destroy(sp_src **p);
+int sp_src_init(sp_data *sp, sp_src *p, SPFLOAT inrate, SPFLOAT outrate,
+    int nchan, int quality);
+int sp_src_reset(sp_data *sp, sp_src *p);
+int sp_src_needed(sp_src *p, int nout);
+int sp_src_compute_block(sp_data *sp, sp_src *p, SPFLOAT **in, int nin,
+    SPFLOAT **out, int nout, int *inused, int *outmade);
+int sp_src_convert(sp_data *sp, SPFLOAT **in, int nin, SPFLOAT inrate,
+    SPFLOAT **out, int nout, SPFLOAT outrate, int nchan, int quality);
 typedef struct sp_sndwarp_warpsection sp_sndwarp_warpsection;
 
 typedef struct {
@@ -1499,6 +1588,7 @@ int sp_tbvcf_create(sp_tbvcf **p);
 int sp_tbvcf_destroy(sp_tbvcf **p);
 int sp_tbvcf_init(sp_data *sp, sp_tbvcf *p);
 int sp_tbvcf_compute(sp_data *sp, sp_tbvcf *p, SPFLOAT *in, SPFLOAT *out);
+int sp_tbvcf_compute_block(sp_data *sp, sp_tbvcf *p, const SPFLOAT *in, SPFLOAT *out, int nframes);
 typedef struct {
     uint32_t num, counter, offset;
 } sp_tdiv;
@@ -1651,6 +1741,7 @@ int sp_voc_destroy(sp_voc **voc);
 int sp_voc_init(sp_data *sp, sp_voc *voc);
 int sp_voc_compute(sp_data *sp, sp_voc *voc, SPFLOAT *out);
 int sp_voc_tract_compute(sp_data *sp, sp_voc *voc, SPFLOAT *in, SPFLOAT *out);
+int sp_voc_compute_voices(sp_data *sp, sp_voc **voc, int nvoices, SPFLOAT *out);
 
 void sp_voc_set_frequency(sp_voc *voc, SPFLOAT freq);
 SPFLOAT * sp_voc_get_frequency_ptr(sp_voc *voc);
@@ -1766,6 +1857,7 @@ int sp_wpkorg35_create(sp_wpkorg35 **p);
 int sp_wpkorg35_destroy(sp_wpkorg35 **p);
 int sp_wpkorg35_init(sp_data *sp, sp_wpkorg35 *p);
 int sp_wpkorg35_compute(sp_data *sp, sp_wpkorg35 *p, SPFLOAT *in, SPFLOAT *out);
+int sp_wpkorg35_compute_block(sp_data *sp, sp_wpkorg35 *p, const SPFLOAT *in, SPFLOAT *out, int nframes);
 typedef struct {
     void *faust;
     int argpos;
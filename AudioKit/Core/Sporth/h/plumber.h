@@ -33,6 +33,15 @@ PTYPE_TABLE,
 PTYPE_USERDATA
 };
 
+/* who a ugen pipe's state belongs to during a recompile */
+enum {
+PSTATE_OWN,
+PSTATE_TAKEN,
+PSTATE_GIVEN
+};
+
+#define PLUMBER_KEEP_MAXOUT 4
+
 typedef int (* plumber_func) (sporth_stack *, void *) ;
 
 typedef struct plumber_ftbl {
@@ -49,11 +58,33 @@ typedef struct {
     plumber_ftbl *last;
 } plumber_ftentry;
 
+/* what a ugen popped and pushed while it was created or initialized.
+ * npop is negative if it popped or pushed anything but floats */
+typedef struct {
+    int npop, npush;
+    uint64_t in;
+    float out[PLUMBER_KEEP_MAXOUT];
+} plumber_effect;
+
+typedef struct {
+    uint32_t id;
+    int inited;
+    plumber_effect create, init;
+} plumber_sig;
+
 typedef struct plumber_pipe {
     uint32_t type;
     size_t size;
     void *ud;
     struct plumber_pipe *next;
+    /* for keeping ugen state over a recompile */
+    plumber_sig *sig;
+    struct plumber_pipe *from;
+    int state;
+    /* stack effect when initialized, for planning parallel blocks.
+     * npop is negative until then */
+    int npop, npush;
+    int strings;
 } plumber_pipe;
 
 typedef struct {
@@ -68,6 +99,16 @@ typedef struct {
     plumber_pipe *last;
 } plumbing;
 
+typedef struct {
+    /* the plumbing being compiled */
+    plumbing *pipes;
+    /* ugens of the running plumbing that can hand over their state */
+    plumber_pipe **table;
+    uint32_t mask;
+    /* for each function, the set of argument counts it was seen with */
+    uint64_t *arity;
+} plumber_keeper;
+
 typedef struct plumber_data {
     int nchan;
     int mode;
@@ -96,6 +137,11 @@ typedef struct plumber_data {
     int showprog;
     int recompile;
     char *str;
+    /* keep the state of unchanged ugens when recompiling */
+    int keep;
+    plumber_keeper keeper;
+    /* computes independent parts of the patch on worker threads */
+    struct plumber_parallel *parallel;
 
     FILE *log;
 } plumber_data;
@@ -195,6 +241,18 @@ int plumber_process_null(sp_data *sp, void *ud, void (*callback)(sp_data *, void
 
 int plumber_create_var(plumber_data *pd, const char *name, SPFLOAT **var);
 
+int plumber_keep_begin(plumber_data *plumb);
+int plumber_keep_revert(plumber_data *plumb);
+int plumber_keep_end(plumber_data *plumb);
+int plumber_keep_exec(plumber_data *plumb, plumbing *pipes, const char *keyword);
+int plumber_keep_compute(plumber_data *plumb, plumber_pipe *pipe, int mode);
+
+int plumber_parallel_init(plumber_data *plumb, int nthreads, int maxframes);
+int plumber_parallel_destroy(plumber_data *plumb);
+int plumber_parallel_measure(plumber_data *plumb, plumber_pipe *pipe);
+int plumber_parallel_plan(plumber_data *plumb);
+int plumber_compute_block(plumber_data *plumb, SPFLOAT **out, int nchan, int nframes);
+
 int plumber_get_userdata(plumber_data *plumb, const char *name, plumber_ptr **p);
 int polysporth_eval(plumber_ptr *p, const char *str);
 
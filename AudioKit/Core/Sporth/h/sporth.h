@@ -26,6 +26,8 @@ typedef struct {
     int pos;
     uint32_t error;
     sporth_stack_val stack[SPORTH_STACK_SIZE];
+    /* lowest pos reached by a pop, for seeing what a function consumed */
+    int low;
 } sporth_stack;
 
 typedef struct sporth_entry {
@@ -86,6 +86,7 @@ SPORTH_UGEN("gen_sinesum", sporth_gen_sinesum, SPORTH_GEN_SINESUM, 3, 0)
 SPORTH_UGEN("gen_sporth", sporth_gen_sporth, SPORTH_GEN_SPORTH, 3, 0)
 SPORTH_UGEN("gen_vals", sporth_gen_vals, SPORTH_GEN_VALS, 2, 0)
 SPORTH_UGEN("get", sporth_get, SPORTH_GET, 1, 1)
+SPORTH_UGEN("grain", sporth_grain, SPORTH_GRAIN, 10, 1)
 SPORTH_UGEN("gt", sporth_gt, SPORTH_GT, 2, 1)
 SPORTH_UGEN("hilbert", sporth_hilbert, SPORTH_HILBERT, 1, 2)
 SPORTH_UGEN("in", sporth_in, SPORTH_IN, 0, 1)
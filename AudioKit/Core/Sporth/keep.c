@@ -0,0 +1,312 @@
+/*
+ * keep
+ *
+ * Lets a recompile keep the state of the ugens that did not change, so
+ * that editing a patch does not reallocate every delay line and reverb,
+ * and does not cut off their tails.
+ *
+ * While a patch is compiled, the stack effect of each ugen with user data
+ * is noted when it is created and again when it is initialized: how many
+ * values it popped, a hash of them, and the values it pushed. A ugen whose
+ * effect involved anything but floats (table and variable names, code) is
+ * never kept, nor is one without user data, which has no state to keep.
+ *
+ * When a patch is recompiled, each ugen about to be created is looked up
+ * among the ugens of the running patch by its function and the values it
+ * is about to pop. If an unclaimed one is found, the new pipe takes its
+ * user data and its create effect is replayed rather than the ugen being
+ * created. Identical ugens are paired in the order they appear. At
+ * initialization the taken ugen's arguments are checked against the ones
+ * it was initialized with; if they match its init effect is replayed, and
+ * if not it is destroyed and created again.
+ *
+ * Until the new plumbing replaces the old one, taken state still belongs
+ * to the old pipes, and is handed back if the new code fails to parse.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "plumber.h"
+
+#define KEEP_FNV_OFFSET 14695981039346656037ULL
+#define KEEP_FNV_PRIME 1099511628211ULL
+
+static uint64_t mix(uint64_t h, uint32_t x)
+{
+    int i;
+    for(i = 0; i < 4; i++) {
+        h = (h ^ (x & 0xff)) * KEEP_FNV_PRIME;
+        x >>= 8;
+    }
+    return h;
+}
+
+static int hash_values(const sporth_stack_val *v, int n, uint64_t *hash)
+{
+    uint64_t h = KEEP_FNV_OFFSET;
+    uint32_t bits;
+    int i;
+    for(i = 0; i < n; i++) {
+        if(v[i].type != SPORTH_FLOAT) return PLUMBER_NOTOK;
+        memcpy(&bits, &v[i].fval, sizeof(bits));
+        h = mix(h, bits);
+    }
+    *hash = h;
+    return PLUMBER_OK;
+}
+
+static uint64_t key(uint32_t id, int npop, uint64_t in)
+{
+    return mix(mix(in, id), (uint32_t)npop);
+}
+
+/* calls a ugen, noting what it popped and pushed */
+static int call(plumber_data *plumb, sporth_func *f, plumber_effect *fx)
+{
+    sporth_stack *stack = &plumb->sporth.stack;
+    sporth_stack_val before[SPORTH_STACK_SIZE];
+    int pos = stack->pos, base, i, rc;
+
+    memcpy(before, stack->stack, pos * sizeof(sporth_stack_val));
+    stack->low = pos;
+    rc = f->func(stack, f->ud);
+
+    base = stack->low < stack->pos ? stack->low : stack->pos;
+    fx->npop = pos - base;
+    fx->npush = stack->pos - base;
+    if(stack->error > 0 ||
+        fx->npush > PLUMBER_KEEP_MAXOUT ||
+        hash_values(&before[base], fx->npop, &fx->in) != PLUMBER_OK) {
+        fx->npop = -1;
+        return rc;
+    }
+    for(i = 0; i < fx->npush; i++) {
+        if(stack->stack[base + i].type != SPORTH_FLOAT) {
+            fx->npop = -1;
+            break;
+        }
+        fx->out[i] = stack->stack[base + i].fval;
+    }
+    return rc;
+}
+
+/* pops what a ugen popped and pushes what it pushed, if the values on the
+ * stack are the ones it popped */
+static int replay(sporth_stack *stack, const plumber_effect *fx)
+{
+    uint64_t in;
+    int i;
+    if(stack->error > 0 || fx->npop < 0 || fx->npop > stack->pos) return PLUMBER_NOTOK;
+    if(hash_values(&stack->stack[stack->pos - fx->npop], fx->npop, &in) != PLUMBER_OK ||
+        in != fx->in) {
+        return PLUMBER_NOTOK;
+    }
+    stack->pos -= fx->npop;
+    if(stack->pos < stack->low) stack->low = stack->pos;
+    for(i = 0; i < fx->npush; i++) sporth_stack_push_float(stack, fx->out[i]);
+    return PLUMBER_OK;
+}
+
+/* adds a pipe taking the state of a matching ugen of the running plumbing */
+static int take(plumber_data *plumb, uint32_t id)
+{
+    plumber_keeper *k = &plumb->keeper;
+    sporth_stack *stack = &plumb->sporth.stack;
+    plumber_pipe *old, *pipe;
+    uint64_t arity, in;
+    uint32_t i;
+    int npop;
+
+    if(k->table == NULL || id >= plumb->sporth.nfunc) return PLUMBER_NOTOK;
+    arity = k->arity[id];
+    /* functions seen taking different numbers of arguments aren't matched */
+    if(arity == 0 || (arity & (arity - 1)) != 0) return PLUMBER_NOTOK;
+    for(npop = 0; !(arity & 1); npop++) arity >>= 1;
+    if(stack->error > 0 || npop > stack->pos) return PLUMBER_NOTOK;
+    if(hash_values(&stack->stack[stack->pos - npop], npop, &in) != PLUMBER_OK) {
+        return PLUMBER_NOTOK;
+    }
+
+    for(i = key(id, npop, in) & k->mask; (old = k->table[i]) != NULL; i = (i + 1) & k->mask) {
+        if(old->state == PSTATE_OWN && old->sig->id == id &&
+            old->sig->create.npop == npop && old->sig->create.in == in) {
+            break;
+        }
+    }
+    if(old == NULL) return PLUMBER_NOTOK;
+
+    pipe = malloc(sizeof(plumber_pipe));
+    if(pipe == NULL) return PLUMBER_NOTOK;
+    pipe->sig = malloc(sizeof(plumber_sig));
+    if(pipe->sig == NULL) {
+        free(pipe);
+        return PLUMBER_NOTOK;
+    }
+    *pipe->sig = *old->sig;
+    pipe->type = old->type;
+    pipe->ud = old->ud;
+    pipe->from = old;
+    pipe->state = PSTATE_TAKEN;
+    pipe->npop = -1;
+    old->state = PSTATE_GIVEN;
+    plumbing_add_pipe(plumb->tmp, pipe);
+    replay(stack, &old->sig->create);
+    return PLUMBER_OK;
+}
+
+/* replaces a ugen's state with a new one, created for the arguments now on
+ * the stack. If that fails the old state is kept. */
+static int renew(plumber_data *plumb, plumber_pipe *pipe, sporth_func *f)
+{
+    sporth_stack *stack = &plumb->sporth.stack;
+    sporth_stack saved;
+    plumbing scratch, *tmp = plumb->tmp;
+    void *ud;
+    int rc = PLUMBER_OK;
+
+    memcpy(&saved, stack, sizeof(saved));
+    plumbing_init(&scratch);
+    plumb->tmp = &scratch;
+    plumb->mode = PLUMBER_CREATE;
+    f->func(stack, f->ud);
+    memcpy(stack, &saved, sizeof(saved));
+    plumb->tmp = tmp;
+
+    if(scratch.npipes == 1 && scratch.root.next->ud != NULL) {
+        ud = scratch.root.next->ud;
+        plumb->mode = PLUMBER_DESTROY;
+        plumb->last = pipe;
+        f->func(stack, f->ud);
+        pipe->ud = ud;
+    } else {
+        plumber_print(plumb, "Could not recreate %s\n",
+            plumb->sporth.flist[pipe->type - SPORTH_FOFFSET].name);
+        rc = PLUMBER_NOTOK;
+    }
+    plumbing_destroy(&scratch);
+    plumb->mode = PLUMBER_INIT;
+    plumb->last = pipe;
+    return rc;
+}
+
+int plumber_keep_begin(plumber_data *plumb)
+{
+    plumber_keeper *k = &plumb->keeper;
+    plumbing *old = plumb->pipes;
+    plumber_pipe *pipe;
+    uint32_t n, count = 0, size = 2, i;
+
+    plumber_keep_end(plumb);
+    if(!plumb->keep || old == plumb->tmp) return PLUMBER_OK;
+
+    for(pipe = old->root.next, n = 0; n < old->npipes; n++, pipe = pipe->next) {
+        if(pipe->sig != NULL && pipe->sig->inited) count++;
+    }
+    if(count == 0) return PLUMBER_OK;
+    while(size < 2 * count) size <<= 1;
+
+    k->table = calloc(size, sizeof(plumber_pipe *));
+    k->arity = calloc(plumb->sporth.nfunc, sizeof(uint64_t));
+    if(k->table == NULL || k->arity == NULL) {
+        plumber_keep_end(plumb);
+        return PLUMBER_NOTOK;
+    }
+    k->mask = size - 1;
+    k->pipes = plumb->tmp;
+
+    for(pipe = old->root.next, n = 0; n < old->npipes; n++, pipe = pipe->next) {
+        plumber_sig *sig = pipe->sig;
+        if(sig == NULL || !sig->inited || sig->id >= plumb->sporth.nfunc) continue;
+        k->arity[sig->id] |= 1ULL << sig->create.npop;
+        i = key(sig->id, sig->create.npop, sig->create.in) & k->mask;
+        while(k->table[i] != NULL) i = (i + 1) & k->mask;
+        k->table[i] = pipe;
+    }
+    return PLUMBER_OK;
+}
+
+/* hands taken state back to the running plumbing */
+int plumber_keep_revert(plumber_data *plumb)
+{
+    plumbing *pipes = plumb->keeper.pipes;
+    plumber_pipe *pipe;
+    uint32_t n;
+
+    if(pipes == NULL) return PLUMBER_OK;
+    for(pipe = pipes->root.next, n = 0; n < pipes->npipes; n++, pipe = pipe->next) {
+        if(pipe->state != PSTATE_TAKEN) continue;
+        pipe->from->ud = pipe->ud;
+        pipe->from->state = PSTATE_OWN;
+        pipe->state = PSTATE_GIVEN;
+    }
+    return PLUMBER_OK;
+}
+
+int plumber_keep_end(plumber_data *plumb)
+{
+    plumber_keeper *k = &plumb->keeper;
+    free(k->table);
+    free(k->arity);
+    k->table = NULL;
+    k->arity = NULL;
+    k->mask = 0;
+    k->pipes = NULL;
+    return PLUMBER_OK;
+}
+
+/* runs a function while parsing, in place of sporth_exec */
+int plumber_keep_exec(plumber_data *plumb, plumbing *pipes, const char *keyword)
+{
+    sporth_data *sporth = &plumb->sporth;
+    uint32_t id, npipes = pipes->npipes;
+    plumber_effect fx;
+    plumber_pipe *pipe;
+    int rc;
+
+    if(!plumb->keep || sporth_search(&sporth->dict, keyword, &id) != SPORTH_OK) {
+        return sporth_exec(sporth, keyword);
+    }
+
+    if(pipes == plumb->keeper.pipes && take(plumb, id) == PLUMBER_OK) {
+        return PLUMBER_OK;
+    }
+
+    rc = call(plumb, &sporth->flist[id], &fx);
+    pipe = pipes->last;
+    if(rc == PLUMBER_OK && fx.npop >= 0 &&
+        pipes->npipes == npipes + 1 && pipe->ud != NULL) {
+        pipe->sig = malloc(sizeof(plumber_sig));
+        if(pipe->sig != NULL) {
+            pipe->sig->id = id;
+            pipe->sig->inited = 0;
+            pipe->sig->create = fx;
+        }
+    }
+    return rc;
+}
+
+/* runs a ugen pipe to initialize or destroy it */
+int plumber_keep_compute(plumber_data *plumb, plumber_pipe *pipe, int mode)
+{
+    sporth_func *f = &plumb->sporth.flist[pipe->type - SPORTH_FOFFSET];
+    sporth_stack *stack = &plumb->sporth.stack;
+    plumber_sig *sig = pipe->sig;
+    int rc;
+
+    /* its state belongs to the other plumbing */
+    if(pipe->state == PSTATE_GIVEN) return PLUMBER_OK;
+
+    if(mode != PLUMBER_INIT || sig == NULL) return f->func(stack, f->ud);
+
+    if(pipe->state == PSTATE_TAKEN) {
+        pipe->state = PSTATE_OWN;
+        pipe->from = NULL;
+        if(replay(stack, &sig->init) == PLUMBER_OK) return PLUMBER_OK;
+        renew(plumb, pipe, f);
+    }
+
+    rc = call(plumb, f, &sig->init);
+    sig->inited = sig->init.npop >= 0;
+    return rc;
+}
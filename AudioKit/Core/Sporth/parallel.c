@@ -0,0 +1,846 @@
+/*
+ * parallel
+ *
+ * Computes the independent parts of a patch on worker threads, a block at
+ * a time.
+ *
+ * When a plumbing is initialized, the stack effect of each ugen is noted.
+ * From these the patch is read as a forest of expressions: each value on
+ * the stack comes from a run of pipes, made of the ugen that pushed it and
+ * the runs that made the values it popped. A run that leaves exactly one
+ * value, and whose ugens touch nothing but their own state and the stack,
+ * can be computed on its own, on its own stack. Ugens that reach outside
+ * (variables, tables being written, p values being set, nested code,
+ * dynamically loaded functions, printing) are never part of such a run. If
+ * a patch has any of them, ugens that read named state (anything that took
+ * a string, and p) are left out as well, since they must see the writes in
+ * order.
+ *
+ * The largest independent runs are chosen as tasks, and a task that
+ * dominates is split into the heavy runs under it, such as the voices
+ * under a sum of voices, for as long as that balances the work across the
+ * threads. Runs that are too light to be worth a thread stay where they
+ * are.
+ *
+ * A block is computed in two passes. Tasks are first claimed by the
+ * calling thread and the workers, and each is computed for every frame of
+ * the block into its own buffer. The rest of the patch is then computed
+ * frame by frame on the calling thread as before, with each task's run
+ * replaced by a push of its value for that frame. The join is therefore
+ * always in patch order, and the result does not depend on which thread
+ * computed what.
+ *
+ * Each task has its own sp_data, with its own random state seeded from the
+ * plumber's seed and the task's place in the patch, so random ugens in a
+ * task give the same values from one run to the next, though not the same
+ * values as they would when computed in order with the rest of the patch.
+ *
+ */
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#else
+#include <semaphore.h>
+#endif
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
+#include "plumber.h"
+
+#define PARALLEL_MAXTHREADS 16
+#define PARALLEL_MAXTASKS 64
+/* about two ugens with state */
+#define PARALLEL_MINCOST 8
+
+/* wakes a worker. Signalling never blocks, so the render thread may do it */
+#ifdef __APPLE__
+typedef dispatch_semaphore_t parallel_sem;
+static void sem_create(parallel_sem *s) { *s = dispatch_semaphore_create(0); }
+static void sem_free(parallel_sem *s) { dispatch_release(*s); }
+static void sem_signal(parallel_sem *s) { dispatch_semaphore_signal(*s); }
+static void sem_block(parallel_sem *s) { dispatch_semaphore_wait(*s, DISPATCH_TIME_FOREVER); }
+#else
+typedef sem_t parallel_sem;
+static void sem_create(parallel_sem *s) { sem_init(s, 0, 0); }
+static void sem_free(parallel_sem *s) { sem_destroy(s); }
+static void sem_signal(parallel_sem *s) { sem_post(s); }
+static void sem_block(parallel_sem *s) { while(sem_wait(s) != 0); }
+#endif
+
+typedef struct {
+    plumber_pipe *first;
+    uint32_t npipes;
+    uint32_t start;
+    int cost;
+    SPFLOAT *buf;
+    sp_data sp;
+} parallel_task;
+
+/* a run of pipes computed in order, or a task's value pushed */
+typedef struct {
+    plumber_pipe *first;
+    uint32_t npipes;
+    int task;
+} parallel_step;
+
+typedef struct parallel_plan {
+    /* the plumbing planned */
+    plumbing *pipes;
+    plumber_pipe *first;
+    uint32_t npipes;
+
+    int ntasks;
+    parallel_task *tasks;
+    /* tasks by decreasing cost, the order they are claimed in */
+    int *order;
+    int nsteps;
+    parallel_step *steps;
+    SPFLOAT *bufs;
+    /* set if a task did not leave exactly one value */
+    atomic_int failed;
+    /* plans retired before this one and not yet freed */
+    struct parallel_plan *older;
+} parallel_plan;
+
+struct plumber_parallel;
+
+typedef struct {
+    struct plumber_parallel *par;
+    plumber_data pd;
+    pthread_t thread;
+    int started;
+    parallel_sem wake;
+} parallel_worker;
+
+struct plumber_parallel {
+    plumber_data *owner;
+    int nthreads;
+    int maxframes;
+    /* the first is the calling thread's */
+    parallel_worker *workers;
+    int running;
+    atomic_int quit;
+    /* the length of a block in mach time units, for the workers' scheduling */
+    uint32_t period;
+
+    /* the block being computed: the number of tasks in the high half of
+     * claim and the next task to claim in the low half */
+    _Atomic(parallel_plan *) plan;
+    int nframes;
+    _Atomic uint32_t claim;
+    atomic_int done;
+    /* signalled by the worker that finishes a block's last task */
+    parallel_sem finished;
+
+    /* plans handed from the compiling thread to the render thread, and back
+     * to be freed. The compiling thread only ever empties retired */
+    parallel_plan *current;
+    _Atomic(parallel_plan *) pending;
+    _Atomic(parallel_plan *) retired;
+};
+
+/* ugens that reach outside their own state and the stack */
+static int is_shared(uint32_t type)
+{
+    switch(type) {
+        case SPORTH_EVAL:
+        case SPORTH_F:
+        case SPORTH_FLOAD:
+        case SPORTH_FLOADI:
+        case SPORTH_FCLOSE:
+        case SPORTH_FEXEC:
+        case SPORTH_GEN_SPORTH:
+        case SPORTH_IN:
+        case SPORTH_LOAD:
+        case SPORTH_PALIAS:
+        case SPORTH_POS:
+        case SPORTH_PRINT:
+        case SPORTH_PSET:
+        case SPORTH_REF:
+        case SPORTH_RENDER:
+        case SPORTH_SAY:
+        case SPORTH_SET:
+        case SPORTH_SETDURS:
+        case SPORTH_SRAND:
+        case SPORTH_TALIAS:
+        case SPORTH_TBLREC:
+        case SPORTH_TICK:
+        case SPORTH_TIN:
+        case SPORTH_TSET:
+        case SPORTH_VAR:
+        case SPORTH_VARSET:
+        case SPORTH_WRITECODE:
+        case SPORTH_ZEROS:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* ugens that read state that shared ugens may write */
+static int is_reader(plumber_pipe *pipe)
+{
+    switch(pipe->type) {
+        case SPORTH_P:
+        case SPORTH_DUR:
+        case SPORTH_DURS:
+            return 1;
+        default:
+            return pipe->strings;
+    }
+}
+
+static int is_ugen(plumber_pipe *pipe)
+{
+    return pipe->type != SPORTH_FLOAT && pipe->type != SPORTH_STRING;
+}
+
+static int is_builtin(plumber_data *plumb, plumber_pipe *pipe)
+{
+    return plumb->sporth.flist[pipe->type - SPORTH_FOFFSET].ud == plumb;
+}
+
+/* frees a plan and those retired before it */
+static void free_plan(parallel_plan *plan)
+{
+    parallel_plan *older;
+    while(plan != NULL) {
+        older = plan->older;
+        free(plan->tasks);
+        free(plan->order);
+        free(plan->steps);
+        free(plan->bufs);
+        free(plan);
+        plan = older;
+    }
+}
+
+/* computes a run of pipes as plumbing_compute does. Built in ugens get pd
+ * as their user data, so that a worker's copy stands in for the plumber */
+static void run(plumber_data *owner, plumber_data *pd, plumber_pipe *pipe, uint32_t npipes)
+{
+    sporth_func *flist = owner->sporth.flist;
+    sporth_stack *stack = &pd->sporth.stack;
+    sporth_func *f;
+    uint32_t n;
+    for(n = 0; n < npipes; n++) {
+        pd->next = pipe->next;
+        switch(pipe->type) {
+            case SPORTH_FLOAT:
+                sporth_stack_push_float(stack, *(float *)pipe->ud);
+                break;
+            case SPORTH_STRING:
+                break;
+            default:
+                f = &flist[pipe->type - SPORTH_FOFFSET];
+                pd->last = pipe;
+                f->func(stack, f->ud == owner ? pd : f->ud);
+                break;
+        }
+        pipe = pd->next;
+    }
+}
+
+static void run_task(struct plumber_parallel *par, parallel_worker *w,
+    parallel_plan *plan, parallel_task *task)
+{
+    plumber_data *owner = par->owner, *pd = &w->pd;
+    sporth_stack *stack = &pd->sporth.stack;
+    uint32_t rand = task->sp.rand;
+    int t;
+
+    task->sp = *owner->sp;
+    task->sp.rand = rand;
+    pd->sp = &task->sp;
+    pd->mode = PLUMBER_COMPUTE;
+    pd->sporth.flist = owner->sporth.flist;
+    pd->sporth.nfunc = owner->sporth.nfunc;
+    pd->pipes = owner->pipes;
+    pd->log = owner->log;
+    memcpy(pd->p, owner->p, sizeof(pd->p));
+    stack->error = 0;
+
+    for(t = 0; t < par->nframes; t++) {
+        stack->pos = 0;
+        run(owner, pd, task->first, task->npipes);
+        task->buf[t] = sporth_stack_pop_float(stack);
+    }
+    if(stack->error > 0 || stack->pos != 0) {
+        atomic_store_explicit(&plan->failed, 1, memory_order_relaxed);
+    }
+}
+
+/* claims and computes tasks until there are none left. A claim made after
+ * the block's tasks are all claimed fails, whichever block it lands in, so
+ * a worker that wakes late cannot run a task twice. Returns whether this
+ * thread finished the block's last task */
+static int take_tasks(struct plumber_parallel *par, parallel_worker *w)
+{
+    parallel_plan *plan;
+    uint32_t claim;
+    int last = 0;
+    for(;;) {
+        claim = atomic_fetch_add_explicit(&par->claim, 1, memory_order_acq_rel);
+        if((claim & 0xffff) >= (claim >> 16)) break;
+        plan = atomic_load_explicit(&par->plan, memory_order_relaxed);
+        run_task(par, w, plan, &plan->tasks[plan->order[claim & 0xffff]]);
+        last = atomic_fetch_add_explicit(&par->done, 1, memory_order_acq_rel) + 1 == plan->ntasks;
+    }
+    return last;
+}
+
+/* on Apple platforms the workers get the time constraint policy the render
+ * thread has, over the period of a block. Elsewhere they get SCHED_FIFO,
+ * which needs privileges on Linux. Either is ignored if refused */
+static void promote(struct plumber_parallel *par)
+{
+#ifdef __APPLE__
+    thread_time_constraint_policy_data_t policy;
+    policy.period = par->period;
+    policy.computation = par->period / 2;
+    policy.constraint = par->period;
+    policy.preemptible = 1;
+    thread_policy_set(pthread_mach_thread_np(pthread_self()),
+        THREAD_TIME_CONSTRAINT_POLICY, (thread_policy_t)&policy,
+        THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+#else
+    struct sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+}
+
+/* subnormals are flushed to zero, as they are on the render thread: the
+ * tail of a filter or reverb would otherwise run many times slower here */
+static void flush_denormals(void)
+{
+#if defined(__SSE__) || defined(__x86_64__)
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (1ULL << 24)));
+#endif
+}
+
+static void *work(void *ud)
+{
+    parallel_worker *w = ud;
+    struct plumber_parallel *par = w->par;
+    promote(par);
+    flush_denormals();
+    for(;;) {
+        sem_block(&w->wake);
+        if(atomic_load(&par->quit)) break;
+        if(take_tasks(par, w)) sem_signal(&par->finished);
+    }
+    return NULL;
+}
+
+static void start_workers(struct plumber_parallel *par)
+{
+    int i;
+    if(par->running) return;
+    par->running = 1;
+#ifdef __APPLE__
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    par->period = (uint32_t)(1e9 * par->maxframes / par->owner->sp->sr *
+        timebase.denom / timebase.numer);
+#endif
+    for(i = 1; i < par->nthreads; i++) {
+        parallel_worker *w = &par->workers[i];
+        w->started = pthread_create(&w->thread, NULL, work, w) == 0;
+        if(!w->started) par->running = 0;
+    }
+}
+
+int plumber_parallel_init(plumber_data *plumb, int nthreads, int maxframes)
+{
+    struct plumber_parallel *par;
+    int i;
+
+    plumber_parallel_destroy(plumb);
+    if(nthreads > PARALLEL_MAXTHREADS) nthreads = PARALLEL_MAXTHREADS;
+    if(nthreads < 2 || maxframes < 1) return PLUMBER_OK;
+
+    par = calloc(1, sizeof(struct plumber_parallel));
+    if(par == NULL) return PLUMBER_NOTOK;
+    par->workers = calloc(nthreads, sizeof(parallel_worker));
+    if(par->workers == NULL) {
+        free(par);
+        return PLUMBER_NOTOK;
+    }
+    par->owner = plumb;
+    par->nthreads = nthreads;
+    par->maxframes = maxframes;
+    atomic_init(&par->quit, 0);
+    atomic_init(&par->plan, NULL);
+    atomic_init(&par->claim, 0);
+    atomic_init(&par->done, 0);
+    atomic_init(&par->pending, NULL);
+    atomic_init(&par->retired, NULL);
+    sem_create(&par->finished);
+    for(i = 0; i < nthreads; i++) {
+        par->workers[i].par = par;
+        par->workers[i].pd.log = plumb->log;
+        sem_create(&par->workers[i].wake);
+    }
+    plumb->parallel = par;
+    return PLUMBER_OK;
+}
+
+int plumber_parallel_destroy(plumber_data *plumb)
+{
+    struct plumber_parallel *par = plumb->parallel;
+    int i;
+
+    if(par == NULL) return PLUMBER_OK;
+    atomic_store(&par->quit, 1);
+    for(i = 1; i < par->nthreads; i++) {
+        if(par->workers[i].started) {
+            sem_signal(&par->workers[i].wake);
+            pthread_join(par->workers[i].thread, NULL);
+        }
+    }
+    for(i = 0; i < par->nthreads; i++) sem_free(&par->workers[i].wake);
+    sem_free(&par->finished);
+    free_plan(par->current);
+    free_plan(atomic_load(&par->pending));
+    free_plan(atomic_load(&par->retired));
+    free(par->workers);
+    free(par);
+    plumb->parallel = NULL;
+    return PLUMBER_OK;
+}
+
+/* initializes a ugen pipe, noting its stack effect */
+int plumber_parallel_measure(plumber_data *plumb, plumber_pipe *pipe)
+{
+    sporth_stack *stack = &plumb->sporth.stack;
+    uint32_t error = stack->error;
+    int pos = stack->pos, str = -1, base, i, rc;
+
+    for(i = 0; i < pos; i++) {
+        if(stack->stack[i].type == SPORTH_STRING) str = i;
+    }
+    stack->low = pos;
+    rc = plumber_keep_compute(plumb, pipe, PLUMBER_INIT);
+
+    base = stack->low < stack->pos ? stack->low : stack->pos;
+    pipe->npop = stack->error > error ? -1 : pos - base;
+    pipe->npush = stack->pos - base;
+    pipe->strings = str >= base;
+    for(i = base; i < stack->pos; i++) {
+        if(stack->stack[i].type == SPORTH_STRING) pipe->strings = 1;
+    }
+    return rc;
+}
+
+/* the expression forest of a plumbing. Each pipe is a node, whose run
+ * starts at start[n] and ends with it. Values on the shadow stack are
+ * items; a ugen that pushes nothing leaves an item that holds no value, so
+ * that the ugen becomes part of whichever run consumes the values below */
+typedef struct {
+    uint32_t n;
+    plumber_pipe **pipes;
+    uint32_t *start;
+    int *cost;
+    char *local;
+    int *nout;
+    int *parent;
+    uint32_t *child, *nchild;
+    uint32_t *children;
+} parallel_graph;
+
+typedef struct {
+    uint32_t node;
+    int real;
+} parallel_item;
+
+static int eligible(parallel_graph *g, uint32_t n)
+{
+    return is_ugen(g->pipes[n]) && g->local[n] && g->nout[n] == 1;
+}
+
+static int build_graph(plumber_data *plumb, parallel_graph *g)
+{
+    plumbing *pipes = plumb->pipes;
+    plumber_pipe *pipe;
+    parallel_item *items;
+    uint32_t *seen, *count, nitems = 0, npool = 0, maxitems = 1, i, j, k;
+    int shared = 0, rc = PLUMBER_NOTOK;
+
+    g->n = pipes->npipes;
+    g->pipes = malloc(g->n * sizeof(plumber_pipe *));
+    g->start = malloc(g->n * sizeof(uint32_t));
+    g->cost = malloc(g->n * sizeof(int));
+    g->local = malloc(g->n);
+    g->nout = malloc(g->n * sizeof(int));
+    g->parent = malloc(g->n * sizeof(int));
+    g->child = malloc(g->n * sizeof(uint32_t));
+    g->nchild = malloc(g->n * sizeof(uint32_t));
+    seen = malloc(g->n * sizeof(uint32_t));
+    count = malloc(g->n * sizeof(uint32_t));
+    if(!g->pipes || !g->start || !g->cost || !g->local || !g->nout ||
+        !g->parent || !g->child || !g->nchild || !seen || !count) {
+        goto done;
+    }
+
+    for(pipe = pipes->root.next, i = 0; i < g->n; i++, pipe = pipe->next) {
+        g->pipes[i] = pipe;
+        if(!is_ugen(pipe)) {
+            maxitems++;
+            continue;
+        }
+        /* not initialized, or failed: its stack effect is unknown */
+        if(pipe->npop < 0) goto done;
+        maxitems += pipe->npush > 0 ? pipe->npush : 1;
+        if(is_shared(pipe->type) || !is_builtin(plumb, pipe)) shared = 1;
+    }
+    items = malloc(maxitems * sizeof(parallel_item));
+    g->children = malloc(maxitems * sizeof(uint32_t));
+    if(items == NULL || g->children == NULL) {
+        free(items);
+        goto done;
+    }
+
+    for(i = 0; i < g->n; i++) {
+        pipe = g->pipes[i];
+        g->parent[i] = -1;
+        g->child[i] = npool;
+        g->nchild[i] = 0;
+        seen[i] = UINT32_MAX;
+        if(!is_ugen(pipe)) {
+            g->start[i] = i;
+            g->cost[i] = 0;
+            g->local[i] = 1;
+            g->nout[i] = 1;
+            items[nitems].node = i;
+            items[nitems].real = 1;
+            nitems++;
+            continue;
+        }
+
+        g->local[i] = !is_shared(pipe->type) && is_builtin(plumb, pipe) &&
+            !(shared && is_reader(pipe));
+        g->cost[i] = pipe->ud != NULL ? 4 : 1;
+
+        /* the items down to the deepest value it popped are its own */
+        for(j = nitems, k = 0; j > 0 && k < (uint32_t)pipe->npop; j--) {
+            if(items[j - 1].real) k++;
+        }
+        /* it popped values pushed before this plumbing */
+        if(k < (uint32_t)pipe->npop) g->local[i] = 0;
+        g->start[i] = j < nitems ? g->start[items[j].node] : i;
+
+        for(k = j; k < nitems; k++) {
+            uint32_t c = items[k].node;
+            if(seen[c] != i) {
+                seen[c] = i;
+                count[c] = 0;
+                g->parent[c] = i;
+                g->cost[i] += g->cost[c];
+                g->local[i] &= g->local[c];
+                if(items[k].real) g->children[npool + g->nchild[i]++] = c;
+            }
+            if(items[k].real) count[c]++;
+        }
+        /* taking some of another ugen's values but not all of them ties
+         * the two together */
+        for(k = 0; k < g->nchild[i]; k++) {
+            uint32_t c = g->children[npool + k];
+            if((int)count[c] != g->nout[c]) g->local[i] = 0;
+        }
+        npool += g->nchild[i];
+
+        nitems = j;
+        g->nout[i] = pipe->npush;
+        if(pipe->npush == 0) {
+            items[nitems].node = i;
+            items[nitems].real = 0;
+            nitems++;
+        }
+        for(k = 0; k < (uint32_t)pipe->npush; k++) {
+            items[nitems].node = i;
+            items[nitems].real = 1;
+            nitems++;
+        }
+    }
+    free(items);
+    rc = PLUMBER_OK;
+
+done:
+    free(seen);
+    free(count);
+    return rc;
+}
+
+static void free_graph(parallel_graph *g)
+{
+    free(g->pipes);
+    free(g->start);
+    free(g->cost);
+    free(g->local);
+    free(g->nout);
+    free(g->parent);
+    free(g->child);
+    free(g->nchild);
+    free(g->children);
+}
+
+/* the heavy runs that could be tasks in place of node n, each the largest
+ * one on its branch */
+static int frontier(parallel_graph *g, uint32_t n, uint32_t *out, uint32_t *work)
+{
+    uint32_t nwork = 0, nout = 0, c, k;
+    for(k = 0; k < g->nchild[n]; k++) work[nwork++] = g->children[g->child[n] + k];
+    while(nwork > 0) {
+        c = work[--nwork];
+        if(eligible(g, c)) {
+            if(g->cost[c] >= PARALLEL_MINCOST) out[nout++] = c;
+        } else if(g->local[c]) {
+            for(k = 0; k < g->nchild[c]; k++) work[nwork++] = g->children[g->child[c] + k];
+        }
+    }
+    return nout;
+}
+
+/* chooses tasks: the largest independent runs, split while one of them
+ * outweighs a thread's share */
+static int choose(parallel_graph *g, int nthreads, uint32_t *tasks)
+{
+    uint32_t *sub, *work;
+    char *covered, *whole;
+    int ntasks = 0, total = 0, best, nsub, i;
+    uint32_t n;
+
+    sub = malloc(g->n * sizeof(uint32_t));
+    work = malloc(g->n * sizeof(uint32_t));
+    covered = calloc(g->n, 1);
+    whole = calloc(g->n, 1);
+    if(!sub || !work || !covered || !whole) goto done;
+
+    /* parents come after their children */
+    for(n = g->n; n-- > 0;) {
+        int p = g->parent[n];
+        covered[n] = p >= 0 && g->local[p] && (eligible(g, p) || covered[p]);
+        if(eligible(g, n) && !covered[n] && g->cost[n] >= PARALLEL_MINCOST &&
+            ntasks < PARALLEL_MAXTASKS) {
+            tasks[ntasks++] = n;
+            total += g->cost[n];
+        }
+    }
+
+    for(;;) {
+        best = -1;
+        for(i = 0; i < ntasks; i++) {
+            if(whole[tasks[i]]) continue;
+            if(best < 0 || g->cost[tasks[i]] > g->cost[tasks[best]]) best = i;
+        }
+        if(best < 0) break;
+        if(ntasks >= nthreads && g->cost[tasks[best]] * nthreads <= total) break;
+        nsub = frontier(g, tasks[best], sub, work);
+        if(nsub < 2 || ntasks - 1 + nsub > PARALLEL_MAXTASKS) {
+            whole[tasks[best]] = 1;
+            continue;
+        }
+        total -= g->cost[tasks[best]];
+        tasks[best] = tasks[--ntasks];
+        for(i = 0; i < nsub; i++) {
+            tasks[ntasks++] = sub[i];
+            total += g->cost[sub[i]];
+        }
+    }
+
+done:
+    free(sub);
+    free(work);
+    free(covered);
+    free(whole);
+    return ntasks;
+}
+
+static int by_start(const void *a, const void *b)
+{
+    const parallel_task *x = a, *y = b;
+    return (x->start > y->start) - (x->start < y->start);
+}
+
+static parallel_plan *build_plan(plumber_data *plumb, struct plumber_parallel *par)
+{
+    parallel_plan *plan;
+    parallel_graph g;
+    uint32_t chosen[PARALLEL_MAXTASKS], i;
+    int t, s, ntasks = 0;
+
+    plan = calloc(1, sizeof(parallel_plan));
+    if(plan == NULL) return NULL;
+    plan->pipes = plumb->pipes;
+    plan->first = plumb->pipes->root.next;
+    plan->npipes = plumb->pipes->npipes;
+    atomic_init(&plan->failed, 0);
+
+    memset(&g, 0, sizeof(g));
+    if(plan->npipes > 0 && build_graph(plumb, &g) == PLUMBER_OK) {
+        ntasks = choose(&g, par->nthreads, chosen);
+    }
+    /* one task would leave nothing to do alongside it */
+    if(ntasks < 2) {
+        free_graph(&g);
+        return plan;
+    }
+
+    plan->tasks = calloc(ntasks, sizeof(parallel_task));
+    plan->order = malloc(ntasks * sizeof(int));
+    plan->steps = malloc((2 * ntasks + 1) * sizeof(parallel_step));
+    plan->bufs = malloc((size_t)ntasks * par->maxframes * sizeof(SPFLOAT));
+    if(!plan->tasks || !plan->order || !plan->steps || !plan->bufs) {
+        free_graph(&g);
+        free_plan(plan);
+        return NULL;
+    }
+
+    for(t = 0; t < ntasks; t++) {
+        parallel_task *task = &plan->tasks[t];
+        task->start = g.start[chosen[t]];
+        task->first = g.pipes[task->start];
+        task->npipes = chosen[t] - task->start + 1;
+        task->cost = g.cost[chosen[t]];
+    }
+    qsort(plan->tasks, ntasks, sizeof(parallel_task), by_start);
+
+    for(t = 0; t < ntasks; t++) {
+        parallel_task *task = &plan->tasks[t];
+        task->buf = plan->bufs + (size_t)t * par->maxframes;
+        task->sp.rand = plumb->seed ^ (2654435761U * (uint32_t)(t + 1));
+        plan->order[t] = t;
+    }
+    /* heaviest first, so the last to finish are short */
+    for(t = 1; t < ntasks; t++) {
+        int o = plan->order[t];
+        for(s = t; s > 0 && plan->tasks[plan->order[s - 1]].cost < plan->tasks[o].cost; s--) {
+            plan->order[s] = plan->order[s - 1];
+        }
+        plan->order[s] = o;
+    }
+
+    for(i = 0, t = 0, s = 0; i < g.n;) {
+        parallel_step *step = &plan->steps[s++];
+        if(t < ntasks && plan->tasks[t].start == i) {
+            step->first = NULL;
+            step->npipes = 0;
+            step->task = t;
+            i += plan->tasks[t].npipes;
+            t++;
+        } else {
+            step->first = g.pipes[i];
+            step->npipes = (t < ntasks ? plan->tasks[t].start : g.n) - i;
+            step->task = -1;
+            i += step->npipes;
+        }
+    }
+    plan->nsteps = s;
+    plan->ntasks = ntasks;
+    free_graph(&g);
+    return plan;
+}
+
+/* plans the plumbing that was just initialized. The plan is handed to the
+ * render thread, which takes it at its next block */
+int plumber_parallel_plan(plumber_data *plumb)
+{
+    struct plumber_parallel *par = plumb->parallel;
+    parallel_plan *plan;
+
+    if(par == NULL) return PLUMBER_OK;
+    free_plan(atomic_exchange(&par->retired, NULL));
+    plan = build_plan(plumb, par);
+    if(plan == NULL) return PLUMBER_NOTOK;
+    if(plan->ntasks > 0) start_workers(par);
+    free_plan(atomic_exchange(&par->pending, plan));
+    return PLUMBER_OK;
+}
+
+static int usable(plumber_data *plumb, struct plumber_parallel *par, parallel_plan *plan)
+{
+    return par->running && plan != NULL && plan->ntasks > 0 &&
+        !atomic_load_explicit(&plan->failed, memory_order_relaxed) &&
+        plan->pipes == plumb->pipes &&
+        plan->first == plumb->pipes->root.next &&
+        plan->npipes == plumb->pipes->npipes;
+}
+
+static void compute_tasks(struct plumber_parallel *par, parallel_plan *plan, int nframes)
+{
+    int i, nwake = plan->ntasks < par->nthreads ? plan->ntasks : par->nthreads;
+
+    atomic_store_explicit(&par->plan, plan, memory_order_relaxed);
+    par->nframes = nframes;
+    atomic_store_explicit(&par->done, 0, memory_order_relaxed);
+    atomic_store_explicit(&par->claim, (uint32_t)plan->ntasks << 16, memory_order_release);
+    for(i = 1; i < nwake; i++) sem_signal(&par->workers[i].wake);
+
+    /* a worker finishing the last task wakes this thread. Each block has
+     * one last task, so the semaphore is back to zero after every block */
+    if(!take_tasks(par, &par->workers[0])) sem_block(&par->finished);
+}
+
+/* computes nframes of the plumbing, popping nchan values into out after
+ * each frame. The p values are read once for the whole block */
+int plumber_compute_block(plumber_data *plumb, SPFLOAT **out, int nchan, int nframes)
+{
+    struct plumber_parallel *par = plumb->parallel;
+    sporth_stack *stack = &plumb->sporth.stack;
+    parallel_plan *plan = NULL, *next;
+    int offset, n, t, s, c;
+
+    if(par != NULL) {
+        next = atomic_exchange(&par->pending, NULL);
+        if(next != NULL && par->current != NULL) {
+            /* freed by the compiling thread, not here. Plans it has not
+             * collected yet are chained behind the current one; the slot
+             * stays empty between the two exchanges, since the compiling
+             * thread only takes from it */
+            par->current->older = atomic_exchange(&par->retired, NULL);
+            atomic_exchange(&par->retired, par->current);
+        }
+        if(next != NULL) par->current = next;
+        plan = par->current;
+        if(!usable(plumb, par, plan)) plan = NULL;
+    }
+
+    for(offset = 0; offset < nframes; offset += n) {
+        n = nframes - offset;
+        if(plan == NULL) {
+            for(t = 0; t < n; t++) {
+                plumber_compute(plumb, PLUMBER_COMPUTE);
+                for(c = 0; c < nchan; c++) out[c][offset + t] = sporth_stack_pop_float(stack);
+            }
+            continue;
+        }
+        if(n > par->maxframes) n = par->maxframes;
+        compute_tasks(par, plan, n);
+        plumb->mode = PLUMBER_COMPUTE;
+        for(t = 0; t < n; t++) {
+            for(s = 0; s < plan->nsteps; s++) {
+                parallel_step *step = &plan->steps[s];
+                if(step->task >= 0) {
+                    sporth_stack_push_float(stack, plan->tasks[step->task].buf[t]);
+                } else {
+                    run(plumb, plumb, step->first, step->npipes);
+                }
+            }
+            for(c = 0; c < nchan; c++) out[c][offset + t] = sporth_stack_pop_float(stack);
+        }
+    }
+    return PLUMBER_OK;
+}
@@ -350,7 +350,7 @@ int plumber_lexer(plumber_data *plumb, plumbing *pipes, char *out, uint32_t len)
 #ifdef DEBUG_MODE
             plumber_print(plumb, "%s is a function!\n", out);
 #endif
-            rc = sporth_exec(&plumb->sporth, out);
+            rc = plumber_keep_exec(plumb, pipes, out);
             if(rc == PLUMBER_NOTOK || rc == SPORTH_NOTOK) {
                 plumber_print(plumb, "%s returned an error.\n", out);
 #ifdef DEBUG_MODE
@@ -439,8 +439,8 @@ int plumber_parse(plumber_data *plumb)
 
 int plumber_reparse(plumber_data *plumb)
 {
+    /* plumber_swap initializes the new pipes */
     if(plumbing_parse(plumb, plumb->tmp) == PLUMBER_OK) {
-        plumbing_compute(plumb, plumb->tmp, PLUMBER_INIT);
 #ifdef DEBUG_MODE
         plumber_print(plumb, "Successful parse...\n");
         plumber_print(plumb, "at stack position %d\n",
@@ -477,6 +477,7 @@ int plumber_swap(plumber_data *plumb, int error)
 {
     if(error == PLUMBER_NOTOK) {
         plumber_print(plumb, "Did not recompile...\n");
+        plumber_keep_revert(plumb);
         plumbing_compute(plumb, plumb->tmp, PLUMBER_DESTROY);
         plumbing_destroy(plumb->tmp);
         sporth_stack_init(&plumb->sporth.stack);
@@ -508,6 +509,7 @@ int plumber_swap(plumber_data *plumb, int error)
         plumb->sp->pos = 0;
         plumbing_compute(plumb, plumb->pipes, PLUMBER_INIT);
     }
+    plumber_keep_end(plumb);
     return PLUMBER_OK;
 }
 
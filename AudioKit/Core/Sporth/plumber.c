@@ -50,6 +50,11 @@ int plumber_init(plumber_data *plumb)
     plumb->seed = (int) time(NULL);
     plumb->fp = NULL;
     plumb->recompile = 0;
+    plumb->keep = 1;
+    plumb->keeper.pipes = NULL;
+    plumb->keeper.table = NULL;
+    plumb->keeper.arity = NULL;
+    plumb->parallel = NULL;
     int pos;
     for(pos = 0; pos < 16; pos++) plumb->p[pos] = 0;
     plumb->showprog = 0;
@@ -93,8 +98,14 @@ int plumbing_compute(plumber_data *plumb, plumbing *pipes, int mode)
                 break;
             default:
                 plumb->last = pipe;
-                sporth->flist[pipe->type - SPORTH_FOFFSET].func(&sporth->stack,
-                                                                sporth->flist[pipe->type - SPORTH_FOFFSET].ud);
+                if(mode == PLUMBER_COMPUTE) {
+                    sporth->flist[pipe->type - SPORTH_FOFFSET].func(&sporth->stack,
+                                                                    sporth->flist[pipe->type - SPORTH_FOFFSET].ud);
+                } else if(mode == PLUMBER_INIT && plumb->parallel != NULL) {
+                    plumber_parallel_measure(plumb, pipe);
+                } else {
+                    plumber_keep_compute(plumb, pipe, mode);
+                }
                 break;
         }
         pipe = plumb->next;
@@ -105,6 +116,10 @@ int plumbing_compute(plumber_data *plumb, plumbing *pipes, int mode)
     plumb->next = top_next;
     /* restore temp */
     plumb->tmp = tmp;
+    /* the top level plumbing is ready to be planned */
+    if(mode == PLUMBER_INIT && pipes == prev) {
+        plumber_parallel_plan(plumb);
+    }
     return PLUMBER_OK;
 }
 
@@ -195,6 +210,7 @@ int plumbing_destroy(plumbing *pipes)
             free(pipe->ud);
         }
 
+        free(pipe->sig);
         free(pipe);
         pipe = next;
     }
@@ -207,6 +223,8 @@ int plumber_clean(plumber_data *plumb)
     sporth_htable_destroy(&plumb->sporth.dict);
     plumbing_destroy(plumb->pipes);
     plumber_ftmap_destroy(plumb);
+    plumber_keep_end(plumb);
+    plumber_parallel_destroy(plumb);
     if(plumb->fp != NULL) fclose(plumb->fp);
     free(plumb->sporth.flist);
     return PLUMBER_OK;
@@ -230,6 +248,10 @@ int plumber_add_float(plumber_data *plumb, plumbing *pipes, float num)
     }
 
     new->type = SPORTH_FLOAT;
+    new->sig = NULL;
+    new->from = NULL;
+    new->state = PSTATE_OWN;
+    new->npop = -1;
     new->size = sizeof(SPFLOAT);
     new->ud = malloc(new->size);
     float *val = new->ud;
@@ -253,6 +275,10 @@ char * plumber_add_string(plumber_data *plumb, plumbing *pipes, const char *str)
     }
 
     new->type = SPORTH_STRING;
+    new->sig = NULL;
+    new->from = NULL;
+    new->state = PSTATE_OWN;
+    new->npop = -1;
     new->size = sizeof(char) * strlen(str) + 1;
     new->ud = malloc(new->size);
     char *sval = new->ud;
@@ -277,6 +303,10 @@ int plumber_add_ugen(plumber_data *plumb, uint32_t id, void *ud)
 
     new->type = id;
     new->ud = ud;
+    new->sig = NULL;
+    new->from = NULL;
+    new->state = PSTATE_OWN;
+    new->npop = -1;
 
     plumbing_add_pipe(plumb->tmp, new);
     return PLUMBER_OK;
@@ -319,6 +349,7 @@ int plumber_reinit(plumber_data *plumb)
     if(plumb->fp != NULL) fseek(plumb->fp, 0L, SEEK_SET);
     sporth_stack_init(&plumb->sporth.stack);
     plumber_ftmap_init(plumb);
+    plumber_keep_begin(plumb);
     return PLUMBER_OK;
 }
 
@@ -90,6 +90,7 @@ float sporth_stack_pop_float(sporth_stack *stack)
     }
 
     stack->pos--;
+    if(stack->pos < stack->low) stack->low = stack->pos;
     return pstack->fval;
 }
 
@@ -121,6 +122,7 @@ const char * sporth_stack_pop_string(sporth_stack *stack)
 
     str = pstack->sval;
     stack->pos--;
+    if(stack->pos < stack->low) stack->low = stack->pos;
     return str;
 }
 
@@ -128,5 +130,6 @@ int sporth_stack_init(sporth_stack *stack)
 {
     stack->pos = 0;
     stack->error = 0;
+    stack->low = 0;
     return SPORTH_OK;
 }
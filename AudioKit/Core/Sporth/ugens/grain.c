@@ -0,0 +1,131 @@
+#include <stdlib.h>
+#include "plumber.h"
+
+/* starts a grain reading src from pos (a fraction of the table) at speed,
+ * for dur seconds, with ris and dec seconds of attack and release read from
+ * the win table */
+static void start_grain(sp_data *sp, sp_grainpool *pool, SPFLOAT pos,
+    SPFLOAT speed, SPFLOAT dur, SPFLOAT ris, SPFLOAT dec, SPFLOAT amp)
+{
+    sp_grain grain;
+    grain.phs = grain.inc = 0;
+    grain.pos = pos * pool->src->size;
+    grain.speed = speed;
+    grain.amp = amp;
+    grain.expamp = 1.0;
+    grain.dur = (int32_t)(dur * sp->sr);
+    if(ris >= 1.0 / sp->sr) {
+        grain.risphs = 0;
+        grain.risinc = (int32_t)(pool->win->sicvt / ris);
+    } else {
+        grain.risphs = SP_FT_MAXLEN;
+        grain.risinc = 0;
+    }
+    grain.decinc = 0;
+    if((grain.dectim = (int32_t)(dec * sp->sr)) > 0) {
+        grain.decinc = (int32_t)(pool->win->sicvt / dec);
+    }
+    sp_grainpool_add(sp, pool, &grain);
+}
+
+int sporth_grain(sporth_stack *stack, void *ud)
+{
+    plumber_data *pd = ud;
+    SPFLOAT out;
+    const char *srcstr, *winstr;
+    sp_ftbl *src;
+    sp_ftbl *win;
+    int maxgrains;
+    SPFLOAT trig;
+    SPFLOAT pos;
+    SPFLOAT speed;
+    SPFLOAT dur;
+    SPFLOAT ris;
+    SPFLOAT dec;
+    SPFLOAT amp;
+    sp_grainpool *pool;
+
+    switch(pd->mode) {
+        case PLUMBER_CREATE:
+
+#ifdef DEBUG_MODE
+            plumber_print(pd, "grain: Creating\n");
+#endif
+
+            sp_grainpool_create(&pool);
+            plumber_add_ugen(pd, SPORTH_GRAIN, pool);
+            if(sporth_check_args(stack, "ffffffffss") != SPORTH_OK) {
+                plumber_print(pd,"Not enough arguments for grain\n");
+                stack->error++;
+                return PLUMBER_NOTOK;
+            }
+            winstr = sporth_stack_pop_string(stack);
+            srcstr = sporth_stack_pop_string(stack);
+            maxgrains = sporth_stack_pop_float(stack);
+            amp = sporth_stack_pop_float(stack);
+            dec = sporth_stack_pop_float(stack);
+            ris = sporth_stack_pop_float(stack);
+            dur = sporth_stack_pop_float(stack);
+            speed = sporth_stack_pop_float(stack);
+            pos = sporth_stack_pop_float(stack);
+            trig = sporth_stack_pop_float(stack);
+            sporth_stack_push_float(stack, 0);
+            break;
+        case PLUMBER_INIT:
+
+#ifdef DEBUG_MODE
+            plumber_print(pd, "grain: Initialising\n");
+#endif
+
+            winstr = sporth_stack_pop_string(stack);
+            srcstr = sporth_stack_pop_string(stack);
+            maxgrains = sporth_stack_pop_float(stack);
+            amp = sporth_stack_pop_float(stack);
+            dec = sporth_stack_pop_float(stack);
+            ris = sporth_stack_pop_float(stack);
+            dur = sporth_stack_pop_float(stack);
+            speed = sporth_stack_pop_float(stack);
+            pos = sporth_stack_pop_float(stack);
+            trig = sporth_stack_pop_float(stack);
+            pool = pd->last->ud;
+
+            if(plumber_ftmap_search(pd, srcstr, &src) == PLUMBER_NOTOK) {
+                stack->error++;
+                return PLUMBER_NOTOK;
+            }
+
+            if(plumber_ftmap_search(pd, winstr, &win) == PLUMBER_NOTOK) {
+                stack->error++;
+                return PLUMBER_NOTOK;
+            }
+
+            sp_grainpool_init(pd->sp, pool, src, win, maxgrains, SP_GRAIN_POSITION);
+
+            sporth_stack_push_float(stack, 0);
+            break;
+        case PLUMBER_COMPUTE:
+            maxgrains = sporth_stack_pop_float(stack);
+            amp = sporth_stack_pop_float(stack);
+            dec = sporth_stack_pop_float(stack);
+            ris = sporth_stack_pop_float(stack);
+            dur = sporth_stack_pop_float(stack);
+            speed = sporth_stack_pop_float(stack);
+            pos = sporth_stack_pop_float(stack);
+            trig = sporth_stack_pop_float(stack);
+            pool = pd->last->ud;
+            if(trig != 0) {
+                start_grain(pd->sp, pool, pos, speed, dur, ris, dec, amp);
+            }
+            sp_grainpool_compute_block(pd->sp, pool, &out, 1);
+            sporth_stack_push_float(stack, out);
+            break;
+        case PLUMBER_DESTROY:
+            pool = pd->last->ud;
+            sp_grainpool_destroy(&pool);
+            break;
+        default:
+            plumber_print(pd, "grain: Unknown mode!\n");
+            break;
+    }
+    return PLUMBER_OK;
+}
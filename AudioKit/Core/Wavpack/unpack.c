@@ -36,6 +36,16 @@
     #define DECORR_MONO_PASS_CONT unpack_decorr_mono_pass_cont_armv7
 #endif
 
+// Without assembly, the common stereo passes process both channels together in
+// two-lane vectors (GCC/Clang vector extensions, which become NEON or SSE). The
+// weights are applied with 64-bit products, which give the same results as the
+// apply_weight() macro for all sample magnitudes.
+
+#if !defined(DECORR_STEREO_PASS_CONT) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__clang__) || __GNUC__ >= 9)
+    #define DECORR_STEREO_PASS_SIMD
+#endif
+
 #ifdef DECORR_STEREO_PASS_CONT
 extern void DECORR_STEREO_PASS_CONT (struct decorr_pass *dpp, int32_t *buffer, int32_t sample_count, int32_t long_math);
 extern void DECORR_MONO_PASS_CONT (struct decorr_pass *dpp, int32_t *buffer, int32_t sample_count, int32_t long_math);
@@ -68,6 +78,9 @@ extern void DECORR_MONO_PASS_CONT (struct decorr_pass *dpp, int32_t *buffer, int
 // occurs or the end of the block is reached.
 
 static void decorr_stereo_pass (struct decorr_pass *dpp, int32_t *buffer, int32_t sample_count);
+#ifdef DECORR_STEREO_PASS_SIMD
+static int decorr_stereo_pass_simd (struct decorr_pass *dpp, int32_t *buffer, int32_t sample_count);
+#endif
 static void decorr_mono_pass (struct decorr_pass *dpp, int32_t *buffer, int32_t sample_count);
 static void fixup_samples (WavpackContext *wpc, int32_t *buffer, uint32_t sample_count);
 
@@ -570,6 +583,11 @@ static void decorr_stereo_pass (struct decorr_pass *dpp, int32_t *buffer, int32_
     int32_t *bptr, *eptr = buffer + (sample_count * 2);
     int m, k;
 
+#ifdef DECORR_STEREO_PASS_SIMD
+    if (decorr_stereo_pass_simd (dpp, buffer, sample_count))
+        return;
+#endif
+
     switch (dpp->term) {
         case 17:
             for (bptr = buffer; bptr < eptr; bptr += 2) {
@@ -669,6 +687,95 @@ static void decorr_stereo_pass (struct decorr_pass *dpp, int32_t *buffer, int32_
     }
 }
 
+#ifdef DECORR_STEREO_PASS_SIMD
+
+typedef int32_t stereo_int32 __attribute__ ((vector_size (8)));
+typedef int64_t stereo_int64 __attribute__ ((vector_size (16)));
+
+static inline stereo_int32 apply_weight_stereo (stereo_int32 weight, stereo_int32 sample)
+{
+    stereo_int64 product = __builtin_convertvector (weight, stereo_int64) * __builtin_convertvector (sample, stereo_int64);
+    return __builtin_convertvector ((product + 512) >> 10, stereo_int32);
+}
+
+// Same as update_weight() on each lane: lanes where source or result is zero keep their weight
+
+static inline stereo_int32 update_weight_stereo (stereo_int32 weight, stereo_int32 delta, stereo_int32 source, stereo_int32 result)
+{
+    stereo_int32 s = (source ^ result) >> 31;
+    stereo_int32 active = (source != 0) & (result != 0);
+    return weight + (((delta ^ s) - s) & active);
+}
+
+// Vector version of decorr_stereo_pass() for the positive terms, leaving dpp in exactly
+// the same state. Returns FALSE for the cross-channel (negative) terms, which it can't handle.
+
+static int decorr_stereo_pass_simd (struct decorr_pass *dpp, int32_t *buffer, int32_t sample_count)
+{
+    stereo_int32 weight = { dpp->weight_A, dpp->weight_B }, delta = { dpp->delta, dpp->delta };
+    stereo_int32 samples [MAX_TERM], sam, input, output;
+    int32_t *bptr, *eptr = buffer + (sample_count * 2);
+    int m, k;
+
+    if (dpp->term < 0)
+        return FALSE;
+
+    for (k = 0; k < MAX_TERM; k++) {
+        samples [k] [0] = dpp->samples_A [k];
+        samples [k] [1] = dpp->samples_B [k];
+    }
+
+    switch (dpp->term) {
+        case 17:
+            for (bptr = buffer; bptr < eptr; bptr += 2) {
+                memcpy (&input, bptr, sizeof (input));
+                sam = 2 * samples [0] - samples [1];
+                samples [1] = samples [0];
+                samples [0] = output = apply_weight_stereo (weight, sam) + input;
+                weight = update_weight_stereo (weight, delta, sam, input);
+                memcpy (bptr, &output, sizeof (output));
+            }
+
+            break;
+
+        case 18:
+            for (bptr = buffer; bptr < eptr; bptr += 2) {
+                memcpy (&input, bptr, sizeof (input));
+                sam = samples [0] + ((samples [0] - samples [1]) >> 1);
+                samples [1] = samples [0];
+                samples [0] = output = apply_weight_stereo (weight, sam) + input;
+                weight = update_weight_stereo (weight, delta, sam, input);
+                memcpy (bptr, &output, sizeof (output));
+            }
+
+            break;
+
+        default:
+            for (m = 0, k = dpp->term & (MAX_TERM - 1), bptr = buffer; bptr < eptr; bptr += 2) {
+                memcpy (&input, bptr, sizeof (input));
+                sam = samples [m];
+                samples [k] = output = apply_weight_stereo (weight, sam) + input;
+                weight = update_weight_stereo (weight, delta, sam, input);
+                memcpy (bptr, &output, sizeof (output));
+                m = (m + 1) & (MAX_TERM - 1);
+                k = (k + 1) & (MAX_TERM - 1);
+            }
+
+            break;
+    }
+
+    for (k = 0; k < MAX_TERM; k++) {
+        dpp->samples_A [k] = samples [k] [0];
+        dpp->samples_B [k] = samples [k] [1];
+    }
+
+    dpp->weight_A = weight [0];
+    dpp->weight_B = weight [1];
+    return TRUE;
+}
+
+#endif
+
 // This is a helper function for unpack_samples() that applies several final
 // operations. First, if the data is 32-bit float data, then that conversion
 // is done in the float.c module (whether lossy or lossless) and we return.
@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////
+//                           **** WAVPACK ****                            //
+//                  Hybrid Lossless Wavefile Compressor                   //
+//              Copyright (c) 1998 - 2013 Conifer Software.               //
+//                          All Rights Reserved.                          //
+//      Distributed under the BSD Software License (see license.txt)      //
+////////////////////////////////////////////////////////////////////////////
+
+// unpack_parallel.c
+
+// This module unpacks whole files straight into planar floating-point
+// buffers, optionally splitting the work across threads. WavPack blocks
+// decode independently, so each thread gets its own context (opened on
+// its own stream through whatever WavpackStreamReader the caller uses),
+// seeks to the start of a run of blocks and decodes only that run. The
+// integer-to-float conversion and deinterleaving are done a small chunk at
+// a time, while the unpacked samples are still in cache.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "wavpack_local.h"
+
+#if !defined(_WIN32) && !defined(NO_SEEKING)
+#include <pthread.h>
+#define PARALLEL_UNPACK
+#endif
+
+#define UNPACK_CHUNK_SAMPLES 1024
+
+typedef struct {
+    WavpackContext *wpc;
+    float **channels;
+    uint32_t start, count, unpacked;
+} UnpackRange;
+
+///////////////////////////// executable code ////////////////////////////////
+
+// Unpack the specified number of samples from the current position into
+// separate float arrays, one per reduced channel, starting at the specified
+// offset within them. Integer samples are scaled to +/- 1.0; float samples
+// are passed through as they come from WavpackUnpackSamples() (so they are
+// normalized only if the file was opened with OPEN_NORMALIZE). Returns the
+// number of samples actually unpacked, which is less than requested only at
+// the end of the file or on an allocation failure.
+
+uint32_t WavpackUnpackSamplesFloat (WavpackContext *wpc, float **channels, uint32_t offset, uint32_t samples)
+{
+    int num_channels = WavpackGetReducedChannels (wpc), is_float = WavpackGetMode (wpc) & MODE_FLOAT;
+    float scale = 1.0f / (float) (1U << (WavpackGetBitsPerSample (wpc) - 1));
+    uint32_t unpacked = 0;
+    int32_t *buffer;
+
+    if (num_channels <= 0 || !(buffer = malloc (UNPACK_CHUNK_SAMPLES * num_channels * sizeof (int32_t))))
+        return 0;
+
+    while (unpacked < samples) {
+        uint32_t request = samples - unpacked < UNPACK_CHUNK_SAMPLES ? samples - unpacked : UNPACK_CHUNK_SAMPLES;
+        uint32_t count = WavpackUnpackSamples (wpc, buffer, request), i;
+        int c;
+
+        for (c = 0; c < num_channels; c++) {
+            float *dst = channels [c] + offset + unpacked;
+            int32_t *src = buffer + c;
+
+            if (is_float)
+                for (i = 0; i < count; i++, src += num_channels)
+                    memcpy (dst + i, src, sizeof (float));
+            else if (num_channels == 1)
+                for (i = 0; i < count; i++)
+                    dst [i] = scale * (float) src [i];
+            else
+                for (i = 0; i < count; i++, src += num_channels)
+                    dst [i] = scale * (float) *src;
+        }
+
+        unpacked += count;
+
+        if (count < request)
+            break;
+    }
+
+    free (buffer);
+    return unpacked;
+}
+
+static void *unpack_range (void *param)
+{
+    UnpackRange *range = param;
+
+#ifndef NO_SEEKING
+    if (range->start && !WavpackSeekSample (range->wpc, range->start))
+        return NULL;
+#endif
+
+    range->unpacked = WavpackUnpackSamplesFloat (range->wpc, range->channels, range->start, range->count);
+    return NULL;
+}
+
+// Unpack a whole file into planar float arrays (as WavpackUnpackSamplesFloat())
+// using num_contexts threads. Every context must be freshly opened on the same
+// file with the same flags, on its own stream, and positioned at the start;
+// the caller closes them afterwards. The file is divided on multiples of the
+// first block's length, which are block boundaries in files written with a
+// fixed block size; otherwise seeking just decodes a little of a block twice.
+// The calling thread decodes the first range.
+// Returns the total number of samples unpacked, which equals the file's
+// sample count on success.
+
+uint32_t WavpackUnpackParallel (WavpackContext **contexts, int num_contexts, float **channels)
+{
+    uint32_t total_samples = WavpackGetNumSamples (contexts [0]);
+    uint32_t block_samples = WavpackGetNumSamplesInFrame (contexts [0]);
+    uint32_t total_blocks, start = 0, unpacked = 0;
+    UnpackRange ranges [64];
+    int num_ranges, i;
+
+    if (!block_samples || block_samples == (uint32_t) -1)
+        block_samples = UNPACK_CHUNK_SAMPLES;
+
+    total_blocks = (total_samples + block_samples - 1) / block_samples;
+    num_ranges = num_contexts < 64 ? num_contexts : 64;
+
+#ifndef PARALLEL_UNPACK
+    num_ranges = 1;
+#endif
+
+    if ((uint32_t) num_ranges > total_blocks)
+        num_ranges = total_blocks ? total_blocks : 1;
+
+    for (i = 0; i < num_ranges; i++) {
+        uint32_t end = (uint32_t) ((uint64_t) total_blocks * (i + 1) / num_ranges) * block_samples;
+
+        if (end > total_samples || i == num_ranges - 1)
+            end = total_samples;
+
+        ranges [i].wpc = contexts [i];
+        ranges [i].channels = channels;
+        ranges [i].start = start;
+        ranges [i].count = end - start;
+        ranges [i].unpacked = 0;
+        start = end;
+    }
+
+#ifdef PARALLEL_UNPACK
+    {
+        pthread_t threads [64];
+        int started [64] = { 0 };
+
+        for (i = 1; i < num_ranges; i++)
+            started [i] = pthread_create (&threads [i], NULL, unpack_range, &ranges [i]) == 0;
+
+        unpack_range (&ranges [0]);
+
+        for (i = 1; i < num_ranges; i++)
+            if (started [i])
+                pthread_join (threads [i], NULL);
+            else
+                unpack_range (&ranges [i]);
+    }
+#else
+    unpack_range (&ranges [0]);
+#endif
+
+    for (i = 0; i < num_ranges; i++)
+        unpacked += ranges [i].unpacked;
+
+    return unpacked;
+}
@@ -340,6 +340,8 @@ int WavpackGetVersion (WavpackContext *wpc);
 char *WavpackGetFileExtension (WavpackContext *wpc);
 unsigned char WavpackGetFileFormat (WavpackContext *wpc);
 uint32_t WavpackUnpackSamples (WavpackContext *wpc, int32_t *buffer, uint32_t samples);
+uint32_t WavpackUnpackSamplesFloat (WavpackContext *wpc, float **channels, uint32_t offset, uint32_t samples);
+uint32_t WavpackUnpackParallel (WavpackContext **contexts, int num_contexts, float **channels);
 uint32_t WavpackGetNumSamples (WavpackContext *wpc);
 int64_t WavpackGetNumSamples64 (WavpackContext *wpc);
 uint32_t WavpackGetNumSamplesInFrame (WavpackContext *wpc);
@@ -0,0 +1,108 @@
+//
+//  AKCoreSamplerTests.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/AKCoreSampler.hpp>
+
+#import <algorithm>
+#import <cmath>
+#import <vector>
+
+static const int sampleRate = 44100;
+
+/// Exposes the noise floor that AKSamplerDSP sets from its voiceNoiseFloor parameter
+class QuietSampler : public AKCoreSampler {
+public:
+    void setVoiceNoiseFloor(float decibels) { voiceNoiseFloor = powf(10.0f, 0.05f * decibels); }
+};
+
+@interface AKCoreSamplerTests : XCTestCase
+@end
+
+@implementation AKCoreSamplerTests
+
+/// Two seconds of A440, silent for its first silentSeconds and then decaying by 70 dB a second
+- (std::vector<float>)decayingSampleSilentFor:(float)silentSeconds {
+    std::vector<float> sample(2 * sampleRate);
+    for (int i = silentSeconds * sampleRate; i < (int)sample.size(); i++) {
+        float t = (float)i / sampleRate - silentSeconds;
+        sample[i] = 0.5f * sinf(2 * M_PI * 440 * t) * expf(-8 * t);
+    }
+    return sample;
+}
+
+/// Plays the sample's note under the sustain pedal, as a piano patch would, rendering a chunk at a time
+- (std::vector<float>)render:(std::vector<float> &)sample noiseFloor:(float)decibels attack:(float)attackSeconds {
+    QuietSampler sampler;
+    sampler.init(sampleRate);
+    AKSampleDataDescriptor sdd = {};
+    sdd.sampleDescriptor.noteNumber = 69;
+    sdd.sampleDescriptor.noteFrequency = 440;
+    sdd.sampleDescriptor.minimumNoteNumber = 0;
+    sdd.sampleDescriptor.maximumNoteNumber = 127;
+    sdd.sampleDescriptor.minimumVelocity = -1;
+    sdd.sampleDescriptor.maximumVelocity = -1;
+    sdd.sampleRate = sampleRate;
+    sdd.channelCount = 1;
+    sdd.sampleCount = (int)sample.size();
+    sdd.data = sample.data();
+    sampler.loadSampleData(sdd);
+    sampler.buildSimpleKeyMap();
+    sampler.setADSRAttackDurationSeconds(attackSeconds);
+    sampler.setADSRReleaseDurationSeconds(3);
+    if (decibels > -200) sampler.setVoiceNoiseFloor(decibels);
+
+    sampler.sustainPedal(true);
+    sampler.playNote(69, 127);
+    sampler.stopNote(69, false);
+
+    std::vector<float> output;
+    float left[AKCORESAMPLER_CHUNKSIZE], right[AKCORESAMPLER_CHUNKSIZE];
+    float *outBuffers[2] = { left, right };
+    while (output.size() < 1.5 * sampleRate) {
+        std::fill_n(left, AKCORESAMPLER_CHUNKSIZE, 0.0f);
+        std::fill_n(right, AKCORESAMPLER_CHUNKSIZE, 0.0f);
+        sampler.render(2, AKCORESAMPLER_CHUNKSIZE, outBuffers);
+        output.insert(output.end(), left, left + AKCORESAMPLER_CHUNKSIZE);
+    }
+    sampler.deinit();
+    return output;
+}
+
+- (float)peakOf:(std::vector<float> &)output from:(float)start to:(float)end {
+    float peak = 0;
+    for (int i = start * sampleRate; i < end * sampleRate; i++) peak = std::max(peak, fabsf(output[i]));
+    return peak;
+}
+
+/// The tail crosses -60 dB at about 0.78 s, so the voice should be gone 0.1 s later
+- (void)testFadedVoiceIsRetired {
+    std::vector<float> sample = [self decayingSampleSilentFor:0];
+    std::vector<float> kept = [self render:sample noiseFloor:-200 attack:0];
+    std::vector<float> retired = [self render:sample noiseFloor:-60 attack:0];
+
+    XCTAssertGreaterThan([self peakOf:kept from:0.95 to:1.5], 0.0f, @"without a noise floor the tail plays on");
+    XCTAssertEqual([self peakOf:retired from:0.95 to:1.5], 0.0f, @"with one the voice stops");
+}
+
+- (void)testOutputBeforeRetirementIsUnchanged {
+    std::vector<float> sample = [self decayingSampleSilentFor:0];
+    std::vector<float> kept = [self render:sample noiseFloor:-200 attack:0];
+    std::vector<float> retired = [self render:sample noiseFloor:-60 attack:0];
+    int end = 0.75 * sampleRate;
+    XCTAssertTrue(std::equal(kept.begin(), kept.begin() + end, retired.begin()));
+}
+
+/// A note that starts silent isn't judged until its attack is over
+- (void)testQuietStartDuringAttackIsNotCut {
+    std::vector<float> sample = [self decayingSampleSilentFor:0.2];
+    std::vector<float> output = [self render:sample noiseFloor:-60 attack:0.25];
+    XCTAssertGreaterThan([self peakOf:output from:0.3 to:0.4], 0.1f);
+}
+
+@end
@@ -0,0 +1,90 @@
+//
+//  AKDSPCommandBusTests.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/AKDSPCommandBus.hpp>
+
+#import <thread>
+#import <vector>
+
+@interface AKDSPCommandBusTests : XCTestCase
+@end
+
+@implementation AKDSPCommandBusTests
+
+- (void)testFullBusDropsInsteadOfBlocking {
+    AKDSPCommandBus bus(4);
+    AKDSPCommand command = {};
+    command.type = AKDSPCommandNoteOn;
+    for (int i = 0; i < 4; i++) {
+        XCTAssertTrue(bus.post(command));
+    }
+    XCTAssertFalse(bus.post(command));
+    XCTAssertEqual(bus.getDroppedCount(), 1u);
+
+    AKDSPCommand popped;
+    XCTAssertTrue(bus.pop(popped));
+    XCTAssertTrue(bus.post(command));
+    for (int i = 0; i < 4; i++) {
+        XCTAssertTrue(bus.pop(popped));
+    }
+    XCTAssertFalse(bus.pop(popped));
+}
+
+/// Eight threads post as fast as they can, retrying when the bus is full, while this thread drains it.
+/// Every command must arrive exactly once, and each thread's in the order it posted them.
+- (void)testManyProducers {
+    const int producerCount = 8;
+    const int commandsPerProducer = 100000;
+    AKDSPCommandBus bus(64);
+    std::atomic<uint32_t> retries{0};
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < producerCount; producer++) {
+        producers.emplace_back([&bus, &retries, producer, commandsPerProducer] {
+            AKDSPCommand command = {};
+            command.type = AKDSPCommandNoteOn;
+            command.note.noteNumber = (uint8_t)producer;
+            for (int i = 0; i < commandsPerProducer; i++) {
+                command.sampleTime = i;
+                while (!bus.post(command)) {
+                    retries.fetch_add(1, std::memory_order_relaxed);
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<AUEventSampleTime> next(producerCount, 0);
+    int received = 0;
+    bool ordered = true;
+    AKDSPCommand command;
+    while (received < producerCount * commandsPerProducer) {
+        if (!bus.pop(command)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int producer = command.note.noteNumber;
+        if (producer < producerCount && command.sampleTime == next[producer]) {
+            next[producer]++;
+        } else {
+            ordered = false;
+        }
+        received++;
+    }
+    for (auto &thread : producers) {
+        thread.join();
+    }
+
+    XCTAssertTrue(ordered);
+    XCTAssertEqual(received, producerCount * commandsPerProducer);
+    XCTAssertFalse(bus.pop(command));
+    XCTAssertEqual(bus.getDroppedCount(), retries.load());
+}
+
+@end
@@ -0,0 +1,72 @@
+//
+//  AKDenormalCheckingTests.swift
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+import AudioKit
+import XCTest
+
+class AKDenormalCheckingTests: AKTestCase {
+
+    /// An amplitude below the smallest normal float, so every nonzero sample the oscillator makes is subnormal
+    let quiet = AKOscillator(waveform: AKTable(.sine), amplitude: 1e-40)
+
+    var audioUnit: AKAudioUnitBase? {
+        return (quiet.avAudioNode as? AVAudioUnit)?.auAudioUnit as? AKAudioUnitBase
+    }
+
+    override func setUp() {
+        super.setUp()
+        output = quiet
+        afterStart = { self.quiet.start() }
+    }
+
+    override func tearDown() {
+        AKDenormalCheckingSetEnabled(false)
+        super.tearDown()
+    }
+
+    func testCheckingCountsSubnormalOutput() {
+        AKDenormalCheckingSetEnabled(true)
+        audioUnit?.instrumentationEnabled = true
+        let before = AKDenormalCheckingGetRenderCount()
+
+        AKTestMD5Not("")
+
+        XCTAssertGreaterThan(AKDenormalCheckingGetRenderCount(), before)
+        let stats = audioUnit?.renderStats
+        XCTAssertGreaterThan(stats?.denormalRenders ?? 0, 0, "the oscillator is named as the source")
+        XCTAssertGreaterThan(stats?.denormalSamples ?? 0, 0)
+    }
+
+    /// Without checking, the render runs flushed to zero, so the oscillator is as silent as one at amplitude 0
+    func testOutputIsFlushedWhenNotChecking() {
+        let before = AKDenormalCheckingGetRenderCount()
+        AKTestMD5Not("")
+        let flushed = MD5
+        XCTAssertEqual(AKDenormalCheckingGetRenderCount(), before)
+        AudioKit.disconnectAllInputs()
+        try! AudioKit.stop()
+
+        let silent = AKOscillator(waveform: AKTable(.sine), amplitude: 0)
+        output = silent
+        afterStart = { silent.start() }
+        AKTestMD5Not("")
+        XCTAssertEqual(flushed, MD5)
+    }
+
+    func testCheckingLeavesSubnormalsInTheOutput() {
+        AKTestMD5Not("")
+        let flushed = MD5
+        AudioKit.disconnectAllInputs()
+        try! AudioKit.stop()
+
+        AKDenormalCheckingSetEnabled(true)
+        AKTestMD5Not("")
+        XCTAssertNotEqual(MD5, flushed)
+    }
+
+}
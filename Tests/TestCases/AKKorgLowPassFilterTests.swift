@@ -23,7 +23,7 @@ class AKKorgLowPassFilterTests: AKTestCase {
 
     func testParameters() {
         output = AKKorgLowPassFilter(input, cutoffFrequency: 500, resonance: 0.5, saturation: 1)
-        AKTestMD5("b1a571b7cb02b511aa2ab6896bcaa807")
+        AKTestMD5("4ffbfaf41667cf37b81e802eb5ee1bf9")
     }
 
     func testResonance() {
@@ -33,6 +33,6 @@ class AKKorgLowPassFilterTests: AKTestCase {
 
     func testSaturation() {
         output = AKKorgLowPassFilter(input, saturation: 1)
-        AKTestMD5("5fff20b333cc2575c08f7bec53dc33e0")
+        AKTestMD5("3aa96dee4dd60a33718b9042f61b63b5")
     }
 }
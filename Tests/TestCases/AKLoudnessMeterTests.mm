@@ -0,0 +1,122 @@
+//
+//  AKLoudnessMeterTests.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/AKLoudnessMeter.hpp>
+
+#import <atomic>
+#import <cmath>
+#import <thread>
+#import <vector>
+
+static const int blockSize = 512;
+
+@interface AKLoudnessMeterTests : XCTestCase
+@end
+
+@implementation AKLoudnessMeterTests {
+    long phase;
+}
+
+- (void)setUp {
+    [super setUp];
+    phase = 0;
+}
+
+/// Meters seconds of a stereo 1 kHz sine whose peaks are at decibels dBFS, a block at a time
+- (void)meter:(AKLoudnessMeter &)meter seconds:(double)seconds decibels:(double)decibels sampleRate:(double)sampleRate {
+    float amplitude = pow(10.0, decibels / 20.0);
+    std::vector<float> block(blockSize);
+    const float *channels[2] = { block.data(), block.data() };
+    for (long frames = seconds * sampleRate; frames > 0; frames -= blockSize) {
+        int count = (int)std::min<long>(frames, blockSize);
+        for (int i = 0; i < count; i++, phase++) block[i] = amplitude * sin(2 * M_PI * 1000 * phase / sampleRate);
+        meter.process(channels, count);
+    }
+}
+
+/// EBU Tech 3341 test 1: a stereo 1 kHz sine at -23 dBFS reads -23 LUFS, to within 0.1 LU
+- (void)testReferenceTone {
+    for (double sampleRate : { 44100.0, 48000.0 }) {
+        AKLoudnessMeter meter;
+        meter.init(2, sampleRate);
+        [self meter:meter seconds:20 decibels:-23 sampleRate:sampleRate];
+
+        AKLoudnessReadings readings;
+        meter.getReadings(readings);
+        XCTAssertEqualWithAccuracy(readings.momentaryLoudness, -23, 0.1, @"at %g Hz", sampleRate);
+        XCTAssertEqualWithAccuracy(readings.shortTermLoudness, -23, 0.1, @"at %g Hz", sampleRate);
+        XCTAssertEqualWithAccuracy(readings.integratedLoudness, -23, 0.1, @"at %g Hz", sampleRate);
+        XCTAssertEqualWithAccuracy(readings.duration, 20, 0.02);
+
+        AKChannelMeterReadings levels;
+        XCTAssertTrue(meter.getChannelReadings(1, levels));
+        float amplitude = pow(10.0, -23 / 20.0);
+        XCTAssertEqualWithAccuracy(levels.peak, amplitude, amplitude * 0.01);
+        XCTAssertEqualWithAccuracy(levels.truePeak, amplitude, amplitude * 0.01);
+        XCTAssertEqualWithAccuracy(levels.rms, amplitude / sqrt(2.0), amplitude * 0.01);
+        XCTAssertFalse(meter.getChannelReadings(2, levels));
+    }
+}
+
+/// EBU Tech 3341 test 3: quiet passages either side of the -23 dBFS tone are gated out of the integrated loudness
+- (void)testGating {
+    AKLoudnessMeter meter;
+    meter.init(2, 48000);
+    [self meter:meter seconds:10 decibels:-36 sampleRate:48000];
+    [self meter:meter seconds:60 decibels:-23 sampleRate:48000];
+    [self meter:meter seconds:10 decibels:-36 sampleRate:48000];
+
+    AKLoudnessReadings readings;
+    meter.getReadings(readings);
+    XCTAssertEqualWithAccuracy(readings.integratedLoudness, -23, 0.1);
+    XCTAssertEqualWithAccuracy(readings.momentaryLoudness, -36, 0.1);
+    XCTAssertEqualWithAccuracy(readings.maximumMomentaryLoudness, -23, 0.1);
+}
+
+/// After a reset the duration counts from zero, and a window of silence reads -infinity
+- (void)testSilenceAndReset {
+    AKLoudnessMeter meter;
+    meter.init(2, 48000);
+    [self meter:meter seconds:5 decibels:-23 sampleRate:48000];
+    meter.reset();
+    [self meter:meter seconds:1 decibels:-INFINITY sampleRate:48000];
+
+    AKLoudnessReadings readings;
+    meter.getReadings(readings);
+    XCTAssertEqual(readings.momentaryLoudness, -INFINITY);
+    XCTAssertEqualWithAccuracy(readings.duration, 1, 0.02);
+}
+
+/// Channel readings can be taken while the meter is initialized again with other channel counts, and read
+/// the cleared levels of a channel it has rather than freed memory
+- (void)testChannelReadingsDuringInit {
+    AKLoudnessMeter meter;
+    std::atomic<bool> done(false);
+    std::atomic<long> readCount(0), badCount(0);
+    std::thread reader([&] {
+        AKChannelMeterReadings levels;
+        while (!done) {
+            for (int channel = 0; channel < 8; channel++) {
+                if (!meter.getChannelReadings(channel, levels)) continue;
+                readCount++;
+                if (levels.peak != 0 || levels.maximumTruePeak != 0) badCount++;
+            }
+        }
+    });
+    for (int i = 0; i < 2000; i++) {
+        meter.init(1 + i % 8, 48000);
+        if (i % 3 == 0) meter.deinit();
+    }
+    done = true;
+    reader.join();
+    XCTAssertGreaterThan(readCount.load(), 0);
+    XCTAssertEqual(badCount.load(), 0);
+}
+
+@end
@@ -13,22 +13,22 @@ class AKMoogLadderTests: AKTestCase {
 
     func testCutoffFrequency() {
         output = AKMoogLadder(input, cutoffFrequency: 500)
-        AKTestMD5("f8a072dc406a73d9dbdd18f1affdd39f")
+        AKTestMD5("f17a97c4832c2197c155659e94192994")
     }
 
     func testDefault() {
         output = AKMoogLadder(input)
-        AKTestMD5("e9881ac2030dab7b083d19fd0a536d2b")
+        AKTestMD5("eb2c2b0a8341276de75b597f9f3667a9")
     }
 
     func testParameters() {
         output = AKMoogLadder(input, cutoffFrequency: 500, resonance: 0.9)
-        AKTestMD5("983f6f432ad2e84c1d337f6900fdf257")
+        AKTestMD5("ff63a22074b00badc309ba0b7dfc35b7")
     }
 
     func testResonance() {
         output = AKMoogLadder(input, resonance: 0.9)
-        AKTestMD5("846d7e6648e3252d6668b76a477371e2")
+        AKTestMD5("fa2540e58bae8faf258eaf8704d6d58c")
     }
 
 }
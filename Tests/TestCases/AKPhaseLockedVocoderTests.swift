@@ -0,0 +1,62 @@
+//
+//  AKPhaseLockedVocoderTests.swift
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+import AudioKit
+import XCTest
+
+class AKPhaseLockedVocoderTests: AKTestCase {
+
+    var vocoder: AKPhaseLockedVocoder?
+
+    /// Renders the vocoder and returns the MD5, leaving the engine stopped for the next render
+    func render(afterStart: @escaping () -> Void) -> String {
+        self.afterStart = afterStart
+        AKTestMD5Not("")
+        let md5 = MD5
+        AudioKit.disconnectAllInputs()
+        try! AudioKit.stop()
+        return md5
+    }
+
+    func testStarted() {
+        let silent = render { }
+        let started = render { self.vocoder?.start() }
+        XCTAssertNotEqual(started, silent)
+    }
+
+    /// Starting again reloads the file while the old tables may still be rendering; the render thread must
+    /// pick up the new ones whole, and hand the old ones back rather than have them freed under it
+    func testRestart() {
+        let started = render { self.vocoder?.start() }
+        let restarted = render {
+            self.vocoder?.start()
+            self.vocoder?.start()
+        }
+        XCTAssertEqual(restarted, started)
+    }
+
+    func testPitchRatio() {
+        let started = render { self.vocoder?.start() }
+        vocoder?.pitchRatio = 2
+        let transposed = render { self.vocoder?.start() }
+        XCTAssertNotEqual(transposed, started)
+    }
+
+    override func setUp() {
+        super.setUp()
+        duration = 0.5
+        if let path = Bundle.main.path(forResource: "sinechirp", ofType: "wav") {
+            let file = try! AKAudioFile(forReading: URL(fileURLWithPath: path))
+            vocoder = AKPhaseLockedVocoder(file: file, position: 0.2)
+            output = vocoder
+        } else {
+            XCTFail("Could not load sinechirp.wav")
+        }
+    }
+
+}
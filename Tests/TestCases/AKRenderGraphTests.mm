@@ -0,0 +1,178 @@
+//
+//  AKRenderGraphTests.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/AKRenderGraph.hpp>
+
+#import <atomic>
+#import <thread>
+#import <vector>
+
+namespace {
+
+/// Writes the sample time of each frame, times value
+struct RampProcessor : AKRenderGraphProcessor {
+    float value;
+    RampProcessor(float value) : value(value) {}
+    void render(AudioBufferList *in, AudioBufferList *out,
+                AudioTimeStamp const *timestamp, uint32_t frameCount) override {
+        for (UInt32 channel = 0; channel < out->mNumberBuffers; ++channel) {
+            float *samples = (float *)out->mBuffers[channel].mData;
+            for (uint32_t frame = 0; frame < frameCount; ++frame) {
+                samples[frame] = value * (float)(timestamp->mSampleTime + frame);
+            }
+        }
+    }
+};
+
+struct GainProcessor : AKRenderGraphProcessor {
+    float gain;
+    GainProcessor(float gain) : gain(gain) {}
+    void render(AudioBufferList *in, AudioBufferList *out,
+                AudioTimeStamp const *timestamp, uint32_t frameCount) override {
+        for (UInt32 channel = 0; channel < out->mNumberBuffers; ++channel) {
+            float const *input = (float const *)in->mBuffers[channel].mData;
+            float *output = (float *)out->mBuffers[channel].mData;
+            for (uint32_t frame = 0; frame < frameCount; ++frame) {
+                output[frame] = gain * input[frame];
+            }
+        }
+    }
+};
+
+/// A stereo output list over left and right
+struct StereoOutput {
+    std::vector<float> left, right;
+    AudioBufferList *list;
+
+    StereoOutput(uint32_t frameCount) : left(frameCount), right(frameCount) {
+        list = (AudioBufferList *)malloc(sizeof(AudioBufferList) + sizeof(AudioBuffer));
+        list->mNumberBuffers = 2;
+        list->mBuffers[0].mData = left.data();
+        list->mBuffers[1].mData = right.data();
+    }
+    ~StereoOutput() { free(list); }
+};
+
+}
+
+@interface AKRenderGraphTests : XCTestCase
+@end
+
+@implementation AKRenderGraphTests
+
+/// ramp -> (x2 in place, x3) -> mixer, rendered with more frames than the graph's buffers hold
+- (void)renderDiamondWithWorkers:(int)workerCount {
+    AKRenderGraph graph(2, 64, workerCount);
+    AKRenderGraph::NodeID ramp = graph.addNode(new RampProcessor(1.0f));
+    AKRenderGraph::NodeID doubled = graph.addNode(new GainProcessor(2.0f), true);
+    AKRenderGraph::NodeID tripled = graph.addNode(new GainProcessor(3.0f));
+    AKRenderGraph::NodeID mixer = graph.addNode(new AKRenderGraphMixer(), true);
+    graph.connect(ramp, doubled);
+    graph.connect(ramp, tripled);
+    graph.connect(doubled, mixer);
+    graph.connect(tripled, mixer);
+    graph.setOutputNode(mixer);
+    XCTAssertTrue(graph.compile());
+
+    uint32_t const frameCount = 1000;
+    StereoOutput output(frameCount);
+    AudioTimeStamp timestamp = {};
+    timestamp.mSampleTime = 100;
+    graph.render(&timestamp, frameCount, output.list);
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        float expected = 5.0f * (100.0f + frame);
+        if (output.left[frame] != expected || output.right[frame] != expected) {
+            XCTFail(@"frame %u: %f %f, expected %f", frame, output.left[frame], output.right[frame], expected);
+            return;
+        }
+    }
+    XCTAssertEqual(graph.getTiming(mixer).renderCount, (uint64_t)16, @"1000 frames take 16 passes of 64");
+}
+
+- (void)testSerialRender {
+    [self renderDiamondWithWorkers:0];
+}
+
+- (void)testParallelRender {
+    [self renderDiamondWithWorkers:2];
+}
+
+- (void)testCycleIsRejected {
+    AKRenderGraph graph(2, 64);
+    AKRenderGraph::NodeID a = graph.addNode(new GainProcessor(1.0f));
+    AKRenderGraph::NodeID b = graph.addNode(new GainProcessor(1.0f));
+    graph.connect(a, b);
+    graph.connect(b, a);
+    XCTAssertFalse(graph.compile());
+}
+
+- (void)testBuffersAreReused {
+    AKRenderGraph inPlace(2, 64);
+    AKRenderGraph::NodeID last = inPlace.addNode(new RampProcessor(1.0f));
+    for (int i = 0; i < 7; ++i) {
+        AKRenderGraph::NodeID node = inPlace.addNode(new GainProcessor(1.0f), true);
+        inPlace.connect(last, node);
+        last = node;
+    }
+    inPlace.setOutputNode(last);
+    XCTAssertTrue(inPlace.compile());
+    XCTAssertEqual(inPlace.getBufferCount(), 1);
+
+    AKRenderGraph chain(2, 64);
+    last = chain.addNode(new RampProcessor(1.0f));
+    for (int i = 0; i < 7; ++i) {
+        AKRenderGraph::NodeID node = chain.addNode(new GainProcessor(1.0f));
+        chain.connect(last, node);
+        last = node;
+    }
+    chain.setOutputNode(last);
+    XCTAssertTrue(chain.compile());
+    XCTAssertEqual(chain.getBufferCount(), 2);
+}
+
+/// Every compile reaches the render thread, however the two threads interleave, and the last one wins
+- (void)testRecompileWhileRendering {
+    AKRenderGraph graph(2, 64, 2);
+    std::vector<AKRenderGraph::NodeID> sources;
+    for (int i = 0; i < 8; ++i) {
+        sources.push_back(graph.addNode(new RampProcessor((float)(1 << i))));
+    }
+    AKRenderGraph::NodeID mixer = graph.addNode(new AKRenderGraphMixer(), true);
+    graph.setOutputNode(mixer);
+    XCTAssertTrue(graph.compile());
+
+    StereoOutput output(256);
+    std::atomic<bool> done(false);
+    std::thread renderThread([&] {
+        AudioTimeStamp timestamp = {};
+        timestamp.mSampleTime = 1;
+        while (!done) graph.render(&timestamp, 256, output.list);
+    });
+
+    for (int change = 0; change < 3000; ++change) {
+        AKRenderGraph::NodeID source = sources[change % 8];
+        if (change & 1) {
+            graph.connect(source, mixer);
+        } else {
+            graph.disconnect(source, mixer);
+        }
+        graph.compile();
+    }
+    done = true;
+    renderThread.join();
+
+    AudioTimeStamp timestamp = {};
+    timestamp.mSampleTime = 1;
+    graph.render(&timestamp, 256, output.list);
+    // the odd sources were connected last
+    XCTAssertEqual(output.left[0], 2.0f + 8.0f + 32.0f + 128.0f);
+}
+
+@end
@@ -13,17 +13,17 @@ class AKRolandTB303FilterTests: AKTestCase {
 
     func testCutoffFrequency() {
         output = AKRolandTB303Filter(input, cutoffFrequency: 400)
-        AKTestMD5("4e4d3d1d59c1e27de3c3b7f19a2ba749")
+        AKTestMD5("ab91b529c8d7751af856a7b2ae622258")
     }
 
     func testDefault() {
         output = AKRolandTB303Filter(input)
-        AKTestMD5("a03ff20770be1844d163d6ae7288bc19")
+        AKTestMD5("6060958f21109ce151b00c87f73f367a")
     }
 
     func testDistortion() {
         output = AKRolandTB303Filter(input, distortion: 1)
-        AKTestMD5("f8be86a128671bb0351e1a10e06c0776")
+        AKTestMD5("0bf3c41719ad80ad7ef331c193e887a4")
     }
 
     func testParameters() {
@@ -32,16 +32,16 @@ class AKRolandTB303FilterTests: AKTestCase {
                                      resonance: 1,
                                      distortion: 1,
                                      resonanceAsymmetry: 0.66)
-        AKTestMD5("46fb509f4d44addb5fca8ac00c51daeb")
+        AKTestMD5("adae88fdbf3e81911ea0cd75d6df2711")
     }
 
     func testResonance() {
         output = AKRolandTB303Filter(input, resonance: 1)
-        AKTestMD5("88188ae732ef35b5d729b35bd2ce57c9")
+        AKTestMD5("484621126bfc450c6a6d9a08001b05e8")
     }
 
     func testResonanceAsymmetry() {
         output = AKRolandTB303Filter(input, resonanceAsymmetry: 0.66)
-        AKTestMD5("e6bd521da1b764c710075c9f1368ff74")
+        AKTestMD5("0f0bba98c91e2646c1977c7012209125")
     }
 }
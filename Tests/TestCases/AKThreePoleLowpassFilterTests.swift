@@ -13,26 +13,26 @@ class AKThreePoleLowpassFilterTests: AKTestCase {
 
     func testCutoffFrequency() {
         output = AKThreePoleLowpassFilter(input, cutoffFrequency: 500)
-        AKTestMD5("ec26496e6ee4da9945fd4f2c2df9d6a1")
+        AKTestMD5("8447bbf13eb4438c2a96826cdf5757c3")
     }
 
     func testDefault() {
         output = AKThreePoleLowpassFilter(input)
-        AKTestMD5("787ed3c7631adee9af6bd9603a6a7e56")
+        AKTestMD5("7b5044f502cc8f0ec55b10c1294daafa")
     }
 
     func testDistortion() {
         output = AKThreePoleLowpassFilter(input, distortion: 1)
-        AKTestMD5("39e2f904606600640b5b83a680457c2b")
+        AKTestMD5("ee7852ca4c77ae47939e7f195259dfa3")
     }
 
     func testParameters() {
         output = AKThreePoleLowpassFilter(input, distortion: 1, cutoffFrequency: 500, resonance: 1)
-        AKTestMD5("15a8a9a91615e0c1f72f3b83e3526729")
+        AKTestMD5("a39d4999b75398f19c9284515d842241")
     }
 
     func testResonance() {
         output = AKThreePoleLowpassFilter(input, resonance: 1)
-        AKTestMD5("98ad6f5f4327410317ec4e277ee5cf2c")
+        AKTestMD5("634391f40792988f47c0cabdf561e966")
     }
 }
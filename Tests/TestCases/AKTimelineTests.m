@@ -0,0 +1,56 @@
+//
+//  AKTimelineTests.m
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/AKTimeline.h>
+
+@interface AKTimelineTests : XCTestCase
+@end
+
+@implementation AKTimelineTests
+
+/// The main thread keeps changing the loop while this thread renders. Each render must see one whole
+/// message (loop end twice loop start, as they were set), never an older one than the last render saw,
+/// and the newest one once the changes stop.
+- (void)testLoopChangesDuringRender {
+    const UInt32 changeCount = 200000;
+    AudioStreamBasicDescription format = {0};
+    format.mSampleRate = 44100;
+    format.mBytesPerFrame = sizeof(float);
+
+    AKTimeline *timeline = calloc(1, sizeof(AKTimeline));
+    AKTimelineInit(timeline, format, NULL, NULL);
+
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE, 0), ^{
+        for (UInt32 i = 1; i <= changeCount; i++) {
+            AKTimelineSetLoop(timeline, i, i);
+        }
+    });
+
+    AudioTimeStamp timeStamp = {0};
+    timeStamp.mFlags = kAudioTimeStampSampleTimeValid | kAudioTimeStampHostTimeValid;
+    UInt32 lastLoopStart = 0;
+    BOOL whole = YES, ordered = YES;
+    while (dispatch_group_wait(group, DISPATCH_TIME_NOW) != 0) {
+        AKTimelineRender(timeline, &timeStamp, 512, NULL);
+        timeStamp.mSampleTime += 512;
+        whole = whole && timeline->_loopEnd == 2 * timeline->_loopStart;
+        ordered = ordered && timeline->_loopStart >= lastLoopStart;
+        lastLoopStart = timeline->_loopStart;
+    }
+    AKTimelineRender(timeline, &timeStamp, 512, NULL);
+
+    XCTAssertTrue(whole);
+    XCTAssertTrue(ordered);
+    XCTAssertEqual(timeline->_loopStart, changeCount);
+    XCTAssertEqual(timeline->_loopEnd, 2 * changeCount);
+    free(timeline);
+}
+
+@end
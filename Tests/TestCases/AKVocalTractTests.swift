@@ -26,31 +26,31 @@ class AKVocalTractTests: AKTestCase {
     func testFrequency() {
         vocalTract.frequency = 444.5
         output = vocalTract
-        AKTestMD5("2b396d9594b82055f08a0bc4fa920d7b")
+        AKTestMD5("dbadee90905d46d5a960fe5efa31aa2e")
     }
 
     func testNasality() {
         vocalTract.nasality = 0.6
         output = vocalTract
-        AKTestMD5("71ecb9a92790fffae596c3f46c445f7e")
+        AKTestMD5("d693694883096657d773b2227af0114e")
     }
 
     func testTenseness() {
         vocalTract.tenseness = 0.5
         output = vocalTract
-        AKTestMD5("b68e8abc69646b53b0df69c1ba7e33aa")
+        AKTestMD5("1020830d800b978f753552f13bd6a473")
     }
 
     func testTongueDiameter() {
         vocalTract.tongueDiameter = 0.4
         output = vocalTract
-        AKTestMD5("35085ac510e12e74e6c4f0107bb6bfe9")
+        AKTestMD5("fe5d445626778e9221c16588c8a3cabd")
     }
 
     func testTonguePosition() {
         vocalTract.tonguePosition = 0.3
         output = vocalTract
-        AKTestMD5("d959f6ad27f11640dab046ed3eca472b")
+        AKTestMD5("db18fcc4c3884bbc85ef693b0a05acc3")
     }
 
     func testParametersSetAfterInit() {
@@ -60,7 +60,7 @@ class AKVocalTractTests: AKTestCase {
         vocalTract.tenseness = 0.5
         vocalTract.nasality = 0.6
         output = vocalTract
-        AKTestMD5("0501c323ab9f99c3f6c8a43c74983eec")
+        AKTestMD5("8e69ba0428d4262ddcb787c5ef37e624")
     }
 
     func testParametersSetOnInit() {
@@ -69,7 +69,7 @@ class AKVocalTractTests: AKTestCase {
                               tongueDiameter: 0.4,
                               tenseness: 0.5,
                               nasality: 0.6)
-        AKTestMD5("0501c323ab9f99c3f6c8a43c74983eec")
+        AKTestMD5("8e69ba0428d4262ddcb787c5ef37e624")
     }
 
 }
@@ -0,0 +1,123 @@
+//
+//  AKWavpackDecodeTests.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/wavpack.h>
+
+#import <algorithm>
+#import <cmath>
+#import <cstring>
+#import <vector>
+
+static const uint32_t sampleRate = 44100;
+static const uint32_t frameCount = 30 * sampleRate;
+
+static int writeBlock(void *file, void *data, int32_t byteCount) {
+    return fwrite(data, 1, byteCount, (FILE *)file) == (size_t)byteCount;
+}
+
+@interface AKWavpackDecodeTests : XCTestCase
+@end
+
+@implementation AKWavpackDecodeTests {
+    NSString *path;
+    std::vector<int32_t> original;
+}
+
+/// Thirty seconds of 16-bit stereo, two tones with a little noise, so the decoder has real work to do
+- (void)setUp {
+    [super setUp];
+    path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+            [NSUUID.UUID.UUIDString stringByAppendingPathExtension:@"wv"]];
+    FILE *file = fopen(path.UTF8String, "wb");
+    XCTAssertTrue(file != nullptr);
+
+    WavpackContext *context = WavpackOpenFileOutput(writeBlock, file, nullptr);
+    WavpackConfig config;
+    memset(&config, 0, sizeof(config));
+    config.bits_per_sample = 16;
+    config.bytes_per_sample = 2;
+    config.num_channels = 2;
+    config.channel_mask = 0x3;
+    config.sample_rate = sampleRate;
+    XCTAssertTrue(WavpackSetConfiguration(context, &config, frameCount));
+    XCTAssertTrue(WavpackPackInit(context));
+
+    original.resize(2 * frameCount);
+    uint32_t noise = 1;
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        double t = (double)i / sampleRate;
+        noise = noise * 1664525 + 1013904223;
+        double tone = 0.3 * sin(2 * M_PI * 220 * t) + 0.2 * sin(2 * M_PI * 277 * t);
+        original[2 * i] = (int32_t)(32767 * tone) + (int32_t)(noise >> 24) - 128;
+        original[2 * i + 1] = (int32_t)(32767 * tone * cos(t)) + (int32_t)((noise >> 16) & 0xff) - 128;
+    }
+    for (uint32_t start = 0; start < frameCount; start += 4096) {
+        uint32_t count = std::min(4096u, frameCount - start);
+        XCTAssertTrue(WavpackPackSamples(context, original.data() + 2 * start, count));
+    }
+    XCTAssertTrue(WavpackFlushSamples(context));
+    WavpackCloseFile(context);
+    fclose(file);
+}
+
+- (void)tearDown {
+    [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+    [super tearDown];
+}
+
+/// Decodes the file through threadCount contexts into left and right, as AKSampler loads compressed samples
+- (uint32_t)decodeWithThreads:(int)threadCount into:(std::vector<float> &)left and:(std::vector<float> &)right {
+    char error[100];
+    std::vector<WavpackContext *> contexts;
+    while ((int)contexts.size() < threadCount) {
+        WavpackContext *context = WavpackOpenFileInput(path.UTF8String, error, OPEN_2CH_MAX, 0);
+        if (!context) break;
+        contexts.push_back(context);
+    }
+    if (contexts.empty()) return 0;
+
+    left.assign(frameCount, 0);
+    right.assign(frameCount, 0);
+    float *channels[2] = { left.data(), right.data() };
+    uint32_t decoded = WavpackUnpackParallel(contexts.data(), (int)contexts.size(), channels);
+    for (WavpackContext *context : contexts) WavpackCloseFile(context);
+    return decoded;
+}
+
+- (void)testParallelMatchesSerial {
+    std::vector<float> serialLeft, serialRight, parallelLeft, parallelRight;
+    XCTAssertEqual([self decodeWithThreads:1 into:serialLeft and:serialRight], frameCount);
+    XCTAssertEqual([self decodeWithThreads:4 into:parallelLeft and:parallelRight], frameCount);
+    XCTAssertTrue(serialLeft == parallelLeft);
+    XCTAssertTrue(serialRight == parallelRight);
+
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        if (serialLeft[i] * 32768 != original[2 * i] || serialRight[i] * 32768 != original[2 * i + 1]) {
+            XCTFail(@"frame %u didn't survive the round trip", i);
+            return;
+        }
+    }
+}
+
+- (void)measureDecodeWithThreads:(int)threadCount {
+    [self measureBlock:^{
+        std::vector<float> left, right;
+        [self decodeWithThreads:threadCount into:left and:right];
+    }];
+}
+
+- (void)testPerformanceSerialDecode {
+    [self measureDecodeWithThreads:1];
+}
+
+- (void)testPerformanceParallelDecode {
+    [self measureDecodeWithThreads:4];
+}
+
+@end
@@ -0,0 +1,134 @@
+//
+//  AKWavpackRecorderTests.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/AKWavpackRecorder.hpp>
+#import <AudioKit/wavpack.h>
+
+#import <cmath>
+#import <vector>
+
+static const double sampleRate = 44100;
+static const AUAudioFrameCount blockSize = 512;
+static const AUAudioFrameCount frameCount = 400 * blockSize;
+
+@interface AKWavpackRecorderTests : XCTestCase
+@end
+
+@implementation AKWavpackRecorderTests {
+    NSString *path;
+    std::vector<float> left, right;
+}
+
+/// About 4.6 seconds of a stereo tone with a little noise, kept inside +/- 1 so integer files don't clip
+- (void)setUp {
+    [super setUp];
+    path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+            [NSUUID.UUID.UUIDString stringByAppendingPathExtension:@"wv"]];
+    left.resize(frameCount);
+    right.resize(frameCount);
+    uint32_t noise = 1;
+    for (AUAudioFrameCount i = 0; i < frameCount; ++i) {
+        double t = i / sampleRate;
+        noise = noise * 1664525 + 1013904223;
+        left[i] = 0.5 * sin(2 * M_PI * 440 * t) + (noise >> 8) / 16777216.0 * 0.01;
+        right[i] = 0.4 * sin(2 * M_PI * 660 * t) * cos(t);
+    }
+}
+
+- (void)tearDown {
+    [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+    [super tearDown];
+}
+
+/// Writes the signal a render's worth at a time, as the render thread would, then stops to finish the file
+- (AKWavpackRecorder::TrackStats)record:(AKWavpackRecorder::Settings)settings {
+    // This loop runs far faster than real time, so the ring holds the whole take rather than drop any
+    settings.queueSeconds = frameCount / sampleRate + 1;
+    AKWavpackRecorder recorder(sampleRate, settings);
+    XCTAssertEqual(recorder.addTrack(path.fileSystemRepresentation, 2), 0);
+    XCTAssertTrue(recorder.start());
+    XCTAssertEqual(recorder.addTrack(path.fileSystemRepresentation, 2), -1, @"tracks can't be added while recording");
+    for (AUAudioFrameCount start = 0; start < frameCount; start += blockSize) {
+        const float *channels[2] = { left.data() + start, right.data() + start };
+        XCTAssertTrue(recorder.write(0, channels, blockSize));
+    }
+    recorder.stop();
+    XCTAssertFalse(recorder.isRecording());
+    return recorder.getStats(0);
+}
+
+- (std::vector<float>)decodeChannel:(int)channel mode:(int *)mode {
+    char error[100];
+    WavpackContext *context = WavpackOpenFileInput(path.UTF8String, error, OPEN_2CH_MAX, 0);
+    if (!context) {
+        XCTFail(@"couldn't open the recording: %s", error);
+        return {};
+    }
+    XCTAssertEqual(WavpackGetNumSamples(context), frameCount);
+    XCTAssertEqual(WavpackGetSampleRate(context), (uint32_t)sampleRate);
+    *mode = WavpackGetMode(context);
+
+    std::vector<float> decoded[2] = { std::vector<float>(frameCount), std::vector<float>(frameCount) };
+    float *channels[2] = { decoded[0].data(), decoded[1].data() };
+    XCTAssertEqual(WavpackUnpackSamplesFloat(context, channels, 0, frameCount), frameCount);
+    WavpackCloseFile(context);
+    return decoded[channel];
+}
+
+- (void)testFloatRoundTripIsExact {
+    AKWavpackRecorder::Settings settings;
+    settings.bitsPerSample = 32;
+    AKWavpackRecorder::TrackStats stats = [self record:settings];
+    XCTAssertEqual(stats.framesWritten, frameCount);
+    XCTAssertEqual(stats.framesEncoded, frameCount);
+    XCTAssertEqual(stats.framesDropped, 0u);
+    XCTAssertFalse(stats.failed);
+
+    int mode;
+    XCTAssertTrue([self decodeChannel:0 mode:&mode] == left);
+    XCTAssertTrue(mode & MODE_FLOAT);
+    XCTAssertTrue([self decodeChannel:1 mode:&mode] == right);
+}
+
+- (void)testIntegerRoundTripIsWithinQuantization {
+    AKWavpackRecorder::Settings settings;
+    settings.bitsPerSample = 24;
+    settings.highQuality = true;
+    AKWavpackRecorder::TrackStats stats = [self record:settings];
+    XCTAssertEqual(stats.framesEncoded, frameCount);
+
+    // Compressed below the size of the 24-bit samples themselves
+    NSDictionary *attributes = [NSFileManager.defaultManager attributesOfItemAtPath:path error:nil];
+    XCTAssertEqual(attributes.fileSize, stats.bytesEncoded);
+    XCTAssertLessThan(stats.bytesEncoded, frameCount * 2 * 3);
+
+    int mode;
+    std::vector<float> decoded = [self decodeChannel:0 mode:&mode];
+    XCTAssertFalse(mode & MODE_FLOAT);
+    float step = 1.0f / (1 << 23);
+    for (AUAudioFrameCount i = 0; i < frameCount; ++i) {
+        if (fabsf(decoded[i] - left[i]) > step) {
+            XCTFail(@"frame %u came back as %f, not %f", i, decoded[i], left[i]);
+            return;
+        }
+    }
+}
+
+- (void)testRecordingAgainReplacesTheFile {
+    AKWavpackRecorder::Settings settings;
+    settings.bitsPerSample = 16;
+    [self record:settings];
+    AKWavpackRecorder::TrackStats stats = [self record:settings];
+    XCTAssertEqual(stats.framesEncoded, frameCount);
+
+    int mode;
+    XCTAssertEqual([self decodeChannel:1 mode:&mode].size(), frameCount);
+}
+
+@end
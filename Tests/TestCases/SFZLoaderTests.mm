@@ -0,0 +1,183 @@
+//
+//  SFZLoaderTests.mm
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/SFZLoader.hpp>
+
+#import <vector>
+
+using AudioKitCore::SFZLoader;
+using AudioKitCore::SFZRegion;
+
+@interface SFZLoaderTests : XCTestCase
+@end
+
+@implementation SFZLoaderTests {
+    NSString *directory;
+}
+
+- (void)setUp {
+    [super setUp];
+    directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+    [NSFileManager.defaultManager createDirectoryAtPath:directory
+                            withIntermediateDirectories:YES
+                                             attributes:nil
+                                                  error:nil];
+}
+
+- (void)tearDown {
+    [NSFileManager.defaultManager removeItemAtPath:directory error:nil];
+    [super tearDown];
+}
+
+- (void)write:(NSString *)text to:(NSString *)fileName {
+    [text writeToFile:[directory stringByAppendingPathComponent:fileName]
+           atomically:YES
+             encoding:NSUTF8StringEncoding
+                error:nil];
+}
+
+- (std::vector<SFZRegion>)parse:(const char *)text {
+    std::vector<SFZRegion> regions;
+    SFZLoader::parse(text, "/samples", regions);
+    return regions;
+}
+
+- (void)testRegionsInheritFromTheHeadersAboveThem {
+    std::vector<SFZRegion> regions = [self parse:
+        "<global> lovel=10\n"
+        "<group> lokey=40 hikey=50 pitch_keycenter=45\n"
+        "<region> sample=a.wav\n"
+        "<region> sample=b.wav hikey=48 hivel=90\n"
+        "<group> key=70\n"
+        "<region> sample=c.wav\n"
+        "<global>\n"
+        "<region> sample=d.wav\n"
+        "<region> lokey=1\n"];
+
+    XCTAssertEqual(regions.size(), 4u, @"a region without a sample is dropped");
+
+    const AKSampleDescriptor &a = regions[0].sampleDescriptor;
+    XCTAssertEqual(a.minimumNoteNumber, 40);
+    XCTAssertEqual(a.maximumNoteNumber, 50);
+    XCTAssertEqual(a.noteNumber, 45);
+    XCTAssertEqual(a.minimumVelocity, 10);
+    XCTAssertEqual(a.maximumVelocity, 127);
+
+    const AKSampleDescriptor &b = regions[1].sampleDescriptor;
+    XCTAssertEqual(b.minimumNoteNumber, 40);
+    XCTAssertEqual(b.maximumNoteNumber, 48);
+    XCTAssertEqual(b.maximumVelocity, 90);
+
+    const AKSampleDescriptor &c = regions[2].sampleDescriptor;
+    XCTAssertEqual(c.minimumNoteNumber, 70);
+    XCTAssertEqual(c.maximumNoteNumber, 70);
+    XCTAssertEqual(c.noteNumber, 70);
+    XCTAssertEqual(c.minimumVelocity, 10);
+
+    const AKSampleDescriptor &d = regions[3].sampleDescriptor;
+    XCTAssertEqual(d.minimumNoteNumber, 0);
+    XCTAssertEqual(d.maximumNoteNumber, 127);
+    XCTAssertEqual(d.minimumVelocity, 0, @"a new <global> starts over from the defaults");
+
+    XCTAssertEqualObjects(@(regions[0].samplePath.c_str()), @"/samples/a.wav");
+    XCTAssertEqualObjects(@(regions[3].samplePath.c_str()), @"/samples/d.wav");
+}
+
+- (void)testDefinesAndNoteNames {
+    std::vector<SFZRegion> regions = [self parse:
+        "#define $ROOT c4\n"
+        "#define $ROOT_SHARP c#4\n"
+        "<region> sample=$ROOT.wav key=$ROOT\n"
+        "<region> sample=x.wav key=$ROOT_SHARP\n"
+        "<region> sample=x.wav lokey=eb-1 hikey=F#3 pitch_keycenter=a4\n"];
+
+    XCTAssertEqual(regions.size(), 3u);
+    XCTAssertEqualObjects(@(regions[0].samplePath.c_str()), @"/samples/c4.wav");
+    XCTAssertEqual(regions[0].sampleDescriptor.noteNumber, 60);
+    XCTAssertEqual(regions[1].sampleDescriptor.noteNumber, 61, @"the longer name is substituted first");
+    XCTAssertEqual(regions[2].sampleDescriptor.minimumNoteNumber, 3);
+    XCTAssertEqual(regions[2].sampleDescriptor.maximumNoteNumber, 54);
+    XCTAssertEqual(regions[2].sampleDescriptor.noteNumber, 69);
+}
+
+- (void)testValuesWithSpacesCommentsAndLineEndings {
+    std::vector<SFZRegion> regions = [self parse:
+        "<control> default_path=Grand Piano\\\r\n"
+        "/* a block\r\n comment */\r\n"
+        "<region> sample=Soft C4.wav lokey=60 hikey=62 // the softest layer\r\n"
+        "<region>sample=Loud\\C4.wav<region>sample=/absolute/C4.wav"];
+
+    XCTAssertEqual(regions.size(), 3u);
+    XCTAssertEqualObjects(@(regions[0].samplePath.c_str()), @"/samples/Grand Piano/Soft C4.wav");
+    XCTAssertEqual(regions[0].sampleDescriptor.minimumNoteNumber, 60);
+    XCTAssertEqual(regions[0].sampleDescriptor.maximumNoteNumber, 62);
+    XCTAssertEqualObjects(@(regions[1].samplePath.c_str()), @"/samples/Grand Piano/Loud/C4.wav");
+    XCTAssertEqualObjects(@(regions[2].samplePath.c_str()), @"/absolute/C4.wav");
+}
+
+- (void)testTuningOffsetsAndLoops {
+    std::vector<SFZRegion> regions = [self parse:
+        "<region> sample=a.wav pitch_keycenter=69\n"
+        "<region> sample=a.wav pitch_keycenter=69 transpose=12\n"
+        "<region> sample=a.wav pitch_keycenter=69 tune=-100\n"
+        "<region> sample=a.wav offset=100 end=2000 loop_mode=loop_continuous loop_start=200 loop_end=1000\n"
+        "<region> sample=a.wav loop_mode=loop_sustain\n"
+        "<region> sample=a.wav loop_mode=one_shot loop_start=200 loop_end=1000\n"];
+
+    XCTAssertEqual(regions.size(), 6u);
+    XCTAssertEqualWithAccuracy(regions[0].sampleDescriptor.noteFrequency, 440.0f, 0.01f);
+    XCTAssertEqualWithAccuracy(regions[1].sampleDescriptor.noteFrequency, 220.0f, 0.01f);
+    XCTAssertEqualWithAccuracy(regions[2].sampleDescriptor.noteFrequency, 466.16f, 0.01f);
+
+    const AKSampleDescriptor &looped = regions[3].sampleDescriptor;
+    XCTAssertEqual(looped.startPoint, 100.0f);
+    XCTAssertEqual(looped.endPoint, 2000.0f);
+    XCTAssertTrue(looped.isLooping);
+    XCTAssertEqual(looped.loopStartPoint, 200.0f);
+    XCTAssertEqual(looped.loopEndPoint, 1000.0f);
+
+    const AKSampleDescriptor &wholeLoop = regions[4].sampleDescriptor;
+    XCTAssertTrue(wholeLoop.isLooping);
+    XCTAssertEqual(wholeLoop.loopStartPoint, 0.0f);
+    XCTAssertEqual(wholeLoop.loopEndPoint, 1.0f, @"a loop without points loops the whole sample");
+
+    XCTAssertFalse(regions[5].sampleDescriptor.isLooping);
+}
+
+- (void)testIncludesAndWavpackSamples {
+    [self write:@"<group> lokey=30\n#include \"regions.sfz\"\n" to:@"instrument.sfz"];
+    [self write:@"<region> sample=a.wav\n<region> sample=b.wav\n" to:@"regions.sfz"];
+    [self write:@"wvpk" to:@"a.wv"];
+
+    std::vector<SFZRegion> regions;
+    NSString *path = [directory stringByAppendingPathComponent:@"instrument.sfz"];
+    XCTAssertTrue(SFZLoader::parse(path.UTF8String, regions));
+
+    XCTAssertEqual(regions.size(), 2u);
+    XCTAssertEqualObjects(@(regions[0].samplePath.c_str()), [directory stringByAppendingPathComponent:@"a.wv"],
+                          @"a .wv beside a .wav is loaded instead");
+    XCTAssertEqualObjects(@(regions[1].samplePath.c_str()), [directory stringByAppendingPathComponent:@"b.wav"]);
+    XCTAssertEqual(regions[1].sampleDescriptor.minimumNoteNumber, 30);
+
+    regions.clear();
+    NSString *missing = [directory stringByAppendingPathComponent:@"missing.sfz"];
+    XCTAssertFalse(SFZLoader::parse(missing.UTF8String, regions));
+    XCTAssertTrue(regions.empty());
+}
+
+- (void)testIncludeLoopStops {
+    [self write:@"<region> sample=a.wav\n#include \"loop.sfz\"\n" to:@"loop.sfz"];
+
+    std::vector<SFZRegion> regions;
+    NSString *path = [directory stringByAppendingPathComponent:@"loop.sfz"];
+    XCTAssertTrue(SFZLoader::parse(path.UTF8String, regions));
+    XCTAssertGreaterThan(regions.size(), 0u);
+}
+
+@end
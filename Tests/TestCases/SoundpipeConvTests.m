@@ -0,0 +1,131 @@
+//
+//  SoundpipeConvTests.m
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/soundpipe.h>
+
+static const int responseLength = 300;
+static const int partitionSize = 64;
+static const int inputLength = 2000;
+
+@interface SoundpipeConvTests : XCTestCase
+@end
+
+@implementation SoundpipeConvTests {
+    sp_data *sp;
+    sp_ftbl *response, *copy;
+    SPFLOAT input[inputLength];
+}
+
+/// A decaying noise response, loaded into two separate tables, and a noise input
+- (void)setUp {
+    [super setUp];
+    sp_create(&sp);
+    sp->sr = 44100;
+    sp_ftbl_create(sp, &response, responseLength);
+    sp_ftbl_create(sp, &copy, responseLength);
+    uint32_t noise = 1;
+    for (int i = 0; i < responseLength; i++) {
+        noise = noise * 1664525 + 1013904223;
+        response->tbl[i] = copy->tbl[i] = ((SPFLOAT)(noise >> 8) / 8388608 - 1) * exp(-i / 50.0);
+    }
+    for (int i = 0; i < inputLength; i++) {
+        noise = noise * 1664525 + 1013904223;
+        input[i] = (SPFLOAT)(noise >> 8) / 8388608 - 1;
+    }
+}
+
+- (void)tearDown {
+    sp_ftbl_destroy(&response);
+    sp_ftbl_destroy(&copy);
+    sp_destroy(&sp);
+    [super tearDown];
+}
+
+- (sp_conv *)convWith:(sp_ftbl *)table partitionSize:(int)size {
+    sp_conv *conv;
+    sp_conv_create(&conv);
+    XCTAssertEqual(sp_conv_init(sp, conv, table, size), SP_OK);
+    return conv;
+}
+
+- (void)render:(sp_conv *)conv into:(SPFLOAT *)output {
+    for (int i = 0; i < inputLength; i++) sp_conv_compute(sp, conv, &input[i], &output[i]);
+}
+
+/// conv delays its output by one partition
+- (void)testMatchesDirectConvolution {
+    sp_conv *conv = [self convWith:response partitionSize:partitionSize];
+    SPFLOAT output[inputLength];
+    [self render:conv into:output];
+    sp_conv_destroy(&conv);
+
+    for (int i = partitionSize; i < inputLength; i++) {
+        SPFLOAT expected = 0;
+        for (int j = 0; j < responseLength && j <= i - partitionSize; j++) {
+            expected += response->tbl[j] * input[i - partitionSize - j];
+        }
+        XCTAssertEqualWithAccuracy(output[i], expected, 1e-4);
+    }
+}
+
+- (void)testSameSamplesShareOneTransform {
+    sp_conv *a = [self convWith:response partitionSize:partitionSize];
+    sp_conv *b = [self convWith:copy partitionSize:partitionSize];
+    XCTAssertTrue(a->ir == b->ir, @"equal responses in different tables are transformed once");
+
+    SPFLOAT outA[inputLength], outB[inputLength];
+    [self render:a into:outA];
+
+    // The survivor keeps the shared transform after the other instance goes
+    sp_conv_destroy(&a);
+    [self render:b into:outB];
+    XCTAssertEqual(memcmp(outA, outB, sizeof(outA)), 0);
+    sp_conv_destroy(&b);
+}
+
+- (void)testDifferentResponsesDontShare {
+    copy->tbl[responseLength - 1] += 1e-6;
+    sp_conv *a = [self convWith:response partitionSize:partitionSize];
+    sp_conv *b = [self convWith:copy partitionSize:partitionSize];
+    sp_conv *c = [self convWith:response partitionSize:2 * partitionSize];
+    XCTAssertTrue(a->ir != b->ir, @"one changed sample is a different response");
+    XCTAssertTrue(a->ir != c->ir, @"a different partition size is a different transform");
+    sp_conv_destroy(&a);
+    sp_conv_destroy(&b);
+    sp_conv_destroy(&c);
+}
+
+- (void)testInitAgainSwitchesResponse {
+    sp_conv *a = [self convWith:response partitionSize:partitionSize];
+    copy->tbl[0] = 0;
+    XCTAssertEqual(sp_conv_init(sp, a, copy, partitionSize), SP_OK);
+    sp_conv *b = [self convWith:copy partitionSize:partitionSize];
+    XCTAssertTrue(a->ir == b->ir);
+    sp_conv_destroy(&a);
+    sp_conv_destroy(&b);
+}
+
+/// Eight instances over one three second response, as four stereo convolution nodes would load it
+- (void)testPerformanceInitSharedResponse {
+    sp_ftbl *reverb;
+    sp_ftbl_create(sp, &reverb, 3 * 44100);
+    uint32_t noise = 1;
+    for (size_t i = 0; i < reverb->size; i++) {
+        noise = noise * 1664525 + 1013904223;
+        reverb->tbl[i] = ((SPFLOAT)(noise >> 8) / 8388608 - 1) * exp(-(SPFLOAT)i / 20000);
+    }
+    [self measureBlock:^{
+        sp_conv *convs[8];
+        for (int i = 0; i < 8; i++) convs[i] = [self convWith:reverb partitionSize:2048];
+        for (int i = 0; i < 8; i++) sp_conv_destroy(&convs[i]);
+    }];
+    sp_ftbl_destroy(&reverb);
+}
+
+@end
@@ -0,0 +1,154 @@
+//
+//  SoundpipeFastMathTests.m
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/fastmath.h>
+
+// Roughly a million floats from each range; every float would take too long
+static const int32_t stride = 997;
+static const int count = 1 << 20;
+
+/// The next float after x (which must be finite and positive), stride floats along
+static float step(float x) {
+    return sp_fast_as_float(sp_fast_as_int(x) + stride);
+}
+
+static double relative(double value, double exact) {
+    return fabs(value - exact) / fabs(exact);
+}
+
+@interface SoundpipeFastMathTests : XCTestCase
+@end
+
+@implementation SoundpipeFastMathTests {
+    float *input, *output;
+}
+
+/// Arguments like the ones the filters pass: a driven signal, mostly within +/- 4
+- (void)setUp {
+    [super setUp];
+    input = malloc(sizeof(float) * count);
+    output = malloc(sizeof(float) * count);
+    uint32_t noise = 1;
+    for (int i = 0; i < count; i++) {
+        noise = noise * 1664525 + 1013904223;
+        input[i] = 4 * sinf(i * 0.001f) + (noise >> 8) / 16777216.0f - 0.5f;
+    }
+}
+
+- (void)tearDown {
+    free(input);
+    free(output);
+    [super tearDown];
+}
+
+// Each test checks the bound documented in fastmath.h
+
+- (void)testExp2 {
+    double worst = 0;
+    for (float x = 1e-30f; x <= 127; x = step(x)) {
+        worst = fmax(worst, relative(sp_fast_exp2(x), exp2(x)));
+        if (x <= 126) worst = fmax(worst, relative(sp_fast_exp2(-x), exp2(-x)));
+    }
+    XCTAssertLessThan(worst, 1.1e-7);
+    XCTAssertEqual(sp_fast_exp2(200), sp_fast_exp2(127));
+    XCTAssertEqual(sp_fast_exp2(-200), sp_fast_exp2(-126));
+    XCTAssertTrue(isnormal(sp_fast_exp2(-1000)));
+}
+
+- (void)testExp {
+    double worst = 0, worstAnywhere = 0;
+    for (float x = 1e-30f; x <= 88; x = step(x)) {
+        double error = relative(sp_fast_exp(x), exp(x));
+        if (x <= 87) error = fmax(error, relative(sp_fast_exp(-x), exp(-x)));
+        if (x <= 4) worst = fmax(worst, error);
+        worstAnywhere = fmax(worstAnywhere, error);
+    }
+    XCTAssertLessThan(worst, 3.1e-7);
+    XCTAssertLessThan(worstAnywhere, 4e-6);
+}
+
+- (void)testLog2AndLog {
+    double worstLog2 = 0, worstLog = 0;
+    for (float x = FLT_MIN; x <= FLT_MAX / 2; x = step(x)) {
+        if (x >= 0.5f && x <= 2) {
+            worstLog2 = fmax(worstLog2, fabs(sp_fast_log2(x) - log2(x)) / 1.2e-7);
+            worstLog = fmax(worstLog, fabs(sp_fast_log(x) - log(x)) / 1e-7);
+        } else {
+            worstLog2 = fmax(worstLog2, relative(sp_fast_log2(x), log2(x)) / 1e-7);
+            worstLog = fmax(worstLog, relative(sp_fast_log(x), log(x)) / 1.5e-7);
+        }
+    }
+    // As fractions of the bounds
+    XCTAssertLessThan(worstLog2, 1);
+    XCTAssertLessThan(worstLog, 1);
+}
+
+- (void)testPow {
+    double worst = 0;
+    for (float x = 0.01f; x <= 200; x = step(x)) {
+        for (float y = -3; y <= 3; y += 0.125f) {
+            double bound = 1e-7 * (1 + fabs(y) + fabs(y * log2(x)));
+            worst = fmax(worst, relative(sp_fast_pow(x, y), pow(x, y)) / bound);
+        }
+    }
+    XCTAssertLessThan(worst, 1);
+}
+
+- (void)testTanh {
+    double worst = 0, worstNearZero = 0;
+    for (float x = 1e-30f; x <= 10; x = step(x)) {
+        double exact = tanh(x);
+        XCTAssertEqual(sp_fast_tanh(-x), -sp_fast_tanh(x));
+        worst = fmax(worst, fabs(sp_fast_tanh(x) - exact));
+        if (x < 1) worstNearZero = fmax(worstNearZero, relative(sp_fast_tanh(x), exact));
+        if (x > 7.906f) XCTAssertEqual(sp_fast_tanh(x), 1.0f);
+    }
+    XCTAssertLessThan(worst, 4.2e-7);
+    XCTAssertLessThan(worstNearZero, 3e-7);
+}
+
+// Each function against libm's float version over the same arguments
+
+- (void)testPerformanceFastExp {
+    [self measureBlock:^{
+        for (int i = 0; i < count; i++) self->output[i] = sp_fast_exp(self->input[i]);
+    }];
+}
+
+- (void)testPerformanceLibmExp {
+    [self measureBlock:^{
+        for (int i = 0; i < count; i++) self->output[i] = expf(self->input[i]);
+    }];
+}
+
+- (void)testPerformanceFastPow {
+    [self measureBlock:^{
+        for (int i = 0; i < count; i++) self->output[i] = sp_fast_pow(5 + self->input[i], 1.5f);
+    }];
+}
+
+- (void)testPerformanceLibmPow {
+    [self measureBlock:^{
+        for (int i = 0; i < count; i++) self->output[i] = powf(5 + self->input[i], 1.5f);
+    }];
+}
+
+- (void)testPerformanceFastTanh {
+    [self measureBlock:^{
+        for (int i = 0; i < count; i++) self->output[i] = sp_fast_tanh(self->input[i]);
+    }];
+}
+
+- (void)testPerformanceLibmTanh {
+    [self measureBlock:^{
+        for (int i = 0; i < count; i++) self->output[i] = tanhf(self->input[i]);
+    }];
+}
+
+@end
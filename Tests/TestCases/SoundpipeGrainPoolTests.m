@@ -0,0 +1,139 @@
+//
+//  SoundpipeGrainPoolTests.m
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/soundpipe.h>
+
+static const int tableSize = 1024;
+
+@interface SoundpipeGrainPoolTests : XCTestCase
+@end
+
+@implementation SoundpipeGrainPoolTests {
+    sp_data *sp;
+    sp_ftbl *ones, *ramp;
+}
+
+/// A source of all ones, so the output is the envelope, and a window rising from 0 to 1
+- (void)setUp {
+    [super setUp];
+    sp_create(&sp);
+    sp->sr = 44100;
+    sp_ftbl_create(sp, &ones, tableSize);
+    sp_ftbl_create(sp, &ramp, tableSize);
+    for (int i = 0; i <= tableSize; i++) {
+        ones->tbl[i] = 1;
+        ramp->tbl[i] = (SPFLOAT)i / tableSize;
+    }
+}
+
+- (void)tearDown {
+    sp_ftbl_destroy(&ones);
+    sp_ftbl_destroy(&ramp);
+    sp_destroy(&sp);
+    [super tearDown];
+}
+
+- (sp_grain)grainLasting:(int32_t)duration {
+    sp_grain grain;
+    memset(&grain, 0, sizeof(grain));
+    grain.speed = 1;
+    grain.amp = 0.5;
+    grain.expamp = 1;
+    grain.dur = duration;
+    grain.risphs = SP_FT_MAXLEN;
+    return grain;
+}
+
+- (void)testGrainPlaysForItsDuration {
+    sp_grainpool *pool;
+    sp_grainpool_create(&pool);
+    sp_grainpool_init(sp, pool, ones, ramp, 4, SP_GRAIN_POSITION);
+
+    sp_grain grain = [self grainLasting:100];
+    XCTAssertEqual(sp_grainpool_add(sp, pool, &grain), SP_OK);
+
+    SPFLOAT out[64];
+    sp_grainpool_compute_block(sp, pool, out, 64);
+    XCTAssertEqual(out[0], 0.5f);
+    XCTAssertEqual(out[63], 0.5f);
+    XCTAssertEqual(pool->ngrains, 1);
+
+    sp_grainpool_compute_block(sp, pool, out, 64);
+    XCTAssertEqual(out[35], 0.5f);
+    XCTAssertEqual(out[36], 0.0f);
+    XCTAssertEqual(pool->ngrains, 0, @"a finished grain leaves the pool");
+    sp_grainpool_destroy(&pool);
+}
+
+- (void)testAttackAndRelease {
+    sp_grainpool *pool;
+    sp_grainpool_create(&pool);
+    sp_grainpool_init(sp, pool, ones, ramp, 4, SP_GRAIN_POSITION);
+
+    // 32 samples up the window, then the last 32 back down it
+    sp_grain grain = [self grainLasting:128];
+    grain.risphs = 0;
+    grain.risinc = SP_FT_MAXLEN / 32;
+    grain.dectim = 32;
+    grain.decinc = SP_FT_MAXLEN / 32;
+    sp_grainpool_add(sp, pool, &grain);
+
+    SPFLOAT out[128];
+    sp_grainpool_compute_block(sp, pool, out, 128);
+    XCTAssertEqual(out[0], 0.0f);
+    XCTAssertEqualWithAccuracy(out[16], 0.25f, 0.01f);
+    XCTAssertEqual(out[64], 0.5f);
+    XCTAssertEqualWithAccuracy(out[96 + 16], 0.25f, 0.01f);
+    XCTAssertLessThan(out[127], 0.02f);
+    for (int i = 1; i < 32; i++) XCTAssertGreaterThan(out[i], out[i - 1]);
+    for (int i = 97; i < 128; i++) XCTAssertLessThan(out[i], out[i - 1]);
+    sp_grainpool_destroy(&pool);
+}
+
+- (void)testFullPoolRefusesGrains {
+    sp_grainpool *pool;
+    sp_grainpool_create(&pool);
+    sp_grainpool_init(sp, pool, ones, ramp, 2, SP_GRAIN_POSITION);
+
+    sp_grain grain = [self grainLasting:100];
+    XCTAssertEqual(sp_grainpool_add(sp, pool, &grain), SP_OK);
+    XCTAssertEqual(sp_grainpool_add(sp, pool, &grain), SP_OK);
+    XCTAssertEqual(sp_grainpool_add(sp, pool, &grain), SP_NOT_OK);
+
+    SPFLOAT out[8];
+    sp_grainpool_compute_block(sp, pool, out, 8);
+    XCTAssertEqual(out[0], 1.0f, @"the grains that fit still sound");
+
+    sp_grainpool_init(sp, pool, ones, ramp, 2, SP_GRAIN_POSITION);
+    XCTAssertEqual(pool->ngrains, 0, @"init again starts over with an empty pool");
+    sp_grainpool_destroy(&pool);
+}
+
+- (void)testFofAndFogInitAgainAndDestroyWithoutInit {
+    sp_fof *fof;
+    sp_fof_create(&fof);
+    sp_fof_destroy(&fof);
+    sp_fof_create(&fof);
+    sp_fof_init(sp, fof, ones, ramp, 100, 0);
+    sp_fof_init(sp, fof, ones, ramp, 100, 0);
+    SPFLOAT out;
+    for (int i = 0; i < 4410; i++) sp_fof_compute(sp, fof, NULL, &out);
+    sp_fof_destroy(&fof);
+
+    sp_fog *fog;
+    sp_fog_create(&fog);
+    sp_fog_destroy(&fog);
+    sp_fog_create(&fog);
+    sp_fog_init(sp, fog, ones, ramp, 100, 0);
+    sp_fog_init(sp, fog, ones, ramp, 100, 0);
+    for (int i = 0; i < 4410; i++) sp_fog_compute(sp, fog, NULL, &out);
+    sp_fog_destroy(&fog);
+}
+
+@end
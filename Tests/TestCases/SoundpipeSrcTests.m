@@ -0,0 +1,156 @@
+//
+//  SoundpipeSrcTests.m
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/soundpipe.h>
+
+// Filter edges are skipped when comparing; the longest filter is 128 taps
+static const int margin = 200;
+
+@interface SoundpipeSrcTests : XCTestCase
+@end
+
+@implementation SoundpipeSrcTests {
+    sp_data *sp;
+}
+
+- (void)setUp {
+    [super setUp];
+    sp_create(&sp);
+}
+
+- (void)tearDown {
+    sp_destroy(&sp);
+    [super tearDown];
+}
+
+/// Converts a second of a half scale sine, and returns its largest error against the ideal sine, in dB
+- (double)errorConverting:(double)frequency from:(double)inRate to:(double)outRate quality:(int)quality {
+    int inCount = inRate, outCount = inRate * outRate / inRate;
+    SPFLOAT *input = malloc(sizeof(SPFLOAT) * inCount), *output = malloc(sizeof(SPFLOAT) * outCount);
+    for (int i = 0; i < inCount; i++) input[i] = 0.5 * sin(2 * M_PI * frequency * i / inRate);
+    XCTAssertEqual(sp_src_convert(sp, &input, inCount, inRate, &output, outCount, outRate, 1, quality), SP_OK);
+
+    double error = 0;
+    for (int n = margin; n < outCount - margin; n++) {
+        error = fmax(error, fabs(output[n] - 0.5 * sin(2 * M_PI * frequency * n / outRate)));
+    }
+    free(input);
+    free(output);
+    return 20 * log10(error / 0.5);
+}
+
+- (void)testSineAccuracyAtExactRatios {
+    double limits[] = { -60, -85, -100 };
+    for (int quality = SP_SRC_FAST; quality <= SP_SRC_BEST; quality++) {
+        XCTAssertLessThan([self errorConverting:1000 from:44100 to:48000 quality:quality], limits[quality]);
+        XCTAssertLessThan([self errorConverting:5000 from:48000 to:44100 quality:quality], limits[quality]);
+    }
+}
+
+/// Ratios that don't reduce interpolate between phases, which limits the best preset
+- (void)testSineAccuracyAtOtherRatios {
+    double limits[] = { -60, -85, -85 };
+    for (int quality = SP_SRC_FAST; quality <= SP_SRC_BEST; quality++) {
+        XCTAssertLessThan([self errorConverting:1000 from:44100 to:44104.41 quality:quality], limits[quality]);
+    }
+}
+
+/// A 30 kHz tone has no place below the 22.05 kHz Nyquist frequency, so whatever comes out is aliasing
+- (void)testDownsamplingRejectsAliases {
+    double limits[] = { -55, -85, -105 };
+    int inCount = 96000, outCount = 44100;
+    SPFLOAT *input = malloc(sizeof(SPFLOAT) * inCount), *output = malloc(sizeof(SPFLOAT) * outCount);
+    for (int i = 0; i < inCount; i++) input[i] = 0.5 * sin(2 * M_PI * 30000.0 * i / 96000);
+    for (int quality = SP_SRC_FAST; quality <= SP_SRC_BEST; quality++) {
+        sp_src_convert(sp, &input, inCount, 96000, &output, outCount, 44100, 1, quality);
+        double peak = 0;
+        for (int n = margin; n < outCount - margin; n++) peak = fmax(peak, fabs(output[n]));
+        XCTAssertLessThan(20 * log10(peak / 0.5), limits[quality]);
+    }
+    free(input);
+    free(output);
+}
+
+/// Streaming in uneven blocks, then flushing with silence, gives exactly what converting at once does
+- (void)testStreamingMatchesConvert {
+    int inCount = 2 * 44100, outCount = 2 * 48000;
+    SPFLOAT *input[2], *converted[2], *streamed[2];
+    for (int c = 0; c < 2; c++) {
+        input[c] = malloc(sizeof(SPFLOAT) * inCount);
+        converted[c] = malloc(sizeof(SPFLOAT) * outCount);
+        streamed[c] = calloc(outCount, sizeof(SPFLOAT));
+    }
+    uint32_t noise = 1;
+    for (int i = 0; i < inCount; i++) {
+        noise = noise * 1664525 + 1013904223;
+        input[0][i] = (SPFLOAT)(noise >> 8) / 16777216 - 0.5;
+        input[1][i] = sin(i * 0.01);
+    }
+    sp_src_convert(sp, input, inCount, 44100, converted, outCount, 48000, 2, SP_SRC_MEDIUM);
+
+    sp_src *src, *other;
+    sp_src_create(&src);
+    sp_src_create(&other);
+    XCTAssertEqual(sp_src_init(sp, src, 44100, 48000, 2, SP_SRC_MEDIUM), SP_OK);
+    XCTAssertEqual(sp_src_init(sp, other, 44100, 48000, 2, SP_SRC_MEDIUM), SP_OK);
+    XCTAssertTrue(src->bank == other->bank, @"instances converting between the same rates share a bank");
+
+    int made = 0, fed = 0;
+    while (made < outCount) {
+        noise = noise * 1664525 + 1013904223;
+        int wanted = MIN(1 + (int)(noise >> 16) % 700, outCount - made);
+        int needed = sp_src_needed(src, wanted);
+        SPFLOAT *in[2] = { input[0] + fed, input[1] + fed }, *out[2] = { streamed[0] + made, streamed[1] + made };
+        int used, blockMade;
+        if (fed < inCount) {
+            sp_src_compute_block(sp, src, in, MIN(needed, inCount - fed), out, wanted, &used, &blockMade);
+        } else {
+            sp_src_compute_block(sp, src, NULL, needed, out, wanted, &used, &blockMade);
+            used = 0;
+        }
+        fed += used;
+        made += blockMade;
+    }
+    for (int c = 0; c < 2; c++) {
+        XCTAssertEqual(memcmp(converted[c], streamed[c], sizeof(SPFLOAT) * outCount), 0);
+        free(input[c]);
+        free(converted[c]);
+        free(streamed[c]);
+    }
+    sp_src_destroy(&src);
+    sp_src_destroy(&other);
+}
+
+/// Twenty seconds of stereo, as a sample loaded at 44.1 kHz into a 48 kHz session
+- (void)measureConvertWithQuality:(int)quality {
+    int inCount = 20 * 44100, outCount = 20 * 48000;
+    SPFLOAT *input[2], *output[2];
+    for (int c = 0; c < 2; c++) {
+        input[c] = malloc(sizeof(SPFLOAT) * inCount);
+        output[c] = malloc(sizeof(SPFLOAT) * outCount);
+        for (int i = 0; i < inCount; i++) input[c][i] = sin(i * 0.03 * (c + 1));
+    }
+    [self measureBlock:^{
+        sp_src_convert(self->sp, input, inCount, 44100, output, outCount, 48000, 2, quality);
+    }];
+    for (int c = 0; c < 2; c++) {
+        free(input[c]);
+        free(output[c]);
+    }
+}
+
+- (void)testPerformanceConvertFast {
+    [self measureConvertWithQuality:SP_SRC_FAST];
+}
+
+- (void)testPerformanceConvertBest {
+    [self measureConvertWithQuality:SP_SRC_BEST];
+}
+
+@end
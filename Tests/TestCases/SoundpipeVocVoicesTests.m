@@ -0,0 +1,122 @@
+//
+//  SoundpipeVocVoicesTests.m
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/soundpipe.h>
+
+static const int maxVoices = 8;
+static const int sampleCount = 4 * 512 + 100;
+
+@interface SoundpipeVocVoicesTests : XCTestCase
+@end
+
+@implementation SoundpipeVocVoicesTests {
+    sp_data *sp;
+    sp_voc *voices[maxVoices];
+}
+
+- (void)setUp {
+    [super setUp];
+    sp_create(&sp);
+    sp->sr = 44100;
+}
+
+- (void)tearDown {
+    sp_destroy(&sp);
+    [super tearDown];
+}
+
+/// A choir of different vowels and pitches, each voice started startDelay[v] samples after the first
+- (void)makeVoices:(int)count {
+    for (int v = 0; v < count; v++) {
+        sp_voc_create(&voices[v]);
+        sp_voc_init(sp, voices[v]);
+        sp_voc_set_frequency(voices[v], 110 + 37 * v);
+        sp_voc_set_tongue_shape(voices[v], 12 + 3 * v, 2 + 0.2 * v);
+        sp_voc_set_tenseness(voices[v], 0.3 + 0.08 * v);
+        sp_voc_set_velum(voices[v], v % 3 == 0 ? 0.4 : 0.01);
+    }
+}
+
+- (void)destroyVoices:(int)count {
+    for (int v = 0; v < count; v++) sp_voc_destroy(&voices[v]);
+}
+
+/// Renders count voices one by one, then again in lockstep from the same noise seed, and compares them
+- (void)checkLockstepMatchesOneByOne:(int)count offset:(int)offset {
+    SPFLOAT oneByOne[maxVoices][sampleCount], lockstep[maxVoices][sampleCount], frame[maxVoices];
+
+    [self makeVoices:count];
+    sp_srand(sp, 1234);
+    // the last voice runs offset samples ahead, so its blocks don't start with the others
+    for (int i = 0; i < offset; i++) sp_voc_compute(sp, voices[count - 1], &frame[0]);
+    for (int i = 0; i < sampleCount; i++) {
+        for (int v = 0; v < count; v++) sp_voc_compute(sp, voices[v], &oneByOne[v][i]);
+    }
+    [self destroyVoices:count];
+
+    [self makeVoices:count];
+    sp_srand(sp, 1234);
+    for (int i = 0; i < offset; i++) sp_voc_compute(sp, voices[count - 1], &frame[0]);
+    for (int i = 0; i < sampleCount; i++) {
+        sp_voc_compute_voices(sp, voices, count, frame);
+        for (int v = 0; v < count; v++) lockstep[v][i] = frame[v];
+    }
+    [self destroyVoices:count];
+
+    for (int v = 0; v < count; v++) {
+        XCTAssertEqual(memcmp(oneByOne[v], lockstep[v], sizeof(oneByOne[v])), 0, @"voice %d of %d", v, count);
+    }
+}
+
+- (void)testOneVoice {
+    [self checkLockstepMatchesOneByOne:1 offset:0];
+}
+
+/// A full group of lanes and a partial one
+- (void)testSixVoices {
+    [self checkLockstepMatchesOneByOne:6 offset:0];
+}
+
+- (void)testVoiceOutOfStep {
+    [self checkLockstepMatchesOneByOne:5 offset:200];
+}
+
+- (void)testOutputIsntSilent {
+    [self makeVoices:4];
+    SPFLOAT frame[maxVoices], peak[maxVoices] = { 0 };
+    for (int i = 0; i < sampleCount; i++) {
+        sp_voc_compute_voices(sp, voices, 4, frame);
+        for (int v = 0; v < 4; v++) peak[v] = fmax(peak[v], fabs(frame[v]));
+    }
+    [self destroyVoices:4];
+    for (int v = 0; v < 4; v++) XCTAssertGreaterThan(peak[v], 0.01);
+}
+
+/// A second of an eight voice choir
+- (void)testPerformanceOneByOne {
+    [self makeVoices:maxVoices];
+    [self measureBlock:^{
+        SPFLOAT out;
+        for (int i = 0; i < 44100; i++) {
+            for (int v = 0; v < maxVoices; v++) sp_voc_compute(self->sp, self->voices[v], &out);
+        }
+    }];
+    [self destroyVoices:maxVoices];
+}
+
+- (void)testPerformanceLockstep {
+    [self makeVoices:maxVoices];
+    [self measureBlock:^{
+        SPFLOAT frame[maxVoices];
+        for (int i = 0; i < 44100; i++) sp_voc_compute_voices(self->sp, self->voices, maxVoices, frame);
+    }];
+    [self destroyVoices:maxVoices];
+}
+
+@end
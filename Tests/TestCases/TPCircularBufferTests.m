@@ -0,0 +1,104 @@
+//
+//  TPCircularBufferTests.m
+//  AudioKit
+//
+//  Created by AudioKit Contributors, revision history on GitHub.
+//  Copyright © 2019 AudioKit. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <AudioKit/TPCircularBuffer.h>
+
+static const int32_t bufferLength = 64 * 1024;
+
+// 512 stereo float frames, the size of a typical render's worth of audio
+static const int32_t chunkLength = 512 * 2 * sizeof(float);
+
+@interface TPCircularBufferTests : XCTestCase
+@end
+
+@implementation TPCircularBufferTests
+
+/// The fallback used where the platform can't map the buffer twice: a real copy after the end
+- (void)initCopyingBuffer:(TPCircularBuffer *)buffer {
+    buffer->length = bufferLength;
+    buffer->buffer = malloc(2 * bufferLength);
+    buffer->head = buffer->tail = 0;
+    buffer->fillCount = 0;
+    buffer->atomic = true;
+    buffer->mirrored = false;
+}
+
+/// Streams numbered bytes through buffer in uneven pieces, so that writes and reads keep crossing its end,
+/// and checks each read comes back whole and in order
+- (void)checkWrappedReadsAndWrites:(TPCircularBuffer *)buffer {
+    uint8_t piece[1001];
+    uint32_t written = 0, read = 0;
+    while (read < 16 * bufferLength) {
+        int32_t pieceLength = 1 + written % 1001;
+        for (int32_t i = 0; i < pieceLength; ++i) piece[i] = (uint8_t)((written + i) % 251);
+        if (TPCircularBufferProduceBytes(buffer, piece, pieceLength)) {
+            written += pieceLength;
+        }
+
+        int32_t available;
+        uint8_t *tail = TPCircularBufferTail(buffer, &available);
+        int32_t readLength = available * 2 / 3;
+        for (int32_t i = 0; i < readLength; ++i) {
+            if (tail[i] != (uint8_t)((read + i) % 251)) {
+                XCTFail(@"byte %u read back wrong", read + i);
+                return;
+            }
+        }
+        TPCircularBufferConsume(buffer, readLength);
+        read += readLength;
+    }
+}
+
+- (void)testMirroredWrapsAround {
+    TPCircularBuffer buffer;
+    XCTAssertTrue(TPCircularBufferInit(&buffer, bufferLength));
+    [self checkWrappedReadsAndWrites:&buffer];
+    TPCircularBufferCleanup(&buffer);
+}
+
+- (void)testCopyingWrapsAround {
+    TPCircularBuffer buffer;
+    [self initCopyingBuffer:&buffer];
+    [self checkWrappedReadsAndWrites:&buffer];
+    free(buffer.buffer);
+}
+
+/// Produces and consumes 256 MB, a chunk at a time, as a render thread and its reader would
+- (void)measureProduceConsume:(TPCircularBuffer *)buffer {
+    float *chunk = calloc(1, chunkLength);
+    float *out = calloc(1, chunkLength);
+    [self measureBlock:^{
+        for (int i = 0; i < 256 * 1024 * 1024 / chunkLength; ++i) {
+            TPCircularBufferProduceBytes(buffer, chunk, chunkLength);
+            int32_t available;
+            void *tail = TPCircularBufferTail(buffer, &available);
+            memcpy(out, tail, chunkLength);
+            TPCircularBufferConsume(buffer, chunkLength);
+        }
+    }];
+    free(chunk);
+    free(out);
+}
+
+- (void)testPerformanceMirrored {
+    TPCircularBuffer buffer;
+    XCTAssertTrue(TPCircularBufferInit(&buffer, bufferLength));
+    XCTAssertTrue(buffer.mirrored);
+    [self measureProduceConsume:&buffer];
+    TPCircularBufferCleanup(&buffer);
+}
+
+- (void)testPerformanceCopying {
+    TPCircularBuffer buffer;
+    [self initCopyingBuffer:&buffer];
+    [self measureProduceConsume:&buffer];
+    free(buffer.buffer);
+}
+
+@end
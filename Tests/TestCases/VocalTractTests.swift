@@ -20,7 +20,7 @@ class VocalTractTests: AKTestCase {
         output = AKOperationGenerator { _ in
             return AKOperation.vocalTract()
         }
-        AKTestMD5("08151832dac3e5d23d194b4004dc9916")
+        AKTestMD5("b7d89f5fec3655c28564fb5904ff9b3f")
     }
 
     func testParameterSweep() {
@@ -36,7 +36,7 @@ class VocalTractTests: AKTestCase {
                                           tenseness: line,
                                           nasality: line)
         }
-        AKTestMD5("73de198b2746be67144e9cd865815f4b")
+        AKTestMD5("d42cf1d4dc656392b927c38147a727d8")
     }
 
 }
@@ -38,4 +38,32 @@ class FMOscillatorTests: AKTestCase {
         AKTestMD5("4a09613948839bbe5fe458524de8176a")
     }
 
+    func sixteenVoices(threadCount: Int) -> AKOperationGenerator {
+        var mix = AKOperation.fmOscillator(baseFrequency: 110, amplitude: 0.05)
+        for voice in 1..<16 {
+            mix = mix + AKOperation.fmOscillator(baseFrequency: 110 + Double(voice) * 55, amplitude: 0.05)
+        }
+        let generator = AKOperationGenerator { _ in
+            return mix
+        }
+        generator.threadCount = threadCount
+        return generator
+    }
+
+    func testPerformanceOneThread() {
+        duration = 10
+        output = sixteenVoices(threadCount: 1)
+        measure {
+            try! AudioKit.test(node: output!, duration: duration, afterStart: afterStart)
+        }
+    }
+
+    func testPerformanceFourThreads() {
+        duration = 10
+        output = sixteenVoices(threadCount: 4)
+        measure {
+            try! AudioKit.test(node: output!, duration: duration, afterStart: afterStart)
+        }
+    }
+
 }
@@ -27,7 +27,7 @@ class KorgLowPassFilterTests: AKTestCase {
         output = AKOperationEffect(input) { input, _ in
             return input.korgLowPassFilter(cutoffFrequency: 2_000, resonance: 0.9, saturation: 0.5)
         }
-        AKTestMD5("a4acbe1dd84c0075659f10f9e48d45dd")
+        AKTestMD5("e790436b09d4b629677cd1b673e4159f")
     }
 
 }